@@ -22,6 +22,7 @@
 #include "lwip/netif.h"
 #include "netif/etharp.h"
 #include "lwip/dhcp.h"
+#include "lwip/dns.h"
 #include "eth_arch.h"
 #include "lwip/tcpip.h"
 
@@ -35,10 +36,31 @@ static char ip_addr[17] = "\0";
 static char gateway[17] = "\0";
 static char networkmask[17] = "\0";
 static bool use_dhcp = false;
+static bool use_reboot = false;
+static ip_addr_t reboot_addr;
 
 static Semaphore tcpip_inited(0);
 static Semaphore netif_linked(0);
 static Semaphore netif_up(0);
+static Semaphore dns_cache_done(0);
+static Semaphore arp_done(0);
+
+/* One DNS cache entry, copied in the tcpip thread */
+struct dns_cache_msg {
+    u8_t index;
+    u8_t ok;
+    char name[DNS_MAX_NAME_LENGTH];
+    ip_addr_t addr;
+    u32_t ttl;
+};
+
+/* One ARP table entry, read or changed in the tcpip thread */
+struct arp_msg {
+    u8_t index;
+    s8_t result;
+    ip_addr_t addr;
+    struct eth_addr eth;
+};
 
 static void tcpip_init_done(void *arg) {
     tcpip_inited.release();
@@ -59,6 +81,47 @@ static void netif_status_callback(struct netif *netif) {
     }
 }
 
+static void dns_cache_get_fn(void *arg) {
+    struct dns_cache_msg *msg = (struct dns_cache_msg *) arg;
+    
+    msg->ok = dns_cache_get(msg->index, msg->name, &msg->addr, &msg->ttl);
+    dns_cache_done.release();
+}
+
+static void dns_cache_add_fn(void *arg) {
+    struct dns_cache_msg *msg = (struct dns_cache_msg *) arg;
+    
+    msg->ok = (dns_cache_add(msg->name, &msg->addr, msg->ttl) == ERR_OK);
+    dns_cache_done.release();
+}
+
+static void arp_get_fn(void *arg) {
+    struct arp_msg *msg = (struct arp_msg *) arg;
+    ip_addr_t *addr;
+    struct eth_addr *eth;
+    
+    msg->result = etharp_get_entry(msg->index, &addr, &eth);
+    if (msg->result > 0) {
+        ip_addr_copy(msg->addr, *addr);
+        msg->eth = *eth;
+    }
+    arp_done.release();
+}
+
+static void arp_add_fn(void *arg) {
+    struct arp_msg *msg = (struct arp_msg *) arg;
+    
+    msg->result = etharp_add_static_entry(&msg->addr, &msg->eth);
+    arp_done.release();
+}
+
+static void arp_remove_fn(void *arg) {
+    struct arp_msg *msg = (struct arp_msg *) arg;
+    
+    msg->result = etharp_remove_static_entry(&msg->addr);
+    arp_done.release();
+}
+
 static void init_netif(ip_addr_t *ipaddr, ip_addr_t *netmask, ip_addr_t *gw) {
     tcpip_init(tcpip_init_done, NULL);
     tcpip_inited.wait();
@@ -109,7 +172,10 @@ int EthernetInterface::connect(unsigned int timeout_ms) {
 
     int inited;
     if (use_dhcp) {
-        dhcp_start(&netif);
+        if (use_reboot)
+            dhcp_start_reboot(&netif, &reboot_addr);
+        else
+            dhcp_start(&netif);
         
         // Wait for an IP Address
         // -1: error, 0: timeout
@@ -153,4 +219,142 @@ char* EthernetInterface::getNetworkMask() {
     return networkmask;
 }
 
+// one line per name: "<name> <address> <expiry time>"
+int EthernetInterface::dnsSave(const char* path) {
+    struct dns_cache_msg msg;
+    time_t now = time(NULL);
+    int count = 0;
+    
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL)
+        return -1;
+    
+    for (int i = 0; i < DNS_TABLE_SIZE; i++) {
+        msg.index = i;
+        if (tcpip_callback(dns_cache_get_fn, &msg) != ERR_OK)
+            break;
+        dns_cache_done.wait();
+        if (msg.ok) {
+            fprintf(fp, "%s %s %lu\n", msg.name, inet_ntoa(msg.addr), (unsigned long) (now + msg.ttl));
+            count++;
+        }
+    }
+    fclose(fp);
+    return count;
+}
+
+int EthernetInterface::dnsLoad(const char* path) {
+    struct dns_cache_msg msg;
+    char line[DNS_MAX_NAME_LENGTH + 32];
+    time_t now = time(NULL);
+    int count = 0;
+    
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL)
+        return -1;
+    
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        char *addr = strchr(line, ' ');
+        if (addr == NULL)
+            continue;
+        *addr++ = '\0';
+        char *expiry = strchr(addr, ' ');
+        if (expiry == NULL)
+            continue;
+        *expiry++ = '\0';
+        
+        unsigned long until = strtoul(expiry, NULL, 10);
+        if ((strlen(line) >= DNS_MAX_NAME_LENGTH) || (until <= (unsigned long) now) || !inet_aton(addr, &msg.addr))
+            continue;
+        strcpy(msg.name, line);
+        msg.ttl = until - now;
+        if (tcpip_callback(dns_cache_add_fn, &msg) != ERR_OK)
+            break;
+        dns_cache_done.wait();
+        if (msg.ok)
+            count++;
+    }
+    fclose(fp);
+    return count;
+}
+
+// one line: "<address> <lease expiry time>"
+int EthernetInterface::dhcpSave(const char* path) {
+    if ((netif.dhcp == NULL) || (netif.dhcp->state != DHCP_BOUND))
+        return -1;
+    
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL)
+        return -1;
+    
+    fprintf(fp, "%s %lu\n", inet_ntoa(netif.ip_addr), (unsigned long) (time(NULL) + netif.dhcp->offered_t0_lease));
+    fclose(fp);
+    return 0;
+}
+
+int EthernetInterface::dhcpLoad(const char* path) {
+    char line[32];
+    
+    use_reboot = false;
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL)
+        return -1;
+    
+    if (fgets(line, sizeof(line), fp) != NULL) {
+        char *expiry = strchr(line, ' ');
+        if (expiry != NULL) {
+            *expiry++ = '\0';
+            unsigned long until = strtoul(expiry, NULL, 10);
+            if ((until > (unsigned long) time(NULL)) && inet_aton(line, &reboot_addr))
+                use_reboot = true;
+        }
+    }
+    fclose(fp);
+    return use_reboot ? 0 : -1;
+}
 
+int EthernetInterface::arpAdd(const char* ip, const char* mac) {
+    struct arp_msg msg;
+    unsigned int b[ETHARP_HWADDR_LEN];
+    
+    if (!inet_aton(ip, &msg.addr) ||
+        sscanf(mac, "%x:%x:%x:%x:%x:%x", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) != ETHARP_HWADDR_LEN)
+        return -1;
+    for (int i = 0; i < ETHARP_HWADDR_LEN; i++)
+        msg.eth.addr[i] = b[i];
+    
+    if (tcpip_callback(arp_add_fn, &msg) != ERR_OK)
+        return -1;
+    arp_done.wait();
+    return (msg.result == ERR_OK) ? (0) : (-1);
+}
+
+int EthernetInterface::arpRemove(const char* ip) {
+    struct arp_msg msg;
+    
+    if (!inet_aton(ip, &msg.addr))
+        return -1;
+    
+    if (tcpip_callback(arp_remove_fn, &msg) != ERR_OK)
+        return -1;
+    arp_done.wait();
+    return (msg.result == ERR_OK) ? (0) : (-1);
+}
+
+int EthernetInterface::arpGet(int index, char* ip, char* mac) {
+    struct arp_msg msg;
+    
+    if (index < 0 || index >= ARP_TABLE_SIZE)
+        return -1;
+    
+    msg.index = index;
+    if (tcpip_callback(arp_get_fn, &msg) != ERR_OK)
+        return -1;
+    arp_done.wait();
+    if (msg.result > 0) {
+        strcpy(ip, inet_ntoa(msg.addr));
+        snprintf(mac, 18, "%02x:%02x:%02x:%02x:%02x:%02x", msg.eth.addr[0], msg.eth.addr[1], msg.eth.addr[2],
+                 msg.eth.addr[3], msg.eth.addr[4], msg.eth.addr[5]);
+    }
+    return msg.result;
+}
@@ -79,6 +79,55 @@ public:
    * \return a pointer to a string containing the Network mask
    */
   static char* getNetworkMask();
+
+  /** Save the DNS cache to a file, so the next boot does not start with an empty cache
+   * \param   path  file to write, e.g. "/sd/dns.txt"
+   * \return number of names saved, a negative number on failure
+   */
+  static int dnsSave(const char* path);
+
+  /** Load a DNS cache saved by dnsSave(), names that expired meanwhile are skipped
+   * Call it after init().
+   * \param   path  file to read
+   * \return number of names loaded, a negative number on failure
+   */
+  static int dnsLoad(const char* path);
+
+  /** Save the DHCP lease to a file, so the next boot can ask to keep the address
+   * \param   path  file to write, e.g. "/sd/lease.txt"
+   * \return 0 on success, -1 if there is no lease or the file cannot be written
+   */
+  static int dhcpSave(const char* path);
+
+  /** Load a lease saved by dhcpSave(), connect() then requests that address
+   * instead of discovering a new one. An expired lease is ignored.
+   * Call it after init() and before connect().
+   * \param   path  file to read
+   * \return 0 if a lease was loaded, -1 otherwise
+   */
+  static int dhcpLoad(const char* path);
+
+  /** Add a static ARP entry, it never expires and replaces a learned one
+   * \param   ip   IP address, e.g. "192.168.1.10"
+   * \param   mac  MAC address, e.g. "00:02:f7:f0:00:01"
+   * \return 0 on success, -1 on failure
+   */
+  static int arpAdd(const char* ip, const char* mac);
+
+  /** Remove a static ARP entry added by arpAdd()
+   * \param   ip   IP address of the entry
+   * \return 0 on success, -1 if there is no static entry for ip
+   */
+  static int arpRemove(const char* ip);
+
+  /** Read an entry of the ARP table
+   * \param   index  table index, starting at 0
+   * \param   ip     buffer of 16 chars for the IP address
+   * \param   mac    buffer of 18 chars for the MAC address
+   * \return 1 for a learned entry, 2 for a static one, 0 for an unused index,
+   *         -1 past the end of the table
+   */
+  static int arpGet(int index, char* ip, char* mac);
 };
 
 #include "TCPSocketConnection.h"
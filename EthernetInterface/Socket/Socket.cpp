@@ -50,6 +50,18 @@ int Socket::get_option(int level, int optname, void *optval, socklen_t *optlen)
 }
 
 int Socket::select(struct timeval *timeout, bool read, bool write) {
+#if LWIP_SOCKET_EVENT_HOOK
+    // Most of the time the socket is ready: skip the full lwip_select
+    int state = lwip_sockstate(_sock_fd);
+    if (state < 0)
+        return -1;
+    if ((read  && (state & LWIP_SOCK_READABLE)) ||
+        (write && (state & LWIP_SOCK_WRITABLE)))
+        return 0;
+    if ((timeout->tv_sec == 0) && (timeout->tv_usec == 0))
+        return -1;
+#endif
+    
     fd_set fdSet;
     FD_ZERO(&fdSet);
     FD_SET(_sock_fd, &fdSet);
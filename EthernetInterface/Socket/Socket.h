@@ -31,10 +31,13 @@ inline int gethostbyname_r(const char *name, struct hostent *ret, char *buf, siz
 }
 
 class TimeInterval;
+class SocketReactor;
 
 /** Socket file descriptor and select wrapper
   */
 class Socket {
+    friend class SocketReactor;
+
 public:
     /** Socket
      */
@@ -0,0 +1,149 @@
+/* Copyright (C) 2012 mbed.org, MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "Socket/SocketReactor.h"
+#include "lwip/sys.h"
+#include <cstring>
+
+#if LWIP_SOCKET_EVENT_HOOK
+
+using std::memset;
+
+// one bit per socket in _pending
+#if MEMP_NUM_NETCONN > 32
+#error SocketReactor supports up to 32 sockets
+#endif
+
+SocketReactor::SocketReactor() : _pending(0) {
+    memset(_entries, 0, sizeof(_entries));
+    _thread = osThreadGetId();
+}
+
+// Called by lwIP with SYS_ARCH protected, must not block
+void SocketReactor::event(int s, void *arg) {
+    SocketReactor *reactor = (SocketReactor *) arg;
+    
+    reactor->_pending |= (1UL << s);
+    if (reactor->_thread != NULL)
+        osSignalSet(reactor->_thread, SOCKET_REACTOR_SIGNAL);
+}
+
+void SocketReactor::mark(int s) {
+    SYS_ARCH_DECL_PROTECT(lev);
+    
+    SYS_ARCH_PROTECT(lev);
+    _pending |= (1UL << s);
+    SYS_ARCH_UNPROTECT(lev);
+}
+
+int SocketReactor::add(Socket *socket, int events, Handler handler, void *arg) {
+    int s = socket->_sock_fd;
+    
+    if ((s < 0) || (s >= MEMP_NUM_NETCONN) || (handler == NULL))
+        return -1;
+    
+    _entries[s].socket  = socket;
+    _entries[s].events  = events;
+    _entries[s].handler = handler;
+    _entries[s].arg     = arg;
+    if (lwip_sockevent(s, &SocketReactor::event, this) < 0) {
+        _entries[s].socket = NULL;
+        return -1;
+    }
+    
+    // report the current state on the next poll
+    mark(s);
+    return 0;
+}
+
+int SocketReactor::modify(Socket *socket, int events) {
+    int s = socket->_sock_fd;
+    
+    if ((s < 0) || (s >= MEMP_NUM_NETCONN) || (_entries[s].socket != socket))
+        return -1;
+    
+    _entries[s].events = events;
+    mark(s);
+    return 0;
+}
+
+int SocketReactor::remove(Socket *socket) {
+    int s = socket->_sock_fd;
+    SYS_ARCH_DECL_PROTECT(lev);
+    
+    if ((s < 0) || (s >= MEMP_NUM_NETCONN) || (_entries[s].socket != socket))
+        return -1;
+    
+    lwip_sockevent(s, NULL, NULL);
+    _entries[s].socket = NULL;
+    SYS_ARCH_PROTECT(lev);
+    _pending &= ~(1UL << s);
+    SYS_ARCH_UNPROTECT(lev);
+    return 0;
+}
+
+int SocketReactor::poll(uint32_t timeout) {
+    uint32_t pending;
+    int called = 0;
+    SYS_ARCH_DECL_PROTECT(lev);
+    
+    _thread = osThreadGetId();
+    
+    SYS_ARCH_PROTECT(lev);
+    pending = _pending;
+    _pending = 0;
+    SYS_ARCH_UNPROTECT(lev);
+    
+    if (pending == 0) {
+        osSignalWait(SOCKET_REACTOR_SIGNAL, timeout);
+        
+        SYS_ARCH_PROTECT(lev);
+        pending = _pending;
+        _pending = 0;
+        SYS_ARCH_UNPROTECT(lev);
+    }
+    
+    // only the sockets with events are looked at
+    for (int s = 0; pending != 0; s++, pending >>= 1) {
+        if ((pending & 1) == 0)
+            continue;
+        
+        Entry *entry = &_entries[s];
+        // the socket may have been closed and its number reused
+        if ((entry->socket == NULL) || (entry->socket->_sock_fd != s))
+            continue;
+        
+        int state = lwip_sockstate(s);
+        if (state < 0)
+            state = CLOSED;
+        state &= (entry->events | CLOSED);
+        if (state != 0) {
+            entry->handler(entry->socket, state, entry->arg);
+            called++;
+        }
+    }
+    return called;
+}
+
+SocketReactor::~SocketReactor() {
+    for (int s = 0; s < MEMP_NUM_NETCONN; s++) {
+        if ((_entries[s].socket != NULL) && (_entries[s].socket->_sock_fd == s))
+            lwip_sockevent(s, NULL, NULL);
+    }
+}
+
+#endif /* LWIP_SOCKET_EVENT_HOOK */
@@ -0,0 +1,107 @@
+/* Copyright (C) 2012 mbed.org, MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef SOCKETREACTOR_H_
+#define SOCKETREACTOR_H_
+
+#include "Socket/Socket.h"
+#include "cmsis_os.h"
+
+#if LWIP_SOCKET_EVENT_HOOK
+
+/** Signal set on the polling thread when a socket has an event */
+#define SOCKET_REACTOR_SIGNAL   0x1000
+
+/** Event loop serving many sockets from one thread
+ *
+ * The sockets are registered once. lwIP tells the reactor about every
+ * socket event, so poll() waits for a single RTX signal and calls the
+ * handlers of the sockets that had events, without a lwip_select() call.
+ *
+ * Handlers are edge triggered: a handler has to read or write until the
+ * socket would block, otherwise it is not called again for that state.
+ * Use non-blocking sockets with a timeout of 0.
+ */
+class SocketReactor {
+public:
+    /** Events passed to the handler */
+    enum {
+        READABLE = LWIP_SOCK_READABLE,  ///< data, a connection to accept or the end of the stream
+        WRITABLE = LWIP_SOCK_WRITABLE,  ///< room in the send buffer
+        CLOSED   = LWIP_SOCK_ERROR      ///< error or reset, always reported
+    };
+    
+    /** Event handler
+    \param socket  socket with an event
+    \param events  READABLE, WRITABLE and CLOSED flags
+    \param arg     argument given to add()
+    */
+    typedef void (*Handler)(Socket *socket, int events, void *arg);
+    
+    /** Event loop without sockets
+     */
+    SocketReactor();
+    
+    /** Watch a socket
+    \param socket   an open socket
+    \param events   READABLE and WRITABLE flags to report
+    \param handler  function to call from poll()
+    \param arg      argument passed to the handler
+    \return 0 on success, -1 on failure
+    */
+    int add(Socket *socket, int events, Handler handler, void *arg=NULL);
+    
+    /** Change the events reported for a socket, the socket is checked again
+    \param socket  a socket given to add()
+    \param events  READABLE and WRITABLE flags to report
+    \return 0 on success, -1 on failure
+    */
+    int modify(Socket *socket, int events);
+    
+    /** Stop watching a socket, call it before closing the socket
+    \param socket  a socket given to add()
+    \return 0 on success, -1 on failure
+    */
+    int remove(Socket *socket);
+    
+    /** Wait for socket events and call the handlers
+    \param timeout  timeout in ms [Default: osWaitForever]
+    \return number of handlers called
+    */
+    int poll(uint32_t timeout=osWaitForever);
+    
+    ~SocketReactor();
+    
+private:
+    static void event(int s, void *arg);
+    void mark(int s);
+    
+    struct Entry {
+        Socket *socket;
+        int events;
+        Handler handler;
+        void *arg;
+    };
+    
+    Entry _entries[MEMP_NUM_NETCONN];
+    uint32_t _pending;
+    osThreadId _thread;
+};
+
+#endif /* LWIP_SOCKET_EVENT_HOOK */
+
+#endif /* SOCKETREACTOR_H_ */
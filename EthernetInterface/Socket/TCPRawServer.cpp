@@ -0,0 +1,250 @@
+/* Copyright (C) 2012 mbed.org, MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "Socket/TCPRawServer.h"
+#include "lwip/tcpip.h"
+
+// poll interval in TCP coarse timer ticks (500 ms)
+#define TCP_RAW_POLL            2
+// polls a closing connection may wait for its data to be acknowledged
+#define TCP_RAW_CLOSE_POLLS     20
+
+int TCPRawConnection::send(const void *data, int length, bool copy) {
+    if (_pcb == NULL || _closing)
+        return 0;
+    
+    int space = tcp_sndbuf(_pcb);
+    if (length > space)
+        length = space;
+    if (length > 0xFFFF)
+        length = 0xFFFF;
+    if (length <= 0)
+        return 0;
+    
+    if (tcp_write(_pcb, data, length, copy ? TCP_WRITE_FLAG_COPY : 0) != ERR_OK)
+        return 0;
+    return length;
+}
+
+int TCPRawConnection::sendSpace(void) {
+    if (_pcb == NULL || _closing)
+        return 0;
+    return tcp_sndbuf(_pcb);
+}
+
+void TCPRawConnection::close(void) {
+    if (_pcb == NULL || _closing)
+        return;
+    
+    _closing = true;
+    _polls = 0;
+    // data sent without copy is still referenced until it is acknowledged
+    if (_pcb->unsent == NULL && _pcb->unacked == NULL)
+        _server->shut(this);
+}
+
+TCPRawServer::TCPRawServer() : _listen(NULL) {
+    for (int i = 0; i < TCP_RAW_CONNECTIONS; i++) {
+        _conns[i]._server = this;
+        _conns[i]._pcb = NULL;
+        _conns[i]._id = i;
+        _conns[i]._closing = false;
+        _conns[i]._peerClosed = false;
+    }
+    sys_sem_new(&_done, 0);
+}
+
+// run fn in the tcpip thread and wait for it
+int TCPRawServer::call(void (*fn)(void *)) {
+    _result = -1;
+    if (tcpip_callback(fn, this) != ERR_OK)
+        return -1;
+    sys_arch_sem_wait(&_done, 0);
+    return _result;
+}
+
+int TCPRawServer::listen(int port, int backlog) {
+    if (_listen != NULL)
+        return -1;
+    
+    _port = port;
+    _backlog = backlog;
+    return call(&TCPRawServer::do_listen);
+}
+
+int TCPRawServer::close(void) {
+    if (_listen == NULL)
+        return -1;
+    
+    return call(&TCPRawServer::do_close);
+}
+
+void TCPRawServer::do_listen(void *arg) {
+    TCPRawServer *server = (TCPRawServer *) arg;
+    struct tcp_pcb *pcb = tcp_new();
+    
+    if (pcb != NULL) {
+        if (tcp_bind(pcb, IP_ADDR_ANY, server->_port) == ERR_OK) {
+            server->_listen = tcp_listen_with_backlog(pcb, server->_backlog);
+        }
+        if (server->_listen == NULL) {
+            tcp_close(pcb);
+        } else {
+            tcp_arg(server->_listen, server);
+            tcp_accept(server->_listen, &TCPRawServer::accept_cb);
+            server->_result = 0;
+        }
+    }
+    sys_sem_signal(&server->_done);
+}
+
+void TCPRawServer::do_close(void *arg) {
+    TCPRawServer *server = (TCPRawServer *) arg;
+    
+    tcp_accept(server->_listen, NULL);
+    if (tcp_close(server->_listen) == ERR_OK) {
+        server->_listen = NULL;
+        server->_result = 0;
+    }
+    sys_sem_signal(&server->_done);
+}
+
+err_t TCPRawServer::accept_cb(void *arg, struct tcp_pcb *pcb, err_t err) {
+    TCPRawServer *server = (TCPRawServer *) arg;
+    TCPRawConnection *conn = NULL;
+    
+    tcp_accepted(server->_listen);
+    if (err != ERR_OK)
+        return err;
+    
+    for (int i = 0; i < TCP_RAW_CONNECTIONS; i++) {
+        if (server->_conns[i]._pcb == NULL) {
+            conn = &server->_conns[i];
+            break;
+        }
+    }
+    // returning an error makes the stack abort the new connection
+    if (conn == NULL)
+        return ERR_MEM;
+    
+    conn->_pcb = pcb;
+    conn->_closing = false;
+    conn->_peerClosed = false;
+    conn->_polls = 0;
+    if (!server->onAccept(conn)) {
+        conn->_pcb = NULL;
+        return ERR_MEM;
+    }
+    
+    tcp_arg(pcb, conn);
+    tcp_recv(pcb, &TCPRawServer::recv_cb);
+    tcp_sent(pcb, &TCPRawServer::sent_cb);
+    tcp_poll(pcb, &TCPRawServer::poll_cb, TCP_RAW_POLL);
+    tcp_err(pcb, &TCPRawServer::err_cb);
+    return ERR_OK;
+}
+
+err_t TCPRawServer::recv_cb(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err) {
+    TCPRawConnection *conn = (TCPRawConnection *) arg;
+    
+    if (p == NULL) {
+        // the peer closed its side, ours stays open until the handler closes it
+        conn->_peerClosed = true;
+        if (!conn->_closing)
+            conn->_server->onPeerClose(conn);
+        return ERR_OK;
+    }
+    
+    // the window is opened before the handler runs, the handler may close pcb
+    tcp_recved(pcb, p->tot_len);
+    if (!conn->_closing)
+        conn->_server->onReceive(conn, p);
+    pbuf_free(p);
+    return ERR_OK;
+}
+
+err_t TCPRawServer::sent_cb(void *arg, struct tcp_pcb *pcb, u16_t len) {
+    TCPRawConnection *conn = (TCPRawConnection *) arg;
+    
+    if (!conn->_closing) {
+        conn->_server->onSent(conn, len);
+    } else if (pcb->unsent == NULL && pcb->unacked == NULL) {
+        return conn->_server->shut(conn);
+    }
+    return ERR_OK;
+}
+
+err_t TCPRawServer::poll_cb(void *arg, struct tcp_pcb *pcb) {
+    TCPRawConnection *conn = (TCPRawConnection *) arg;
+    
+    if (!conn->_closing)
+        return ERR_OK;
+    
+    if (pcb->unsent == NULL && pcb->unacked == NULL)
+        return conn->_server->shut(conn);
+    
+    if (++conn->_polls > TCP_RAW_CLOSE_POLLS) {
+        // the peer stopped acknowledging, drop the connection
+        tcp_arg(pcb, NULL);
+        tcp_abort(pcb);
+        conn->_pcb = NULL;
+        conn->_server->release(conn);
+        return ERR_ABRT;
+    }
+    return ERR_OK;
+}
+
+void TCPRawServer::err_cb(void *arg, err_t err) {
+    TCPRawConnection *conn = (TCPRawConnection *) arg;
+    
+    if (conn == NULL)
+        return;
+    
+    // the pcb is already freed by the stack
+    conn->_pcb = NULL;
+    conn->_server->release(conn);
+}
+
+// close the pcb, retried from poll_cb if the stack is short of memory
+err_t TCPRawServer::shut(TCPRawConnection *conn) {
+    struct tcp_pcb *pcb = conn->_pcb;
+    
+    tcp_recv(pcb, NULL);
+    tcp_sent(pcb, NULL);
+    if (tcp_close(pcb) != ERR_OK) {
+        tcp_recv(pcb, &TCPRawServer::recv_cb);
+        tcp_sent(pcb, &TCPRawServer::sent_cb);
+        return ERR_OK;
+    }
+    tcp_poll(pcb, NULL, 0);
+    tcp_err(pcb, NULL);
+    tcp_arg(pcb, NULL);
+    conn->_pcb = NULL;
+    release(conn);
+    return ERR_OK;
+}
+
+void TCPRawServer::release(TCPRawConnection *conn) {
+    onClose(conn);
+    conn->_closing = false;
+}
+
+TCPRawServer::~TCPRawServer() {
+    if (_listen != NULL)
+        close();
+    sys_sem_free(&_done);
+}
@@ -0,0 +1,147 @@
+/* Copyright (C) 2012 mbed.org, MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef TCPRAWSERVER_H
+#define TCPRAWSERVER_H
+
+#include "lwip/tcp.h"
+
+/** Connections served at the same time, one per TCP PCB */
+#define TCP_RAW_CONNECTIONS     MEMP_NUM_TCP_PCB
+
+class TCPRawServer;
+
+/** Connection accepted by a TCPRawServer.
+ *
+ * The methods may only be called from the TCPRawServer handlers, which run
+ * in the tcpip thread.
+ */
+class TCPRawConnection {
+  public:
+    /** Queue data for sending, the stack sends it when the handler returns.
+    \param data   The data to send.
+    \param length The length of the data.
+    \param copy   false : the data is referenced, not copied. It has to stay
+                  unchanged until onSent() reports it acknowledged, which
+                  suits const and flash data [Default: false].
+    \return number of bytes queued, 0 if the send buffer is full.
+    */
+    int send(const void *data, int length, bool copy=false);
+    
+    /** Room in the send buffer.
+    \return number of bytes send() can queue.
+    */
+    int sendSpace(void);
+    
+    /** Close the connection once all queued data is acknowledged.
+    */
+    void close(void);
+    
+    /** Index of the connection, from 0 to TCP_RAW_CONNECTIONS-1.
+    */
+    int id(void) {return _id;}
+    
+    /** The peer closed its side, it sends nothing more.
+    */
+    bool peerClosed(void) {return _peerClosed;}
+    
+  private:
+    friend class TCPRawServer;
+    
+    TCPRawServer *_server;
+    struct tcp_pcb *_pcb;
+    int _id;
+    bool _closing;
+    bool _peerClosed;
+    int _polls;
+};
+
+/** TCP server on the lwIP raw API.
+ *
+ * Unlike TCPSocketServer there is no socket, netconn or mailbox between the
+ * stack and the application: the handlers are called in the tcpip thread
+ * with the received pbuf chain, and the answer is queued in place.
+ * Handlers must not block for long, the whole stack waits for them.
+ */
+class TCPRawServer {
+  public:
+    TCPRawServer();
+    
+    /** Start listening for incoming connections.
+    \param port    The port to listen on.
+    \param backlog ignored unless TCP_LISTEN_BACKLOG is enabled [Default: 1].
+    \return 0 on success, -1 on failure.
+    */
+    int listen(int port, int backlog=1);
+    
+    /** Stop accepting connections, open connections are served to the end.
+    \return 0 on success, -1 on failure.
+    */
+    int close(void);
+    
+    virtual ~TCPRawServer();
+    
+  protected:
+    /** A connection was accepted.
+    \return false to refuse the connection.
+    */
+    virtual bool onAccept(TCPRawConnection *conn) {return true;}
+    
+    /** Data was received.
+    \param p The received chain, freed when the handler returns.
+    */
+    virtual void onReceive(TCPRawConnection *conn, struct pbuf *p) = 0;
+    
+    /** The peer acknowledged sent data.
+    \param length number of bytes acknowledged.
+    */
+    virtual void onSent(TCPRawConnection *conn, int length) {}
+    
+    /** The peer closed its side, data can still be sent. The default
+        closes the connection, servers that answer after the request
+        was half-closed (e.g. curl --no-keepalive, nc -q) override it.
+    */
+    virtual void onPeerClose(TCPRawConnection *conn) {conn->close();}
+    
+    /** The connection is closed or reset, conn is free for the next accept.
+    */
+    virtual void onClose(TCPRawConnection *conn) {}
+    
+  private:
+    friend class TCPRawConnection;
+    
+    static void do_listen(void *arg);
+    static void do_close(void *arg);
+    static err_t accept_cb(void *arg, struct tcp_pcb *pcb, err_t err);
+    static err_t recv_cb(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err);
+    static err_t sent_cb(void *arg, struct tcp_pcb *pcb, u16_t len);
+    static err_t poll_cb(void *arg, struct tcp_pcb *pcb);
+    static void err_cb(void *arg, err_t err);
+    
+    void release(TCPRawConnection *conn);
+    err_t shut(TCPRawConnection *conn);
+    int call(void (*fn)(void *));
+    
+    struct tcp_pcb *_listen;
+    TCPRawConnection _conns[TCP_RAW_CONNECTIONS];
+    int _port;
+    int _backlog;
+    int _result;
+    sys_sem_t _done;
+};
+
+#endif
@@ -105,6 +105,27 @@ int TCPSocketConnection::receive(char* data, int length) {
     return n;
 }
 
+// takes the data straight out of the sector buffer of the file
+static size_t sendfile_stream(void* ctx, const void* data, size_t length) {
+    TCPSocketConnection* conn = (TCPSocketConnection*) ctx;
+    
+    if (data == NULL)
+        return conn->is_connected() ? 1 : 0;
+    
+    int n = conn->send_all((char*) data, length);
+    return (n > 0) ? n : 0;
+}
+
+int sendfile(mbed::FileHandle* file, TCPSocketConnection& conn, off_t offset, size_t length) {
+    if (!conn.is_connected())
+        return -1;
+    
+    if (file->lseek(offset, SEEK_SET) != offset)
+        return -1;
+    
+    return file->forward(&sendfile_stream, &conn, length);
+}
+
 // -1 if unsuccessful, else number of bytes received
 int TCPSocketConnection::receive_all(char* data, int length) {
     if ((_sock_fd < 0) || !_is_connected)
@@ -21,6 +21,7 @@
 
 #include "Socket/Socket.h"
 #include "Socket/Endpoint.h"
+#include "FileHandle.h"
 
 /**
 TCP socket connection
@@ -78,4 +79,16 @@ private:
 
 };
 
+/** Send part of a file to the remote host.
+The data goes to the stack from the buffer the file system read it into, see
+FileHandle::forward(), so no buffer of the caller is needed. The file
+position is left after the last byte sent.
+\param file The file to send from, as returned by FileSystemLike::open().
+\param conn The connected socket.
+\param offset The position of the first byte to send.
+\param length The number of bytes to send, less if the file ends before.
+\return the number of sent bytes on success (>=0) or -1 on failure
+*/
+int sendfile(mbed::FileHandle* file, TCPSocketConnection& conn, off_t offset, size_t length);
+
 #endif
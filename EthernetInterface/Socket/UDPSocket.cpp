@@ -23,6 +23,9 @@
 using std::memset;
 
 UDPSocket::UDPSocket() {
+#if LWIP_SOCKET_BATCH
+    _batch_busy = false;
+#endif
 }
 
 int UDPSocket::init(void) {
@@ -92,3 +95,96 @@ int UDPSocket::receiveFrom(Endpoint &remote, char *buffer, int length) {
     socklen_t remoteHostLen = sizeof(remote._remoteHost);
     return lwip_recvfrom(_sock_fd, buffer, length, 0, (struct sockaddr*) &remote._remoteHost, &remoteHostLen);
 }
+
+#if LWIP_SOCKET_BATCH
+// called by the stack once every packet of the batch was sent and released
+void UDPSocket::batch_done(struct lwip_mmsg_batch *batch) {
+    UDPSocket *socket = (UDPSocket *) batch->arg;
+    void (*done)(void *arg) = socket->_batch_done;
+    void *arg = socket->_batch_arg;
+    osThreadId thread = socket->_batch_thread;
+    
+    for (int i = 0; i < socket->_batch_count; i++)
+        socket->_batch_msgs[i].result = socket->_batch_msgs[i].mmsg.result;
+    
+    // done may already queue the next batch
+    socket->_batch_busy = false;
+    if (done != NULL)
+        done(arg);
+    else
+        osSignalSet(thread, UDPSOCKET_BATCH_SIGNAL);
+}
+
+// -1 if unsuccessful, else number of packets sent or queued
+int UDPSocket::sendBatch(UDPMessage *msgs, int count, void (*done)(void *arg), void *arg) {
+    if (_sock_fd < 0 || count <= 0 || _batch_busy)
+        return -1;
+    
+    for (int i = 0; i < count; i++) {
+        // largest UDP payload in an IPv4 datagram
+        if (msgs[i].remote == NULL || msgs[i].length < 0 || msgs[i].length > 65507)
+            return -1;
+        
+        struct lwip_mmsg *m = &msgs[i].mmsg;
+        m->next = (i + 1 < count) ? &msgs[i + 1].mmsg : NULL;
+        m->data = msgs[i].buffer;
+        m->len = msgs[i].length;
+        m->addr = &msgs[i].remote->_remoteHost;
+        msgs[i].result = -1;
+    }
+    
+    _batch.msgs = &msgs[0].mmsg;
+    _batch.done = batch_done;
+    _batch.arg = this;
+    _batch_msgs = msgs;
+    _batch_count = count;
+    _batch_done = done;
+    _batch_arg = arg;
+    _batch_thread = osThreadGetId();
+    _batch_busy = true;
+    if (done == NULL)
+        osSignalClear(_batch_thread, UDPSOCKET_BATCH_SIGNAL);
+    
+    if (lwip_sendmmsg(_sock_fd, &_batch) < 0) {
+        _batch_busy = false;
+        return -1;
+    }
+    if (done != NULL)
+        return count;
+    
+    osSignalWait(UDPSOCKET_BATCH_SIGNAL, osWaitForever);
+    int sent = 0;
+    for (int i = 0; i < count; i++) {
+        if (msgs[i].result >= 0)
+            sent++;
+    }
+    return sent;
+}
+#endif
+
+// -1 if unsuccessful, else number of packets received
+int UDPSocket::receiveBatch(UDPMessage *msgs, int count) {
+    if (_sock_fd < 0)
+        return -1;
+    
+    if (!_blocking) {
+        TimeInterval timeout(_timeout);
+        if (wait_readable(timeout) != 0)
+            return 0;
+    }
+    
+    int n;
+    for (n = 0; n < count; n++) {
+        Endpoint *remote = msgs[n].remote;
+        if (remote == NULL)
+            break;
+        remote->reset_address();
+        socklen_t remoteHostLen = sizeof(remote->_remoteHost);
+        // only the first packet may block, the others have to be queued already
+        msgs[n].result = lwip_recvfrom(_sock_fd, msgs[n].buffer, msgs[n].length, (n == 0) ? 0 : MSG_DONTWAIT,
+                                       (struct sockaddr*) &remote->_remoteHost, &remoteHostLen);
+        if (msgs[n].result < 0)
+            break;
+    }
+    return (n == 0 && count > 0) ? -1 : n;
+}
@@ -21,6 +21,22 @@
 
 #include "Socket/Socket.h"
 #include "Socket/Endpoint.h"
+#include "cmsis_os.h"
+
+/** Signal set on a thread waiting in UDPSocket::sendBatch() */
+#define UDPSOCKET_BATCH_SIGNAL  0x2000
+
+/** One packet of UDPSocket::sendBatch() or UDPSocket::receiveBatch()
+*/
+struct UDPMessage {
+    Endpoint *remote;   ///< destination of a send, source of a receive
+    char *buffer;       ///< packet to send or buffer to receive into
+    int length;         ///< length of the packet or of the buffer
+    int result;         ///< bytes sent or received, -1 on failure
+#if LWIP_SOCKET_BATCH
+    struct lwip_mmsg mmsg;  ///< used by the stack while a send is queued
+#endif
+};
 
 /**
 UDP Socket
@@ -70,6 +86,41 @@ public:
     \return the number of received bytes on success (>=0) or -1 on failure
     */
     int receiveFrom(Endpoint &remote, char *buffer, int length);
+    
+#if LWIP_SOCKET_BATCH
+    /** Send several packets with a single message to the network stack.
+        The packets are referenced, not copied: the buffers must not change
+        until the batch is done. One batch at a time per socket.
+    \param msgs     The packets, result is set for each one
+    \param count    The number of packets
+    \param done     Called from a network stack thread once the stack no longer
+           uses the buffers. NULL to wait for that before returning
+    \param arg      The argument passed to done
+    \return the number of packets sent (done == NULL) or queued, -1 on failure
+    */
+    int sendBatch(UDPMessage *msgs, int count, void (*done)(void *arg)=NULL, void *arg=NULL);
+#endif
+    
+    /** Receive several packets: waits like receiveFrom() for the first one,
+        then takes the packets that are already queued without waiting again
+    \param msgs     The buffers and endpoints, result is set for each packet received
+    \param count    The number of buffers
+    \return the number of received packets on success (>=0) or -1 on failure
+    */
+    int receiveBatch(UDPMessage *msgs, int count);
+
+#if LWIP_SOCKET_BATCH
+private:
+    static void batch_done(struct lwip_mmsg_batch *batch);
+    
+    struct lwip_mmsg_batch _batch;
+    UDPMessage *_batch_msgs;
+    int _batch_count;
+    void (*_batch_done)(void *arg);
+    void *_batch_arg;
+    osThreadId _batch_thread;
+    volatile bool _batch_busy;
+#endif
 };
 
 #endif
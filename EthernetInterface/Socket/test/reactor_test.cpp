@@ -0,0 +1,177 @@
+/* Host test of the socket reactor
+ *
+ * Builds and runs on the host, without the mbed tree:
+ *
+ *   g++ -DLWIP_TIMEVAL_PRIVATE=0 -I../.. -I../../lwip -I../../lwip/include -I../../lwip/include/ipv4 \
+ *       -I../../lwip-sys -I../../lwip-sys/arch -I../../../mbed-rtos/rtx/TARGET_CORTEX_M \
+ *       -I../../../mbed-src/targets/cmsis -I../../../mbed-src/targets/cmsis/TARGET_NXP/TARGET_LPC176X \
+ *       -I../../lwip-eth/arch/TARGET_NXP -I../../lwip/test/stub -DTARGET_LPC1768 \
+ *       reactor_test.cpp -o reactor_test && ./reactor_test
+ *
+ * Registers sockets whose state is set here instead of by lwIP, raises
+ * events through the hook the reactor gave to lwip_sockevent() and checks
+ * which handlers poll() calls with which events: each socket once per
+ * event, masked by what it asked for, none without an event, none for a
+ * removed socket or a socket number reused by another socket, and
+ * CLOSED when lwIP no longer knows the socket.
+ */
+#include "../SocketReactor.cpp"
+
+#include <stdio.h>
+
+static int failures;
+
+// What the reactor uses from sockets.c and RTX
+static int state[MEMP_NUM_NETCONN];
+static void (*hook_fn[MEMP_NUM_NETCONN])(int s, void *arg);
+static void *hook_arg[MEMP_NUM_NETCONN];
+static int signals, waits;
+static osThreadId self = (osThreadId)&signals;
+
+sys_prot_t sys_arch_protect(void) { return 0; }
+void sys_arch_unprotect(sys_prot_t pval) {}
+osThreadId osThreadGetId(void) { return self; }
+int32_t osSignalSet(osThreadId thread_id, int32_t signals_) { signals++; return 0; }
+osEvent osSignalWait(int32_t signals_, uint32_t millisec) { osEvent e = { osEventTimeout }; waits++; return e; }
+
+int lwip_sockevent(int s, void (*fn)(int s, void *arg), void *arg)
+{
+    if (s < 0 || s >= MEMP_NUM_NETCONN || state[s] < 0)
+        return -1;
+    hook_fn[s] = fn;
+    hook_arg[s] = arg;
+    return 0;
+}
+
+int lwip_sockstate(int s)
+{
+    return state[s];
+}
+
+Socket::Socket() : _sock_fd(-1), _blocking(true), _timeout(1500) {}
+Socket::~Socket() {}
+
+class TestSocket : public Socket {
+public:
+    TestSocket(int s) { _sock_fd = s; }
+    void reopen(int s) { _sock_fd = s; }
+};
+
+// Calls seen by the handler
+static Socket *handled[MEMP_NUM_NETCONN];
+static int handled_events[MEMP_NUM_NETCONN];
+static void *handled_arg;
+
+static void handler(Socket *socket, int events, void *arg)
+{
+    for (int s = 0; s < MEMP_NUM_NETCONN; s++) {
+        if (handled[s] == NULL) {
+            handled[s] = socket;
+            handled_events[s] = events;
+            break;
+        }
+    }
+    handled_arg = arg;
+}
+
+static void check(bool ok, const char *what)
+{
+    printf("%s: %s\n", ok ? "ok" : "FAIL", what);
+    if (!ok)
+        failures++;
+}
+
+// An event of socket s, as event_callback() in sockets.c reports it
+static void raise(int s, int new_state)
+{
+    state[s] = new_state;
+    if (hook_fn[s] != NULL)
+        hook_fn[s](s, hook_arg[s]);
+}
+
+static int poll(SocketReactor &reactor)
+{
+    memset(handled, 0, sizeof(handled));
+    memset(handled_events, 0, sizeof(handled_events));
+    return reactor.poll(0);
+}
+
+static void events(void)
+{
+    SocketReactor reactor;
+    TestSocket a(1), b(2), c(-1);
+    int arg;
+
+    state[1] = LWIP_SOCK_WRITABLE;
+    state[2] = 0;
+    check(reactor.add(&a, SocketReactor::READABLE | SocketReactor::WRITABLE, handler, &arg) == 0 &&
+          reactor.add(&b, SocketReactor::READABLE, handler) == 0, "added");
+    check(reactor.add(&c, SocketReactor::READABLE, handler) == -1, "closed socket refused");
+    check(hook_fn[1] != NULL && hook_fn[2] != NULL, "hooks set");
+
+    check(poll(reactor) == 1 && handled[0] == &a && handled_events[0] == SocketReactor::WRITABLE &&
+          handled_arg == &arg, "current state reported after add");
+    waits = 0;
+    check(poll(reactor) == 0 && waits == 1, "nothing without an event, waited");
+
+    signals = 0;
+    raise(2, LWIP_SOCK_READABLE | LWIP_SOCK_WRITABLE);
+    check(signals == 1, "polling thread signalled");
+    waits = 0;
+    check(poll(reactor) == 1 && handled[0] == &b && handled_events[0] == SocketReactor::READABLE && waits == 0,
+          "event reported without waiting, masked");
+    raise(2, LWIP_SOCK_WRITABLE);
+    check(poll(reactor) == 0, "event reported only if asked for");
+
+    raise(1, LWIP_SOCK_READABLE | LWIP_SOCK_WRITABLE);
+    raise(2, LWIP_SOCK_ERROR);
+    check(poll(reactor) == 2 && handled[0] == &a && handled[1] == &b &&
+          handled_events[0] == (SocketReactor::READABLE | SocketReactor::WRITABLE) &&
+          handled_events[1] == SocketReactor::CLOSED, "two sockets in one poll, CLOSED always reported");
+
+    check(reactor.modify(&a, SocketReactor::READABLE) == 0 && poll(reactor) == 1 &&
+          handled_events[0] == SocketReactor::READABLE, "modify reports the current state");
+
+    raise(2, -1);
+    check(poll(reactor) == 1 && handled[0] == &b && handled_events[0] == SocketReactor::CLOSED,
+          "socket lwIP no longer knows reported CLOSED");
+
+    state[2] = 0;
+    raise(2, LWIP_SOCK_READABLE);
+    check(reactor.remove(&b) == 0 && hook_fn[2] == NULL, "removed");
+    check(poll(reactor) == 0, "pending event of a removed socket dropped");
+    check(reactor.remove(&b) == -1 && reactor.modify(&b, SocketReactor::READABLE) == -1, "removed twice refused");
+
+    // a has been closed without remove() and its number given to d
+    raise(1, LWIP_SOCK_READABLE);
+    a.reopen(-1);
+    TestSocket d(1);
+    check(poll(reactor) == 0, "reused socket number not reported to the closed socket");
+    check(reactor.add(&d, SocketReactor::READABLE, handler) == 0 && poll(reactor) == 1 && handled[0] == &d,
+          "new socket on the number reported");
+    state[1] = 0;
+}
+
+static void destroy(void)
+{
+    TestSocket a(0), b(3);
+
+    state[0] = state[3] = 0;
+    {
+        SocketReactor reactor;
+        reactor.add(&a, SocketReactor::READABLE, handler);
+        reactor.add(&b, SocketReactor::READABLE, handler);
+        b.reopen(-1);
+    }
+    check(hook_fn[0] == NULL, "hooks removed with the reactor");
+    check(hook_fn[3] != NULL, "hook of a reused socket number left alone");
+}
+
+int main()
+{
+    events();
+    destroy();
+
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
@@ -30,6 +30,7 @@
 #include "lwip/pbuf.h"
 #include "lwip/stats.h"
 #include "lwip/snmp.h"
+#include "lwip/igmp.h"
 #include "netif/etharp.h"
 #include "netif/ppp_oe.h"
 
@@ -132,6 +133,9 @@ struct lpc_enetdata {
 	sys_mutex_t TXLockMutex; /**< TX critical section mutex */
 	sys_sem_t xTXDCountSem; /**< TX free buffer counting semaphore */
 #endif
+#if LWIP_IGMP
+	u8_t mcast_refs[64]; /**< Joined groups per multicast hash filter bit */
+#endif
 };
 
 #if defined(TARGET_LPC4088) || defined(TARGET_LPC4088_DM)
@@ -877,7 +881,14 @@ static err_t low_level_init(struct netif *netif)
 		return ERR_BUF;
 
 	/* Enable packet reception */
-#if IP_SOF_BROADCAST_RECV
+#if IP_SOF_BROADCAST_RECV && LWIP_IGMP
+	/* Multicast frames only pass for the groups igmp.c joined through
+	   lpc_igmp_mac_filter(), everything else is dropped by the EMAC */
+	LPC_EMAC->HashFilterL = 0;
+	LPC_EMAC->HashFilterH = 0;
+	memset(lpc_enetdata.mcast_refs, 0, sizeof(lpc_enetdata.mcast_refs));
+	LPC_EMAC->RxFilterCtrl = EMAC_RFC_PERFECT_EN | EMAC_RFC_BCAST_EN | EMAC_RFC_MCAST_HASH_EN;
+#elif IP_SOF_BROADCAST_RECV
 	LPC_EMAC->RxFilterCtrl = EMAC_RFC_PERFECT_EN | EMAC_RFC_BCAST_EN | EMAC_RFC_MCAST_EN;
 #else
 	LPC_EMAC->RxFilterCtrl = EMAC_RFC_PERFECT_EN;
@@ -938,6 +949,74 @@ err_t lpc_etharp_output(struct netif *netif, struct pbuf *q,
 	return ERR_CONN;
 }
 
+#if LWIP_IGMP
+/**
+ * Index of a destination MAC address in the EMAC hash filter: bits 28..23
+ * of the CRC-32 the EMAC computes over the address, data bits taken LSB
+ * first.
+ *
+ * \param[in] addr destination MAC address
+ * \return bit number 0..63 in HashFilterH:HashFilterL
+ */
+static u32_t lpc_mac_hash(const u8_t *addr)
+{
+	u32_t crc = 0xFFFFFFFF;
+	u32_t i, bit, byte;
+
+	for (i = 0; i < ETHARP_HWADDR_LEN; i++) {
+		byte = addr[i];
+		for (bit = 0; bit < 8; bit++, byte >>= 1) {
+			if (((crc >> 31) ^ byte) & 1)
+				crc = (crc << 1) ^ 0x04C11DB7;
+			else
+				crc <<= 1;
+		}
+	}
+	return (crc >> 23) & 0x3F;
+}
+
+/**
+ * Adds or removes a multicast group in the EMAC hash filter. Called by
+ * igmp.c on the first join and the last leave of a group. Groups can
+ * share a filter bit, so every bit counts its groups and is only cleared
+ * when the last one is gone.
+ *
+ * \param[in] netif the lwip network interface structure for this lpc_enetif
+ * \param[in] group multicast group address
+ * \param[in] action IGMP_ADD_MAC_FILTER or IGMP_DEL_MAC_FILTER
+ * \return ERR_OK
+ */
+static err_t lpc_igmp_mac_filter(struct netif *netif, ip_addr_t *group,
+	u8_t action)
+{
+	struct lpc_enetdata *lpc_enetif = netif->state;
+	u8_t mac[ETHARP_HWADDR_LEN];
+	u32_t index;
+	volatile uint32_t *reg;
+
+	/* 01:00:5e followed by the low 23 bits of the group (RFC 1112) */
+	mac[0] = 0x01;
+	mac[1] = 0x00;
+	mac[2] = 0x5e;
+	mac[3] = ip4_addr2(group) & 0x7f;
+	mac[4] = ip4_addr3(group);
+	mac[5] = ip4_addr4(group);
+
+	index = lpc_mac_hash(mac);
+	reg = (index > 31) ? &LPC_EMAC->HashFilterH : &LPC_EMAC->HashFilterL;
+
+	if (action == IGMP_ADD_MAC_FILTER) {
+		if (lpc_enetif->mcast_refs[index]++ == 0)
+			*reg |= 1UL << (index & 31);
+	} else if (lpc_enetif->mcast_refs[index] > 0) {
+		if (--lpc_enetif->mcast_refs[index] == 0)
+			*reg &= ~(1UL << (index & 31));
+	}
+
+	return ERR_OK;
+}
+#endif /* LWIP_IGMP */
+
 #if NO_SYS == 0
 /* periodic PHY status update */
 void phy_update(void const *nif) {
@@ -1000,6 +1079,9 @@ err_t eth_arch_enetif_init(struct netif *netif)
 
 	netif->output = lpc_etharp_output;
 	netif->linkoutput = lpc_low_level_output;
+#if LWIP_IGMP
+	netif->igmp_mac_filter = lpc_igmp_mac_filter;
+#endif
 
     /* CMSIS-RTOS, start tasks */
 #if NO_SYS == 0
@@ -25,6 +25,16 @@
 #define MEM_SIZE                      15360
 #elif defined(TARGET_LPC1768)
 #define MEM_SIZE                      16362
+/* The 16 KB of AHBSRAM0 as size classes (4 byte header each):
+ * 80   : TCP headers alone, i.e. pbuf_alloc(PBUF_IP, TCP_HLEN) for ACK, SYN
+ *        and RST and the headers of segments written without copy: 16 byte
+ *        pbuf + 34 link and IP + 20 TCP = 72, 76 with the MSS option. ARP
+ * 256  : DNS, short TCP segments
+ * 640  : DHCP, medium TCP segments
+ * 1552 : EMAC receive buffers (3 held by the driver), full TCP segments
+ * Tune the numbers with the "netmem" shell command. */
+#define MEM_SIZE_CLASSES              1
+#define MEM_SIZE_CLASS_LIST(CLASS)    CLASS(80, 32) CLASS(256, 9) CLASS(640, 3) CLASS(1552, 6)
 #endif
 
 #endif
@@ -123,4 +123,114 @@ __attribute__((naked)) void /*uint16_t*/ thumb2_checksum(const void* pData, int
     );
 }
 
+
+/* Same summation as thumb2_checksum() but every word that is loaded from
+   pSource is also stored to pDest, so a copy with checksum (LWIP_CHKSUM_COPY)
+   reads the data only once instead of once in thumb2_memcpy() and again in
+   thumb2_checksum().  Alignment is done on pSource, stores to pDest may be
+   unaligned which the Cortex-M3 handles for STR and STRH.
+   
+   Returns:
+        16-bit 1's complement summation (not inversed) of the copied data.
+        
+   NOTE: Marked as void for the same reason as thumb2_checksum().
+*/
+__attribute__((naked)) void /*uint16_t*/ thumb2_checksum_copy(void* pDest, const void* pSource, int length)
+{
+    __asm (
+        ".syntax unified\n"
+        ".thumb\n"
+
+        // Push non-volatile registers we use on stack, four registers keep the
+        // stack 8-byte aligned.
+        "    push        {r4, r5, r6, lr}\n"
+        // Initialize sum, r3, to 0.
+        "    movs    r3, #0\n"
+        // Remember whether pSource was at odd address in r5.
+        "    ands    r5, r1, #1\n"
+        // Need to 2-byte align?  If not skip ahead.
+        "    beq     1$\n"
+        // We can return if there are no bytes to copy.
+        "    cmp     r2, #0\n"
+        "    beq     9$\n"
+
+        // 2-byte align.
+        // Copy the first data byte and place it in odd summation location since
+        // it needs to be swapped later.
+        "    ldrb    r3, [r1], #1\n"
+        "    strb    r3, [r0], #1\n"
+        "    lsls    r3, r3, #8\n"
+        "    subs    r2, r2, #1\n"
+
+        // Need to 4-byte align?  If not skip ahead.
+        "1$:\n"
+        "    ands    r4, r1, #3\n"
+        "    beq     2$\n"
+        // Have more than 1 byte left to align?  If not skip ahead to take care of
+        // trailing byte.
+        "    cmp     r2, #2\n"
+        "    blt     7$\n"
+
+        // 4-byte align.
+        "    ldrh    r4, [r1], #2\n"
+        "    strh    r4, [r0], #2\n"
+        "    adds    r3, r3, r4\n"
+        "    subs    r2, r2, #2\n"
+
+        // Main loop which copies and sums up data 2 words at a time.
+        // Make sure that we have more than 7 bytes left.
+        "2$:\n"
+        "    cmp     r2, #8\n"
+        "    blt     3$\n"
+        // Copy next two words and sum them, applying the carries to the
+        // lower 16-bits.
+        "    ldr     r4, [r1], #4\n"
+        "    ldr     r6, [r1], #4\n"
+        "    str     r4, [r0], #4\n"
+        "    str     r6, [r0], #4\n"
+        "    adds    r3, r4\n"
+        "    adcs    r3, r6\n"
+        "    adc     r3, r3, #0\n"
+        "    subs    r2, r2, #8\n"
+        "    b       2$\n"
+
+        // Copy and sum up any remaining half-words.
+        "3$:\n"
+        // Make sure that we have more than 1 byte left.
+        "    cmp     r2, #2\n"
+        "    blt     7$\n"
+        "    ldrh    r4, [r1], #2\n"
+        "    strh    r4, [r0], #2\n"
+        "    adds    r3, r4\n"
+        "    adc     r3, r3, #0\n"
+        "    subs    r2, r2, #2\n"
+        "    b       3$\n"
+
+        // Handle trailing byte, if it exists
+        "7$:\n"
+        "    cbz     r2, 8$\n"
+        "    ldrb    r4, [r1]\n"
+        "    strb    r4, [r0]\n"
+        "    adds    r3, r4\n"
+        "    adc     r3, r3, #0\n"
+
+        // Fold 32-bit checksum into 16-bit checksum.
+        "8$:\n"
+        "    ubfx    r4, r3, #16, #16\n"
+        "    ubfx    r3, r3, #0, #16\n"
+        "    adds    r3, r4\n"
+        "    ubfx    r4, r3, #16, #16\n"
+        "    ubfx    r3, r3, #0, #16\n"
+        "    adds    r3, r4\n"
+
+        // Swap bytes if started at odd address
+        "    cbz     r5, 9$\n"
+        "    rev16   r3, r3\n"
+
+        // Return final sum.
+        "9$: mov     r0, r3\n"
+        "    pop     {r4, r5, r6, pc}\n"
+    );
+}
+
 #endif
@@ -80,6 +80,12 @@ struct lwip_sock {
   int err;
   /** counter of how many threads are waiting for this socket using select */
   int select_waiting;
+#if LWIP_SOCKET_EVENT_HOOK
+  /** function called by event_callback(), set by lwip_sockevent() */
+  lwip_sockevent_fn evt_fn;
+  /** argument passed to evt_fn */
+  void *evt_arg;
+#endif /* LWIP_SOCKET_EVENT_HOOK */
 };
 
 /** Description for a task waiting in select */
@@ -263,6 +269,10 @@ alloc_socket(struct netconn *newconn, int accepted)
       sockets[i].errevent   = 0;
       sockets[i].err        = 0;
       sockets[i].select_waiting = 0;
+#if LWIP_SOCKET_EVENT_HOOK
+      sockets[i].evt_fn     = NULL;
+      sockets[i].evt_arg    = NULL;
+#endif /* LWIP_SOCKET_EVENT_HOOK */
       return i;
     }
     SYS_ARCH_UNPROTECT(lev);
@@ -290,6 +300,10 @@ free_socket(struct lwip_sock *sock, int is_tcp)
   /* Protect socket array */
   SYS_ARCH_PROTECT(lev);
   sock->conn       = NULL;
+#if LWIP_SOCKET_EVENT_HOOK
+  sock->evt_fn     = NULL;
+  sock->evt_arg    = NULL;
+#endif /* LWIP_SOCKET_EVENT_HOOK */
   SYS_ARCH_UNPROTECT(lev);
   /* don't use 'sock' after this line, as another task might have allocated it */
 
@@ -1293,6 +1307,12 @@ event_callback(struct netconn *conn, enum netconn_evt evt, u16_t len)
       break;
   }
 
+#if LWIP_SOCKET_EVENT_HOOK
+  if (sock->evt_fn != NULL) {
+    sock->evt_fn(s, sock->evt_arg);
+  }
+#endif /* LWIP_SOCKET_EVENT_HOOK */
+
   if (sock->select_waiting == 0) {
     /* noone is waiting for this socket, no need to check select_cb_list */
     SYS_ARCH_UNPROTECT(lev);
@@ -1346,6 +1366,180 @@ again:
   SYS_ARCH_UNPROTECT(lev);
 }
 
+#if LWIP_SOCKET_EVENT_HOOK
+/**
+ * Register a function that is called on every event of a socket. This
+ * lets one thread wait for many sockets without calling lwip_select().
+ *
+ * The function is called from event_callback() with SYS_ARCH protected,
+ * in the tcpip_thread or in the thread using the socket. It must not
+ * block and must not call socket functions. Use lwip_sockstate() to
+ * read the state of the socket later.
+ *
+ * @param s socket to watch
+ * @param fn function to call, NULL to stop watching
+ * @param arg argument passed to fn
+ * @return 0 on success, -1 if the socket is not valid
+ */
+int
+lwip_sockevent(int s, lwip_sockevent_fn fn, void *arg)
+{
+  struct lwip_sock *sock;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  sock = get_socket(s);
+  if (!sock) {
+    return -1;
+  }
+  SYS_ARCH_PROTECT(lev);
+  sock->evt_fn  = fn;
+  sock->evt_arg = arg;
+  SYS_ARCH_UNPROTECT(lev);
+  return 0;
+}
+
+/**
+ * Return the state of a socket as seen by select, without waiting.
+ *
+ * @param s socket to test
+ * @return LWIP_SOCK_READABLE, LWIP_SOCK_WRITABLE and LWIP_SOCK_ERROR
+ *         flags or -1 if the socket is not valid
+ */
+int
+lwip_sockstate(int s)
+{
+  struct lwip_sock *sock;
+  int state = 0;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  sock = get_socket(s);
+  if (!sock) {
+    return -1;
+  }
+  SYS_ARCH_PROTECT(lev);
+  if ((sock->lastdata != NULL) || (sock->rcvevent > 0)) {
+    state |= LWIP_SOCK_READABLE;
+  }
+  if (sock->sendevent != 0) {
+    state |= LWIP_SOCK_WRITABLE;
+  }
+  if (sock->errevent != 0) {
+    state |= LWIP_SOCK_ERROR;
+  }
+  SYS_ARCH_UNPROTECT(lev);
+  return state;
+}
+#endif /* LWIP_SOCKET_EVENT_HOOK */
+
+#if LWIP_SOCKET_BATCH
+/**
+ * Drops one reference to a batch and calls its done function for the last.
+ */
+static void
+lwip_mmsg_release(struct lwip_mmsg_batch *batch)
+{
+  int pending;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  SYS_ARCH_PROTECT(lev);
+  pending = --batch->pending;
+  SYS_ARCH_UNPROTECT(lev);
+  if (pending == 0) {
+    batch->done(batch);
+  }
+}
+
+/**
+ * Free function of the pbuf referencing a datagram of a batch. Called when
+ * udp_sendto() and the netif driver are done with the payload.
+ */
+static void
+lwip_mmsg_free(struct pbuf *p)
+{
+  struct lwip_mmsg *m = (struct lwip_mmsg *)p;
+
+  lwip_mmsg_release(m->batch);
+}
+
+/**
+ * Sends every datagram of a batch, runs in tcpip_thread context.
+ */
+static void
+lwip_sendmmsg_internal(void *arg)
+{
+  struct lwip_mmsg_batch *batch = (struct lwip_mmsg_batch *)arg;
+  struct udp_pcb *pcb = batch->conn->pcb.udp;
+  struct lwip_mmsg *m;
+  struct pbuf *p;
+  ip_addr_t remote_addr;
+  err_t err;
+
+  for (m = batch->msgs; m != NULL; m = m->next) {
+    p = pbuf_alloced_custom(PBUF_RAW, m->len, PBUF_REF, &m->ref, m->data, m->len);
+    if ((pcb == NULL) || (p == NULL)) {
+      lwip_mmsg_release(batch);
+      continue;
+    }
+    m->ref.custom_free_function = lwip_mmsg_free;
+    if (m->addr != NULL) {
+      inet_addr_to_ipaddr(&remote_addr, &m->addr->sin_addr);
+      err = udp_sendto(pcb, p, &remote_addr, ntohs(m->addr->sin_port));
+    } else {
+      err = udp_send(pcb, p);
+    }
+    if (err == ERR_OK) {
+      m->result = m->len;
+    }
+    /* the driver may still hold a reference, lwip_mmsg_free() follows
+       when it lets go */
+    pbuf_free(p);
+  }
+  lwip_mmsg_release(batch);
+}
+
+/**
+ * Queues a batch of UDP datagrams with a single tcpip_thread message.
+ * The payloads are referenced, not copied: they must stay unchanged until
+ * batch->done is called. Only one batch at a time may use a batch struct.
+ *
+ * @param s UDP socket to send on
+ * @param batch datagrams, done function and its argument
+ * @return 0 if the batch was queued, -1 on error (done is not called)
+ */
+int
+lwip_sendmmsg(int s, struct lwip_mmsg_batch *batch)
+{
+  struct lwip_sock *sock;
+  struct lwip_mmsg *m;
+
+  sock = get_socket(s);
+  if (!sock) {
+    return -1;
+  }
+  if (NETCONNTYPE_GROUP(sock->conn->type) != NETCONN_UDP) {
+    sock_set_errno(sock, err_to_errno(ERR_ARG));
+    return -1;
+  }
+
+  batch->conn = sock->conn;
+  /* one reference per datagram plus one held by lwip_sendmmsg_internal() */
+  batch->pending = 1;
+  for (m = batch->msgs; m != NULL; m = m->next) {
+    LWIP_ASSERT("lwip_sendmmsg: datagram too long", m->len <= 0xffff - UDP_HLEN);
+    m->result = -1;
+    m->batch = batch;
+    batch->pending++;
+  }
+
+  if (tcpip_callback(lwip_sendmmsg_internal, batch) != ERR_OK) {
+    sock_set_errno(sock, err_to_errno(ERR_MEM));
+    return -1;
+  }
+  sock_set_errno(sock, 0);
+  return 0;
+}
+#endif /* LWIP_SOCKET_BATCH */
+
 /**
  * Unimplemented: Close one end of a full-duplex connection.
  * Currently, the full connection is closed.
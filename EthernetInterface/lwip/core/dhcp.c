@@ -116,7 +116,12 @@
 #define DHCP_OPTION_IDX_SUBNET_MASK 6
 #define DHCP_OPTION_IDX_ROUTER      7
 #define DHCP_OPTION_IDX_DNS_SERVER	8
+#if LWIP_DHCP_RAPID_COMMIT
+#define DHCP_OPTION_IDX_RAPID_COMMIT (DHCP_OPTION_IDX_DNS_SERVER + DNS_MAX_SERVERS)
+#define DHCP_OPTION_IDX_MAX         (DHCP_OPTION_IDX_RAPID_COMMIT + 1)
+#else /* LWIP_DHCP_RAPID_COMMIT */
 #define DHCP_OPTION_IDX_MAX         (DHCP_OPTION_IDX_DNS_SERVER + DNS_MAX_SERVERS)
+#endif /* LWIP_DHCP_RAPID_COMMIT */
 
 /** Holds the decoded option values, only valid while in dhcp_recv.
     @todo: move this into struct dhcp? */
@@ -143,6 +148,7 @@ static err_t dhcp_decline(struct netif *netif);
 #endif /* DHCP_DOES_ARP_CHECK */
 static err_t dhcp_rebind(struct netif *netif);
 static err_t dhcp_reboot(struct netif *netif);
+static err_t dhcp_start_client(struct netif *netif);
 static void dhcp_set_state(struct dhcp *dhcp, u8_t new_state);
 
 /* receive, unfold, parse and free incoming messages */
@@ -223,7 +229,7 @@ dhcp_check(struct netif *netif)
     LWIP_DEBUGF(DHCP_DEBUG | LWIP_DBG_TRACE | LWIP_DBG_LEVEL_WARNING, ("dhcp_check: could not perform ARP query\n"));
   }
   dhcp->tries++;
-  msecs = 500;
+  msecs = DHCP_ARP_CHECK_MSECS;
   dhcp->request_timeout = (msecs + DHCP_FINE_TIMER_MSECS - 1) / DHCP_FINE_TIMER_MSECS;
   LWIP_DEBUGF(DHCP_DEBUG | LWIP_DBG_TRACE | LWIP_DBG_STATE, ("dhcp_check(): set request timeout %"U16_F" msecs\n", msecs));
 }
@@ -417,7 +423,7 @@ dhcp_timeout(struct netif *netif)
   /* received no ARP reply for the offered address (which is good) */
   } else if (dhcp->state == DHCP_CHECKING) {
     LWIP_DEBUGF(DHCP_DEBUG | LWIP_DBG_TRACE | LWIP_DBG_STATE, ("dhcp_timeout(): CHECKING, ARP request timed out\n"));
-    if (dhcp->tries <= 1) {
+    if (dhcp->tries < DHCP_ARP_CHECK_TRIES) {
       dhcp_check(netif);
     /* no ARP replies on the offered address,
        looks like the IP address is indeed free */
@@ -515,6 +521,12 @@ dhcp_handle_ack(struct netif *netif)
   ip_addr_set_zero(&dhcp->offered_si_addr);
 #endif /* LWIP_DHCP_BOOTP_FILE */
 
+  /* server identifier given? there was no OFFER after a reboot or a
+     rapid commit, so this is where we learn the server for renewals */
+  if (dhcp_option_given(dhcp, DHCP_OPTION_IDX_SERVER_ID)) {
+    ip4_addr_set_u32(&dhcp->server_ip_addr, htonl(dhcp_get_option_value(dhcp, DHCP_OPTION_IDX_SERVER_ID)));
+  }
+
   /* lease time given? */
   if (dhcp_option_given(dhcp, DHCP_OPTION_IDX_LEASE_TIME)) {
     /* remember offered lease time */
@@ -623,9 +635,72 @@ void dhcp_cleanup(struct netif *netif)
  */
 err_t
 dhcp_start(struct netif *netif)
+{
+  err_t result;
+
+  result = dhcp_start_client(netif);
+  if (result != ERR_OK) {
+    return result;
+  }
+  /* (re)start the DHCP negotiation */
+  result = dhcp_discover(netif);
+  if (result != ERR_OK) {
+    /* free resources allocated above */
+    dhcp_stop(netif);
+    return ERR_MEM;
+  }
+  /* Set the flag that says this netif is handled by DHCP. */
+  netif->flags |= NETIF_FLAG_DHCP;
+  return result;
+}
+
+/**
+ * Start DHCP in the INIT-REBOOT state (RFC 2131 3.2): instead of
+ * discovering a new lease, request the address leased before a reset.
+ * The server acknowledges it with a single round trip and the netif comes
+ * up without an ARP check, or it answers with a NAK and a normal discovery
+ * follows. Without any answer, discovery starts after REBOOT_TRIES requests.
+ *
+ * @param netif The lwIP network interface
+ * @param ipaddr address of the previous lease
+ * @return lwIP error code
+ * - ERR_OK - No error
+ * - ERR_MEM - Out of memory
+ */
+err_t
+dhcp_start_reboot(struct netif *netif, ip_addr_t *ipaddr)
+{
+  err_t result;
+
+  LWIP_ERROR("ipaddr != NULL", (ipaddr != NULL), return ERR_ARG;);
+  result = dhcp_start_client(netif);
+  if (result != ERR_OK) {
+    return result;
+  }
+  ip_addr_copy(netif->dhcp->offered_ip_addr, *ipaddr);
+  result = dhcp_reboot(netif);
+  if (result != ERR_OK) {
+    /* free resources allocated above */
+    dhcp_stop(netif);
+    return ERR_MEM;
+  }
+  /* Set the flag that says this netif is handled by DHCP. */
+  netif->flags |= NETIF_FLAG_DHCP;
+  return result;
+}
+
+/**
+ * Attach a DHCP client to a network interface, or reset the one already
+ * attached, and open its UDP pcb. Used by dhcp_start() and
+ * dhcp_start_reboot() before they send their first message.
+ *
+ * @param netif The lwIP network interface
+ * @return lwIP error code
+ */
+static err_t
+dhcp_start_client(struct netif *netif)
 {
   struct dhcp *dhcp;
-  err_t result = ERR_OK;
 
   LWIP_ERROR("netif != NULL", (netif != NULL), return ERR_ARG;);
   dhcp = netif->dhcp;
@@ -683,16 +758,7 @@ dhcp_start(struct netif *netif)
   /* set up the recv callback and argument */
   udp_recv(dhcp->pcb, dhcp_recv, netif);
   LWIP_DEBUGF(DHCP_DEBUG | LWIP_DBG_TRACE, ("dhcp_start(): starting DHCP configuration\n"));
-  /* (re)start the DHCP negotiation */
-  result = dhcp_discover(netif);
-  if (result != ERR_OK) {
-    /* free resources allocated above */
-    dhcp_stop(netif);
-    return ERR_MEM;
-  }
-  /* Set the flag that says this netif is handled by DHCP. */
-  netif->flags |= NETIF_FLAG_DHCP;
-  return result;
+  return ERR_OK;
 }
 
 /**
@@ -887,6 +953,10 @@ dhcp_discover(struct netif *netif)
     dhcp_option_byte(dhcp, DHCP_OPTION_BROADCAST);
     dhcp_option_byte(dhcp, DHCP_OPTION_DNS_SERVER);
 
+#if LWIP_DHCP_RAPID_COMMIT
+    dhcp_option(dhcp, DHCP_OPTION_RAPID_COMMIT, 0);
+#endif /* LWIP_DHCP_RAPID_COMMIT */
+
     dhcp_option_trailer(dhcp);
 
     LWIP_DEBUGF(DHCP_DEBUG | LWIP_DBG_TRACE, ("dhcp_discover: realloc()ing\n"));
@@ -1150,6 +1220,13 @@ dhcp_reboot(struct netif *netif)
     dhcp_option(dhcp, DHCP_OPTION_REQUESTED_IP, 4);
     dhcp_option_long(dhcp, ntohl(ip4_addr_get_u32(&dhcp->offered_ip_addr)));
 
+    /* the ACK is all we get after a reset, it has to carry the configuration */
+    dhcp_option(dhcp, DHCP_OPTION_PARAMETER_REQUEST_LIST, 4/*num options*/);
+    dhcp_option_byte(dhcp, DHCP_OPTION_SUBNET_MASK);
+    dhcp_option_byte(dhcp, DHCP_OPTION_ROUTER);
+    dhcp_option_byte(dhcp, DHCP_OPTION_BROADCAST);
+    dhcp_option_byte(dhcp, DHCP_OPTION_DNS_SERVER);
+
     dhcp_option_trailer(dhcp);
 
     pbuf_realloc(dhcp->p_out, sizeof(struct dhcp_msg) - DHCP_OPTIONS_LEN + dhcp->options_out_len);
@@ -1427,6 +1504,14 @@ again:
         LWIP_ASSERT("len == 4", len == 4);
         decode_idx = DHCP_OPTION_IDX_T2;
         break;
+#if LWIP_DHCP_RAPID_COMMIT
+      case(DHCP_OPTION_RAPID_COMMIT):
+        /* no value, only its presence counts */
+        LWIP_ASSERT("len == 0", len == 0);
+        decode_len = 0;
+        dhcp_got_option(dhcp, DHCP_OPTION_IDX_RAPID_COMMIT);
+        break;
+#endif /* LWIP_DHCP_RAPID_COMMIT */
       default:
         decode_len = 0;
         LWIP_DEBUGF(DHCP_DEBUG, ("skipping option %"U16_F" in options\n", op));
@@ -1575,8 +1660,13 @@ dhcp_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, ip_addr_t *addr, u16_t
   /* message type is DHCP ACK? */
   if (msg_type == DHCP_ACK) {
     LWIP_DEBUGF(DHCP_DEBUG | LWIP_DBG_TRACE, ("DHCP_ACK received\n"));
-    /* in requesting state? */
-    if (dhcp->state == DHCP_REQUESTING) {
+    /* in requesting state? or a rapid commit answering our DISCOVER? */
+    if ((dhcp->state == DHCP_REQUESTING)
+#if LWIP_DHCP_RAPID_COMMIT
+        /* RFC 4039 4: an ACK without the Rapid Commit option is discarded while selecting */
+        || ((dhcp->state == DHCP_SELECTING) && dhcp_option_given(dhcp, DHCP_OPTION_IDX_RAPID_COMMIT))
+#endif /* LWIP_DHCP_RAPID_COMMIT */
+       ) {
       dhcp_handle_ack(netif);
 #if DHCP_DOES_ARP_CHECK
       /* check if the acknowledged lease address is already in use */
@@ -1588,6 +1678,8 @@ dhcp_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, ip_addr_t *addr, u16_t
     }
     /* already bound to the given lease address? */
     else if ((dhcp->state == DHCP_REBOOTING) || (dhcp->state == DHCP_REBINDING) || (dhcp->state == DHCP_RENEWING)) {
+      /* take over lease times, mask and gateway of the new ACK */
+      dhcp_handle_ack(netif);
       dhcp_bind(netif);
     }
   }
@@ -121,6 +121,7 @@
 #define DNS_STATE_NEW             1
 #define DNS_STATE_ASKING          2
 #define DNS_STATE_DONE            3
+#define DNS_STATE_REFRESH         4
 
 #ifdef PACK_STRUCT_USE_INCLUDES
 #  include "arch/bpstruct.h"
@@ -172,7 +173,9 @@ struct dns_table_entry {
   u8_t  retries;
   u8_t  seqno;
   u8_t  err;
+  u8_t  used;
   u32_t ttl;
+  u32_t hash;
   char name[DNS_MAX_NAME_LENGTH];
   ip_addr_t ipaddr;
   /* pointer to callback on DNS query done */
@@ -433,6 +436,45 @@ dns_local_addhost(const char *hostname, const ip_addr_t *addr)
 #endif /* DNS_LOCAL_HOSTLIST_IS_DYNAMIC*/
 #endif /* DNS_LOCAL_HOSTLIST */
 
+/**
+ * Hash a hostname (FNV-1a), so the table is searched comparing one word
+ * per entry and strcmp() is only called for the matching entry.
+ *
+ * @param name the hostname
+ * @return hash of the name
+ */
+static u32_t
+dns_hash(const char *name)
+{
+  u32_t hash = 2166136261UL;
+
+  while (*name != 0) {
+    hash = (hash ^ (u8_t)*name++) * 16777619UL;
+  }
+  return hash;
+}
+
+/**
+ * Find the table entry holding the answer (positive or negative) for a name.
+ *
+ * @param name the hostname to look up
+ * @return index of the entry in dns_table, DNS_TABLE_SIZE if not found
+ */
+static u8_t
+dns_find(const char *name)
+{
+  u8_t i;
+  u32_t hash = dns_hash(name);
+
+  for (i = 0; i < DNS_TABLE_SIZE; ++i) {
+    if (((dns_table[i].state == DNS_STATE_DONE) || (dns_table[i].state == DNS_STATE_REFRESH)) &&
+        (dns_table[i].hash == hash) && (strcmp(name, dns_table[i].name) == 0)) {
+      return i;
+    }
+  }
+  return DNS_TABLE_SIZE;
+}
+
 /**
  * Look up a hostname in the array of known hostnames.
  *
@@ -464,15 +506,16 @@ dns_lookup(const char *name)
   }
 #endif /* DNS_LOOKUP_LOCAL_EXTERN */
 
-  /* Walk through name list, return entry if found. If not, return NULL. */
-  for (i = 0; i < DNS_TABLE_SIZE; ++i) {
-    if ((dns_table[i].state == DNS_STATE_DONE) &&
-        (strcmp(name, dns_table[i].name) == 0)) {
-      LWIP_DEBUGF(DNS_DEBUG, ("dns_lookup: \"%s\": found = ", name));
-      ip_addr_debug_print(DNS_DEBUG, &(dns_table[i].ipaddr));
-      LWIP_DEBUGF(DNS_DEBUG, ("\n"));
-      return ip4_addr_get_u32(&dns_table[i].ipaddr);
-    }
+  /* Look the name up in the table, negative entries are not returned. */
+  i = dns_find(name);
+  if ((i < DNS_TABLE_SIZE) && (dns_table[i].err == 0)) {
+    LWIP_DEBUGF(DNS_DEBUG, ("dns_lookup: \"%s\": found = ", name));
+    ip_addr_debug_print(DNS_DEBUG, &(dns_table[i].ipaddr));
+    LWIP_DEBUGF(DNS_DEBUG, ("\n"));
+    /* candidate for a refresh before it expires, and last to be evicted */
+    dns_table[i].used = 1;
+    dns_table[i].seqno = dns_seqno++;
+    return ip4_addr_get_u32(&dns_table[i].ipaddr);
   }
 
   return IPADDR_NONE;
@@ -609,8 +652,10 @@ dns_send(u8_t numdns, const char* name, u8_t id)
     /* resize pbuf to the exact dns query */
     pbuf_realloc(p, (u16_t)((query + SIZEOF_DNS_QUERY) - ((char*)(p->payload))));
 
+#if !DNS_PARALLEL_SERVERS
     /* connect to the server for faster receiving */
     udp_connect(dns_pcb, &dns_servers[numdns], DNS_SERVER_PORT);
+#endif /* !DNS_PARALLEL_SERVERS */
     /* send dns packet */
     err = udp_sendto(dns_pcb, p, &dns_servers[numdns], DNS_SERVER_PORT);
 
@@ -623,6 +668,32 @@ dns_send(u8_t numdns, const char* name, u8_t id)
   return err;
 }
 
+/**
+ * Send the query of a dns_table entry, to all the servers at once if
+ * DNS_PARALLEL_SERVERS is set, else to the current server of the entry.
+ *
+ * @param i index of the dns_table entry
+ * @return ERR_OK if at least one packet is sent
+ */
+static err_t
+dns_query(u8_t i)
+{
+  struct dns_table_entry *pEntry = &dns_table[i];
+#if DNS_PARALLEL_SERVERS
+  u8_t n;
+  err_t err = ERR_ARG;
+
+  for (n = 0; n < DNS_MAX_SERVERS; ++n) {
+    if (!ip_addr_isany(&dns_servers[n]) && (dns_send(n, pEntry->name, i) == ERR_OK)) {
+      err = ERR_OK;
+    }
+  }
+  return err;
+#else /* DNS_PARALLEL_SERVERS */
+  return dns_send(pEntry->numdns, pEntry->name, i);
+#endif /* DNS_PARALLEL_SERVERS */
+}
+
 /**
  * dns_check_entry() - see if pEntry has not yet been queried and, if so, sends out a query.
  * Check an entry in the dns_table:
@@ -650,7 +721,7 @@ dns_check_entry(u8_t i)
       pEntry->retries = 0;
       
       /* send DNS packet for this entry */
-      err = dns_send(pEntry->numdns, pEntry->name, i);
+      err = dns_query(i);
       if (err != ERR_OK) {
         LWIP_DEBUGF(DNS_DEBUG | LWIP_DBG_LEVEL_WARNING,
                     ("dns_send returned error: %s\n", lwip_strerr(err)));
@@ -658,15 +729,29 @@ dns_check_entry(u8_t i)
       break;
     }
 
+    case DNS_STATE_REFRESH:
+      /* the cached address is still served while it is asked again */
+      if ((pEntry->ttl == 0) || (--pEntry->ttl == 0)) {
+        LWIP_DEBUGF(DNS_DEBUG, ("dns_check_entry: \"%s\": flush\n", pEntry->name));
+        pEntry->state = DNS_STATE_UNUSED;
+        break;
+      }
+      /* fall through */
     case DNS_STATE_ASKING: {
       if (--pEntry->tmr == 0) {
         if (++pEntry->retries == DNS_MAX_RETRIES) {
-          if ((pEntry->numdns+1<DNS_MAX_SERVERS) && !ip_addr_isany(&dns_servers[pEntry->numdns+1])) {
+          if (!DNS_PARALLEL_SERVERS &&
+              (pEntry->numdns+1<DNS_MAX_SERVERS) && !ip_addr_isany(&dns_servers[pEntry->numdns+1])) {
             /* change of server */
             pEntry->numdns++;
             pEntry->tmr     = 1;
             pEntry->retries = 0;
             break;
+          } else if (pEntry->state == DNS_STATE_REFRESH) {
+            /* keep the old answer until it expires */
+            LWIP_DEBUGF(DNS_DEBUG, ("dns_check_entry: \"%s\": refresh timeout\n", pEntry->name));
+            pEntry->state = DNS_STATE_DONE;
+            break;
           } else {
             LWIP_DEBUGF(DNS_DEBUG, ("dns_check_entry: \"%s\": timeout\n", pEntry->name));
             /* call specified callback function if provided */
@@ -683,7 +768,7 @@ dns_check_entry(u8_t i)
         pEntry->tmr = pEntry->retries;
 
         /* send DNS packet for this entry */
-        err = dns_send(pEntry->numdns, pEntry->name, i);
+        err = dns_query(i);
         if (err != ERR_OK) {
           LWIP_DEBUGF(DNS_DEBUG | LWIP_DBG_LEVEL_WARNING,
                       ("dns_send returned error: %s\n", lwip_strerr(err)));
@@ -694,12 +779,29 @@ dns_check_entry(u8_t i)
 
     case DNS_STATE_DONE: {
       /* if the time to live is nul */
-      if (--pEntry->ttl == 0) {
+      if ((pEntry->ttl == 0) || (--pEntry->ttl == 0)) {
         LWIP_DEBUGF(DNS_DEBUG, ("dns_check_entry: \"%s\": flush\n", pEntry->name));
         /* flush this entry */
         pEntry->state = DNS_STATE_UNUSED;
         pEntry->found = NULL;
       }
+#if DNS_PREFETCH_TTL
+      else if ((pEntry->ttl == DNS_PREFETCH_TTL) && pEntry->used && (pEntry->err == 0)) {
+        /* name in use: ask again before it expires, nobody waits for the answer */
+        LWIP_DEBUGF(DNS_DEBUG, ("dns_check_entry: \"%s\": refresh\n", pEntry->name));
+        pEntry->state   = DNS_STATE_REFRESH;
+        pEntry->numdns  = 0;
+        pEntry->tmr     = 1;
+        pEntry->retries = 0;
+        pEntry->used    = 0;
+        pEntry->found   = NULL;
+        err = dns_query(i);
+        if (err != ERR_OK) {
+          LWIP_DEBUGF(DNS_DEBUG | LWIP_DBG_LEVEL_WARNING,
+                      ("dns_send returned error: %s\n", lwip_strerr(err)));
+        }
+      }
+#endif /* DNS_PREFETCH_TTL */
       break;
     }
     case DNS_STATE_UNUSED:
@@ -724,6 +826,51 @@ dns_check_entries(void)
   }
 }
 
+#if DNS_NEG_TTL
+/**
+ * Time to remember a name reported as non-existent: the SOA record of the
+ * authority section gives it (RFC 2308 - 5), bounded by DNS_NEG_TTL.
+ *
+ * @param hdr the response in dns_payload
+ * @param len length of the response
+ * @return time to live of the negative entry in seconds
+ */
+static u32_t
+dns_neg_ttl(struct dns_hdr *hdr, u16_t len)
+{
+  struct dns_answer ans;
+  u32_t ttl = DNS_NEG_TTL;
+  u32_t minimum;
+  u16_t n, rdlen;
+  unsigned char *end = (unsigned char *)hdr + len;
+  unsigned char *ptr;
+
+  /* skip the question, then the answers and authority records up to the SOA */
+  ptr = dns_parse_name((unsigned char *)hdr + SIZEOF_DNS_HDR) + SIZEOF_DNS_QUERY;
+  n = htons(hdr->numanswers) + htons(hdr->numauthrr);
+  while ((n-- > 0) && (ptr < end)) {
+    ptr = dns_parse_name(ptr);
+    if (ptr + SIZEOF_DNS_ANSWER > end) {
+      break;
+    }
+    SMEMCPY(&ans, ptr, SIZEOF_DNS_ANSWER);
+    ptr += SIZEOF_DNS_ANSWER;
+    rdlen = htons(ans.len);
+    if (ptr + rdlen > end) {
+      break;
+    }
+    if ((ans.type == PP_HTONS(DNS_RRTYPE_SOA)) && (rdlen >= sizeof(minimum))) {
+      /* MINIMUM is the last field of the SOA data */
+      SMEMCPY(&minimum, ptr + rdlen - sizeof(minimum), sizeof(minimum));
+      ttl = LWIP_MIN(ttl, LWIP_MIN(ntohl(ans.ttl), ntohl(minimum)));
+      break;
+    }
+    ptr += rdlen;
+  }
+  return ttl;
+}
+#endif /* DNS_NEG_TTL */
+
 /**
  * Receive input function for DNS response packets arriving for the dns UDP pcb.
  *
@@ -738,10 +885,16 @@ dns_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, ip_addr_t *addr, u16_t
   struct dns_answer ans;
   struct dns_table_entry *pEntry;
   u16_t nquestions, nanswers;
+  u8_t refreshing = 0;
+#if DNS_PARALLEL_SERVERS
+  u8_t n;
+#endif /* DNS_PARALLEL_SERVERS */
 
   LWIP_UNUSED_ARG(arg);
   LWIP_UNUSED_ARG(pcb);
+#if !DNS_PARALLEL_SERVERS
   LWIP_UNUSED_ARG(addr);
+#endif /* !DNS_PARALLEL_SERVERS */
   LWIP_UNUSED_ARG(port);
 
   /* is the dns message too big ? */
@@ -765,7 +918,19 @@ dns_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, ip_addr_t *addr, u16_t
     i = htons(hdr->id);
     if (i < DNS_TABLE_SIZE) {
       pEntry = &dns_table[i];
-      if(pEntry->state == DNS_STATE_ASKING) {
+      if((pEntry->state == DNS_STATE_ASKING) || (pEntry->state == DNS_STATE_REFRESH)) {
+#if DNS_PARALLEL_SERVERS
+        /* the pcb is not connected, only take answers from our servers */
+        for (n = 0; n < DNS_MAX_SERVERS; ++n) {
+          if (ip_addr_cmp(addr, &dns_servers[n])) {
+            break;
+          }
+        }
+        if (n == DNS_MAX_SERVERS) {
+          goto memerr;
+        }
+#endif /* DNS_PARALLEL_SERVERS */
+        refreshing = (pEntry->state == DNS_STATE_REFRESH);
         /* This entry is now completed. */
         pEntry->state = DNS_STATE_DONE;
         pEntry->err   = hdr->flags2 & DNS_FLAG2_ERR_MASK;
@@ -816,6 +981,7 @@ dns_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, ip_addr_t *addr, u16_t
             if (pEntry->found) {
               (*pEntry->found)(pEntry->name, &pEntry->ipaddr, pEntry->arg);
             }
+            pEntry->found = NULL;
             /* deallocate memory and return */
             goto memerr;
           } else {
@@ -834,6 +1000,28 @@ dns_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, ip_addr_t *addr, u16_t
   goto memerr;
 
 responseerr:
+#if DNS_NEG_TTL
+  if ((pEntry->err == DNS_FLAG2_ERR_NAME) && ((hdr->flags1 & DNS_FLAG1_RESPONSE) != 0) &&
+      (htons(hdr->numquestions) == 1)
+#if DNS_DOES_NAME_CHECK
+      && (dns_compare_name((unsigned char *)(pEntry->name), (unsigned char *)dns_payload + SIZEOF_DNS_HDR) == 0)
+#endif /* DNS_DOES_NAME_CHECK */
+     ) {
+    /* the name does not exist: keep the entry as a negative answer */
+    LWIP_DEBUGF(DNS_DEBUG, ("dns_recv: \"%s\": no such name\n", pEntry->name));
+    pEntry->ttl = dns_neg_ttl(hdr, p->tot_len);
+    if (pEntry->found) {
+      (*pEntry->found)(pEntry->name, NULL, pEntry->arg);
+    }
+    pEntry->found = NULL;
+    goto memerr;
+  }
+#endif /* DNS_NEG_TTL */
+  if (refreshing) {
+    /* keep the old answer until it expires */
+    pEntry->err = 0;
+    goto memerr;
+  }
   /* ERROR: call specified callback function with NULL as name to indicate an error */
   if (pEntry->found) {
     (*pEntry->found)(pEntry->name, NULL, pEntry->arg);
@@ -849,20 +1037,20 @@ memerr:
 }
 
 /**
- * Queues a new hostname to resolve and sends out a DNS query for that hostname
+ * Take an entry of dns_table for a new name: an unused entry, or the oldest
+ * completed one.
  *
- * @param name the hostname that is to be queried
- * @param found a callback founction to be called on success, failure or timeout
- * @param callback_arg argument to pass to the callback function
- * @return @return a err_t return code.
+ * @param name the hostname, for debug output
+ * @return index of the entry, DNS_TABLE_SIZE if the table is full
  */
-static err_t
-dns_enqueue(const char *name, dns_found_callback found, void *callback_arg)
+static u8_t
+dns_alloc(const char *name)
 {
   u8_t i;
   u8_t lseq, lseqi;
   struct dns_table_entry *pEntry = NULL;
-  size_t namelen;
+
+  LWIP_UNUSED_ARG(name);
 
   /* search an unused entry, or the oldest one */
   lseq = lseqi = 0;
@@ -886,25 +1074,63 @@ dns_enqueue(const char *name, dns_found_callback found, void *callback_arg)
     if ((lseqi >= DNS_TABLE_SIZE) || (dns_table[lseqi].state != DNS_STATE_DONE)) {
       /* no entry can't be used now, table is full */
       LWIP_DEBUGF(DNS_DEBUG, ("dns_enqueue: \"%s\": DNS entries table is full\n", name));
-      return ERR_MEM;
+      return DNS_TABLE_SIZE;
     } else {
       /* use the oldest completed one */
       i = lseqi;
-      pEntry = &dns_table[i];
     }
   }
 
   /* use this entry */
   LWIP_DEBUGF(DNS_DEBUG, ("dns_enqueue: \"%s\": use DNS entry %"U16_F"\n", name, (u16_t)(i)));
+  return i;
+}
+
+/**
+ * Copy a hostname into an entry of dns_table.
+ *
+ * @param pEntry the entry
+ * @param name the hostname
+ */
+static void
+dns_setname(struct dns_table_entry *pEntry, const char *name)
+{
+  size_t namelen;
 
-  /* fill the entry */
-  pEntry->state = DNS_STATE_NEW;
   pEntry->seqno = dns_seqno++;
-  pEntry->found = found;
-  pEntry->arg   = callback_arg;
+  pEntry->used  = 0;
+  pEntry->err   = 0;
   namelen = LWIP_MIN(strlen(name), DNS_MAX_NAME_LENGTH-1);
   MEMCPY(pEntry->name, name, namelen);
   pEntry->name[namelen] = 0;
+  pEntry->hash = dns_hash(pEntry->name);
+}
+
+/**
+ * Queues a new hostname to resolve and sends out a DNS query for that hostname
+ *
+ * @param name the hostname that is to be queried
+ * @param found a callback founction to be called on success, failure or timeout
+ * @param callback_arg argument to pass to the callback function
+ * @return @return a err_t return code.
+ */
+static err_t
+dns_enqueue(const char *name, dns_found_callback found, void *callback_arg)
+{
+  u8_t i;
+  struct dns_table_entry *pEntry;
+
+  i = dns_alloc(name);
+  if (i == DNS_TABLE_SIZE) {
+    return ERR_MEM;
+  }
+
+  /* fill the entry */
+  pEntry = &dns_table[i];
+  pEntry->state = DNS_STATE_NEW;
+  pEntry->found = found;
+  pEntry->arg   = callback_arg;
+  dns_setname(pEntry, name);
 
   /* force to send query without waiting timer */
   dns_check_entry(i);
@@ -937,6 +1163,9 @@ dns_gethostbyname(const char *hostname, ip_addr_t *addr, dns_found_callback foun
                   void *callback_arg)
 {
   u32_t ipaddr;
+#if DNS_NEG_TTL
+  u8_t i;
+#endif /* DNS_NEG_TTL */
   /* not initialized or no valid server yet, or invalid addr pointer
    * or invalid hostname or invalid hostname length */
   if ((dns_pcb == NULL) || (addr == NULL) ||
@@ -963,8 +1192,79 @@ dns_gethostbyname(const char *hostname, ip_addr_t *addr, dns_found_callback foun
     return ERR_OK;
   }
 
+#if DNS_NEG_TTL
+  /* known not to exist? */
+  i = dns_find(hostname);
+  if ((i < DNS_TABLE_SIZE) && (dns_table[i].err != 0)) {
+    return ERR_VAL;
+  }
+#endif /* DNS_NEG_TTL */
+
   /* queue query with specified callback */
   return dns_enqueue(hostname, found, callback_arg);
 }
 
+/**
+ * Read one positive answer of the cache, to save the cache across reboots.
+ * Must be called in the tcpip thread.
+ *
+ * @param index index of the entry, from 0 to DNS_TABLE_SIZE-1
+ * @param name buffer of DNS_MAX_NAME_LENGTH chars receiving the hostname
+ * @param addr receives the address
+ * @param ttl receives the remaining time to live in seconds
+ * @return 1 if the entry holds an address, 0 if not
+ */
+u8_t
+dns_cache_get(u8_t index, char *name, ip_addr_t *addr, u32_t *ttl)
+{
+  struct dns_table_entry *pEntry;
+
+  if (index >= DNS_TABLE_SIZE) {
+    return 0;
+  }
+  pEntry = &dns_table[index];
+  if (((pEntry->state != DNS_STATE_DONE) && (pEntry->state != DNS_STATE_REFRESH)) ||
+      (pEntry->err != 0)) {
+    return 0;
+  }
+  strcpy(name, pEntry->name);
+  ip_addr_copy(*addr, pEntry->ipaddr);
+  *ttl = pEntry->ttl;
+  return 1;
+}
+
+/**
+ * Put an answer into the cache, to restore a saved cache.
+ * Must be called in the tcpip thread.
+ *
+ * @param name the hostname
+ * @param addr its address
+ * @param ttl time to live in seconds
+ * @return ERR_OK, ERR_ARG for a bad name or ERR_MEM if the table is full
+ */
+err_t
+dns_cache_add(const char *name, ip_addr_t *addr, u32_t ttl)
+{
+  u8_t i;
+  struct dns_table_entry *pEntry;
+
+  if ((name == NULL) || (name[0] == 0) || (strlen(name) >= DNS_MAX_NAME_LENGTH) || (ttl == 0)) {
+    return ERR_ARG;
+  }
+  i = dns_find(name);
+  if (i == DNS_TABLE_SIZE) {
+    i = dns_alloc(name);
+    if (i == DNS_TABLE_SIZE) {
+      return ERR_MEM;
+    }
+  }
+  pEntry = &dns_table[i];
+  pEntry->state = DNS_STATE_DONE;
+  pEntry->found = NULL;
+  dns_setname(pEntry, name);
+  ip_addr_copy(pEntry->ipaddr, *addr);
+  pEntry->ttl = LWIP_MIN(ttl, DNS_MAX_TTL);
+  return ERR_OK;
+}
+
 #endif /* LWIP_DNS */
@@ -65,6 +65,20 @@
 
 #include <string.h>
 
+#if defined(TARGET_LPC4088) || defined(TARGET_LPC4088_DM)
+#  if defined (__ICCARM__)
+#     define ETHMEM_SECTION
+#  elif defined(TOOLCHAIN_GCC_CR)
+#     define ETHMEM_SECTION __attribute__((section(".data.$RamPeriph32")))
+#  else
+#     define ETHMEM_SECTION __attribute__((section("AHBSRAM1"),aligned))
+#  endif
+#elif defined(TARGET_LPC1768)
+#   define ETHMEM_SECTION __attribute((section("AHBSRAM0")))
+#else
+#		define ETHMEM_SECTION
+#endif
+
 #if MEM_USE_POOLS
 /* lwIP head implemented with different sized pools */
 
@@ -144,7 +158,210 @@ mem_free(void *rmem)
   memp_free(hmem->poolnr, hmem);
 }
 
-#else /* MEM_USE_POOLS */
+#elif MEM_SIZE_CLASSES
+/* lwIP heap split into size classes (MEM_SIZE_CLASS_LIST): every class is a
+   free list of equal elements, so mem_malloc and mem_free take constant time
+   and freed memory never splits into holes too small to use. */
+
+/** Header in front of every element */
+struct mem_class_hdr {
+  /** bytes asked for, for the internal fragmentation figures */
+  mem_size_t size;
+  /** class of the element */
+  u8_t cls;
+};
+#define SIZEOF_MEM_CLASS_HDR LWIP_MEM_ALIGN_SIZE(sizeof(struct mem_class_hdr))
+
+/** Free element, the link is kept in the data area */
+struct mem_class_free {
+  struct mem_class_free *next;
+};
+
+#define MEM_CLASS_NUM(size, num)    + 1
+#define MEM_CLASS_BYTES(size, num)  + (num) * (SIZEOF_MEM_CLASS_HDR + LWIP_MEM_ALIGN_SIZE(size))
+#define MEM_CLASS_SIZE(size, num)   LWIP_MEM_ALIGN_SIZE(size),
+#define MEM_CLASS_COUNT(size, num)  (num),
+
+/** number of classes */
+#define MEM_CLASSES        (0 MEM_SIZE_CLASS_LIST(MEM_CLASS_NUM))
+/** memory used by all the classes */
+#define MEM_CLASSES_SIZE   (0 MEM_SIZE_CLASS_LIST(MEM_CLASS_BYTES))
+
+#ifndef LWIP_RAM_HEAP_POINTER
+/** the heap, the linker complains if the classes do not fit in its section */
+u8_t ram_heap[MEM_CLASSES_SIZE + MEM_ALIGNMENT] ETHMEM_SECTION;
+#define LWIP_RAM_HEAP_POINTER ram_heap
+#endif /* LWIP_RAM_HEAP_POINTER */
+
+static const mem_size_t mem_class_size[MEM_CLASSES] = {
+  MEM_SIZE_CLASS_LIST(MEM_CLASS_SIZE)
+};
+static const u16_t mem_class_num[MEM_CLASSES] = {
+  MEM_SIZE_CLASS_LIST(MEM_CLASS_COUNT)
+};
+
+static struct mem_class_free *mem_class_free[MEM_CLASSES];
+static struct mem_class_stats mem_class_stat[MEM_CLASSES];
+
+/**
+ * Carve the heap into the elements of each class.
+ */
+void
+mem_init(void)
+{
+  u8_t *ptr;
+  u8_t cls;
+  u16_t i;
+  struct mem_class_free *elem;
+
+  ptr = (u8_t *)LWIP_MEM_ALIGN(LWIP_RAM_HEAP_POINTER);
+  for (cls = 0; cls < MEM_CLASSES; cls++) {
+    mem_class_free[cls] = NULL;
+    for (i = 0; i < mem_class_num[cls]; i++) {
+      ((struct mem_class_hdr *)(void *)ptr)->cls = cls;
+      elem = (struct mem_class_free *)(void *)(ptr + SIZEOF_MEM_CLASS_HDR);
+      elem->next = mem_class_free[cls];
+      mem_class_free[cls] = elem;
+      ptr += SIZEOF_MEM_CLASS_HDR + mem_class_size[cls];
+    }
+    memset(&mem_class_stat[cls], 0, sizeof(struct mem_class_stats));
+    mem_class_stat[cls].size = mem_class_size[cls];
+    mem_class_stat[cls].num = mem_class_num[cls];
+  }
+  MEM_STATS_AVAIL(avail, MEM_CLASSES_SIZE);
+}
+
+/**
+ * Allocate memory: take an element of the smallest class that is big enough,
+ * or of the next bigger class if that one is empty.
+ *
+ * @param size the size in bytes of the memory needed
+ * @return a pointer to the allocated memory or NULL if no class can hold it
+ */
+void *
+mem_malloc(mem_size_t size)
+{
+  u8_t cls, fit;
+  struct mem_class_free *elem = NULL;
+  struct mem_class_hdr *hdr;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  if (size == 0) {
+    return NULL;
+  }
+  for (fit = 0; fit < MEM_CLASSES; fit++) {
+    if (size <= mem_class_size[fit]) {
+      break;
+    }
+  }
+  if (fit == MEM_CLASSES) {
+    LWIP_DEBUGF(MEM_DEBUG | LWIP_DBG_LEVEL_SERIOUS, ("mem_malloc: no class holds %"S16_F" bytes\n", (s16_t)size));
+    return NULL;
+  }
+
+  SYS_ARCH_PROTECT(lev);
+  for (cls = fit; cls < MEM_CLASSES; cls++) {
+    elem = mem_class_free[cls];
+    if (elem != NULL) {
+      break;
+    }
+  }
+  if (elem == NULL) {
+    mem_class_stat[fit].err++;
+    MEM_STATS_INC(err);
+    SYS_ARCH_UNPROTECT(lev);
+    LWIP_DEBUGF(MEM_DEBUG | LWIP_DBG_LEVEL_SERIOUS, ("mem_malloc: could not allocate %"S16_F" bytes\n", (s16_t)size));
+    return NULL;
+  }
+  mem_class_free[cls] = elem->next;
+  if (cls != fit) {
+    mem_class_stat[fit].spill++;
+  }
+  mem_class_stat[cls].requested += size;
+  if (++mem_class_stat[cls].used > mem_class_stat[cls].max) {
+    mem_class_stat[cls].max = mem_class_stat[cls].used;
+  }
+  MEM_STATS_INC_USED(used, SIZEOF_MEM_CLASS_HDR + mem_class_size[cls]);
+  SYS_ARCH_UNPROTECT(lev);
+
+  hdr = (struct mem_class_hdr *)(void *)((u8_t *)elem - SIZEOF_MEM_CLASS_HDR);
+  hdr->size = size;
+  return elem;
+}
+
+/**
+ * Put an element back on the free list of its class.
+ *
+ * @param rmem the memory returned by mem_malloc()
+ */
+void
+mem_free(void *rmem)
+{
+  struct mem_class_hdr *hdr;
+  struct mem_class_free *elem = (struct mem_class_free *)rmem;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  if (rmem == NULL) {
+    LWIP_DEBUGF(MEM_DEBUG | LWIP_DBG_TRACE | LWIP_DBG_LEVEL_SERIOUS, ("mem_free(p == NULL) was called.\n"));
+    return;
+  }
+  hdr = (struct mem_class_hdr *)(void *)((u8_t *)rmem - SIZEOF_MEM_CLASS_HDR);
+  LWIP_ASSERT("mem_free: legal memory", hdr->cls < MEM_CLASSES);
+
+  SYS_ARCH_PROTECT(lev);
+  mem_class_stat[hdr->cls].used--;
+  mem_class_stat[hdr->cls].requested -= hdr->size;
+  MEM_STATS_DEC_USED(used, SIZEOF_MEM_CLASS_HDR + mem_class_size[hdr->cls]);
+  elem->next = mem_class_free[hdr->cls];
+  mem_class_free[hdr->cls] = elem;
+  SYS_ARCH_UNPROTECT(lev);
+}
+
+/**
+ * Shrink memory returned by mem_malloc(). The element keeps its size, only
+ * the figures are updated.
+ *
+ * @param rmem the memory returned by mem_malloc()
+ * @param newsize the new size, no bigger than the old one
+ * @return rmem
+ */
+void *
+mem_trim(void *rmem, mem_size_t newsize)
+{
+  struct mem_class_hdr *hdr = (struct mem_class_hdr *)(void *)((u8_t *)rmem - SIZEOF_MEM_CLASS_HDR);
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  if (newsize < hdr->size) {
+    SYS_ARCH_PROTECT(lev);
+    mem_class_stat[hdr->cls].requested -= hdr->size - newsize;
+    hdr->size = newsize;
+    SYS_ARCH_UNPROTECT(lev);
+  }
+  return rmem;
+}
+
+/**
+ * Read the figures of one class.
+ *
+ * @param cls the class, from 0 upwards
+ * @param stats receives the figures
+ * @return 1 if the class exists, 0 after the last class
+ */
+u8_t
+mem_class_stats(u8_t cls, struct mem_class_stats *stats)
+{
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  if (cls >= MEM_CLASSES) {
+    return 0;
+  }
+  SYS_ARCH_PROTECT(lev);
+  *stats = mem_class_stat[cls];
+  SYS_ARCH_UNPROTECT(lev);
+  return 1;
+}
+
+#else /* MEM_SIZE_CLASSES */
 /* lwIP replacement for your libc malloc() */
 
 /**
@@ -177,21 +394,6 @@ struct mem {
  * If so, make sure the memory at that location is big enough (see below on
  * how that space is calculated). */
 #ifndef LWIP_RAM_HEAP_POINTER
-
-#if defined(TARGET_LPC4088) || defined(TARGET_LPC4088_DM)
-#  if defined (__ICCARM__)
-#     define ETHMEM_SECTION
-#  elif defined(TOOLCHAIN_GCC_CR)
-#     define ETHMEM_SECTION __attribute__((section(".data.$RamPeriph32")))
-#  else
-#     define ETHMEM_SECTION __attribute__((section("AHBSRAM1"),aligned))
-#  endif
-#elif defined(TARGET_LPC1768)
-#   define ETHMEM_SECTION __attribute((section("AHBSRAM0")))
-#else
-#		define ETHMEM_SECTION
-#endif
-
 /** the heap. we need one struct mem at the end and some room for alignment */
 u8_t ram_heap[MEM_SIZE_ALIGNED + (2*SIZEOF_STRUCT_MEM) + MEM_ALIGNMENT] ETHMEM_SECTION;
 #define LWIP_RAM_HEAP_POINTER ram_heap
@@ -630,7 +832,36 @@ mem_malloc(mem_size_t size)
   return NULL;
 }
 
+/**
+ * Walk the heap to measure its fragmentation.
+ *
+ * @param stats receives the figures
+ */
+void
+mem_heap_stats(struct mem_heap_stats *stats)
+{
+  struct mem *mem;
+  mem_size_t size;
+
+  memset(stats, 0, sizeof(struct mem_heap_stats));
+  sys_mutex_lock(&mem_mutex);
+  for (mem = (struct mem *)(void *)ram; mem != ram_end; mem = (struct mem *)(void *)&ram[mem->next]) {
+    size = mem->next - (mem_size_t)((u8_t *)mem - ram) - SIZEOF_STRUCT_MEM;
+    if (mem->used) {
+      stats->used += size;
+    } else {
+      stats->free += size;
+      stats->holes++;
+      if (size > stats->largest) {
+        stats->largest = size;
+      }
+    }
+  }
+  sys_mutex_unlock(&mem_mutex);
+}
+
 #endif /* MEM_USE_POOLS */
+
 /**
  * Contiguously allocates enough space for count objects that are size bytes
  * of memory each and returns a pointer to the allocated memory.
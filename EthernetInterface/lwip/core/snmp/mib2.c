@@ -164,6 +164,21 @@ const struct mib_array_node snmp = {
 /* lwIP has no EGP, thus may not implement it. (egp .1.3.6.1.2.1.8) */
 
 /* udp .1.3.6.1.2.1.7 */
+#if SNMP_SORTED_TABLES
+static s32_t udp_idx[(MEMP_NUM_UDP_PCB) * 5];
+/** index rows for udpTable */
+struct mib_table_node udp_root = {
+  &udpentry_get_object_def,
+  &udpentry_get_value,
+  &noleafs_set_test,
+  &noleafs_set_value,
+  MIB_NODE_TB,
+  MEMP_NUM_UDP_PCB,
+  5,
+  0,
+  udp_idx
+};
+#else
 /** index root node for udpTable */
 struct mib_list_rootnode udp_root = {
   &noleafs_get_object_def,
@@ -176,6 +191,7 @@ struct mib_list_rootnode udp_root = {
   NULL,
   0
 };
+#endif /* SNMP_SORTED_TABLES */
 const s32_t udpentry_ids[2] = { 1, 2 };
 struct mib_node* const udpentry_nodes[2] = {
   (struct mib_node*)&udp_root, (struct mib_node*)&udp_root,
@@ -343,6 +359,21 @@ const struct mib_array_node icmp = {
   icmp_nodes
 };
 
+#if SNMP_SORTED_TABLES
+static s32_t ipntom_idx[(ARP_TABLE_SIZE) * 5];
+/** index rows for ipNetToMediaTable */
+struct mib_table_node ipntomtree_root = {
+  &ip_ntomentry_get_object_def,
+  &ip_ntomentry_get_value,
+  &noleafs_set_test,
+  &noleafs_set_value,
+  MIB_NODE_TB,
+  ARP_TABLE_SIZE,
+  5,
+  0,
+  ipntom_idx
+};
+#else
 /** index root node for ipNetToMediaTable */
 struct mib_list_rootnode ipntomtree_root = {
   &noleafs_get_object_def,
@@ -355,6 +386,7 @@ struct mib_list_rootnode ipntomtree_root = {
   NULL,
   0
 };
+#endif /* SNMP_SORTED_TABLES */
 const s32_t ipntomentry_ids[4] = { 1, 2, 3, 4 };
 struct mib_node* const ipntomentry_nodes[4] = {
   (struct mib_node*)&ipntomtree_root, (struct mib_node*)&ipntomtree_root,
@@ -384,6 +416,21 @@ struct mib_ram_array_node ipntomtable = {
   &ipntomtable_node
 };
 
+#if SNMP_SORTED_TABLES
+static s32_t iprte_idx[(SNMP_NETIF_ROWS + 1) * 4];
+/** index rows for ipRouteTable */
+struct mib_table_node iprtetree_root = {
+  &ip_rteentry_get_object_def,
+  &ip_rteentry_get_value,
+  &noleafs_set_test,
+  &noleafs_set_value,
+  MIB_NODE_TB,
+  SNMP_NETIF_ROWS + 1,
+  4,
+  0,
+  iprte_idx
+};
+#else
 /** index root node for ipRouteTable */
 struct mib_list_rootnode iprtetree_root = {
   &noleafs_get_object_def,
@@ -396,6 +443,7 @@ struct mib_list_rootnode iprtetree_root = {
   NULL,
   0
 };
+#endif /* SNMP_SORTED_TABLES */
 const s32_t iprteentry_ids[13] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13 };
 struct mib_node* const iprteentry_nodes[13] = {
   (struct mib_node*)&iprtetree_root, (struct mib_node*)&iprtetree_root,
@@ -430,6 +478,21 @@ struct mib_ram_array_node iprtetable = {
   &iprtetable_node
 };
 
+#if SNMP_SORTED_TABLES
+static s32_t ipaddr_idx[(SNMP_NETIF_ROWS) * 4];
+/** index rows for ipAddrTable */
+struct mib_table_node ipaddrtree_root = {
+  &ip_addrentry_get_object_def,
+  &ip_addrentry_get_value,
+  &noleafs_set_test,
+  &noleafs_set_value,
+  MIB_NODE_TB,
+  SNMP_NETIF_ROWS,
+  4,
+  0,
+  ipaddr_idx
+};
+#else
 /** index root node for ipAddrTable */
 struct mib_list_rootnode ipaddrtree_root = {
   &noleafs_get_object_def,
@@ -442,6 +505,7 @@ struct mib_list_rootnode ipaddrtree_root = {
   NULL,
   0
 };
+#endif /* SNMP_SORTED_TABLES */
 const s32_t ipaddrentry_ids[5] = { 1, 2, 3, 4, 5 };
 struct mib_node* const ipaddrentry_nodes[5] = {
   (struct mib_node*)&ipaddrtree_root,
@@ -509,6 +573,21 @@ const struct mib_array_node mib2_ip = {
   ip_nodes
 };
 
+#if SNMP_SORTED_TABLES
+static s32_t at_idx[(ARP_TABLE_SIZE) * 5];
+/** index rows for atTable */
+struct mib_table_node arptree_root = {
+  &atentry_get_object_def,
+  &atentry_get_value,
+  &noleafs_set_test,
+  &noleafs_set_value,
+  MIB_NODE_TB,
+  ARP_TABLE_SIZE,
+  5,
+  0,
+  at_idx
+};
+#else
 /** index root node for atTable */
 struct mib_list_rootnode arptree_root = {
   &noleafs_get_object_def,
@@ -521,6 +600,7 @@ struct mib_list_rootnode arptree_root = {
   NULL,
   0
 };
+#endif /* SNMP_SORTED_TABLES */
 const s32_t atentry_ids[3] = { 1, 2, 3 };
 struct mib_node* const atentry_nodes[3] = {
   (struct mib_node*)&arptree_root,
@@ -1088,6 +1168,15 @@ void snmp_dec_iflist(void)
  */
 void snmp_insert_arpidx_tree(struct netif *ni, ip_addr_t *ip)
 {
+#if SNMP_SORTED_TABLES
+  s32_t arpidx[5];
+
+  LWIP_ASSERT("ni != NULL", ni != NULL);
+  snmp_netiftoifindex(ni, &arpidx[0]);
+  snmp_iptooid(ip, &arpidx[1]);
+  snmp_mib_table_insert(&arptree_root, arpidx);
+  snmp_mib_table_insert(&ipntomtree_root, arpidx);
+#else /* SNMP_SORTED_TABLES */
   struct mib_list_rootnode *at_rn;
   struct mib_list_node *at_node;
   s32_t arpidx[5];
@@ -1149,6 +1238,7 @@ void snmp_insert_arpidx_tree(struct netif *ni, ip_addr_t *ip)
       }
     }
   }
+#endif /* SNMP_SORTED_TABLES */
   /* enable getnext traversal on filled tables */
   at.maxlength = 1;
   ipntomtable.maxlength = 1;
@@ -1160,6 +1250,14 @@ void snmp_insert_arpidx_tree(struct netif *ni, ip_addr_t *ip)
  */
 void snmp_delete_arpidx_tree(struct netif *ni, ip_addr_t *ip)
 {
+#if SNMP_SORTED_TABLES
+  s32_t arpidx[5];
+
+  snmp_netiftoifindex(ni, &arpidx[0]);
+  snmp_iptooid(ip, &arpidx[1]);
+  snmp_mib_table_delete(&arptree_root, arpidx);
+  snmp_mib_table_delete(&ipntomtree_root, arpidx);
+#else /* SNMP_SORTED_TABLES */
   struct mib_list_rootnode *at_rn, *next, *del_rn[5];
   struct mib_list_node *at_n, *del_n[5];
   s32_t arpidx[5];
@@ -1221,6 +1319,7 @@ void snmp_delete_arpidx_tree(struct netif *ni, ip_addr_t *ip)
       }
     }
   }
+#endif /* SNMP_SORTED_TABLES */
   /* disable getnext traversal on empty tables */
   if(arptree_root.count == 0) at.maxlength = 0;
   if(ipntomtree_root.count == 0) ipntomtable.maxlength = 0;
@@ -1317,6 +1416,13 @@ void snmp_inc_iproutingdiscards(void)
  */
 void snmp_insert_ipaddridx_tree(struct netif *ni)
 {
+#if SNMP_SORTED_TABLES
+  s32_t ipaddridx[4];
+
+  LWIP_ASSERT("ni != NULL", ni != NULL);
+  snmp_iptooid(&ni->ip_addr, &ipaddridx[0]);
+  snmp_mib_table_insert(&ipaddrtree_root, ipaddridx);
+#else /* SNMP_SORTED_TABLES */
   struct mib_list_rootnode *ipa_rn;
   struct mib_list_node *ipa_node;
   s32_t ipaddridx[4];
@@ -1361,6 +1467,7 @@ void snmp_insert_ipaddridx_tree(struct netif *ni)
     }
     level++;
   }
+#endif /* SNMP_SORTED_TABLES */
   /* enable getnext traversal on filled table */
   ipaddrtable.maxlength = 1;
 }
@@ -1371,6 +1478,13 @@ void snmp_insert_ipaddridx_tree(struct netif *ni)
  */
 void snmp_delete_ipaddridx_tree(struct netif *ni)
 {
+#if SNMP_SORTED_TABLES
+  s32_t ipaddridx[4];
+
+  LWIP_ASSERT("ni != NULL", ni != NULL);
+  snmp_iptooid(&ni->ip_addr, &ipaddridx[0]);
+  snmp_mib_table_delete(&ipaddrtree_root, ipaddridx);
+#else /* SNMP_SORTED_TABLES */
   struct mib_list_rootnode *ipa_rn, *next, *del_rn[4];
   struct mib_list_node *ipa_n, *del_n[4];
   s32_t ipaddridx[4];
@@ -1422,6 +1536,7 @@ void snmp_delete_ipaddridx_tree(struct netif *ni)
       snmp_mib_lrn_free(next);
     }
   }
+#endif /* SNMP_SORTED_TABLES */
   /* disable getnext traversal on empty table */
   if (ipaddrtree_root.count == 0) ipaddrtable.maxlength = 0;
 }
@@ -1458,6 +1573,12 @@ void snmp_insert_iprteidx_tree(u8_t dflt, struct netif *ni)
   }
   if (insert)
   {
+#if SNMP_SORTED_TABLES
+    s32_t iprteidx[4];
+
+    snmp_iptooid(&dst, &iprteidx[0]);
+    snmp_mib_table_insert(&iprtetree_root, iprteidx);
+#else /* SNMP_SORTED_TABLES */
     struct mib_list_rootnode *iprte_rn;
     struct mib_list_node *iprte_node;
     s32_t iprteidx[4];
@@ -1500,6 +1621,7 @@ void snmp_insert_iprteidx_tree(u8_t dflt, struct netif *ni)
       }
       level++;
     }
+#endif /* SNMP_SORTED_TABLES */
   }
   /* enable getnext traversal on filled table */
   iprtetable.maxlength = 1;
@@ -1535,6 +1657,12 @@ void snmp_delete_iprteidx_tree(u8_t dflt, struct netif *ni)
   }
   if (del)
   {
+#if SNMP_SORTED_TABLES
+    s32_t iprteidx[4];
+
+    snmp_iptooid(&dst, &iprteidx[0]);
+    snmp_mib_table_delete(&iprtetree_root, iprteidx);
+#else /* SNMP_SORTED_TABLES */
     struct mib_list_rootnode *iprte_rn, *next, *del_rn[4];
     struct mib_list_node *iprte_n, *del_n[4];
     s32_t iprteidx[4];
@@ -1584,6 +1712,7 @@ void snmp_delete_iprteidx_tree(u8_t dflt, struct netif *ni)
         snmp_mib_lrn_free(next);
       }
     }
+#endif /* SNMP_SORTED_TABLES */
   }
   /* disable getnext traversal on empty table */
   if (iprtetree_root.count == 0) iprtetable.maxlength = 0;
@@ -1791,6 +1920,14 @@ void snmp_inc_udpoutdatagrams(void)
  */
 void snmp_insert_udpidx_tree(struct udp_pcb *pcb)
 {
+#if SNMP_SORTED_TABLES
+  s32_t udpidx[5];
+
+  LWIP_ASSERT("pcb != NULL", pcb != NULL);
+  snmp_iptooid(&pcb->local_ip, &udpidx[0]);
+  udpidx[4] = pcb->local_port;
+  snmp_mib_table_insert(&udp_root, udpidx);
+#else /* SNMP_SORTED_TABLES */
   struct mib_list_rootnode *udp_rn;
   struct mib_list_node *udp_node;
   s32_t udpidx[5];
@@ -1834,6 +1971,7 @@ void snmp_insert_udpidx_tree(struct udp_pcb *pcb)
       }
     }
   }
+#endif /* SNMP_SORTED_TABLES */
   udptable.maxlength = 1;
 }
 
@@ -1844,10 +1982,13 @@ void snmp_insert_udpidx_tree(struct udp_pcb *pcb)
 void snmp_delete_udpidx_tree(struct udp_pcb *pcb)
 {
   struct udp_pcb *npcb;
+#if !SNMP_SORTED_TABLES
   struct mib_list_rootnode *udp_rn, *next, *del_rn[5];
   struct mib_list_node *udp_n, *del_n[5];
+  u8_t fc, level, del_cnt;
+#endif /* !SNMP_SORTED_TABLES */
   s32_t udpidx[5];
-  u8_t bindings, fc, level, del_cnt;
+  u8_t bindings;
 
   LWIP_ASSERT("pcb != NULL", pcb != NULL);
   snmp_iptooid(&pcb->local_ip, &udpidx[0]);
@@ -1868,6 +2009,9 @@ void snmp_delete_udpidx_tree(struct udp_pcb *pcb)
   }
   if (bindings == 1)
   {
+#if SNMP_SORTED_TABLES
+    snmp_mib_table_delete(&udp_root, udpidx);
+#else /* SNMP_SORTED_TABLES */
     /* selectively remove */
     /* mark nodes for deletion */
     level = 0;
@@ -1912,6 +2056,7 @@ void snmp_delete_udpidx_tree(struct udp_pcb *pcb)
         snmp_mib_lrn_free(next);
       }
     }
+#endif /* SNMP_SORTED_TABLES */
   }
   /* disable getnext traversal on empty table */
   if (udp_root.count == 0) udptable.maxlength = 0;
@@ -437,6 +437,133 @@ snmp_mib_node_delete(struct mib_list_rootnode *rn, struct mib_list_node *n)
   return next;
 }
 
+/**
+ * Compares a table row with an object identifier.
+ *
+ * @param tn points to the table node
+ * @param row is the row number
+ * @param ident_len the length of the supplied object identifier
+ * @param ident points to the array of sub identifiers
+ * @return -1 if the row sorts before ident, 0 if ident starts with the row,
+ *   1 if the row sorts after ident
+ */
+static s8_t
+snmp_mib_table_cmp(struct mib_table_node *tn, u16_t row, u8_t ident_len, s32_t *ident)
+{
+  s32_t *idx;
+  u8_t i;
+
+  idx = &tn->idx[row * tn->idx_len];
+  for (i = 0; i < tn->idx_len; i++)
+  {
+    if (i == ident_len)
+    {
+      /* ident is a prefix of the row */
+      return 1;
+    }
+    if (idx[i] != ident[i])
+    {
+      return (idx[i] < ident[i]) ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Finds the first table row not sorting before an object identifier.
+ *
+ * @return the row number, tn->count if all rows sort before ident
+ */
+static u16_t
+snmp_mib_table_lower(struct mib_table_node *tn, u8_t ident_len, s32_t *ident)
+{
+  u16_t lo, hi, mid;
+
+  lo = 0;
+  hi = tn->count;
+  while (lo < hi)
+  {
+    mid = lo + (hi - lo) / 2;
+    if (snmp_mib_table_cmp(tn, mid, ident_len, ident) < 0)
+    {
+      lo = mid + 1;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/**
+ * Inserts a row in a table node, keeping the rows sorted.
+ *
+ * @param tn points to the table node
+ * @param row points to tn->idx_len sub identifiers
+ * @return -1 if the table is full, 1 if inserted, 2 if present.
+ */
+s8_t
+snmp_mib_table_insert(struct mib_table_node *tn, s32_t *row)
+{
+  s32_t *idx;
+  u16_t i, j;
+
+  LWIP_ASSERT("tn != NULL",tn != NULL);
+
+  i = snmp_mib_table_lower(tn, tn->idx_len, row);
+  if ((i < tn->count) && (snmp_mib_table_cmp(tn, i, tn->idx_len, row) == 0))
+  {
+    return 2;
+  }
+  if (tn->count >= tn->maxlength)
+  {
+    LWIP_DEBUGF(SNMP_MIB_DEBUG,("table full, %"U16_F" rows\n",tn->count));
+    return -1;
+  }
+  /* make room at row i */
+  idx = &tn->idx[i * tn->idx_len];
+  for (j = (tn->count - i) * tn->idx_len; j > 0; j--)
+  {
+    idx[j - 1 + tn->idx_len] = idx[j - 1];
+  }
+  for (j = 0; j < tn->idx_len; j++)
+  {
+    idx[j] = row[j];
+  }
+  tn->count += 1;
+  return 1;
+}
+
+/**
+ * Removes a row from a table node.
+ *
+ * @param tn points to the table node
+ * @param row points to tn->idx_len sub identifiers
+ * @return 1 if removed, 0 if not found.
+ */
+u8_t
+snmp_mib_table_delete(struct mib_table_node *tn, s32_t *row)
+{
+  s32_t *idx;
+  u16_t i, j;
+
+  LWIP_ASSERT("tn != NULL",tn != NULL);
+
+  i = snmp_mib_table_lower(tn, tn->idx_len, row);
+  if ((i == tn->count) || (snmp_mib_table_cmp(tn, i, tn->idx_len, row) != 0))
+  {
+    return 0;
+  }
+  tn->count -= 1;
+  idx = &tn->idx[i * tn->idx_len];
+  for (j = 0; j < (tn->count - i) * tn->idx_len; j++)
+  {
+    idx[j] = idx[j + tn->idx_len];
+  }
+  return 1;
+}
+
 
 
 /**
@@ -553,6 +680,28 @@ snmp_search_tree(struct mib_node *node, u8_t ident_len, s32_t *ident, struct snm
         return NULL;
       }
     }
+    else if(node_type == MIB_NODE_TB)
+    {
+      struct mib_table_node *tn;
+      u16_t i;
+
+      /* table node, the remaining identifier must start with a row */
+      tn = (struct mib_table_node *)node;
+      i = snmp_mib_table_lower(tn, ident_len, ident);
+      if ((i < tn->count) && (snmp_mib_table_cmp(tn, i, ident_len, ident) == 0))
+      {
+        /* point at the last index sub identifier, like a list leaf */
+        np->ident_len = ident_len - tn->idx_len + 1;
+        np->ident = ident + tn->idx_len - 1;
+        return (struct mib_node*)tn;
+      }
+      else
+      {
+        /* search failed */
+        LWIP_DEBUGF(SNMP_MIB_DEBUG,("tn search failed *ident==%"S32_F"\n",*ident));
+        return NULL;
+      }
+    }
     else if(node_type == MIB_NODE_EX)
     {
       struct mib_external_node *en;
@@ -672,6 +821,15 @@ empty_table(struct mib_node *node)
         empty = 1;
       }
     }
+    else if (node_type == MIB_NODE_TB)
+    {
+      struct mib_table_node *tn;
+      tn = (struct mib_table_node *)node;
+      if (tn->count == 0)
+      {
+        empty = 1;
+      }
+    }
   }
   return empty;
 }
@@ -929,6 +1087,37 @@ snmp_expand_tree(struct mib_node *node, u8_t ident_len, s32_t *ident, struct snm
         }
       }
     }
+    else if(node_type == MIB_NODE_TB)
+    {
+      struct mib_table_node *tn;
+      s32_t *idx;
+      u16_t i;
+      u8_t j;
+
+      /* table node, first row sorting after the remaining identifier */
+      tn = (struct mib_table_node *)node;
+      i = snmp_mib_table_lower(tn, ident_len, ident);
+      if ((i < tn->count) && (snmp_mib_table_cmp(tn, i, ident_len, ident) == 0))
+      {
+        /* ident names this row (or an instance below it), take the next */
+        i++;
+      }
+      if (i < tn->count)
+      {
+        idx = &tn->idx[i * tn->idx_len];
+        for (j = 0; j < tn->idx_len; j++)
+        {
+          oidret->id[oidret->len] = idx[j];
+          (oidret->len)++;
+        }
+        return (struct mib_node*)tn;
+      }
+      else
+      {
+        /* i == tn->count */
+        climb_tree = 1;
+      }
+    }
     else if(node_type == MIB_NODE_EX)
     {
       struct mib_external_node *en;
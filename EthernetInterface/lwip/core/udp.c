@@ -68,6 +68,56 @@
 /* exported in udp.h (was static) */
 struct udp_pcb *udp_pcbs;
 
+/* The same PCBs hashed by local port, chained through hash_next.
+ * udp_input() only walks the chain of the destination port. */
+#define UDP_PCB_HASH(port) ((((port) >> 8) ^ (port)) & (UDP_PCB_HASH_SIZE - 1))
+static struct udp_pcb *udp_pcb_hash[UDP_PCB_HASH_SIZE];
+
+/**
+ * Put a pcb into the hash chain of its local port.
+ */
+static void
+udp_hash_add(struct udp_pcb *pcb)
+{
+  struct udp_pcb **head = &udp_pcb_hash[UDP_PCB_HASH(pcb->local_port)];
+
+  pcb->hash_next = *head;
+  *head = pcb;
+}
+
+/**
+ * Take a pcb out of the hash chain of its local port, if it is in there.
+ */
+static void
+udp_hash_remove(struct udp_pcb *pcb)
+{
+  struct udp_pcb **pp;
+
+  for (pp = &udp_pcb_hash[UDP_PCB_HASH(pcb->local_port)]; *pp != NULL; pp = &(*pp)->hash_next) {
+    if (*pp == pcb) {
+      *pp = pcb->hash_next;
+      pcb->hash_next = NULL;
+      return;
+    }
+  }
+}
+
+/**
+ * Check whether any pcb is bound to a local port.
+ */
+static u8_t
+udp_port_used(u16_t port)
+{
+  struct udp_pcb *pcb;
+
+  for (pcb = udp_pcb_hash[UDP_PCB_HASH(port)]; pcb != NULL; pcb = pcb->hash_next) {
+    if (pcb->local_port == port) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
 /**
  * Process an incoming UDP datagram.
  *
@@ -155,11 +205,11 @@ udp_input(struct pbuf *p, struct netif *inp)
     prev = NULL;
     local_match = 0;
     uncon_pcb = NULL;
-    /* Iterate through the UDP pcb list for a matching pcb.
-     * 'Perfect match' pcbs (connected to the remote port & ip address) are
+    /* Iterate through the hash chain of the destination port for a matching
+     * pcb. 'Perfect match' pcbs (connected to the remote port & ip address) are
      * preferred. If no perfect match is found, the first unconnected pcb that
      * matches the local port and ip address gets the datagram. */
-    for (pcb = udp_pcbs; pcb != NULL; pcb = pcb->next) {
+    for (pcb = udp_pcb_hash[UDP_PCB_HASH(dest)]; pcb != NULL; pcb = pcb->hash_next) {
       local_match = 0;
       /* print the PCB local and remote address */
       LWIP_DEBUGF(UDP_DEBUG,
@@ -196,11 +246,11 @@ udp_input(struct pbuf *p, struct netif *inp)
            ip_addr_cmp(&(pcb->remote_ip), &current_iphdr_src))) {
         /* the first fully matching PCB */
         if (prev != NULL) {
-          /* move the pcb to the front of udp_pcbs so that is
+          /* move the pcb to the front of its hash chain so that is
              found faster next time */
-          prev->next = pcb->next;
-          pcb->next = udp_pcbs;
-          udp_pcbs = pcb;
+          prev->hash_next = pcb->hash_next;
+          pcb->hash_next = udp_pcb_hash[UDP_PCB_HASH(dest)];
+          udp_pcb_hash[UDP_PCB_HASH(dest)] = pcb;
         } else {
           UDP_STATS_INC(udp.cachehit);
         }
@@ -283,7 +333,7 @@ udp_input(struct pbuf *p, struct netif *inp)
            if SOF_REUSEADDR is set on the first match */
         struct udp_pcb *mpcb;
         u8_t p_header_changed = 0;
-        for (mpcb = udp_pcbs; mpcb != NULL; mpcb = mpcb->next) {
+        for (mpcb = udp_pcb_hash[UDP_PCB_HASH(dest)]; mpcb != NULL; mpcb = mpcb->hash_next) {
           if (mpcb != pcb) {
             /* compare PCB local addr+port to UDP destination addr+port */
             if ((mpcb->local_port == dest) &&
@@ -708,25 +758,31 @@ udp_bind(struct udp_pcb *pcb, ip_addr_t *ipaddr, u16_t port)
   LWIP_DEBUGF(UDP_DEBUG | LWIP_DBG_TRACE, (", port = %"U16_F")\n", port));
 
   rebind = 0;
-  /* Check for double bind and rebind of the same pcb */
-  for (ipcb = udp_pcbs; ipcb != NULL; ipcb = ipcb->next) {
-    /* is this UDP PCB already on active list? */
+  /* Check for rebind of the same pcb: a pcb on the active list is
+     always in the hash chain of its current local port */
+  for (ipcb = udp_pcb_hash[UDP_PCB_HASH(pcb->local_port)]; ipcb != NULL; ipcb = ipcb->hash_next) {
     if (pcb == ipcb) {
-      /* pcb may occur at most once in active list */
-      LWIP_ASSERT("rebind == 0", rebind == 0);
       /* pcb already in list, just rebind */
       rebind = 1;
+      break;
+    }
+  }
+
+  /* Check for double bind, only pcbs in the chain of port can use it */
+  for (ipcb = udp_pcb_hash[UDP_PCB_HASH(port)]; ipcb != NULL; ipcb = ipcb->hash_next) {
+    if (pcb == ipcb) {
+      continue;
     }
 
     /* By default, we don't allow to bind to a port that any other udp
        PCB is alread bound to, unless *all* PCBs with that port have tha
        REUSEADDR flag set. */
 #if SO_REUSE
-    else if (((pcb->so_options & SOF_REUSEADDR) == 0) &&
-             ((ipcb->so_options & SOF_REUSEADDR) == 0)) {
+    if (((pcb->so_options & SOF_REUSEADDR) == 0) &&
+        ((ipcb->so_options & SOF_REUSEADDR) == 0)) {
 #else /* SO_REUSE */
     /* port matches that of PCB in list and REUSEADDR not set -> reject */
-    else {
+    {
 #endif /* SO_REUSE */
       if ((ipcb->local_port == port) &&
           /* IP address matches, or one is IP_ADDR_ANY? */
@@ -752,25 +808,22 @@ udp_bind(struct udp_pcb *pcb, ip_addr_t *ipaddr, u16_t port)
 #define UDP_LOCAL_PORT_RANGE_END    0xffff
 #endif
     port = UDP_LOCAL_PORT_RANGE_START;
-    ipcb = udp_pcbs;
-    while ((ipcb != NULL) && (port != UDP_LOCAL_PORT_RANGE_END)) {
-      if (ipcb->local_port == port) {
-        /* port is already used by another udp_pcb */
-        port++;
-        /* restart scanning all udp pcbs */
-        ipcb = udp_pcbs;
-      } else {
-        /* go on with next udp pcb */
-        ipcb = ipcb->next;
+    /* only the hash chain of each candidate port has to be checked */
+    while (udp_port_used(port)) {
+      if (port == UDP_LOCAL_PORT_RANGE_END) {
+        /* no more ports available in local range */
+        LWIP_DEBUGF(UDP_DEBUG, ("udp_bind: out of free UDP ports\n"));
+        return ERR_USE;
       }
+      port++;
     }
-    if (ipcb != NULL) {
-      /* no more ports available in local range */
-      LWIP_DEBUGF(UDP_DEBUG, ("udp_bind: out of free UDP ports\n"));
-      return ERR_USE;
-    }
+  }
+  if (rebind != 0) {
+    /* the pcb moves to the hash chain of its new port */
+    udp_hash_remove(pcb);
   }
   pcb->local_port = port;
+  udp_hash_add(pcb);
   snmp_insert_udpidx_tree(pcb);
   /* pcb not active yet? */
   if (rebind == 0) {
@@ -852,6 +905,7 @@ udp_connect(struct udp_pcb *pcb, ip_addr_t *ipaddr, u16_t port)
   /* PCB not yet on the list, add PCB now */
   pcb->next = udp_pcbs;
   udp_pcbs = pcb;
+  udp_hash_add(pcb);
   return ERR_OK;
 }
 
@@ -901,6 +955,7 @@ udp_remove(struct udp_pcb *pcb)
   struct udp_pcb *pcb2;
 
   snmp_delete_udpidx_tree(pcb);
+  udp_hash_remove(pcb);
   /* pcb to be removed is first in list? */
   if (udp_pcbs == pcb) {
     /* make list start at 2nd pcb */
@@ -111,6 +111,8 @@ void dhcp_set_struct(struct netif *netif, struct dhcp *dhcp);
 void dhcp_cleanup(struct netif *netif);
 /** start DHCP configuration */
 err_t dhcp_start(struct netif *netif);
+/** start DHCP configuration by asking to keep an address leased before */
+err_t dhcp_start_reboot(struct netif *netif, ip_addr_t *ipaddr);
 /** enforce early lease renewal (not needed normally)*/
 err_t dhcp_renew(struct netif *netif);
 /** release the DHCP lease, usually called before dhcp_stop()*/
@@ -226,6 +228,7 @@ void dhcp_fine_tmr(void);
 #define DHCP_OPTION_CLIENT_ID 61
 #define DHCP_OPTION_TFTP_SERVERNAME 66
 #define DHCP_OPTION_BOOTFILE 67
+#define DHCP_OPTION_RAPID_COMMIT 80 /* RFC 4039 */
 
 /** possible combinations of overloading the file and sname fields with options */
 #define DHCP_OVERLOAD_NONE 0
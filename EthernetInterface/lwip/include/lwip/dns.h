@@ -110,6 +110,9 @@ ip_addr_t      dns_getserver(u8_t numdns);
 err_t          dns_gethostbyname(const char *hostname, ip_addr_t *addr,
                                  dns_found_callback found, void *callback_arg);
 
+u8_t           dns_cache_get(u8_t index, char *name, ip_addr_t *addr, u32_t *ttl);
+err_t          dns_cache_add(const char *name, ip_addr_t *addr, u32_t ttl);
+
 #if DNS_LOCAL_HOSTLIST && DNS_LOCAL_HOSTLIST_IS_DYNAMIC
 int            dns_local_removehost(const char *hostname, const ip_addr_t *addr);
 err_t          dns_local_addhost(const char *hostname, const ip_addr_t *addr);
@@ -82,10 +82,45 @@ typedef u16_t mem_size_t;
 /** mem_trim is not used when using pools instead of a heap:
     we can't free part of a pool element and don't want to copy the rest */
 #define mem_trim(mem, size) (mem)
+#elif MEM_SIZE_CLASSES
+/** Figures of one size class */
+struct mem_class_stats {
+  /** usable bytes of an element */
+  mem_size_t size;
+  /** elements in the class */
+  u16_t num;
+  /** elements in use */
+  u16_t used;
+  /** high-water mark of used */
+  u16_t max;
+  /** allocations of this size that failed */
+  u16_t err;
+  /** allocations of this size served by a bigger class */
+  u16_t spill;
+  /** bytes asked for by the elements in use */
+  u32_t requested;
+};
+
+void  mem_init(void);
+void *mem_trim(void *mem, mem_size_t size);
+u8_t  mem_class_stats(u8_t cls, struct mem_class_stats *stats);
 #else /* MEM_USE_POOLS */
+/** Fragmentation figures of the heap */
+struct mem_heap_stats {
+  /** bytes in use */
+  mem_size_t used;
+  /** bytes free */
+  mem_size_t free;
+  /** biggest block mem_malloc can return */
+  mem_size_t largest;
+  /** number of free blocks */
+  u16_t holes;
+};
+
 /* lwIP alternative malloc */
 void  mem_init(void);
 void *mem_trim(void *mem, mem_size_t size);
+void  mem_heap_stats(struct mem_heap_stats *stats);
 #endif /* MEM_USE_POOLS */
 void *mem_malloc(mem_size_t size);
 void *mem_calloc(mem_size_t count, mem_size_t size);
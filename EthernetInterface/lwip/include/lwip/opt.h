@@ -172,6 +172,17 @@
 #define MEM_USE_POOLS                   0
 #endif
 
+/**
+ * MEM_SIZE_CLASSES==1: Split the heap into size classes instead of a first
+ * fit heap. MEM_SIZE_CLASS_LIST(CLASS) must list the classes from the
+ * smallest up, as CLASS(element size, number of elements). An empty class
+ * borrows from the next bigger one. mem_malloc and mem_free take constant
+ * time and the heap cannot fragment; mem_class_stats() reports each class.
+ */
+#ifndef MEM_SIZE_CLASSES
+#define MEM_SIZE_CLASSES                0
+#endif
+
 /**
  * MEM_USE_POOLS_TRY_BIGGER_POOL==1: if one malloc-pool is empty, try the next
  * bigger pool - WARNING: THIS MIGHT WASTE MEMORY but it can make a system more
@@ -431,6 +442,23 @@
 #define ARP_TABLE_SIZE                  10
 #endif
 
+/**
+ * ETHARP_HASH_SIZE: Number of hash chains used to find the ARP entry of an
+ * IP address. Must be a power of 2.
+ */
+#ifndef ETHARP_HASH_SIZE
+#define ETHARP_HASH_SIZE                1
+#endif
+
+/**
+ * ETHARP_PROACTIVE_REFRESH==1: A stable ARP entry that is still used at 90%
+ * of its age is refreshed with a unicast request, so it does not expire and
+ * stall the packets of a busy peer while it is re-resolved.
+ */
+#ifndef ETHARP_PROACTIVE_REFRESH
+#define ETHARP_PROACTIVE_REFRESH        0
+#endif
+
 /**
  * ARP_QUEUEING==1: Multiple outgoing packets are queued during hardware address
  * resolution. By default, only the most recent packet is queued per IP address.
@@ -665,6 +693,28 @@
 #define DHCP_DOES_ARP_CHECK             ((LWIP_DHCP) && (LWIP_ARP))
 #endif
 
+/**
+ * DHCP_ARP_CHECK_TRIES: Number of ARP requests sent for the offered address
+ * before it is taken, each one waits DHCP_ARP_CHECK_MSECS for a reply
+ * (rounded up to the DHCP fine timer). (requires DHCP_DOES_ARP_CHECK)
+ */
+#ifndef DHCP_ARP_CHECK_TRIES
+#define DHCP_ARP_CHECK_TRIES            2
+#endif
+
+#ifndef DHCP_ARP_CHECK_MSECS
+#define DHCP_ARP_CHECK_MSECS            500
+#endif
+
+/**
+ * LWIP_DHCP_RAPID_COMMIT==1: Ask for the Rapid Commit option (RFC 4039) in
+ * DISCOVER messages. A server supporting it answers with an ACK right away,
+ * saving the REQUEST/ACK round trip.
+ */
+#ifndef LWIP_DHCP_RAPID_COMMIT
+#define LWIP_DHCP_RAPID_COMMIT          0
+#endif
+
 /*
    ------------------------------------
    ---------- AUTOIP options ----------
@@ -769,6 +819,26 @@
 #define SNMP_MAX_VALUE_SIZE             LWIP_MAX((SNMP_MAX_OCTET_STRING_LEN)+1, sizeof(s32_t)*(SNMP_MAX_TREE_DEPTH))
 #endif
 
+/**
+ * SNMP_SORTED_TABLES==1: Keep the indexes of atTable, ipNetToMediaTable,
+ * ipAddrTable, ipRouteTable and udpTable as sorted arrays of rows in static
+ * memory, updated when an entry comes or goes. GET and GETNEXT find a row
+ * by binary search and nothing is taken from MEMP_SNMP_NODE/ROOTNODE.
+ * Tables hold ARP_TABLE_SIZE, SNMP_NETIF_ROWS (+1 default route) and
+ * MEMP_NUM_UDP_PCB rows.
+ */
+#ifndef SNMP_SORTED_TABLES
+#define SNMP_SORTED_TABLES              0
+#endif
+
+/**
+ * SNMP_NETIF_ROWS: Number of network interfaces listed in ipAddrTable and
+ * ipRouteTable. (requires SNMP_SORTED_TABLES)
+ */
+#ifndef SNMP_NETIF_ROWS
+#define SNMP_NETIF_ROWS                 2
+#endif
+
 /*
    ----------------------------------
    ---------- IGMP options ----------
@@ -819,6 +889,27 @@
 #define DNS_MSG_SIZE                    512
 #endif
 
+/** DNS_NEG_TTL: Longest time in seconds a name reported as non-existent
+ * (NXDOMAIN) is remembered, the SOA minimum of the answer is used if it is
+ * shorter (RFC 2308). 0 disables negative caching. */
+#ifndef DNS_NEG_TTL
+#define DNS_NEG_TTL                     0
+#endif
+
+/** DNS_PREFETCH_TTL: A cached name that was looked up since it was resolved
+ * is queried again this many seconds before it expires. Lookups keep being
+ * answered from the cache meanwhile. 0 disables prefetching. */
+#ifndef DNS_PREFETCH_TTL
+#define DNS_PREFETCH_TTL                0
+#endif
+
+/** DNS_PARALLEL_SERVERS==1: Send every query to all the configured DNS
+ * servers at once and take the first answer, instead of trying the next
+ * server after DNS_MAX_RETRIES timeouts. */
+#ifndef DNS_PARALLEL_SERVERS
+#define DNS_PARALLEL_SERVERS            0
+#endif
+
 /** DNS_LOCAL_HOSTLIST: Implements a local host-to-address list. If enabled,
  *  you have to define
  *    #define DNS_LOCAL_HOSTLIST_INIT {{"host1", 0x123}, {"host2", 0x234}}
@@ -858,6 +949,14 @@
 #define LWIP_UDPLITE                    0
 #endif
 
+/**
+ * UDP_PCB_HASH_SIZE: number of hash chains udp_input() uses to find the
+ * pcb for a local port. Must be a power of 2.
+ */
+#ifndef UDP_PCB_HASH_SIZE
+#define UDP_PCB_HASH_SIZE               8
+#endif
+
 /**
  * UDP_TTL: Default Time-To-Live value.
  */
@@ -1397,6 +1496,24 @@
 #define LWIP_POSIX_SOCKETS_IO_NAMES     1
 #endif
 
+/**
+ * LWIP_SOCKET_EVENT_HOOK==1: Enable lwip_sockevent() and lwip_sockstate()
+ * to be told about socket events without calling lwip_select().
+ * (only used if you use sockets.c)
+ */
+#ifndef LWIP_SOCKET_EVENT_HOOK
+#define LWIP_SOCKET_EVENT_HOOK          0
+#endif
+
+/**
+ * LWIP_SOCKET_BATCH==1: Enable lwip_sendmmsg() to queue several UDP
+ * datagrams in one tcpip_thread message, referencing the caller's buffers
+ * instead of copying them. (only used if you use sockets.c)
+ */
+#ifndef LWIP_SOCKET_BATCH
+#define LWIP_SOCKET_BATCH               0
+#endif
+
 /**
  * LWIP_TCP_KEEPALIVE==1: Enable TCP_KEEPIDLE, TCP_KEEPINTVL and TCP_KEEPCNT
  * options processing. Note that TCP_KEEPIDLE and TCP_KEEPINTVL have to be set
@@ -101,6 +101,8 @@ struct snmp_name_ptr
 #define MIB_NODE_LR 0x04
 /** MIB node for external objects */
 #define MIB_NODE_EX 0x05
+/** MIB table node (sorted array of index rows in RAM) */
+#define MIB_NODE_TB 0x06
 
 /** node "base class" layout, the mandatory fields for a node  */
 struct mib_node
@@ -231,6 +233,29 @@ struct mib_external_node
   void (*set_value_pc)(u8_t rid, struct obj_def *od);
 };
 
+/** derived node, keeps the complete index of every table row
+    (idx_len sub-identifiers each) in one array sorted in ascending order,
+    a row is found by binary search instead of walking a list per level */
+struct mib_table_node
+{
+  /* inherited "base class" members */
+  void (*get_object_def)(u8_t ident_len, s32_t *ident, struct obj_def *od);
+  void (*get_value)(struct obj_def *od, u16_t len, void *value);
+  u8_t (*set_test)(struct obj_def *od, u16_t len, void *value);
+  void (*set_value)(struct obj_def *od, u16_t len, void *value);
+
+  u8_t node_type;
+  /* number of rows idx has room for */
+  u16_t maxlength;
+
+  /* additional struct members */
+  /* sub-identifiers per row */
+  u8_t idx_len;
+  /* counts rows in use */
+  u16_t count;
+  s32_t *idx;
+};
+
 /** export MIB tree from mib2.c */
 extern const struct mib_array_node internet;
 
@@ -254,6 +279,9 @@ s8_t snmp_mib_node_insert(struct mib_list_rootnode *rn, s32_t objid, struct mib_
 s8_t snmp_mib_node_find(struct mib_list_rootnode *rn, s32_t objid, struct mib_list_node **fn);
 struct mib_list_rootnode *snmp_mib_node_delete(struct mib_list_rootnode *rn, struct mib_list_node *n);
 
+s8_t snmp_mib_table_insert(struct mib_table_node *tn, s32_t *row);
+u8_t snmp_mib_table_delete(struct mib_table_node *tn, s32_t *row);
+
 struct mib_node* snmp_search_tree(struct mib_node *node, u8_t ident_len, s32_t *ident, struct snmp_name_ptr *np);
 struct mib_node* snmp_expand_tree(struct mib_node *node, u8_t ident_len, s32_t *ident, struct snmp_obj_id *oidret);
 u8_t snmp_iso_prefix_tst(u8_t ident_len, s32_t *ident);
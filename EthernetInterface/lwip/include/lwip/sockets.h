@@ -42,6 +42,9 @@
 
 #include "lwip/ip_addr.h"
 #include "lwip/inet.h"
+#if LWIP_SOCKET_BATCH
+#include "lwip/pbuf.h"
+#endif /* LWIP_SOCKET_BATCH */
 
 #ifdef __cplusplus
 extern "C" {
@@ -340,6 +343,61 @@ int lwip_select(int maxfdp1, fd_set *readset, fd_set *writeset, fd_set *exceptse
 int lwip_ioctl(int s, long cmd, void *argp);
 int lwip_fcntl(int s, int cmd, int val);
 
+#if LWIP_SOCKET_EVENT_HOOK
+/* Flags returned by lwip_sockstate() */
+#define LWIP_SOCK_READABLE    0x01
+#define LWIP_SOCK_WRITABLE    0x02
+#define LWIP_SOCK_ERROR       0x04
+
+/** Function called on every event of a socket, see lwip_sockevent() */
+typedef void (*lwip_sockevent_fn)(int s, void *arg);
+
+int lwip_sockevent(int s, lwip_sockevent_fn fn, void *arg);
+int lwip_sockstate(int s);
+#endif /* LWIP_SOCKET_EVENT_HOOK */
+
+#if LWIP_SOCKET_BATCH
+struct netconn;
+struct lwip_mmsg_batch;
+
+/** One datagram of a batch passed to lwip_sendmmsg() */
+struct lwip_mmsg {
+  /** pbuf referencing data while the stack uses it, must be first */
+  struct pbuf_custom ref;
+  /** next datagram of the batch, NULL for the last one */
+  struct lwip_mmsg *next;
+  /** payload, must not change until the batch is done */
+  void *data;
+  /** payload length */
+  u16_t len;
+  /** destination, NULL to send to the connected remote */
+  const struct sockaddr_in *addr;
+  /** set by the stack: bytes sent or -1 */
+  int result;
+  /** batch the datagram belongs to, set by lwip_sendmmsg() */
+  struct lwip_mmsg_batch *batch;
+};
+
+/** Function called when the stack no longer references a batch */
+typedef void (*lwip_mmsg_done_fn)(struct lwip_mmsg_batch *batch);
+
+/** A list of datagrams sent by one tcpip_thread message */
+struct lwip_mmsg_batch {
+  /** first datagram */
+  struct lwip_mmsg *msgs;
+  /** called from tcpip_thread or the netif driver once every datagram
+      was sent (or failed) and its payload is released */
+  lwip_mmsg_done_fn done;
+  /** argument for done */
+  void *arg;
+  /* private: set by lwip_sendmmsg() */
+  struct netconn *conn;
+  int pending;
+};
+
+int lwip_sendmmsg(int s, struct lwip_mmsg_batch *batch);
+#endif /* LWIP_SOCKET_BATCH */
+
 #if LWIP_COMPAT_SOCKETS
 #define accept(a,b,c)         lwip_accept(a,b,c)
 #define bind(a,b,c)           lwip_bind(a,b,c)
@@ -95,6 +95,8 @@ struct udp_pcb {
 /* Protocol specific PCB members */
 
   struct udp_pcb *next;
+  /** chain of pcbs with the same local port hash */
+  struct udp_pcb *hash_next;
 
   u8_t flags;
   /** ports are in host byte order */
@@ -37,7 +37,8 @@
 #define DEFAULT_RAW_RECVMBOX_SIZE   8
 #define DEFAULT_ACCEPTMBOX_SIZE     8
 
-#define TCPIP_THREAD_STACKSIZE      1024
+// TCPRawServer handlers (file server) use FatFs from the tcpip thread
+#define TCPIP_THREAD_STACKSIZE      2048
 #define TCPIP_THREAD_PRIO           (osPriorityNormal)
 
 #define DEFAULT_THREAD_STACKSIZE    512
@@ -51,23 +52,37 @@
 #define PBUF_POOL_SIZE              5
 #define MEMP_NUM_TCP_PCB_LISTEN     4
 #define MEMP_NUM_TCP_PCB            4
-#define MEMP_NUM_PBUF               8
+// one per segment sent without copy by TCPRawServer
+#define MEMP_NUM_PBUF               16
 
 #define TCP_QUEUE_OOSEQ             0
 #define TCP_OVERSIZE                0
 
 #define LWIP_DHCP                   1
+#define DHCP_ARP_CHECK_TRIES        1
+#define LWIP_DHCP_RAPID_COMMIT      1
 #define LWIP_DNS                    1
+#define DNS_TABLE_SIZE              16
+#define DNS_MAX_NAME_LENGTH         64
+#define DNS_NEG_TTL                 60
+#define DNS_PREFETCH_TTL            30
+#define DNS_PARALLEL_SERVERS        1
+
+// table indexes of the SNMP agent in sorted arrays, when LWIP_SNMP is turned on
+#define SNMP_SORTED_TABLES          1
 
 // Support Multicast
 #include "stdlib.h"
 #define LWIP_IGMP                   1
+#define UDP_PCB_HASH_SIZE           16
 #define LWIP_RAND()                 rand()
 
 #define LWIP_COMPAT_SOCKETS         0
 #define LWIP_POSIX_SOCKETS_IO_NAMES 0
 #define LWIP_SO_RCVTIMEO            1
 #define LWIP_TCP_KEEPALIVE          1
+#define LWIP_SOCKET_EVENT_HOOK      1
+#define LWIP_SOCKET_BATCH           1
 
 // Debug Options
 // #define LWIP_DEBUG
@@ -119,6 +134,13 @@
 
 #define LWIP_BROADCAST_PING         1
 
+// ARP
+#define ARP_TABLE_SIZE              16
+#define ETHARP_HASH_SIZE            8
+#define ETHARP_PROACTIVE_REFRESH    1
+#define ETHARP_SUPPORT_STATIC_ENTRIES 1
+#define LWIP_NETIF_HWADDRHINT       1
+
 #define LWIP_CHECKSUM_ON_COPY       1
 
 #define LWIP_NETIF_HOSTNAME         1
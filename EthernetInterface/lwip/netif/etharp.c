@@ -81,12 +81,22 @@ const struct eth_addr ethzero = {{0,0,0,0,0,0}};
  */
 #define ARP_MAXPENDING 2
 
+#if ETHARP_PROACTIVE_REFRESH
+/** the age at which a stable entry that is still used gets refreshed with
+ *  a unicast request, 90% of ARP_MAXAGE, this is
+ *  (216 * 5) seconds = 18 minutes.
+ */
+#define ARP_REFRESH_AGE (ARP_MAXAGE - ARP_MAXAGE / 10)
+#endif /* ETHARP_PROACTIVE_REFRESH */
+
 #define HWTYPE_ETHERNET 1
 
 enum etharp_state {
   ETHARP_STATE_EMPTY = 0,
   ETHARP_STATE_PENDING,
-  ETHARP_STATE_STABLE
+  ETHARP_STATE_STABLE,
+  /** stable, a unicast refresh request was sent during this timer period */
+  ETHARP_STATE_STABLE_REFRESH
 };
 
 struct etharp_entry {
@@ -104,6 +114,8 @@ struct etharp_entry {
 #endif /* LWIP_SNMP */
   u8_t state;
   u8_t ctime;
+  /** next entry in the same hash chain + 1, 0 ends the chain */
+  u8_t hash_next;
 #if ETHARP_SUPPORT_STATIC_ENTRIES
   u8_t static_entry;
 #endif /* ETHARP_SUPPORT_STATIC_ENTRIES */
@@ -111,6 +123,10 @@ struct etharp_entry {
 
 static struct etharp_entry arp_table[ARP_TABLE_SIZE];
 
+/** Entries hashed by IP address, first entry of each chain + 1, 0 if empty */
+#define ETHARP_HASH(ipaddr) ((ip4_addr3(ipaddr) ^ ip4_addr4(ipaddr)) & (ETHARP_HASH_SIZE - 1))
+static u8_t arp_hash[ETHARP_HASH_SIZE];
+
 #if !LWIP_NETIF_HWADDRHINT
 static u8_t etharp_cached_entry;
 #endif /* !LWIP_NETIF_HWADDRHINT */
@@ -129,9 +145,15 @@ static u8_t etharp_cached_entry;
 #endif /* LWIP_NETIF_HWADDRHINT */
 
 static err_t update_arp_entry(struct netif *netif, ip_addr_t *ipaddr, struct eth_addr *ethaddr, u8_t flags);
+#if ETHARP_PROACTIVE_REFRESH
+static err_t etharp_request_dst(struct netif *netif, ip_addr_t *ipaddr, const struct eth_addr *hw_dst_addr);
+#endif /* ETHARP_PROACTIVE_REFRESH */
 
 
 /* Some checks, instead of etharp_init(): */
+#if (LWIP_ARP && ((ETHARP_HASH_SIZE & (ETHARP_HASH_SIZE - 1)) != 0))
+  #error "ETHARP_HASH_SIZE must be a power of 2"
+#endif
 #if (LWIP_ARP && (ARP_TABLE_SIZE > 0x7f))
   #error "ARP_TABLE_SIZE must fit in an s8_t, you have to reduce it in your lwipopts.h"
 #endif
@@ -164,12 +186,29 @@ free_etharp_q(struct etharp_q_entry *q)
 
 #endif /* ARP_QUEUEING */
 
+/** Take an entry out of the hash chain of its IP address, if it is in there */
+static void
+unhash_entry(u8_t i)
+{
+  u8_t *pn;
+
+  for (pn = &arp_hash[ETHARP_HASH(&arp_table[i].ipaddr)]; *pn != 0; pn = &arp_table[*pn - 1].hash_next) {
+    if (*pn == i + 1) {
+      *pn = arp_table[i].hash_next;
+      arp_table[i].hash_next = 0;
+      return;
+    }
+  }
+}
+
 /** Clean up ARP table entries */
 static void
 free_entry(int i)
 {
   /* remove from SNMP ARP index tree */
   snmp_delete_arpidx_tree(arp_table[i].netif, &arp_table[i].ipaddr);
+  /* and from the hash chain */
+  unhash_entry((u8_t)i);
   /* and empty packet queue */
   if (arp_table[i].q != NULL) {
     /* remove all queued packets */
@@ -219,9 +258,12 @@ etharp_tmr(void)
            (arp_table[i].ctime >= ARP_MAXPENDING))) {
         /* pending or stable entry has become old! */
         LWIP_DEBUGF(ETHARP_DEBUG, ("etharp_timer: expired %s entry %"U16_F".\n",
-             arp_table[i].state == ETHARP_STATE_STABLE ? "stable" : "pending", (u16_t)i));
+             arp_table[i].state >= ETHARP_STATE_STABLE ? "stable" : "pending", (u16_t)i));
         /* clean up entries that have just been expired */
         free_entry(i);
+      } else if (arp_table[i].state == ETHARP_STATE_STABLE_REFRESH) {
+        /* no reply to the refresh yet, the next use may ask again */
+        arp_table[i].state = ETHARP_STATE_STABLE;
       }
 #if ARP_QUEUEING
       /* still pending entry? (not expired) */
@@ -266,18 +308,37 @@ find_entry(ip_addr_t *ipaddr, u8_t flags)
   u8_t age_queue = 0;
 
   /**
-   * a) do a search through the cache, remember candidates
-   * b) select candidate entry
-   * c) create new entry
+   * a) look for a matching entry in the hash chain of ipaddr
+   * b) do a search through the cache, remember candidates
+   * c) select candidate entry
+   * d) create new entry
    */
 
-  /* a) in a single search sweep, do all of this
+  /* a) a matching IP entry, either pending or stable, can only be in the
+   *    hash chain of the address */
+  if (ipaddr != NULL) {
+    u8_t n;
+    for (n = arp_hash[ETHARP_HASH(ipaddr)]; n != 0; n = arp_table[n - 1].hash_next) {
+      if ((arp_table[n - 1].state != ETHARP_STATE_EMPTY) &&
+          ip_addr_cmp(ipaddr, &arp_table[n - 1].ipaddr)) {
+        LWIP_DEBUGF(ETHARP_DEBUG | LWIP_DBG_TRACE, ("find_entry: found matching entry %"U16_F"\n", (u16_t)(n - 1)));
+        /* found exact IP address match, simply bail out */
+        return (s8_t)(n - 1);
+      }
+    }
+  }
+
+  /* don't create new entry, only search? */
+  if ((flags & ETHARP_FLAG_FIND_ONLY) != 0) {
+    LWIP_DEBUGF(ETHARP_DEBUG | LWIP_DBG_TRACE, ("find_entry: no matching entry found\n"));
+    return (s8_t)ERR_MEM;
+  }
+
+  /* b) in a single search sweep, do all of this
    * 1) remember the first empty entry (if any)
    * 2) remember the oldest stable entry (if any)
    * 3) remember the oldest pending entry without queued packets (if any)
    * 4) remember the oldest pending entry with queued packets (if any)
-   * 5) search for a matching IP entry, either pending or stable
-   *    until 5 matches, or all entries are searched for.
    */
 
   for (i = 0; i < ARP_TABLE_SIZE; ++i) {
@@ -288,14 +349,8 @@ find_entry(ip_addr_t *ipaddr, u8_t flags)
       /* remember first empty entry */
       empty = i;
     } else if (state != ETHARP_STATE_EMPTY) {
-      LWIP_ASSERT("state == ETHARP_STATE_PENDING || state == ETHARP_STATE_STABLE",
-        state == ETHARP_STATE_PENDING || state == ETHARP_STATE_STABLE);
-      /* if given, does IP address match IP address in ARP entry? */
-      if (ipaddr && ip_addr_cmp(ipaddr, &arp_table[i].ipaddr)) {
-        LWIP_DEBUGF(ETHARP_DEBUG | LWIP_DBG_TRACE, ("find_entry: found matching entry %"U16_F"\n", (u16_t)i));
-        /* found exact IP address match, simply bail out */
-        return i;
-      }
+      LWIP_ASSERT("state == ETHARP_STATE_PENDING || state >= ETHARP_STATE_STABLE",
+        state == ETHARP_STATE_PENDING || state >= ETHARP_STATE_STABLE);
       /* pending entry? */
       if (state == ETHARP_STATE_PENDING) {
         /* pending with queued packets? */
@@ -313,7 +368,7 @@ find_entry(ip_addr_t *ipaddr, u8_t flags)
           }
         }
       /* stable entry? */
-      } else if (state == ETHARP_STATE_STABLE) {
+      } else if (state >= ETHARP_STATE_STABLE) {
 #if ETHARP_SUPPORT_STATIC_ENTRIES
         /* don't record old_stable for static entries since they never expire */
         if (arp_table[i].static_entry == 0)
@@ -330,15 +385,13 @@ find_entry(ip_addr_t *ipaddr, u8_t flags)
   }
   /* { we have no match } => try to create a new entry */
    
-  /* don't create new entry, only search? */
-  if (((flags & ETHARP_FLAG_FIND_ONLY) != 0) ||
-      /* or no empty entry found and not allowed to recycle? */
-      ((empty == ARP_TABLE_SIZE) && ((flags & ETHARP_FLAG_TRY_HARD) == 0))) {
+  /* no empty entry found and not allowed to recycle? */
+  if ((empty == ARP_TABLE_SIZE) && ((flags & ETHARP_FLAG_TRY_HARD) == 0)) {
     LWIP_DEBUGF(ETHARP_DEBUG | LWIP_DBG_TRACE, ("find_entry: no empty entry found and not allowed to recycle\n"));
     return (s8_t)ERR_MEM;
   }
   
-  /* b) choose the least destructive entry to recycle:
+  /* c) choose the least destructive entry to recycle:
    * 1) empty entry
    * 2) oldest stable entry
    * 3) oldest pending entry without queued packets
@@ -386,8 +439,13 @@ find_entry(ip_addr_t *ipaddr, u8_t flags)
 
   /* IP address given? */
   if (ipaddr != NULL) {
-    /* set IP address */
+    u8_t h;
+    /* set IP address and move the entry to the hash chain of it */
+    unhash_entry(i);
     ip_addr_copy(arp_table[i].ipaddr, *ipaddr);
+    h = ETHARP_HASH(ipaddr);
+    arp_table[i].hash_next = arp_hash[h];
+    arp_hash[h] = i + 1;
   }
   arp_table[i].ctime = 0;
 #if ETHARP_SUPPORT_STATIC_ENTRIES
@@ -557,7 +615,7 @@ etharp_remove_static_entry(ip_addr_t *ipaddr)
     return (err_t)i;
   }
 
-  if ((arp_table[i].state != ETHARP_STATE_STABLE) ||
+  if ((arp_table[i].state < ETHARP_STATE_STABLE) ||
     (arp_table[i].static_entry == 0)) {
     /* entry wasn't a static entry, cannot remove it */
     return ERR_ARG;
@@ -591,7 +649,7 @@ etharp_find_addr(struct netif *netif, ip_addr_t *ipaddr,
   LWIP_UNUSED_ARG(netif);
 
   i = find_entry(ipaddr, ETHARP_FLAG_FIND_ONLY);
-  if((i >= 0) && arp_table[i].state == ETHARP_STATE_STABLE) {
+  if((i >= 0) && arp_table[i].state >= ETHARP_STATE_STABLE) {
       *eth_ret = &arp_table[i].ethaddr;
       *ip_ret = &arp_table[i].ipaddr;
       return i;
@@ -599,6 +657,34 @@ etharp_find_addr(struct netif *netif, ip_addr_t *ipaddr,
   return -1;
 }
 
+/**
+ * Reads an entry of the ARP table by its index, e.g. to list the table.
+ *
+ * @param i table index, 0 to ARP_TABLE_SIZE - 1
+ * @param ipaddr points to return pointer for the IP address
+ * @param eth_ret points to return pointer for the ethernet address
+ * @return 1 for a stable entry, 2 for a static one, 0 if the index is
+ *         empty, pending or out of range
+ */
+u8_t
+etharp_get_entry(u8_t i, ip_addr_t **ipaddr, struct eth_addr **eth_ret)
+{
+  LWIP_ASSERT("ipaddr != NULL && eth_ret != NULL",
+    ipaddr != NULL && eth_ret != NULL);
+
+  if ((i < ARP_TABLE_SIZE) && (arp_table[i].state >= ETHARP_STATE_STABLE)) {
+    *ipaddr = &arp_table[i].ipaddr;
+    *eth_ret = &arp_table[i].ethaddr;
+#if ETHARP_SUPPORT_STATIC_ENTRIES
+    if (arp_table[i].static_entry) {
+      return 2;
+    }
+#endif /* ETHARP_SUPPORT_STATIC_ENTRIES */
+    return 1;
+  }
+  return 0;
+}
+
 #if ETHARP_TRUST_IP_MAC
 /**
  * Updates the ARP table using the given IP packet.
@@ -815,6 +901,35 @@ etharp_arp_input(struct netif *netif, struct eth_addr *ethaddr, struct pbuf *p)
   pbuf_free(p);
 }
 
+/**
+ * Send an IP packet to a stable ARP entry. An entry that is still used
+ * close to its expiry is refreshed with a unicast request to the known
+ * address, so busy peers never fall back to a broadcast re-resolution
+ * that stalls their packets.
+ *
+ * @param netif the lwIP network interface on which to send the packet
+ * @param q the packet, payload pointing to the ethernet header
+ * @param i index of a stable ARP entry
+ * @return the return value of etharp_send_ip()
+ */
+static err_t
+etharp_output_to_entry(struct netif *netif, struct pbuf *q, s8_t i)
+{
+#if ETHARP_PROACTIVE_REFRESH
+  if ((arp_table[i].state == ETHARP_STATE_STABLE) &&
+#if ETHARP_SUPPORT_STATIC_ENTRIES
+      (arp_table[i].static_entry == 0) &&
+#endif /* ETHARP_SUPPORT_STATIC_ENTRIES */
+      (arp_table[i].ctime >= ARP_REFRESH_AGE)) {
+    if (etharp_request_dst(netif, &arp_table[i].ipaddr, &arp_table[i].ethaddr) == ERR_OK) {
+      /* only one request per timer period, the reply resets ctime */
+      arp_table[i].state = ETHARP_STATE_STABLE_REFRESH;
+    }
+  }
+#endif /* ETHARP_PROACTIVE_REFRESH */
+  return etharp_send_ip(netif, q, (struct eth_addr*)(netif->hwaddr), &arp_table[i].ethaddr);
+}
+
 /**
  * Resolve and fill-in Ethernet address header for outgoing IP packet.
  *
@@ -899,12 +1014,11 @@ etharp_output(struct netif *netif, struct pbuf *q, ip_addr_t *ipaddr)
       u8_t etharp_cached_entry = *(netif->addr_hint);
       if (etharp_cached_entry < ARP_TABLE_SIZE) {
 #endif /* LWIP_NETIF_HWADDRHINT */
-        if ((arp_table[etharp_cached_entry].state == ETHARP_STATE_STABLE) &&
+        if ((arp_table[etharp_cached_entry].state >= ETHARP_STATE_STABLE) &&
             (ip_addr_cmp(ipaddr, &arp_table[etharp_cached_entry].ipaddr))) {
           /* the per-pcb-cached entry is stable and the right one! */
           ETHARP_STATS_INC(etharp.cachehit);
-          return etharp_send_ip(netif, q, (struct eth_addr*)(netif->hwaddr),
-            &arp_table[etharp_cached_entry].ethaddr);
+          return etharp_output_to_entry(netif, q, etharp_cached_entry);
         }
 #if LWIP_NETIF_HWADDRHINT
       }
@@ -956,7 +1070,6 @@ etharp_output(struct netif *netif, struct pbuf *q, ip_addr_t *ipaddr)
 err_t
 etharp_query(struct netif *netif, ip_addr_t *ipaddr, struct pbuf *q)
 {
-  struct eth_addr * srcaddr = (struct eth_addr *)netif->hwaddr;
   err_t result = ERR_MEM;
   s8_t i; /* ARP entry index */
 
@@ -989,7 +1102,7 @@ etharp_query(struct netif *netif, ip_addr_t *ipaddr, struct pbuf *q)
   /* { i is either a STABLE or (new or existing) PENDING entry } */
   LWIP_ASSERT("arp_table[i].state == PENDING or STABLE",
   ((arp_table[i].state == ETHARP_STATE_PENDING) ||
-   (arp_table[i].state == ETHARP_STATE_STABLE)));
+   (arp_table[i].state >= ETHARP_STATE_STABLE)));
 
   /* do we have a pending entry? or an implicit query request? */
   if ((arp_table[i].state == ETHARP_STATE_PENDING) || (q == NULL)) {
@@ -1009,11 +1122,11 @@ etharp_query(struct netif *netif, ip_addr_t *ipaddr, struct pbuf *q)
   /* packet given? */
   LWIP_ASSERT("q != NULL", q != NULL);
   /* stable entry? */
-  if (arp_table[i].state == ETHARP_STATE_STABLE) {
+  if (arp_table[i].state >= ETHARP_STATE_STABLE) {
     /* we have a valid IP->Ethernet address mapping */
     ETHARP_SET_HINT(netif, i);
     /* send the packet */
-    result = etharp_send_ip(netif, q, srcaddr, &(arp_table[i].ethaddr));
+    result = etharp_output_to_entry(netif, q, i);
   /* pending entry? (either just created or already pending */
   } else if (arp_table[i].state == ETHARP_STATE_PENDING) {
     /* entry is still pending, queue the given packet 'q' */
@@ -1202,6 +1315,28 @@ etharp_request(struct netif *netif, ip_addr_t *ipaddr)
                     (struct eth_addr *)netif->hwaddr, &netif->ip_addr, &ethzero,
                     ipaddr, ARP_REQUEST);
 }
+
+#if ETHARP_PROACTIVE_REFRESH
+/**
+ * Send a unicast ARP request packet asking for ipaddr to the ethernet
+ * address it had so far, to refresh an ARP entry without a broadcast.
+ *
+ * @param netif the lwip network interface on which to send the request
+ * @param ipaddr the IP address for which to ask
+ * @param hw_dst_addr the ethernet address known for ipaddr
+ * @return ERR_OK if the request has been sent
+ *         ERR_MEM if the ARP packet couldn't be allocated
+ *         any other err_t on failure
+ */
+static err_t
+etharp_request_dst(struct netif *netif, ip_addr_t *ipaddr, const struct eth_addr *hw_dst_addr)
+{
+  LWIP_DEBUGF(ETHARP_DEBUG | LWIP_DBG_TRACE, ("etharp_request_dst: sending unicast ARP request.\n"));
+  return etharp_raw(netif, (struct eth_addr *)netif->hwaddr, hw_dst_addr,
+                    (struct eth_addr *)netif->hwaddr, &netif->ip_addr, &ethzero,
+                    ipaddr, ARP_REQUEST);
+}
+#endif /* ETHARP_PROACTIVE_REFRESH */
 #endif /* LWIP_ARP */
 
 /**
@@ -0,0 +1,226 @@
+/* Host test of the DHCP reboot and rapid commit paths
+ *
+ * Builds and runs on the host, without the mbed tree:
+ *
+ *   gcc -Istub -I.. -I../include -I../include/ipv4 -I../../lwip-sys -I../../lwip-sys/arch -I../../lwip-eth/arch/TARGET_NXP \
+ *       -I../../../mbed-rtos/rtx/TARGET_CORTEX_M -I../../../mbed-src/targets/cmsis \
+ *       -I../../../mbed-src/targets/cmsis/TARGET_NXP/TARGET_LPC176X -DTARGET_LPC1768 \
+ *       dhcp_test.c ../core/pbuf.c ../core/mem.c ../core/memp.c ../core/def.c \
+ *       ../core/ipv4/ip_addr.c ../core/ipv4/inet_chksum.c -o dhcp_test && ./dhcp_test
+ *
+ * Plays the server to the client: answers its messages as they are sent
+ * and runs the fine timer between them, counting the 500 ms ticks until
+ * the netif is up. Checks that a reboot onto the saved lease takes one
+ * REQUEST/ACK and no tick, with the configuration taken from the ACK,
+ * that a NAK or no answer fall back to discovery, that a rapid commit
+ * ACK skips the REQUEST, that an ACK without option 80 is ignored while
+ * selecting, and how many ARP probes and ticks the check of a new
+ * address takes.
+ */
+#include "../core/dhcp.c"
+#include "lwip/sys.h"
+
+#include <stdio.h>
+
+#define SERVER      "10.0.0.254"
+#define LEASED      "10.0.0.42"
+
+static int failures;
+
+// What dhcp.c uses from netif.c, etharp.c, udp.c and dns.c, the messages
+// sent are kept here
+static struct netif netif;
+struct netif *netif_list = &netif;
+static struct udp_pcb pcb;
+static u8_t sent_type;
+static int nsent, probes;
+static ip_addr_t sent_requested, sent_server;
+static int sent_rapid;
+static u32_t sent_xid;
+
+sys_prot_t sys_arch_protect(void) { return 0; }
+void sys_arch_unprotect(sys_prot_t pval) {}
+struct udp_pcb *udp_new(void) { return &pcb; }
+void udp_remove(struct udp_pcb *pcb) {}
+err_t udp_bind(struct udp_pcb *pcb, ip_addr_t *ipaddr, u16_t port) { return ERR_OK; }
+err_t udp_connect(struct udp_pcb *pcb, ip_addr_t *ipaddr, u16_t port) { return ERR_OK; }
+void udp_recv(struct udp_pcb *pcb, udp_recv_fn recv, void *recv_arg) {}
+void dns_setserver(u8_t numdns, ip_addr_t *dnsserver) {}
+void netif_set_ipaddr(struct netif *netif, ip_addr_t *ipaddr) { ip_addr_set(&netif->ip_addr, ipaddr); }
+void netif_set_netmask(struct netif *netif, ip_addr_t *netmask) { ip_addr_set(&netif->netmask, netmask); }
+void netif_set_gw(struct netif *netif, ip_addr_t *gw) { ip_addr_set(&netif->gw, gw); }
+void netif_set_up(struct netif *netif) { netif->flags |= NETIF_FLAG_UP; }
+void netif_set_down(struct netif *netif) { netif->flags &= ~NETIF_FLAG_UP; }
+err_t etharp_query(struct netif *netif, ip_addr_t *ipaddr, struct pbuf *q) { probes++; return ERR_OK; }
+
+err_t udp_sendto_if(struct udp_pcb *pcb, struct pbuf *p, ip_addr_t *dst_ip, u16_t dst_port, struct netif *netif)
+{
+    struct dhcp_msg *msg = (struct dhcp_msg *)p->payload;
+    u8_t *o = msg->options;
+
+    nsent++;
+    sent_xid = ntohl(msg->xid);
+    sent_type = 0;
+    sent_rapid = 0;
+    ip_addr_set_zero(&sent_requested);
+    ip_addr_set_zero(&sent_server);
+    while (o < msg->options + DHCP_OPTIONS_LEN && *o != DHCP_OPTION_END) {
+        if (*o == DHCP_OPTION_MESSAGE_TYPE)
+            sent_type = o[2];
+        if (*o == DHCP_OPTION_REQUESTED_IP)
+            MEMCPY(&sent_requested, &o[2], 4);
+        if (*o == DHCP_OPTION_SERVER_ID)
+            MEMCPY(&sent_server, &o[2], 4);
+        if (*o == DHCP_OPTION_RAPID_COMMIT)
+            sent_rapid = 1;
+        o += (*o == DHCP_OPTION_PAD) ? 1 : o[1] + 2;
+    }
+    return ERR_OK;
+}
+
+static void check(int ok, const char *what)
+{
+    printf("%s: %s\n", ok ? "ok" : "FAIL", what);
+    if (!ok)
+        failures++;
+}
+
+static u8_t *option(u8_t *o, u8_t type, u8_t len, u32_t value)
+{
+    *o++ = type;
+    *o++ = len;
+    while (len-- > 0)
+        *o++ = (u8_t)(value >> (8 * len));
+    return o;
+}
+
+// A server answer to the last message sent, rapid set adds option 80
+static void answer(u8_t type, int rapid)
+{
+    struct pbuf *p = pbuf_alloc(PBUF_RAW, sizeof(struct dhcp_msg), PBUF_RAM);
+    struct dhcp_msg *msg = (struct dhcp_msg *)p->payload;
+    ip_addr_t server;
+    u8_t *o = msg->options;
+
+    memset(msg, 0, sizeof(*msg));
+    msg->op = DHCP_BOOTREPLY;
+    msg->htype = DHCP_HTYPE_ETH;
+    msg->hlen = ETHARP_HWADDR_LEN;
+    msg->xid = htonl(sent_xid);
+    MEMCPY(msg->chaddr, netif.hwaddr, ETHARP_HWADDR_LEN);
+    msg->cookie = PP_HTONL(DHCP_MAGIC_COOKIE);
+    if (type != DHCP_NAK)
+        ip4_addr_set_u32(&msg->yiaddr, ipaddr_addr(LEASED));
+    o = option(o, DHCP_OPTION_MESSAGE_TYPE, 1, type);
+    o = option(o, DHCP_OPTION_SERVER_ID, 4, ntohl(ipaddr_addr(SERVER)));
+    if (type != DHCP_NAK) {
+        o = option(o, DHCP_OPTION_LEASE_TIME, 4, 3600);
+        o = option(o, DHCP_OPTION_SUBNET_MASK, 4, 0xffffff00UL);
+        o = option(o, DHCP_OPTION_ROUTER, 4, ntohl(ipaddr_addr("10.0.0.1")));
+    }
+    if (rapid)
+        o = option(o, DHCP_OPTION_RAPID_COMMIT, 0, 0);
+    *o = DHCP_OPTION_END;
+
+    ip4_addr_set_u32(&server, ipaddr_addr(SERVER));
+    dhcp_recv(&netif, &pcb, p, &server, DHCP_SERVER_PORT);
+}
+
+// Runs the fine timer until the netif is up, returns the ticks it took
+static int ticks_to_up(int most)
+{
+    int ticks = 0;
+
+    while (!(netif.flags & NETIF_FLAG_UP) && ticks < most) {
+        dhcp_fine_tmr();
+        ticks++;
+    }
+    return ticks;
+}
+
+static void reset(void)
+{
+    if (netif.dhcp != NULL) {
+        dhcp_stop(&netif);
+        dhcp_cleanup(&netif);
+    }
+    netif.flags &= ~NETIF_FLAG_UP;
+    ip_addr_set_zero(&netif.ip_addr);
+    ip_addr_set_zero(&netif.netmask);
+    ip_addr_set_zero(&netif.gw);
+    nsent = probes = 0;
+}
+
+static void reboot(void)
+{
+    ip_addr_t saved;
+
+    reset();
+    ip4_addr_set_u32(&saved, ipaddr_addr(LEASED));
+    check(dhcp_start_reboot(&netif, &saved) == ERR_OK, "reboot started");
+    check(nsent == 1 && sent_type == DHCP_REQUEST && ip_addr_cmp(&sent_requested, &saved) &&
+          ip_addr_isany(&sent_server), "REQUEST for the saved address, no server id");
+    answer(DHCP_ACK, 0);
+    check(netif.flags & NETIF_FLAG_UP && netif.dhcp->state == DHCP_BOUND, "up on the ACK");
+    check(nsent == 1 && probes == 0, "one round trip, no ARP check");
+    check(netif.ip_addr.addr == ipaddr_addr(LEASED) && netif.netmask.addr == ipaddr_addr("255.255.255.0") &&
+          netif.gw.addr == ipaddr_addr("10.0.0.1"), "configuration taken from the ACK");
+    check(netif.dhcp->server_ip_addr.addr == ipaddr_addr(SERVER) && netif.dhcp->t1_timeout > 0,
+          "server and lease times taken from the ACK");
+
+    // the server does not know the lease any more
+    reset();
+    dhcp_start_reboot(&netif, &saved);
+    answer(DHCP_NAK, 0);
+    check(!(netif.flags & NETIF_FLAG_UP) && nsent == 2 && sent_type == DHCP_DISCOVER &&
+          netif.dhcp->state == DHCP_SELECTING, "discovery right after a NAK");
+
+    // no server answers
+    reset();
+    dhcp_start_reboot(&netif, &saved);
+    while (sent_type == DHCP_REQUEST && nsent <= REBOOT_TRIES)
+        dhcp_fine_tmr();
+    check(nsent == REBOOT_TRIES + 1 && sent_type == DHCP_DISCOVER, "discovery after REBOOT_TRIES requests");
+}
+
+static void discovery(void)
+{
+    reset();
+    check(dhcp_start(&netif) == ERR_OK && sent_type == DHCP_DISCOVER && sent_rapid, "DISCOVER asks for rapid commit");
+    answer(DHCP_OFFER, 0);
+    check(nsent == 2 && sent_type == DHCP_REQUEST && sent_server.addr == ipaddr_addr(SERVER),
+          "REQUEST for the offer");
+    answer(DHCP_ACK, 0);
+    check(netif.dhcp->state == DHCP_CHECKING && probes == 1, "address checked");
+    check(ticks_to_up(100) == DHCP_ARP_CHECK_TRIES * ((DHCP_ARP_CHECK_MSECS + DHCP_FINE_TIMER_MSECS - 1) /
+          DHCP_FINE_TIMER_MSECS) && probes == DHCP_ARP_CHECK_TRIES, "up after the ARP check");
+    check(netif.ip_addr.addr == ipaddr_addr(LEASED), "offered address taken");
+
+    reset();
+    dhcp_start(&netif);
+    answer(DHCP_ACK, 0);
+    check(netif.dhcp->state == DHCP_SELECTING && nsent == 1 && probes == 0, "ACK without option 80 ignored");
+    answer(DHCP_ACK, 1);
+    check(nsent == 1 && netif.dhcp->state == DHCP_CHECKING, "rapid commit ACK taken without a REQUEST");
+    check(ticks_to_up(100) > 0 && netif.ip_addr.addr == ipaddr_addr(LEASED) &&
+          netif.dhcp->server_ip_addr.addr == ipaddr_addr(SERVER), "up after the ARP check, server from the ACK");
+    reset();
+}
+
+int main()
+{
+    struct eth_addr hwaddr = {{ 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 }};
+
+    mem_init();
+    memp_init();
+    netif.hwaddr_len = ETHARP_HWADDR_LEN;
+    memcpy(netif.hwaddr, hwaddr.addr, ETHARP_HWADDR_LEN);
+    netif.mtu = 1500;
+    netif.flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP;
+
+    reboot();
+    discovery();
+
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,344 @@
+/* Host test of the DNS cache
+ *
+ * Builds and runs on the host, without the mbed tree:
+ *
+ *   gcc -Istub -I.. -I../include -I../include/ipv4 -I../../lwip-sys -I../../lwip-sys/arch -I../../lwip-eth/arch/TARGET_NXP \
+ *       -I../../../mbed-rtos/rtx/TARGET_CORTEX_M -I../../../mbed-src/targets/cmsis \
+ *       -I../../../mbed-src/targets/cmsis/TARGET_NXP/TARGET_LPC176X -DTARGET_LPC1768 \
+ *       dns_test.c ../core/pbuf.c ../core/mem.c ../core/memp.c ../core/def.c \
+ *       ../core/ipv4/ip_addr.c ../core/ipv4/inet_chksum.c -o dns_test && ./dns_test
+ *
+ * Drives dns.c through dns_gethostbyname(), dns_recv() and dns_tmr() with
+ * the UDP pcb stubbed out: queries asked to both servers at once, answers
+ * only taken from them, the TTL, the refresh of names in use before they
+ * expire, negative answers bounded by the SOA and DNS_NEG_TTL, and the
+ * cache import and export with its eviction order.
+ */
+#include "../core/dns.c"
+#include "lwip/sys.h"
+
+#include <stdio.h>
+
+#define MAX_SENT    32
+
+static int failures;
+
+// What dns.c uses from udp.c, the queries are kept here
+static struct udp_pcb pcb;
+static struct {
+    ip_addr_t server;
+    u16_t id;
+    char name[DNS_MAX_NAME_LENGTH];
+} sent[MAX_SENT];
+static int nsent;
+
+// Answers given to the callback of dns_gethostbyname()
+static int nfound;
+static int found_ok;
+static ip_addr_t found_addr;
+
+sys_prot_t sys_arch_protect(void) { return 0; }
+void sys_arch_unprotect(sys_prot_t pval) {}
+
+struct udp_pcb *udp_new(void) { return &pcb; }
+err_t udp_bind(struct udp_pcb *pcb, ip_addr_t *ipaddr, u16_t port) { return ERR_OK; }
+err_t udp_connect(struct udp_pcb *pcb, ip_addr_t *ipaddr, u16_t port) { return ERR_OK; }
+void udp_recv(struct udp_pcb *pcb, udp_recv_fn recv, void *recv_arg) {}
+
+err_t udp_sendto(struct udp_pcb *pcb, struct pbuf *p, ip_addr_t *dst_ip, u16_t dst_port)
+{
+    u8_t *q = (u8_t *)p->payload;
+    u8_t *in = q + SIZEOF_DNS_HDR;
+    char *out;
+
+    if (nsent == MAX_SENT)
+        return ERR_MEM;
+    ip_addr_copy(sent[nsent].server, *dst_ip);
+    sent[nsent].id = q[0] << 8 | q[1];
+    // labels back to a dotted name
+    out = sent[nsent].name;
+    while (*in != 0) {
+        memcpy(out, in + 1, *in);
+        out += *in;
+        in += *in + 1;
+        *out++ = '.';
+    }
+    out[-1] = 0;
+    nsent++;
+    return ERR_OK;
+}
+
+static void found(const char *name, ip_addr_t *ipaddr, void *arg)
+{
+    nfound++;
+    found_ok = ipaddr != NULL;
+    if (ipaddr != NULL)
+        ip_addr_copy(found_addr, *ipaddr);
+}
+
+static void check(int ok, const char *what)
+{
+    printf("%s: %s\n", ok ? "ok" : "FAIL", what);
+    if (!ok)
+        failures++;
+}
+
+static u8_t *put16(u8_t *p, u16_t v) { p[0] = v >> 8; p[1] = (u8_t)v; return p + 2; }
+static u8_t *put32(u8_t *p, u32_t v) { return put16(put16(p, v >> 16), (u16_t)v); }
+
+/* A response to the query of entry id from server: an A record with ttl
+ * and addr when rcode is 0, else an SOA record in the authority section
+ * when soa_ttl is not 0. */
+static void respond(const char *server, u16_t id, const char *name, u8_t rcode,
+                    u32_t ttl, const char *addr, u32_t soa_ttl, u32_t soa_min)
+{
+    static u8_t msg[DNS_MSG_SIZE];
+    u8_t *p = msg + SIZEOF_DNS_HDR;
+    const char *label = name;
+    struct pbuf *pb;
+    ip_addr_t from;
+
+    memset(msg, 0, SIZEOF_DNS_HDR);
+    put16(msg, id);
+    msg[2] = DNS_FLAG1_RESPONSE | DNS_FLAG1_RD;
+    msg[3] = DNS_FLAG2_RA | rcode;
+    put16(msg + 4, 1);
+    while (*label != 0) {
+        const char *dot = strchr(label, '.');
+        size_t n = dot ? (size_t)(dot - label) : strlen(label);
+        *p++ = (u8_t)n;
+        memcpy(p, label, n);
+        p += n;
+        label += dot ? n + 1 : n;
+    }
+    *p++ = 0;
+    p = put16(put16(p, DNS_RRTYPE_A), DNS_RRCLASS_IN);
+    if (rcode == 0) {
+        u32_t a = ntohl(ipaddr_addr(addr));
+        put16(msg + 6, 1);
+        p = put16(p, 0xc00c);               // the name of the question
+        p = put32(put16(put16(p, DNS_RRTYPE_A), DNS_RRCLASS_IN), ttl);
+        p = put32(put16(p, 4), a);
+    } else if (soa_ttl != 0) {
+        put16(msg + 8, 1);
+        p = put16(p, 0xc00c);
+        p = put32(put16(put16(p, DNS_RRTYPE_SOA), DNS_RRCLASS_IN), soa_ttl);
+        p = put16(p, 2 + 5 * 4);
+        *p++ = 0;                           // root MNAME and RNAME
+        *p++ = 0;
+        p = put32(put32(put32(put32(put32(p, 1), 7200), 900), 1209600), soa_min);
+    }
+    pb = pbuf_alloc(PBUF_RAW, (u16_t)(p - msg), PBUF_RAM);
+    pbuf_take(pb, msg, (u16_t)(p - msg));
+    ip4_addr_set_u32(&from, ipaddr_addr(server));
+    dns_recv(NULL, &pcb, pb, &from, DNS_SERVER_PORT);
+}
+
+static void ticks(int n)
+{
+    while (n-- > 0)
+        dns_tmr();
+}
+
+static err_t lookup(const char *name, ip_addr_t *addr)
+{
+    return dns_gethostbyname(name, addr, found, NULL);
+}
+
+static int is(ip_addr_t *addr, const char *dotted)
+{
+    return ip4_addr_get_u32(addr) == ipaddr_addr(dotted);
+}
+
+static void reset(void)
+{
+    memset(dns_table, 0, sizeof(dns_table));
+    nsent = 0;
+    nfound = 0;
+}
+
+static void answer(void)
+{
+    ip_addr_t addr;
+    u8_t i;
+
+    reset();
+    check(lookup("mbed.org", &addr) == ERR_INPROGRESS, "new name is asked");
+    check(nsent == 2, "query sent to both servers");
+    check(is(&sent[0].server, "10.0.0.1") && is(&sent[1].server, "10.0.0.2"), "to the first and second server");
+    check(strcmp(sent[0].name, "mbed.org") == 0 && sent[0].id == sent[1].id, "same query to both");
+    i = (u8_t)sent[0].id;
+
+    respond("10.0.0.9", i, "mbed.org", 0, 100, "6.6.6.6", 0, 0);
+    check(nfound == 0 && dns_table[i].state == DNS_STATE_ASKING, "answer from another host ignored");
+
+    respond("10.0.0.2", i, "mbed.org", 0, 100, "1.2.3.4", 0, 0);
+    check(nfound == 1 && found_ok && is(&found_addr, "1.2.3.4"), "answer of the second server taken");
+    respond("10.0.0.1", i, "mbed.org", 0, 100, "6.6.6.6", 0, 0);
+    check(nfound == 1 && is(&dns_table[i].ipaddr, "1.2.3.4"), "late answer of the first server dropped");
+    check(dns_table[i].ttl == 100, "ttl of the answer");
+
+    nsent = 0;
+    check(lookup("mbed.org", &addr) == ERR_OK && is(&addr, "1.2.3.4"), "cached");
+    check(nsent == 0, "no query for a cached name");
+    ticks(99);
+    check(lookup("mbed.org", &addr) == ERR_OK, "cached until the ttl ends");
+    ticks(1);
+    check(dns_table[i].state == DNS_STATE_UNUSED, "flushed at the end of the ttl");
+    nsent = 0;
+    check(lookup("mbed.org", &addr) == ERR_INPROGRESS && nsent == 2, "asked again after the ttl");
+
+    respond("10.0.0.1", i, "mbed.org", 0, 9999999, "1.2.3.4", 0, 0);
+    check(dns_table[i].ttl == DNS_MAX_TTL, "ttl bounded by DNS_MAX_TTL");
+}
+
+static void prefetch(void)
+{
+    ip_addr_t addr;
+    u8_t i;
+
+    reset();
+    lookup("busy.org", &addr);
+    i = (u8_t)sent[0].id;
+    respond("10.0.0.1", i, "busy.org", 0, 100, "1.1.1.1", 0, 0);
+    lookup("busy.org", &addr);              // in use
+
+    nsent = 0;
+    ticks(100 - DNS_PREFETCH_TTL - 1);
+    check(nsent == 0, "no refresh before the prefetch ttl");
+    ticks(1);
+    check(dns_table[i].state == DNS_STATE_REFRESH && nsent == 2, "name in use asked again at the prefetch ttl");
+    respond("10.0.0.2", i, "busy.org", 0, 200, "2.2.2.2", 0, 0);
+    check(dns_table[i].state == DNS_STATE_DONE && dns_table[i].ttl == 200, "refreshed with the new ttl");
+    check(nfound == 1, "nobody called back for a refresh");
+
+    // not used since the refresh: left to expire
+    nsent = 0;
+    ticks(200 - DNS_PREFETCH_TTL);
+    check(nsent == 0 && dns_table[i].state == DNS_STATE_DONE, "unused name not refreshed");
+    ticks(DNS_PREFETCH_TTL);
+    check(dns_table[i].state == DNS_STATE_UNUSED, "unused name expires");
+
+    // a failed refresh keeps the old answer
+    reset();
+    lookup("flaky.org", &addr);
+    i = (u8_t)sent[0].id;
+    respond("10.0.0.1", i, "flaky.org", 0, 100, "3.3.3.3", 0, 0);
+    lookup("flaky.org", &addr);
+    ticks(100 - DNS_PREFETCH_TTL);
+    respond("10.0.0.1", i, "flaky.org", 2, 0, NULL, 0, 0);
+    check(dns_table[i].state == DNS_STATE_DONE && dns_table[i].err == 0, "server failure on a refresh ignored");
+    check(lookup("flaky.org", &addr) == ERR_OK && is(&addr, "3.3.3.3"), "old answer kept after the failure");
+
+    // an unanswered refresh keeps it too, until the old ttl ends
+    reset();
+    lookup("quiet.org", &addr);
+    i = (u8_t)sent[0].id;
+    respond("10.0.0.1", i, "quiet.org", 0, 100, "4.4.4.4", 0, 0);
+    lookup("quiet.org", &addr);
+    nsent = 0;
+    ticks(100 - DNS_PREFETCH_TTL);
+    check(lookup("quiet.org", &addr) == ERR_OK && is(&addr, "4.4.4.4"), "old answer served during the refresh");
+    ticks(7);
+    check(nsent == 2 * DNS_MAX_RETRIES, "refresh retried");
+    check(dns_table[i].state == DNS_STATE_DONE, "refresh given up");
+    check(lookup("quiet.org", &addr) == ERR_OK && is(&addr, "4.4.4.4"), "old answer kept after the timeout");
+    ticks(DNS_PREFETCH_TTL - 7 - 1);
+    check(dns_table[i].state == DNS_STATE_DONE, "old answer kept until its ttl");
+    ticks(1);
+    check(dns_table[i].state == DNS_STATE_UNUSED, "old answer expires");
+}
+
+static void negative(void)
+{
+    ip_addr_t addr;
+    u8_t i;
+
+    reset();
+    lookup("nx.org", &addr);
+    i = (u8_t)sent[0].id;
+    respond("10.0.0.1", i, "nx.org", DNS_FLAG2_ERR_NAME, 0, NULL, 3600, 20);
+    check(nfound == 1 && !found_ok, "no such name called back");
+    check(dns_table[i].state == DNS_STATE_DONE && dns_table[i].ttl == 20, "kept for the SOA minimum");
+    nsent = 0;
+    check(lookup("nx.org", &addr) == ERR_VAL && nsent == 0, "known not to exist without a query");
+    ticks(20);
+    check(lookup("nx.org", &addr) == ERR_INPROGRESS && nsent == 2, "asked again after the negative ttl");
+
+    respond("10.0.0.1", i, "nx.org", DNS_FLAG2_ERR_NAME, 0, NULL, 10, 300);
+    check(dns_table[i].ttl == 10, "kept for the SOA ttl");
+    ticks(10);
+    lookup("nx.org", &addr);
+    respond("10.0.0.1", i, "nx.org", DNS_FLAG2_ERR_NAME, 0, NULL, 3600, 3600);
+    check(dns_table[i].ttl == DNS_NEG_TTL, "bounded by DNS_NEG_TTL");
+
+    ticks(DNS_NEG_TTL);
+    lookup("nx.org", &addr);
+    dns_table[i].used = 1;
+    respond("10.0.0.1", i, "nx.org", DNS_FLAG2_ERR_NAME, 0, NULL, 3600, 3600);
+    nsent = 0;
+    ticks(DNS_NEG_TTL - DNS_PREFETCH_TTL);
+    check(nsent == 0, "negative answer not refreshed");
+
+    reset();
+    lookup("broken.org", &addr);
+    i = (u8_t)sent[0].id;
+    respond("10.0.0.1", i, "broken.org", 2, 0, NULL, 3600, 3600);
+    check(nfound == 1 && !found_ok && dns_table[i].state == DNS_STATE_UNUSED, "server failure not cached");
+}
+
+static void cache(void)
+{
+    ip_addr_t addr;
+    char name[DNS_MAX_NAME_LENGTH];
+    u32_t ttl;
+    u8_t i, n;
+
+    reset();
+    ip4_addr_set_u32(&addr, ipaddr_addr("5.5.5.5"));
+    check(dns_cache_add("", &addr, 10) == ERR_ARG, "empty name rejected");
+    check(dns_cache_add("saved.org", &addr, 0) == ERR_ARG, "zero ttl rejected");
+    check(dns_cache_add("saved.org", &addr, 9999999) == ERR_OK, "added");
+    for (i = 0; !dns_cache_get(i, name, &addr, &ttl) && i < DNS_TABLE_SIZE; i++)
+        ;
+    check(i < DNS_TABLE_SIZE && strcmp(name, "saved.org") == 0 && is(&addr, "5.5.5.5"), "read back");
+    check(ttl == DNS_MAX_TTL, "ttl bounded by DNS_MAX_TTL");
+    ip4_addr_set_u32(&addr, ipaddr_addr("5.5.5.6"));
+    check(dns_cache_add("saved.org", &addr, 50) == ERR_OK && is(&dns_table[i].ipaddr, "5.5.5.6") &&
+          dns_table[i].ttl == 50, "added again in place");
+    check(lookup("saved.org", &addr) == ERR_OK && nsent == 0, "added name served");
+    check(!dns_cache_get(DNS_TABLE_SIZE, name, &addr, &ttl), "index out of the table");
+
+    // the oldest name not looked up since is evicted
+    reset();
+    for (n = 0; n < DNS_TABLE_SIZE; n++) {
+        snprintf(name, sizeof(name), "host%u.org", n);
+        dns_cache_add(name, &addr, 1000);
+    }
+    lookup("host0.org", &addr);
+    dns_cache_add("new.org", &addr, 1000);
+    check(lookup("host0.org", &addr) == ERR_OK, "name in use kept");
+    check(dns_find("host1.org") == DNS_TABLE_SIZE, "oldest name evicted");
+    check(dns_find("new.org") < DNS_TABLE_SIZE && dns_find("host2.org") < DNS_TABLE_SIZE, "others kept");
+}
+
+int main()
+{
+    ip_addr_t server;
+
+    mem_init();
+    memp_init();
+    dns_init();
+    ip4_addr_set_u32(&server, ipaddr_addr("10.0.0.1"));
+    dns_setserver(0, &server);
+    ip4_addr_set_u32(&server, ipaddr_addr("10.0.0.2"));
+    dns_setserver(1, &server);
+
+    answer();
+    prefetch();
+    negative();
+    cache();
+
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
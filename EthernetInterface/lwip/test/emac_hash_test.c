@@ -0,0 +1,194 @@
+/* Host test of the EMAC multicast hash filter
+ *
+ * Builds and runs on the host, without the mbed tree:
+ *
+ *   gcc -Istub -I.. -I../include -I../include/ipv4 -I../../lwip-sys -I../../lwip-sys/arch -I../../lwip-eth/arch/TARGET_NXP \
+ *       -I../../lwip-eth/arch -I../.. -I../../../mbed-src/api -I../../../mbed-rtos/rtx/TARGET_CORTEX_M \
+ *       -I../../../mbed-src/targets/cmsis -I../../../mbed-src/targets/cmsis/TARGET_NXP/TARGET_LPC176X \
+ *       -I../../../mbed-src/targets/hal/TARGET_NXP/TARGET_LPC176X \
+ *       -I../../../mbed-src/targets/hal/TARGET_NXP/TARGET_LPC176X/TARGET_MBED_LPC1768 -DTARGET_LPC1768 \
+ *       emac_hash_test.c -o emac_hash_test && ./emac_hash_test
+ *
+ * Checks the filter bit lpc_mac_hash() picks for every IPv4 group MAC
+ * against emac_CRCCalc() of the NXP LPC17xx driver library, the way its
+ * EMAC_SetHashFilter() uses it. Then joins and leaves groups sharing a
+ * bit through lpc_igmp_mac_filter() and checks the bit stays set until
+ * the last of them leaves. The EMAC registers are a page of plain memory
+ * here.
+ */
+#include "../../lwip-eth/arch/TARGET_NXP/lpc17_emac.c"
+
+#include <stdio.h>
+#include <sys/mman.h>
+
+static int failures;
+
+// What lpc17_emac.c uses from the rest of lwIP, the PHY driver, RTX and mbed
+err_t etharp_output(struct netif *netif, struct pbuf *q, ip_addr_t *ipaddr) { return ERR_OK; }
+err_t lpc_phy_init(struct netif *netif, int rmii) { return ERR_OK; }
+s32_t lpc_phy_sts_sm(struct netif *netif) { return 0; }
+void mbed_mac_address(char *mac) {}
+u8_t pbuf_free(struct pbuf *p) { return 0; }
+struct pbuf *pbuf_alloc(pbuf_layer l, u16_t length, pbuf_type type) { return NULL; }
+void pbuf_ref(struct pbuf *p) {}
+u8_t pbuf_clen(struct pbuf *p) { return 1; }
+err_t sys_sem_new(sys_sem_t *sem, u8_t count) { return ERR_OK; }
+void sys_sem_signal(sys_sem_t *sem) {}
+u32_t sys_arch_sem_wait(sys_sem_t *sem, u32_t timeout) { return 0; }
+err_t sys_mutex_new(sys_mutex_t *mutex) { return ERR_OK; }
+void sys_mutex_lock(sys_mutex_t *mutex) {}
+void sys_mutex_unlock(sys_mutex_t *mutex) {}
+sys_thread_t sys_thread_new(const char *name, lwip_thread_fn thread, void *arg, int stacksize, int prio) { return NULL; }
+osStatus osDelay(uint32_t millisec) { return osOK; }
+int32_t osSignalSet(osThreadId thread_id, int32_t signals) { return 0; }
+osEvent osSignalWait(int32_t signals, uint32_t millisec) { osEvent e = { osOK }; return e; }
+osTimerId osTimerCreate(osTimerDef_t *timer_def, os_timer_type type, void *argument) { return NULL; }
+osStatus osTimerStart(osTimerId timer_id, uint32_t millisec) { return osOK; }
+osSemaphoreId osSemaphoreCreate(osSemaphoreDef_t *semaphore_def, int32_t count) { return NULL; }
+int32_t osSemaphoreWait(osSemaphoreId semaphore_id, uint32_t millisec) { return 1; }
+osStatus osSemaphoreRelease(osSemaphoreId semaphore_id) { return osOK; }
+
+/* emac_CRCCalc() and the bit index of EMAC_SetHashFilter(), from
+ * lpc17xx_emac.c of the NXP LPC17xx CMSIS driver library */
+static int32_t emac_CRCCalc(uint8_t frame_no_fcs[], int32_t frame_len)
+{
+    int i;          // iterator
+    int j;          // another iterator
+    char byte;      // current byte
+    int crc;        // CRC result
+    int q0, q1, q2, q3; // temporary variables
+    crc = 0xFFFFFFFF;
+    for (i = 0; i < frame_len; i++) {
+        byte = *frame_no_fcs++;
+        for (j = 0; j < 2; j++) {
+            if (((crc >> 28) ^ (byte >> 3)) & 0x00000001) {
+                q3 = 0x04C11DB7;
+            } else {
+                q3 = 0x00000000;
+            }
+            if (((crc >> 29) ^ (byte >> 2)) & 0x00000001) {
+                q2 = 0x09823B6E;
+            } else {
+                q2 = 0x00000000;
+            }
+            if (((crc >> 30) ^ (byte >> 1)) & 0x00000001) {
+                q1 = 0x130476DC;
+            } else {
+                q1 = 0x00000000;
+            }
+            if (((crc >> 31) ^ (byte >> 0)) & 0x00000001) {
+                q0 = 0x2608EDB8;
+            } else {
+                q0 = 0x00000000;
+            }
+            crc = (crc << 4) ^ q3 ^ q2 ^ q1 ^ q0;
+            byte >>= 4;
+        }
+    }
+    return crc;
+}
+
+static u32_t nxp_hash(uint8_t *addr)
+{
+    return (emac_CRCCalc(addr, 6) >> 23) & 0x3F;
+}
+
+static void check(int ok, const char *what)
+{
+    printf("%s: %s\n", ok ? "ok" : "FAIL", what);
+    if (!ok)
+        failures++;
+}
+
+static int bit_set(u32_t index)
+{
+    return (((index > 31) ? LPC_EMAC->HashFilterH : LPC_EMAC->HashFilterL) >> (index & 31)) & 1;
+}
+
+static u32_t group_hash(ip_addr_t *group)
+{
+    u8_t mac[ETHARP_HWADDR_LEN] = { 0x01, 0x00, 0x5e };
+
+    mac[3] = ip4_addr2(group) & 0x7f;
+    mac[4] = ip4_addr3(group);
+    mac[5] = ip4_addr4(group);
+    return lpc_mac_hash(mac);
+}
+
+static void crc(void)
+{
+    u8_t mac[ETHARP_HWADDR_LEN] = { 0x01, 0x00, 0x5e };
+    u8_t other[ETHARP_HWADDR_LEN] = { 0x33, 0x33, 0x00, 0x00, 0x00, 0x01 };
+    u32_t low, mismatches = 0;
+    unsigned long long used = 0;
+
+    for (low = 0; low < 0x800000; low++) {
+        mac[3] = (u8_t)(low >> 16);
+        mac[4] = (u8_t)(low >> 8);
+        mac[5] = (u8_t)low;
+        u32_t index = lpc_mac_hash(mac);
+        mismatches += index != nxp_hash(mac);
+        used |= 1ULL << index;
+    }
+    check(mismatches == 0, "same bit as emac_CRCCalc for all 2^23 IPv4 group addresses");
+    check(used == ~0ULL, "group addresses spread over all the bits");
+    check(lpc_mac_hash(other) == nxp_hash(other), "same bit for an IPv6 group address");
+}
+
+static void filter(void)
+{
+    struct netif netif;
+    ip_addr_t a, b, c, d;
+    u32_t i;
+
+    if (mmap((void *)LPC_EMAC_BASE, 0x1000, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) != (void *)LPC_EMAC_BASE) {
+        check(0, "map the EMAC registers");
+        return;
+    }
+    memset(&netif, 0, sizeof(netif));
+    netif.state = &lpc_enetdata;
+
+    // b has the same MAC as a, c another MAC on the same bit, d another bit
+    IP4_ADDR(&a, 239, 1, 2, 3);
+    IP4_ADDR(&b, 239, 129, 2, 3);
+    for (i = 4; ; i++) {
+        IP4_ADDR(&c, 239, 1, 2, i);
+        if (group_hash(&c) == group_hash(&a))
+            break;
+    }
+    for (i = 4; ; i++) {
+        IP4_ADDR(&d, 239, 1, 2, i);
+        if (group_hash(&d) != group_hash(&a))
+            break;
+    }
+    i = group_hash(&a);
+
+    lpc_igmp_mac_filter(&netif, &a, IGMP_ADD_MAC_FILTER);
+    check(bit_set(i), "bit set on the first join");
+    lpc_igmp_mac_filter(&netif, &b, IGMP_ADD_MAC_FILTER);
+    lpc_igmp_mac_filter(&netif, &c, IGMP_ADD_MAC_FILTER);
+    lpc_igmp_mac_filter(&netif, &d, IGMP_ADD_MAC_FILTER);
+    check(lpc_enetdata.mcast_refs[i] == 3, "groups on the bit counted");
+    check(bit_set(group_hash(&d)), "bit of another group set");
+
+    lpc_igmp_mac_filter(&netif, &a, IGMP_DEL_MAC_FILTER);
+    lpc_igmp_mac_filter(&netif, &b, IGMP_DEL_MAC_FILTER);
+    check(bit_set(i), "bit kept while a group uses it");
+    lpc_igmp_mac_filter(&netif, &c, IGMP_DEL_MAC_FILTER);
+    check(!bit_set(i), "bit cleared on the last leave");
+    lpc_igmp_mac_filter(&netif, &c, IGMP_DEL_MAC_FILTER);
+    check(!bit_set(i) && lpc_enetdata.mcast_refs[i] == 0, "extra leave ignored");
+    check(bit_set(group_hash(&d)), "other bit untouched");
+    lpc_igmp_mac_filter(&netif, &d, IGMP_DEL_MAC_FILTER);
+    check(LPC_EMAC->HashFilterL == 0 && LPC_EMAC->HashFilterH == 0, "filter empty");
+}
+
+int main()
+{
+    crc();
+    filter();
+
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,284 @@
+/* Host test of the ARP table hash and refresh
+ *
+ * Builds and runs on the host, without the mbed tree:
+ *
+ *   gcc -Istub -I.. -I../include -I../include/ipv4 -I../../lwip-sys -I../../lwip-sys/arch -I../../lwip-eth/arch/TARGET_NXP \
+ *       -I../../../mbed-rtos/rtx/TARGET_CORTEX_M -I../../../mbed-src/targets/cmsis \
+ *       -I../../../mbed-src/targets/cmsis/TARGET_NXP/TARGET_LPC176X -DTARGET_LPC1768 \
+ *       etharp_test.c ../core/pbuf.c ../core/mem.c ../core/memp.c ../core/def.c \
+ *       ../core/ipv4/ip_addr.c ../core/ipv4/inet_chksum.c -o etharp_test && ./etharp_test
+ *
+ * Fills, recycles and ages out ARP entries with addresses that share hash
+ * chains and checks that every entry in use sits in the chain of its
+ * address once. Then sends packets to a peer through etharp_output() as
+ * its entry ages: one unicast request to its known MAC address per timer
+ * period from ARP_REFRESH_AGE on, none once it answered, none for static
+ * entries, and expiry at ARP_MAXAGE when it never answers.
+ */
+#include "../netif/etharp.c"
+#include "lwip/sys.h"
+
+#include <stdio.h>
+
+#define MAX_FRAMES  8
+
+static int failures;
+
+// What etharp.c uses from ip.c and dhcp.c, the frames sent are kept here
+static struct netif netif;
+static struct {
+    struct eth_addr dst;
+    u16_t type;
+    u16_t opcode;
+    ip_addr_t target;
+} frames[MAX_FRAMES];
+static int nframes;
+
+sys_prot_t sys_arch_protect(void) { return 0; }
+void sys_arch_unprotect(sys_prot_t pval) {}
+err_t ip_input(struct pbuf *p, struct netif *inp) { pbuf_free(p); return ERR_OK; }
+struct netif *ip_route(ip_addr_t *dest) { return &netif; }
+void dhcp_arp_reply(struct netif *netif, ip_addr_t *addr) {}
+
+static err_t linkoutput(struct netif *netif, struct pbuf *p)
+{
+    struct eth_hdr *ethhdr = (struct eth_hdr *)p->payload;
+
+    if (nframes == MAX_FRAMES)
+        return ERR_MEM;
+    ETHADDR16_COPY(&frames[nframes].dst, &ethhdr->dest);
+    frames[nframes].type = ntohs(ethhdr->type);
+    if (frames[nframes].type == ETHTYPE_ARP) {
+        struct etharp_hdr *hdr = (struct etharp_hdr *)(ethhdr + 1);
+        frames[nframes].opcode = ntohs(hdr->opcode);
+        IPADDR2_COPY(&frames[nframes].target, &hdr->dipaddr);
+    }
+    nframes++;
+    return ERR_OK;
+}
+
+static void check(int ok, const char *what)
+{
+    printf("%s: %s\n", ok ? "ok" : "FAIL", what);
+    if (!ok)
+        failures++;
+}
+
+static struct eth_addr mac_of(u8_t host)
+{
+    struct eth_addr mac = {{ 0x02, 0x00, 0x00, 0x00, 0x00, host }};
+    return mac;
+}
+
+static ip_addr_t ip_of(u8_t host)
+{
+    ip_addr_t ip;
+    IP4_ADDR(&ip, 10, 0, 0, host);
+    return ip;
+}
+
+// The peer answered a request or sent one, as etharp_arp_input() records it
+static void heard(u8_t host)
+{
+    ip_addr_t ip = ip_of(host);
+    struct eth_addr mac = mac_of(host);
+    update_arp_entry(&netif, &ip, &mac, ETHARP_FLAG_TRY_HARD);
+}
+
+static int known(u8_t host)
+{
+    ip_addr_t ip = ip_of(host), *ip_ret;
+    struct eth_addr *eth_ret;
+    return etharp_find_addr(&netif, &ip, &eth_ret, &ip_ret) >= 0;
+}
+
+// Sends an IP packet to host, returns the number of frames it took
+static int send_to(u8_t host)
+{
+    ip_addr_t ip = ip_of(host);
+    struct pbuf *q = pbuf_alloc(PBUF_IP, 20, PBUF_RAM);
+
+    nframes = 0;
+    etharp_output(&netif, q, &ip);
+    pbuf_free(q);
+    return nframes;
+}
+
+static int refresh_sent(u8_t host)
+{
+    struct eth_addr mac = mac_of(host);
+    ip_addr_t ip = ip_of(host);
+
+    return frames[0].type == ETHTYPE_ARP && frames[0].opcode == ARP_REQUEST &&
+           eth_addr_cmp(&frames[0].dst, &mac) && ip_addr_cmp(&frames[0].target, &ip) &&
+           frames[1].type == ETHTYPE_IP && eth_addr_cmp(&frames[1].dst, &mac);
+}
+
+static void ticks(int n)
+{
+    while (n-- > 0)
+        etharp_tmr();
+}
+
+// Every entry in use once in the chain of its address, nothing else hashed
+static int hashed(void)
+{
+    int i, n = 0, chained = 0;
+    u8_t h, e;
+
+    for (i = 0; i < ARP_TABLE_SIZE; i++) {
+        int found = 0;
+        if (arp_table[i].state == ETHARP_STATE_EMPTY)
+            continue;
+        n++;
+        for (e = arp_hash[ETHARP_HASH(&arp_table[i].ipaddr)]; e != 0; e = arp_table[e - 1].hash_next)
+            found += e == i + 1;
+        if (found != 1)
+            return 0;
+    }
+    for (h = 0; h < ETHARP_HASH_SIZE; h++)
+        for (e = arp_hash[h]; e != 0; e = arp_table[e - 1].hash_next, chained++)
+            if (arp_table[e - 1].state == ETHARP_STATE_EMPTY || ETHARP_HASH(&arp_table[e - 1].ipaddr) != h)
+                return 0;
+    return n == chained;
+}
+
+static void reset(void)
+{
+    int i;
+
+    for (i = 0; i < ARP_TABLE_SIZE; i++)
+        if (arp_table[i].state != ETHARP_STATE_EMPTY)
+            free_entry(i);
+}
+
+static void hash(void)
+{
+    ip_addr_t ip;
+    struct eth_addr mac;
+    u8_t host;
+    int all = 1;
+
+    // hosts 1, 9, 17... share a chain
+    reset();
+    for (host = 1; host <= ARP_TABLE_SIZE; host++) {
+        heard(host * ETHARP_HASH_SIZE - 7);
+        ticks(1);
+    }
+    check(hashed(), "table filled");
+    for (host = 1; host <= ARP_TABLE_SIZE; host++)
+        all = all && known(host * ETHARP_HASH_SIZE - 7);
+    check(all, "all found");
+
+    heard(200);
+    check(hashed() && known(200) && !known(1), "oldest entry recycled");
+    heard(9);
+    check(hashed() && known(9), "known entry updated in place");
+    heard(201);
+    check(hashed() && known(201) && known(9) && !known(17), "oldest entry recycled, not the one heard again");
+
+    ip = ip_of(25);
+    mac = mac_of(25);
+    check(etharp_add_static_entry(&ip, &mac) == ERR_OK && hashed(), "static entry added in place");
+    ticks(ARP_MAXAGE);
+    check(hashed() && known(25) && !known(33) && !known(200), "all but the static entry expired");
+    check(etharp_remove_static_entry(&ip) == ERR_OK && hashed() && !known(25), "static entry removed");
+
+    ip = ip_of(77);
+    nframes = 0;
+    etharp_request(&netif, &ip);
+    etharp_query(&netif, &ip, NULL);
+    check(hashed() && !known(77), "pending entry hashed, not found as stable");
+    ticks(ARP_MAXPENDING);
+    check(hashed() && arp_hash[ETHARP_HASH(&ip)] == 0, "pending entry expired");
+}
+
+static void refresh(void)
+{
+    u8_t hint = ARP_TABLE_SIZE;
+
+    reset();
+    heard(2);
+    ticks(ARP_REFRESH_AGE - 1);
+    check(send_to(2) == 1 && frames[0].type == ETHTYPE_IP, "no refresh before ARP_REFRESH_AGE");
+    ticks(1);
+    check(send_to(2) == 2 && refresh_sent(2), "unicast refresh at ARP_REFRESH_AGE");
+    check(send_to(2) == 1, "one refresh per timer period");
+    ticks(1);
+    check(send_to(2) == 2 && refresh_sent(2), "refreshed again in the next period");
+    heard(2);
+    check(send_to(2) == 1, "no refresh once the peer answered");
+    ticks(ARP_MAXAGE - 1);
+    check(known(2), "answer renewed the entry");
+
+    // through the per-pcb entry hint of etharp_output()
+    netif.addr_hint = &hint;
+    heard(3);
+    send_to(3);
+    check(hint < ARP_TABLE_SIZE && arp_table[hint].ipaddr.addr == ip_of(3).addr, "hint set");
+    ticks(ARP_REFRESH_AGE);
+    check(send_to(3) == 2 && refresh_sent(3), "refresh through the hint");
+    check(send_to(3) == 1, "one refresh through the hint");
+    netif.addr_hint = NULL;
+
+    // a peer that never answers is dropped at ARP_MAXAGE
+    reset();
+    heard(4);
+    ticks(ARP_REFRESH_AGE);
+    send_to(4);
+    ticks(ARP_MAXAGE - ARP_REFRESH_AGE - 1);
+    check(known(4), "kept while the refresh is unanswered");
+    ticks(1);
+    check(!known(4) && hashed(), "unanswered entry expired at ARP_MAXAGE");
+}
+
+static void entries(void)
+{
+    ip_addr_t ip, *ip_ret;
+    struct eth_addr mac, mac5 = mac_of(5), *eth_ret;
+    u8_t i, stable = 0, statics = 0, n;
+
+    reset();
+    heard(5);
+    ip = ip_of(6);
+    mac = mac_of(6);
+    etharp_add_static_entry(&ip, &mac);
+    ip = ip_of(7);
+    etharp_query(&netif, &ip, NULL);
+
+    for (i = 0; i < ARP_TABLE_SIZE; i++) {
+        n = etharp_get_entry(i, &ip_ret, &eth_ret);
+        if (n == 1)
+            stable += ip_ret->addr == ip_of(5).addr && eth_addr_cmp(eth_ret, &mac5);
+        if (n == 2)
+            statics += ip_ret->addr == ip_of(6).addr && eth_addr_cmp(eth_ret, &mac);
+    }
+    check(stable == 1 && statics == 1, "stable and static entries listed, pending one not");
+
+    ticks(ARP_MAXAGE);
+    check(send_to(6) == 1 && frames[0].type == ETHTYPE_IP, "static entry never refreshed");
+    check(etharp_get_entry(ARP_TABLE_SIZE, &ip_ret, &eth_ret) == 0, "index out of the table");
+    ip = ip_of(6);
+    etharp_remove_static_entry(&ip);
+}
+
+int main()
+{
+    struct eth_addr hwaddr = {{ 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 }};
+
+    mem_init();
+    memp_init();
+    IP4_ADDR(&netif.ip_addr, 10, 0, 0, 1);
+    IP4_ADDR(&netif.netmask, 255, 255, 255, 0);
+    netif.flags = NETIF_FLAG_UP | NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP;
+    netif.hwaddr_len = ETHARP_HWADDR_LEN;
+    memcpy(netif.hwaddr, hwaddr.addr, ETHARP_HWADDR_LEN);
+    netif.linkoutput = linkoutput;
+
+    hash();
+    refresh();
+    entries();
+
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,284 @@
+/* Host test of the socket event hook and of batched UDP sends
+ *
+ * Builds and runs on the host, without the mbed tree:
+ *
+ *   gcc -DLWIP_TIMEVAL_PRIVATE=0 -Istub -I.. -I../include -I../include/ipv4 -I../../lwip-sys -I../../lwip-sys/arch \
+ *       -I../../lwip-eth/arch/TARGET_NXP -I../../../mbed-rtos/rtx/TARGET_CORTEX_M -I../../../mbed-src/targets/cmsis \
+ *       -I../../../mbed-src/targets/cmsis/TARGET_NXP/TARGET_LPC176X -DTARGET_LPC1768 \
+ *       sockets_test.c ../core/pbuf.c ../core/mem.c ../core/memp.c ../core/def.c \
+ *       ../core/ipv4/ip_addr.c ../core/ipv4/inet_chksum.c -o sockets_test && ./sockets_test
+ *
+ * Opens sockets on netconns stubbed out here and raises their events the
+ * way api_msg.c does, through the callback given to the netconn. Checks
+ * that lwip_sockevent() hooks see every event of their socket and nothing
+ * after they are removed or the socket is closed, and that
+ * lwip_sockstate() reports what select would.
+ *
+ * Then queues batches with lwip_sendmmsg() and runs the tcpip_thread
+ * message by hand. Checks that udp_send() and udp_sendto() get the
+ * payloads without a copy, that the results are set, and that done is
+ * called once, only after the driver let go of the last payload, or not
+ * at all when the batch could not be queued.
+ */
+#include "../api/sockets.c"
+#include "lwip/memp.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static int failures;
+
+// What sockets.c uses from api_lib.c, netbuf.c, igmp.c and the tcpip thread
+sys_prot_t sys_arch_protect(void) { return 0; }
+void sys_arch_unprotect(sys_prot_t pval) {}
+err_t sys_sem_new(sys_sem_t *sem, u8_t count) { return ERR_OK; }
+void sys_sem_free(sys_sem_t *sem) {}
+void sys_sem_signal(sys_sem_t *sem) {}
+u32_t sys_arch_sem_wait(sys_sem_t *sem, u32_t timeout) { return 0; }
+void netbuf_delete(struct netbuf *buf) {}
+void netbuf_free(struct netbuf *buf) {}
+err_t netbuf_ref(struct netbuf *buf, const void *dataptr, u16_t size) { return ERR_OK; }
+err_t igmp_joingroup(ip_addr_t *ifaddr, ip_addr_t *groupaddr) { return ERR_OK; }
+err_t igmp_leavegroup(ip_addr_t *ifaddr, ip_addr_t *groupaddr) { return ERR_OK; }
+err_t netconn_accept(struct netconn *conn, struct netconn **new_conn) { return ERR_CONN; }
+err_t netconn_bind(struct netconn *conn, ip_addr_t *addr, u16_t port) { return ERR_OK; }
+err_t netconn_connect(struct netconn *conn, ip_addr_t *addr, u16_t port) { return ERR_OK; }
+err_t netconn_disconnect(struct netconn *conn) { return ERR_OK; }
+err_t netconn_getaddr(struct netconn *conn, ip_addr_t *addr, u16_t *port, u8_t local) { return ERR_OK; }
+err_t netconn_listen_with_backlog(struct netconn *conn, u8_t backlog) { return ERR_OK; }
+err_t netconn_recv(struct netconn *conn, struct netbuf **new_buf) { return ERR_WOULDBLOCK; }
+err_t netconn_recv_tcp_pbuf(struct netconn *conn, struct pbuf **new_buf) { return ERR_WOULDBLOCK; }
+void netconn_recved(struct netconn *conn, u32_t length) {}
+err_t netconn_send(struct netconn *conn, struct netbuf *buf) { return ERR_OK; }
+err_t netconn_shutdown(struct netconn *conn, u8_t shut_rx, u8_t shut_tx) { return ERR_OK; }
+err_t netconn_write(struct netconn *conn, const void *dataptr, size_t size, u8_t apiflags) { return ERR_OK; }
+
+// What the batch sends went through, the driver holds the pbufs in held
+#define MAX_SENT    4
+
+static struct {
+    struct pbuf *p;
+    ip_addr_t addr;
+    u16_t port;
+} sent[MAX_SENT];
+static int nsent;
+static struct pbuf *held[MAX_SENT];
+static int hold;
+static err_t send_err;
+static tcpip_callback_fn queued;
+static void *queued_ctx;
+static err_t queue_err;
+
+err_t udp_sendto(struct udp_pcb *pcb, struct pbuf *p, ip_addr_t *dst_ip, u16_t dst_port)
+{
+    if (send_err != ERR_OK)
+        return send_err;
+    sent[nsent].p = p;
+    ip_addr_set(&sent[nsent].addr, dst_ip);
+    sent[nsent].port = dst_port;
+    if (hold) {
+        pbuf_ref(p);
+        held[nsent] = p;
+    }
+    nsent++;
+    return ERR_OK;
+}
+
+err_t udp_send(struct udp_pcb *pcb, struct pbuf *p)
+{
+    return udp_sendto(pcb, p, IP_ADDR_ANY, 0);
+}
+
+err_t tcpip_callback_with_block(tcpip_callback_fn function, void *ctx, u8_t block)
+{
+    if (queue_err != ERR_OK)
+        return queue_err;
+    queued = function;
+    queued_ctx = ctx;
+    return ERR_OK;
+}
+
+struct netconn *netconn_new_with_proto_and_callback(enum netconn_type t, u8_t proto, netconn_callback callback)
+{
+    struct netconn *conn = (struct netconn *)calloc(1, sizeof(struct netconn));
+
+    conn->type = t;
+    conn->socket = -1;
+    conn->callback = callback;
+    return conn;
+}
+
+err_t netconn_delete(struct netconn *conn)
+{
+    free(conn);
+    return ERR_OK;
+}
+
+// Calls seen by the hook
+static int hooked, hooked_s;
+static void *hooked_arg;
+
+static void hook(int s, void *arg)
+{
+    hooked++;
+    hooked_s = s;
+    hooked_arg = arg;
+}
+
+static void check(int ok, const char *what)
+{
+    printf("%s: %s\n", ok ? "ok" : "FAIL", what);
+    if (!ok)
+        failures++;
+}
+
+// An event raised by the stack on the netconn of socket s
+static void raise(int s, enum netconn_evt evt)
+{
+    struct netconn *conn = sockets[s].conn;
+    conn->callback(conn, evt, 0);
+}
+
+static void hooks(void)
+{
+    int s, t, arg;
+
+    s = lwip_socket(AF_INET, SOCK_DGRAM, 0);
+    t = lwip_socket(AF_INET, SOCK_STREAM, 0);
+    check(s >= 0 && t >= 0, "sockets opened");
+    check(lwip_sockstate(s) == LWIP_SOCK_WRITABLE, "new UDP socket writable");
+    check(lwip_sockstate(t) == 0, "new TCP socket neither readable nor writable");
+
+    check(lwip_sockevent(s, hook, &arg) == 0, "hook set");
+    raise(s, NETCONN_EVT_RCVPLUS);
+    check(hooked == 1 && hooked_s == s && hooked_arg == &arg, "receive event seen");
+    check(lwip_sockstate(s) == (LWIP_SOCK_READABLE | LWIP_SOCK_WRITABLE), "readable");
+    raise(s, NETCONN_EVT_RCVPLUS);
+    raise(s, NETCONN_EVT_RCVMINUS);
+    check(hooked == 3 && lwip_sockstate(s) & LWIP_SOCK_READABLE, "readable until the last datagram is read");
+    raise(s, NETCONN_EVT_RCVMINUS);
+    check(hooked == 4 && !(lwip_sockstate(s) & LWIP_SOCK_READABLE), "read out");
+    raise(s, NETCONN_EVT_SENDMINUS);
+    check(hooked == 5 && lwip_sockstate(s) == 0, "send buffer full");
+    raise(s, NETCONN_EVT_ERROR);
+    check(hooked == 6 && lwip_sockstate(s) == LWIP_SOCK_ERROR, "error");
+
+    raise(t, NETCONN_EVT_RCVPLUS);
+    check(hooked == 6, "events of another socket not seen");
+    check(lwip_sockevent(t, hook, NULL) == 0, "second hook set");
+    raise(t, NETCONN_EVT_SENDPLUS);
+    check(hooked == 7 && hooked_s == t && hooked_arg == NULL, "event of the second socket seen");
+
+    check(lwip_sockevent(s, NULL, NULL) == 0, "hook removed");
+    raise(s, NETCONN_EVT_RCVPLUS);
+    check(hooked == 7, "no call after the hook is removed");
+
+    // the socket number is reused by the next socket opened
+    lwip_close(t);
+    check(lwip_sockstate(t) == -1 && lwip_sockevent(t, hook, NULL) == -1, "closed socket refused");
+    t = lwip_socket(AF_INET, SOCK_DGRAM, 0);
+    raise(t, NETCONN_EVT_RCVPLUS);
+    check(hooked == 7, "hook not inherited by the next socket on the number");
+    lwip_close(s);
+    lwip_close(t);
+
+    check(lwip_sockstate(-1) == -1 && lwip_sockstate(NUM_SOCKETS) == -1, "invalid sockets refused");
+}
+
+// Calls of done
+static int done;
+
+static void batch_done(struct lwip_mmsg_batch *batch)
+{
+    done++;
+}
+
+// Runs the tcpip_thread message queued by lwip_sendmmsg()
+static void run_queued(void)
+{
+    tcpip_callback_fn fn = queued;
+
+    queued = NULL;
+    if (fn != NULL)
+        fn(queued_ctx);
+}
+
+static void batches(void)
+{
+    static char data[3][64] = { "first", "second", "third" };
+    struct sockaddr_in to;
+    struct lwip_mmsg m[3];
+    struct lwip_mmsg_batch batch;
+    struct udp_pcb pcb;
+    int s, t, i;
+
+    s = lwip_socket(AF_INET, SOCK_DGRAM, 0);
+    sockets[s].conn->pcb.udp = &pcb;
+    memset(&to, 0, sizeof(to));
+    to.sin_family = AF_INET;
+    to.sin_port = htons(5000);
+    to.sin_addr.s_addr = inet_addr("10.0.0.2");
+    memset(m, 0, sizeof(m));
+    for (i = 0; i < 3; i++) {
+        m[i].data = data[i];
+        m[i].len = 10 + i;
+        m[i].next = i < 2 ? &m[i + 1] : NULL;
+    }
+    m[1].addr = &to;
+    memset(&batch, 0, sizeof(batch));
+    batch.msgs = m;
+    batch.done = batch_done;
+
+    check(lwip_sendmmsg(s, &batch) == 0 && queued != NULL && done == 0, "batch queued");
+    check(m[0].result == -1 && m[1].result == -1 && m[2].result == -1, "results unset until sent");
+    hold = 1;
+    run_queued();
+    check(nsent == 3, "all sent by one message");
+    check(sent[0].p->payload == data[0] && sent[1].p->payload == data[1] && sent[2].p->payload == data[2] &&
+          sent[1].p->tot_len == 11, "payloads referenced, not copied");
+    check(sent[1].addr.addr == inet_addr("10.0.0.2") && sent[1].port == 5000, "sent to the address given");
+    check(m[0].result == 10 && m[1].result == 11 && m[2].result == 12, "results set");
+    check(done == 0, "not done while the driver holds a payload");
+    pbuf_free(held[0]);
+    pbuf_free(held[2]);
+    check(done == 0, "not done before the last payload is let go");
+    pbuf_free(held[1]);
+    check(done == 1, "done once the last payload is let go");
+
+    // without a driver holding the payloads, done comes from the message
+    nsent = hold = 0;
+    send_err = ERR_RTE;
+    check(lwip_sendmmsg(s, &batch) == 0, "queued again");
+    run_queued();
+    check(done == 2 && m[0].result == -1 && m[1].result == -1 && m[2].result == -1, "send errors reported");
+    send_err = ERR_OK;
+
+    sockets[s].conn->pcb.udp = NULL;
+    check(lwip_sendmmsg(s, &batch) == 0, "queued without a pcb");
+    run_queued();
+    check(done == 3 && nsent == 0 && m[0].result == -1, "nothing sent without a pcb, still done");
+    sockets[s].conn->pcb.udp = &pcb;
+
+    queue_err = ERR_MEM;
+    check(lwip_sendmmsg(s, &batch) == -1 && queued == NULL, "refused when tcpip_thread is busy");
+    queue_err = ERR_OK;
+
+    t = lwip_socket(AF_INET, SOCK_STREAM, 0);
+    check(lwip_sendmmsg(t, &batch) == -1 && queued == NULL, "refused on a TCP socket");
+    check(lwip_sendmmsg(NUM_SOCKETS, &batch) == -1, "refused on an invalid socket");
+    check(done == 3, "done not called for a refused batch");
+    lwip_close(s);
+    lwip_close(t);
+}
+
+int main()
+{
+    mem_init();
+    memp_init();
+
+    hooks();
+    batches();
+
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
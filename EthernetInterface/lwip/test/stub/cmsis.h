@@ -0,0 +1,24 @@
+/* The LPC1768 register map without the Cortex-M core header, which has
+ * Thumb assembly, for building lwIP and the EMAC driver on the host.
+ * The registers are plain memory mapped by the test. */
+#ifndef HOST_CMSIS_H
+#define HOST_CMSIS_H
+
+#include <stdint.h>
+
+#define __CORE_CM3_H_GENERIC
+#define __CORE_CM3_H_DEPENDANT
+#define __I     volatile const
+#define __O     volatile
+#define __IO    volatile
+
+#include "LPC17xx.h"
+
+#define __REV16(x)  __builtin_bswap16(x)
+#define __REV(x)    __builtin_bswap32(x)
+
+#define NVIC_SetPriority(irq, prio)
+#define NVIC_EnableIRQ(irq)
+#define NVIC_DisableIRQ(irq)
+
+#endif
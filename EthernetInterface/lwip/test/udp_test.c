@@ -0,0 +1,196 @@
+/* Host test of the UDP pcb hash chains
+ *
+ * Builds and runs on the host, without the mbed tree:
+ *
+ *   gcc -Istub -I.. -I../include -I../include/ipv4 -I../../lwip-sys -I../../lwip-sys/arch -I../../lwip-eth/arch/TARGET_NXP \
+ *       -I../../../mbed-rtos/rtx/TARGET_CORTEX_M -I../../../mbed-src/targets/cmsis \
+ *       -I../../../mbed-src/targets/cmsis/TARGET_NXP/TARGET_LPC176X -DTARGET_LPC1768 \
+ *       udp_test.c ../core/pbuf.c ../core/mem.c ../core/memp.c ../core/def.c \
+ *       ../core/ipv4/ip_addr.c ../core/ipv4/inet_chksum.c -o udp_test && ./udp_test
+ *
+ * Binds, rebinds, connects and removes pcbs on ports that share a hash
+ * chain and checks after each step that every pcb of udp_pcbs is in the
+ * chain of its local port exactly once. Then feeds datagrams to
+ * udp_input() and checks which pcb gets them, that a connected pcb moves
+ * to the front of its chain, and that a port nobody is bound to is
+ * reported unreachable.
+ */
+#include "../core/udp.c"
+#include "lwip/sys.h"
+
+#include <stdio.h>
+
+static int failures;
+
+// What udp.c uses from ip.c and icmp.c
+ip_addr_t current_iphdr_src;
+ip_addr_t current_iphdr_dest;
+static int unreachable;
+
+sys_prot_t sys_arch_protect(void) { return 0; }
+void sys_arch_unprotect(sys_prot_t pval) {}
+void icmp_dest_unreach(struct pbuf *p, enum icmp_dur_type t) { unreachable++; }
+struct netif *ip_route(ip_addr_t *dest) { return NULL; }
+err_t ip_output_if(struct pbuf *p, ip_addr_t *src, ip_addr_t *dest, u8_t ttl, u8_t tos,
+                   u8_t proto, struct netif *netif) { return ERR_OK; }
+
+static struct netif netif;
+static struct udp_pcb *received;
+
+static void check(int ok, const char *what)
+{
+    printf("%s: %s\n", ok ? "ok" : "FAIL", what);
+    if (!ok)
+        failures++;
+}
+
+static void got(void *arg, struct udp_pcb *pcb, struct pbuf *p, ip_addr_t *addr, u16_t port)
+{
+    received = pcb;
+    pbuf_free(p);
+}
+
+// Every pcb of udp_pcbs once in the chain of its port, nothing else hashed
+static int hashed(void)
+{
+    struct udp_pcb *pcb, *h;
+    int n = 0, chained = 0, i;
+
+    for (pcb = udp_pcbs; pcb != NULL; pcb = pcb->next, n++) {
+        int found = 0;
+        for (h = udp_pcb_hash[UDP_PCB_HASH(pcb->local_port)]; h != NULL; h = h->hash_next)
+            found += h == pcb;
+        if (found != 1)
+            return 0;
+    }
+    for (i = 0; i < UDP_PCB_HASH_SIZE; i++)
+        for (h = udp_pcb_hash[i]; h != NULL; h = h->hash_next, chained++)
+            if (UDP_PCB_HASH(h->local_port) != i)
+                return 0;
+    return n == chained;
+}
+
+static struct udp_pcb *bound(u16_t port)
+{
+    struct udp_pcb *pcb = udp_new();
+
+    if (udp_bind(pcb, IP_ADDR_ANY, port) != ERR_OK) {
+        udp_remove(pcb);
+        return NULL;
+    }
+    udp_recv(pcb, got, NULL);
+    return pcb;
+}
+
+// A datagram from src:sport to our address at dport
+static void input(const char *src, u16_t sport, u16_t dport)
+{
+    struct pbuf *p = pbuf_alloc(PBUF_RAW, IP_HLEN + UDP_HLEN + 4, PBUF_RAM);
+    struct ip_hdr *iphdr = (struct ip_hdr *)p->payload;
+    struct udp_hdr *udphdr = (struct udp_hdr *)((u8_t *)p->payload + IP_HLEN);
+
+    memset(p->payload, 0, p->len);
+    IPH_VHLTOS_SET(iphdr, 4, IP_HLEN / 4, 0);
+    udphdr->src = htons(sport);
+    udphdr->dest = htons(dport);
+    udphdr->len = htons(UDP_HLEN + 4);
+    ip4_addr_set_u32(&current_iphdr_src, ipaddr_addr(src));
+    ip_addr_copy(current_iphdr_dest, netif.ip_addr);
+    received = NULL;
+    udp_input(p, &netif);
+}
+
+static void binding(void)
+{
+    struct udp_pcb *a, *b, *c, *d, *e, *f;
+    ip_addr_t remote;
+
+    check(UDP_PCB_HASH(1000) == UDP_PCB_HASH(1016) && UDP_PCB_HASH(0xc000) == UDP_PCB_HASH(0xc010),
+          "test ports share chains");
+    a = bound(1000);
+    b = bound(1016);
+    c = bound(2000);
+    check(a && b && c && hashed(), "bound");
+    check(bound(1000) == NULL && bound(1016) == NULL, "double bind refused");
+    check(hashed(), "refused pcbs not hashed");
+
+    check(udp_bind(a, IP_ADDR_ANY, 3000) == ERR_OK && hashed(), "rebound");
+    check(a->local_port == 3000 && udp_pcb_hash[UDP_PCB_HASH(1000)] == b, "moved to the chain of its new port");
+    d = bound(1000);
+    check(d && hashed(), "old port free after the rebind");
+    check(udp_bind(a, IP_ADDR_ANY, 3000) == ERR_OK && hashed(), "rebound to the same port");
+
+    udp_remove(b);
+    check(hashed(), "removed");
+    b = bound(1016);
+    check(b && hashed(), "port free after the remove");
+
+    // MEMP_NUM_UDP_PCB is 4
+    udp_remove(b);
+    udp_remove(c);
+    udp_remove(d);
+
+    e = bound(0xc000);
+    f = bound(0xc010);
+    c = bound(0);
+    check(c && c->local_port == 0xc001 && hashed(), "ephemeral port skips the used one");
+    udp_remove(e);
+    udp_remove(f);
+    udp_remove(c);
+
+    // udp_connect() binds an unbound pcb
+    c = udp_new();
+    IP4_ADDR(&remote, 10, 0, 0, 2);
+    check(udp_connect(c, &remote, 7) == ERR_OK && c->local_port == 0xc000 && hashed(), "bound by connect");
+    udp_remove(c);
+    check(hashed() && udp_pcbs == a && a->next == NULL, "all removed but one");
+}
+
+static void delivery(void)
+{
+    struct udp_pcb *a, *b;
+    ip_addr_t remote;
+
+    while (udp_pcbs != NULL)
+        udp_remove(udp_pcbs);
+    check(hashed() && udp_pcb_hash[UDP_PCB_HASH(1000)] == NULL, "empty");
+
+    a = bound(1000);
+    IP4_ADDR(&remote, 10, 0, 0, 2);
+    udp_connect(a, &remote, 7000);
+    b = bound(1016);
+    check(udp_pcb_hash[UDP_PCB_HASH(1000)] == b, "last bound first in the chain");
+
+    input("10.0.0.3", 7000, 1016);
+    check(received == b, "unconnected pcb takes any sender");
+    input("10.0.0.2", 7000, 1000);
+    check(received == a, "connected pcb takes its peer");
+    check(udp_pcb_hash[UDP_PCB_HASH(1000)] == a && a->hash_next == b && hashed(), "moved to the front");
+    input("10.0.0.2", 7000, 1000);
+    check(received == a && udp_pcb_hash[UDP_PCB_HASH(1000)] == a, "found first the next time");
+
+    unreachable = 0;
+    input("10.0.0.3", 7000, 1000);
+    check(received == NULL && unreachable == 1, "connected pcb ignores other senders");
+    input("10.0.0.2", 7000, 1032);
+    check(UDP_PCB_HASH(1032) != UDP_PCB_HASH(1000) && received == NULL && unreachable == 2,
+          "port of an empty chain unreachable");
+    input("10.0.0.2", 7000, 1000 - UDP_PCB_HASH_SIZE);
+    check(UDP_PCB_HASH(1000 - UDP_PCB_HASH_SIZE) == UDP_PCB_HASH(1000) && received == NULL &&
+          unreachable == 3, "unbound port of a used chain unreachable");
+}
+
+int main()
+{
+    mem_init();
+    memp_init();
+    IP4_ADDR(&netif.ip_addr, 10, 0, 0, 1);
+    IP4_ADDR(&netif.netmask, 255, 255, 255, 0);
+    netif.flags = NETIF_FLAG_UP | NETIF_FLAG_BROADCAST;
+
+    binding();
+    delivery();
+
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
@@ -19,11 +19,12 @@
 
 //Debug is disabled by default
 #if 0
-//Enable debug
-#include <cstdio>
-#define DBG(x, ...) std::printf("[HTTPClient : DBG]"x"\r\n", ##__VA_ARGS__); 
-#define WARN(x, ...) std::printf("[HTTPClient : WARN]"x"\r\n", ##__VA_ARGS__); 
-#define ERR(x, ...) std::printf("[HTTPClient : ERR]"x"\r\n", ##__VA_ARGS__); 
+//Enable debug, formatted later by the trace drain thread
+#define TRACE_ON 1
+#include "Trace.h"
+#define DBG(x, ...) TRACE("[HTTPClient : DBG]" x, ##__VA_ARGS__); 
+#define WARN(x, ...) TRACE("[HTTPClient : WARN]" x, ##__VA_ARGS__); 
+#define ERR(x, ...) TRACE("[HTTPClient : ERR]" x, ##__VA_ARGS__); 
 
 #else
 //Disable debug
@@ -42,19 +43,29 @@
 
 #define CHUNK_SIZE 256
 
+#define CHUNK_HEADER_LEN 6 //"XXXX\r\n", chunk length with leading zeros
+
 #include <cstring>
 
 #include "HTTPClient.h"
 
+#if HTTP_CLIENT_TX_SIZE > 0xFFFF
+#error "HTTP_CLIENT_TX_SIZE must fit in 4 hex digits"
+#endif
+#if HTTP_CLIENT_TX_SIZE < CHUNK_HEADER_LEN + CHUNK_SIZE + 2
+#error "HTTP_CLIENT_TX_SIZE is too small"
+#endif
+
 HTTPClient::HTTPClient() :
-m_sock(), m_basicAuthUser(NULL), m_basicAuthPassword(NULL), m_httpResponseCode(0)
+m_sock(), m_basicAuthUser(NULL), m_basicAuthPassword(NULL), m_httpResponseCode(0),
+m_txBuf(NULL), m_txLen(0), m_txBody(0), m_sent(0), m_total(0), m_progress(NULL), m_progressCtx(NULL)
 {
 
 }
 
 HTTPClient::~HTTPClient()
 {
-
+  delete[] m_txBuf;
 }
 
 #if 0
@@ -97,6 +108,12 @@ int HTTPClient::getHTTPResponseCode()
   return m_httpResponseCode;
 }
 
+void HTTPClient::setProgressCallback(void (*fn)(void* ctx, size_t sent, size_t total), void* ctx /*= NULL*/)
+{
+  m_progress = fn;
+  m_progressCtx = ctx;
+}
+
 #define CHECK_CONN_ERR(ret) \
   do{ \
     if(ret) { \
@@ -118,10 +135,23 @@ HTTPResult HTTPClient::connect(const char* url, HTTP_METH method, IHTTPDataOut*
   m_httpResponseCode = 0; //Invalidate code
   m_timeout = timeout;
   
+  if( m_txBuf == NULL )
+  {
+    m_txBuf = new char[HTTP_CLIENT_TX_SIZE];
+  }
+  m_txLen = 0;
+  m_txBody = 0;
+  m_sent = 0;
+  m_total = 0;
+  
   pDataIn->writeReset();
   if( pDataOut )
   {
-    pDataOut->readReset();
+    if( pDataOut->readReset() != OK )
+    {
+      ERR("Data to send is not available");
+      return HTTP_ERROR;
+    }
   }
 
   char scheme[8];
@@ -161,7 +191,7 @@ HTTPResult HTTPClient::connect(const char* url, HTTP_METH method, IHTTPDataOut*
   char buf[CHUNK_SIZE];
   const char* meth = (method==HTTP_GET)?"GET":(method==HTTP_POST)?"POST":(method==HTTP_PUT)?"PUT":(method==HTTP_DELETE)?"DELETE":"";
   snprintf(buf, sizeof(buf), "%s %s HTTP/1.1\r\nHost: %s\r\n", meth, path, host); //Write request
-  ret = send(buf);
+  ret = write(buf);
   if(ret)
   {
     m_sock.close();
@@ -177,20 +207,21 @@ HTTPResult HTTPClient::connect(const char* url, HTTP_METH method, IHTTPDataOut*
   {
     if( pDataOut->getIsChunked() )
     {
-      ret = send("Transfer-Encoding: chunked\r\n");
+      ret = write("Transfer-Encoding: chunked\r\n");
       CHECK_CONN_ERR(ret);
     }
     else
     {
-      snprintf(buf, sizeof(buf), "Content-Length: %d\r\n", pDataOut->getDataLen());
-      ret = send(buf);
+      m_total = pDataOut->getDataLen();
+      snprintf(buf, sizeof(buf), "Content-Length: %d\r\n", m_total);
+      ret = write(buf);
       CHECK_CONN_ERR(ret);
     }
-    char type[48];
-    if( pDataOut->getDataType(type, 48) == HTTP_OK )
+    char type[80];
+    if( pDataOut->getDataType(type, sizeof(type)) == HTTP_OK )
     {
       snprintf(buf, sizeof(buf), "Content-Type: %s\r\n", type);
-      ret = send(buf);
+      ret = write(buf);
       CHECK_CONN_ERR(ret);
     }
     
@@ -199,7 +230,7 @@ HTTPResult HTTPClient::connect(const char* url, HTTP_METH method, IHTTPDataOut*
     {
       size_t headerlen = strlen(buf);
       snprintf(buf + headerlen, sizeof(buf) - headerlen, "\r\n");
-      ret = send(buf);
+      ret = write(buf);
       CHECK_CONN_ERR(ret);
     }
   }
@@ -209,13 +240,13 @@ HTTPResult HTTPClient::connect(const char* url, HTTP_METH method, IHTTPDataOut*
   {
     size_t headerlen = strlen(buf);
     snprintf(buf + headerlen, sizeof(buf) - headerlen, "\r\n");
-    ret = send(buf);
+    ret = write(buf);
     CHECK_CONN_ERR(ret);
   }
   
-  //Close headers
+  //Close headers, they go out with the start of the body
   DBG("Headers sent");
-  ret = send("\r\n");
+  ret = write("\r\n");
   CHECK_CONN_ERR(ret);
 
   size_t trfLen;
@@ -224,48 +255,66 @@ HTTPResult HTTPClient::connect(const char* url, HTTP_METH method, IHTTPDataOut*
   if( pDataOut != NULL )
   {
     DBG("Sending data");
-    while(true)
+    bool chunked = pDataOut->getIsChunked();
+    size_t writtenLen = 0;
+    while( chunked || (writtenLen < m_total) )
     {
-      size_t writtenLen = 0;
-      pDataOut->read(buf, CHUNK_SIZE, &trfLen);
-      if( pDataOut->getIsChunked() )
+      //Data is read in place, behind the room for a chunk header
+      //Each read gets room for at least CHUNK_SIZE bytes (or what is left), data sources expect that
+      size_t framing = chunked ? CHUNK_HEADER_LEN + 2 : 0;
+      if( HTTP_CLIENT_TX_SIZE - m_txLen < framing + CHUNK_SIZE )
       {
-        //Write chunk header
-        char chunkHeader[16];
-        snprintf(chunkHeader, sizeof(chunkHeader), "%X\r\n", trfLen); //In hex encoding
-        ret = send(chunkHeader);
+        ret = flush();
         CHECK_CONN_ERR(ret);
       }
-      else if( trfLen == 0 )
-      {
-        break;
-      }
-      if( trfLen != 0 )
+      char* data = m_txBuf + m_txLen + (chunked ? CHUNK_HEADER_LEN : 0);
+      size_t len = HTTP_CLIENT_TX_SIZE - m_txLen - framing;
+      if( !chunked )
       {
-        ret = send(buf, trfLen);
-        CHECK_CONN_ERR(ret);
+        len = MIN(len, m_total - writtenLen);
       }
-
-      if( pDataOut->getIsChunked()  )
+      trfLen = 0;
+      if( pDataOut->read(data, len, &trfLen) != OK )
       {
-        ret = send("\r\n"); //Chunk-terminating CRLF
-        CHECK_CONN_ERR(ret);
+        m_sock.close();
+        ERR("Could not read data to send");
+        return HTTP_ERROR;
       }
-      else
+      if( chunked )
       {
-        writtenLen += trfLen;
-        if( writtenLen >= pDataOut->getDataLen() )
+        //Chunk header, then the chunk-terminating CRLF
+        const char hex[] = "0123456789ABCDEF";
+        char* chunkHeader = data - CHUNK_HEADER_LEN;
+        chunkHeader[0] = hex[(trfLen >> 12) & 0xf];
+        chunkHeader[1] = hex[(trfLen >> 8) & 0xf];
+        chunkHeader[2] = hex[(trfLen >> 4) & 0xf];
+        chunkHeader[3] = hex[trfLen & 0xf];
+        chunkHeader[4] = '\r';
+        chunkHeader[5] = '\n';
+        data[trfLen] = '\r';
+        data[trfLen + 1] = '\n';
+        m_txLen += trfLen + framing;
+        m_txBody += trfLen;
+        if( trfLen == 0 ) //Last chunk
         {
           break;
         }
       }
-
-      if( trfLen == 0 )
+      else
       {
-        break;
+        if( trfLen == 0 )
+        {
+          ERR("Data ended %d bytes short of its length", m_total - writtenLen);
+          PRTCL_ERR();
+        }
+        m_txLen += trfLen;
+        m_txBody += trfLen;
+        writtenLen += trfLen;
       }
     }
   }
+  ret = flush();
+  CHECK_CONN_ERR(ret);
   
   //Receive response
   DBG("Receiving response");
@@ -665,6 +714,55 @@ HTTPResult HTTPClient::send(char* buf, size_t len) //0 on success, err code on f
   return HTTP_OK;
 }
 
+HTTPResult HTTPClient::write(const char* buf, size_t len) //Queue data to be sent, 0 on success, err code on failure
+{
+  if(len == 0)
+  {
+    len = strlen(buf);
+  }
+  while(len > 0)
+  {
+    if(m_txLen == HTTP_CLIENT_TX_SIZE)
+    {
+      HTTPResult ret = flush();
+      if(ret)
+      {
+        return ret;
+      }
+    }
+    size_t n = MIN(len, HTTP_CLIENT_TX_SIZE - m_txLen);
+    memcpy(m_txBuf + m_txLen, buf, n);
+    m_txLen += n;
+    buf += n;
+    len -= n;
+  }
+  return HTTP_OK;
+}
+
+HTTPResult HTTPClient::flush() //Send queued data, 0 on success, err code on failure
+{
+  if(m_txLen == 0)
+  {
+    return HTTP_OK;
+  }
+  HTTPResult ret = send(m_txBuf, m_txLen);
+  m_txLen = 0;
+  if(ret)
+  {
+    return ret;
+  }
+  if(m_txBody != 0)
+  {
+    m_sent += m_txBody;
+    m_txBody = 0;
+    if(m_progress != NULL)
+    {
+      m_progress(m_progressCtx, m_sent, m_total);
+    }
+  }
+  return HTTP_OK;
+}
+
 HTTPResult HTTPClient::parseURL(const char* url, char* scheme, size_t maxSchemeLen, char* host, size_t maxHostLen, uint16_t* port, char* path, size_t maxPathLen) //Parse URL
 {
   char* schemePtr = (char*) url;
@@ -28,6 +28,10 @@ HTTP Client header file
 
 #define HTTP_CLIENT_DEFAULT_TIMEOUT 15000
 
+#ifndef HTTP_CLIENT_TX_SIZE
+#define HTTP_CLIENT_TX_SIZE 1460 //Requests are sent in writes of up to one TCP segment (TCP_MSS)
+#endif
+
 class HTTPData;
 
 #include "IHTTPData.h"
@@ -52,7 +56,10 @@ enum HTTPResult
 /**A simple HTTP Client
 The HTTPClient is composed of:
 - The actual client (HTTPClient)
-- Classes that act as a data repository, each of which deriving from the HTTPData class (HTTPText for short text content, HTTPFile for file I/O, HTTPMap for key/value pairs, and HTTPStream for streaming purposes)
+- Classes that act as a data repository, each of which deriving from the HTTPData class (HTTPText for short text content, HTTPFile for file uploads, HTTPMap for key/value pairs, and HTTPMultipart for form uploads with files)
+
+Request line, headers and body are collected in a buffer of HTTP_CLIENT_TX_SIZE bytes (allocated on the first request) and sent in as few socket writes as possible.
+Body data is read straight into that buffer.
 */
 class HTTPClient
 {
@@ -126,6 +133,12 @@ public:
   */
   int getHTTPResponseCode();
   
+  /** Set a function to be called while a request body is sent
+  @param fn : called with ctx, the number of body bytes sent so far and the body length (0 if chunked), NULL for none
+  @param ctx : passed to fn
+  */
+  void setProgressCallback(void (*fn)(void* ctx, size_t sent, size_t total), void* ctx = NULL);
+  
 private:
   enum HTTP_METH
   {
@@ -139,6 +152,8 @@ private:
   HTTPResult connect(const char* url, HTTP_METH method, IHTTPDataOut* pDataOut, IHTTPDataIn* pDataIn, int timeout); //Execute request
   HTTPResult recv(char* buf, size_t minLen, size_t maxLen, size_t* pReadLen); //0 on success, err code on failure
   HTTPResult send(char* buf, size_t len = 0); //0 on success, err code on failure
+  HTTPResult write(const char* buf, size_t len = 0); //Queue data to be sent, 0 on success, err code on failure
+  HTTPResult flush(); //Send queued data, 0 on success, err code on failure
   HTTPResult parseURL(const char* url, char* scheme, size_t maxSchemeLen, char* host, size_t maxHostLen, uint16_t* port, char* path, size_t maxPathLen); //Parse URL
 
   //Parameters
@@ -150,10 +165,21 @@ private:
   const char* m_basicAuthPassword;
   int m_httpResponseCode;
 
+  char* m_txBuf; //Data queued to be sent
+  size_t m_txLen;
+  size_t m_txBody; //Body bytes in m_txBuf
+  size_t m_sent; //Body bytes sent
+  size_t m_total; //Body length, 0 if chunked
+  
+  void (*m_progress)(void* ctx, size_t sent, size_t total);
+  void* m_progressCtx;
+
 };
 
 //Including data containers here for more convenience
 #include "data/HTTPText.h"
 #include "data/HTTPMap.h"
+#include "data/HTTPFile.h"
+#include "data/HTTPMultipart.h"
 
 #endif
@@ -41,8 +41,9 @@ protected:
   
   /** Reset stream to its beginning 
    * Called by the HTTPClient on each new request
+   * @return 0 on success, the request fails before anything is sent otherwise
    */
-  virtual void readReset() = 0;
+  virtual int readReset() = 0;
 
   /** Read a piece of data to be transmitted
    * @param buf Pointer to the buffer on which to copy the data
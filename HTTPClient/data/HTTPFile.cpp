@@ -0,0 +1,135 @@
+/* HTTPFile.cpp */
+/* Copyright (C) 2012 mbed.org, MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "HTTPFile.h"
+
+#include <cstring>
+
+#define OK 0
+
+using std::fopen;
+using std::fclose;
+using std::fread;
+using std::fseek;
+using std::ftell;
+using std::snprintf;
+using std::strncpy;
+
+#define MIN(x,y) (((x)<(y))?(x):(y))
+
+HTTPFile::HTTPFile(const char* path, const char* type /*= "application/octet-stream"*/) :
+m_path(path), m_type(type), m_fp(NULL), m_size(0), m_offset(0), m_pos(0), m_header(false)
+{
+
+}
+
+HTTPFile::~HTTPFile()
+{
+  if(m_fp != NULL)
+  {
+    fclose(m_fp);
+  }
+}
+
+void HTTPFile::setOffset(size_t offset)
+{
+  m_offset = offset;
+}
+
+size_t HTTPFile::getSize()
+{
+  return m_size;
+}
+
+/*virtual*/ bool HTTPFile::getHeader(char* header, size_t maxHeaderLen)
+{
+  if(!m_header || m_offset == 0)
+  {
+    return false;
+  }
+  m_header = false;
+  if(m_offset < m_size)
+  {
+    snprintf(header, maxHeaderLen, "Content-Range: bytes %u-%u/%u", m_offset, m_size - 1, m_size);
+  }
+  else
+  {
+    snprintf(header, maxHeaderLen, "Content-Range: bytes */%u", m_size);
+  }
+  return true;
+}
+
+//IHTTPDataOut
+/*virtual*/ int HTTPFile::readReset()
+{
+  if(m_fp == NULL)
+  {
+    m_fp = fopen(m_path, "rb");
+  }
+  m_size = 0;
+  m_pos = 0;
+  m_header = false;
+  if(m_fp == NULL)
+  {
+    return -1; //Do not send an empty body in place of the file
+  }
+  //The file may have grown since the last request
+  fseek(m_fp, 0, SEEK_END);
+  m_size = ftell(m_fp);
+  fseek(m_fp, MIN(m_offset, m_size), SEEK_SET);
+  m_pos = MIN(m_offset, m_size);
+  m_header = true;
+  return OK;
+}
+
+/*virtual*/ int HTTPFile::read(char* buf, size_t len, size_t* pReadLen)
+{
+  *pReadLen = 0;
+  if(m_fp == NULL)
+  {
+    return -1;
+  }
+  size_t n = fread(buf, 1, MIN(len, m_size - m_pos), m_fp);
+  m_pos += n;
+  *pReadLen = n;
+  if(m_pos >= m_size || n == 0)
+  {
+    //Done, or the file shrank and the HTTPClient gives up
+    fclose(m_fp);
+    m_fp = NULL;
+  }
+  return OK;
+}
+
+/*virtual*/ int HTTPFile::getDataType(char* type, size_t maxTypeLen) //Internet media type for Content-Type header
+{
+  strncpy(type, m_type, maxTypeLen-1);
+  type[maxTypeLen-1] = '\0';
+  return OK;
+}
+
+/*virtual*/ bool HTTPFile::getIsChunked() //For Transfer-Encoding header
+{
+  return false;
+}
+
+/*virtual*/ size_t HTTPFile::getDataLen() //For Content-Length header
+{
+  return m_size - MIN(m_offset, m_size);
+}
@@ -0,0 +1,78 @@
+/* HTTPFile.h */
+/* Copyright (C) 2012 mbed.org, MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef HTTPFILE_H_
+#define HTTPFILE_H_
+
+#include "../IHTTPData.h"
+
+#include <cstdio>
+
+/** A data endpoint to upload a file
+ * The file is read straight into the buffer of the HTTPClient, so it is sent in writes as large as that buffer.
+ * An interrupted upload can be resumed: setOffset() skips the part the server has, a Content-Range header tells the server which part follows.
+ */
+class HTTPFile : public IHTTPDataOut
+{
+public:
+  /** Create an HTTPFile instance for output
+   * @param path File to be transmitted (e.g. "/sd/log.txt"), must remain valid
+   * @param type Internet media type for the Content-Type header, must remain valid
+   */
+  HTTPFile(const char* path, const char* type = "application/octet-stream");
+  ~HTTPFile();
+
+  /** Transmit the file from an offset on
+   * At the end of the file no data is sent, the Content-Range header asks for the state of the upload ("bytes *" and the size)
+   * @param offset First byte to transmit, 0 for the whole file without a Content-Range header
+   */
+  void setOffset(size_t offset);
+
+  /** Get the size of the file
+   * @return Size as of the last request
+   */
+  size_t getSize();
+
+protected:
+  virtual bool getHeader(char* header, size_t maxHeaderLen);
+
+  //IHTTPDataOut
+  virtual int readReset();
+
+  virtual int read(char* buf, size_t len, size_t* pReadLen);
+
+  virtual int getDataType(char* type, size_t maxTypeLen); //Internet media type for Content-Type header
+
+  virtual bool getIsChunked(); //For Transfer-Encoding header
+
+  virtual size_t getDataLen(); //For Content-Length header
+
+private:
+  const char* m_path;
+  const char* m_type;
+  std::FILE* m_fp;
+
+  size_t m_size;
+  size_t m_offset;
+  size_t m_pos;
+  bool m_header; //Content-Range header still to be sent
+};
+
+#endif /* HTTPFILE_H_ */
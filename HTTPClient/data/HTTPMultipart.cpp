@@ -0,0 +1,250 @@
+/* HTTPMultipart.cpp */
+/* Copyright (C) 2012 mbed.org, MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "HTTPMultipart.h"
+
+#include <cstring>
+#include <cstdlib>
+
+#define OK 0
+
+using std::memcpy;
+using std::strlen;
+using std::strrchr;
+using std::snprintf;
+using std::fopen;
+using std::fclose;
+using std::fread;
+using std::fseek;
+using std::ftell;
+
+#define MIN(x,y) (((x)<(y))?(x):(y))
+
+HTTPMultipart::HTTPMultipart() : m_count(0), m_part(0), m_pos(0), m_fp(NULL)
+{
+  //Must not appear in the data. rand() is not seeded, so the boundaries repeat from boot to boot:
+  //they only make a match in text or binary data unlikely, they are not secret
+  snprintf(m_boundary, sizeof(m_boundary), "----mbed%08x%08x", std::rand(), std::rand());
+}
+
+HTTPMultipart::~HTTPMultipart()
+{
+  clear();
+}
+
+void HTTPMultipart::put(const char* name, const char* value)
+{
+  if(m_count >= HTTPMULTIPART_MAX_PARTS)
+  {
+    return;
+  }
+  m_parts[m_count].name = name;
+  m_parts[m_count].value = value;
+  m_parts[m_count].type = NULL;
+  m_parts[m_count].len = 0;
+  m_count++;
+}
+
+void HTTPMultipart::putFile(const char* name, const char* path, const char* type /*= "application/octet-stream"*/)
+{
+  if(m_count >= HTTPMULTIPART_MAX_PARTS)
+  {
+    return;
+  }
+  m_parts[m_count].name = name;
+  m_parts[m_count].value = path;
+  m_parts[m_count].type = type;
+  m_parts[m_count].len = 0;
+  m_count++;
+}
+
+void HTTPMultipart::clear()
+{
+  if(m_fp != NULL)
+  {
+    fclose(m_fp);
+    m_fp = NULL;
+  }
+  m_count = 0;
+  m_part = 0;
+  m_pos = 0;
+}
+
+size_t HTTPMultipart::header(size_t i, char* buf, size_t len, size_t skip)
+{
+  const char* str[12];
+  size_t n = 0;
+
+  if(i > 0)
+  {
+    str[n++] = "\r\n"; //Ends the data of the previous part
+  }
+  str[n++] = "--";
+  str[n++] = m_boundary;
+  if(i < m_count)
+  {
+    str[n++] = "\r\nContent-Disposition: form-data; name=\"";
+    str[n++] = m_parts[i].name;
+    if(m_parts[i].type != NULL)
+    {
+      const char* filename = strrchr(m_parts[i].value, '/');
+      str[n++] = "\"; filename=\"";
+      str[n++] = filename ? filename + 1 : m_parts[i].value;
+      str[n++] = "\"\r\nContent-Type: ";
+      str[n++] = m_parts[i].type;
+      str[n++] = "\r\n\r\n";
+    }
+    else
+    {
+      str[n++] = "\"\r\n\r\n";
+    }
+  }
+  else
+  {
+    str[n++] = "--\r\n";
+  }
+
+  //Copy what is left after skip, or get the length if there is no buffer
+  size_t total = 0;
+  size_t out = 0;
+  for(size_t k = 0; k < n; k++)
+  {
+    size_t l = strlen(str[k]);
+    if( (buf != NULL) && (skip < total + l) && (out < len) )
+    {
+      size_t from = (skip > total) ? skip - total : 0;
+      size_t copy = MIN(l - from, len - out);
+      memcpy(buf + out, str[k] + from, copy);
+      out += copy;
+    }
+    total += l;
+  }
+  return (buf != NULL) ? out : total;
+}
+
+/*virtual*/ int HTTPMultipart::readReset()
+{
+  if(m_fp != NULL)
+  {
+    fclose(m_fp);
+    m_fp = NULL;
+  }
+  for(size_t i = 0; i < m_count; i++)
+  {
+    if(m_parts[i].type == NULL)
+    {
+      m_parts[i].len = strlen(m_parts[i].value);
+      continue;
+    }
+    //Files may have grown since the last request
+    m_parts[i].len = 0;
+    std::FILE* fp = fopen(m_parts[i].value, "rb");
+    if(fp == NULL)
+    {
+      return -1; //Do not send an empty part in place of the file
+    }
+    fseek(fp, 0, SEEK_END);
+    m_parts[i].len = ftell(fp);
+    fclose(fp);
+  }
+  m_part = 0;
+  m_pos = 0;
+  return OK;
+}
+
+/*virtual*/ int HTTPMultipart::read(char* buf, size_t len, size_t* pReadLen)
+{
+  size_t out = 0;
+  while( (out < len) && (m_part <= m_count) )
+  {
+    size_t headerLen = header(m_part, NULL, 0, 0);
+    if(m_pos < headerLen)
+    {
+      size_t n = header(m_part, buf + out, len - out, m_pos);
+      out += n;
+      m_pos += n;
+      continue;
+    }
+    if(m_part == m_count) //Closing boundary sent
+    {
+      m_part++;
+      break;
+    }
+
+    Part& part = m_parts[m_part];
+    size_t pos = m_pos - headerLen;
+    if(pos < part.len)
+    {
+      size_t want = MIN(len - out, part.len - pos);
+      size_t n;
+      if(part.type == NULL)
+      {
+        memcpy(buf + out, part.value + pos, want);
+        n = want;
+      }
+      else
+      {
+        if(m_fp == NULL)
+        {
+          m_fp = fopen(part.value, "rb");
+        }
+        n = (m_fp != NULL) ? fread(buf + out, 1, want, m_fp) : 0;
+      }
+      out += n;
+      m_pos += n;
+      if(n < want) //The file shrank, the HTTPClient gives up when nothing is left
+      {
+        break;
+      }
+      continue;
+    }
+
+    //Next part
+    if(m_fp != NULL)
+    {
+      fclose(m_fp);
+      m_fp = NULL;
+    }
+    m_part++;
+    m_pos = 0;
+  }
+  *pReadLen = out;
+  return OK;
+}
+
+/*virtual*/ int HTTPMultipart::getDataType(char* type, size_t maxTypeLen) //Internet media type for Content-Type header
+{
+  snprintf(type, maxTypeLen, "multipart/form-data; boundary=%s", m_boundary);
+  return OK;
+}
+
+/*virtual*/ bool HTTPMultipart::getIsChunked() //For Transfer-Encoding header
+{
+  return false;
+}
+
+/*virtual*/ size_t HTTPMultipart::getDataLen() //For Content-Length header
+{
+  size_t count = 0;
+  for(size_t i = 0; i < m_count; i++)
+  {
+    count += header(i, NULL, 0, 0) + m_parts[i].len;
+  }
+  return count + header(m_count, NULL, 0, 0);
+}
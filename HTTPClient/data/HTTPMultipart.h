@@ -0,0 +1,96 @@
+/* HTTPMultipart.h */
+/* Copyright (C) 2012 mbed.org, MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef HTTPMULTIPART_H_
+#define HTTPMULTIPART_H_
+
+#include "../IHTTPData.h"
+
+#include <cstdio>
+
+#define HTTPMULTIPART_MAX_PARTS 8
+
+/** Form of fields and files
+ * Used to transmit POST data using the multipart/form-data encoding (RFC 2388), e.g. to upload a log file from /sd.
+ * Part headers and boundaries are generated as the HTTPClient reads and files are read straight into its buffer, nothing is assembled in memory.
+ * The sizes of the files are taken on each request so the Content-Length is exact.
+ */
+class HTTPMultipart : public IHTTPDataOut
+{
+public:
+  /**
+   Instantiates HTTPMultipart
+   It supports at most HTTPMULTIPART_MAX_PARTS fields and files
+   */
+  HTTPMultipart();
+  ~HTTPMultipart();
+
+  /** Put a field
+   The references to the parameters must remain valid as long as the clear() function is not called
+   @param name The name of the field, without '"'
+   @param value The value of the field
+   */
+  void put(const char* name, const char* value);
+
+  /** Put a file
+   The references to the parameters must remain valid as long as the clear() function is not called
+   @param name The name of the field, without '"'
+   @param path The file to be transmitted (e.g. "/sd/log.txt"), the file name after the last '/' is sent along
+   @param type Internet media type of the file
+   */
+  void putFile(const char* name, const char* path, const char* type = "application/octet-stream");
+
+  /** Clear form
+   */
+  void clear();
+
+protected:
+  //IHTTPDataOut
+  virtual int readReset();
+
+  virtual int read(char* buf, size_t len, size_t* pReadLen);
+
+  virtual int getDataType(char* type, size_t maxTypeLen); //Internet media type for Content-Type header
+
+  virtual bool getIsChunked(); //For Transfer-Encoding header
+
+  virtual size_t getDataLen(); //For Content-Length header
+
+private:
+  struct Part
+  {
+    const char* name;
+    const char* value; //Value of a field, path of a file
+    const char* type; //Type of a file, NULL for a field
+    size_t len; //Length of the value or the file
+  };
+
+  size_t header(size_t i, char* buf, size_t len, size_t skip); //Part header, or closing boundary after the last part
+
+  Part m_parts[HTTPMULTIPART_MAX_PARTS];
+  size_t m_count;
+  char m_boundary[28];
+
+  size_t m_part; //Part being read
+  size_t m_pos; //Position in the part, header first
+  std::FILE* m_fp;
+};
+
+#endif /* HTTPMULTIPART_H_ */
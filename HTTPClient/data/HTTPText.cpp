@@ -40,9 +40,10 @@ HTTPText::HTTPText(char* str, size_t size) : m_str(str), m_size(size), m_pos(0)
 }
 
 //IHTTPDataIn
-/*virtual*/ void HTTPText::readReset()
+/*virtual*/ int HTTPText::readReset()
 {
   m_pos = 0;
+  return OK;
 }
 
 /*virtual*/ int HTTPText::read(char* buf, size_t len, size_t* pReadLen)
@@ -41,7 +41,7 @@ public:
 
 protected:
   //IHTTPDataIn
-  virtual void readReset();
+  virtual int readReset();
   
   virtual int read(char* buf, size_t len, size_t* pReadLen);
 
@@ -0,0 +1,491 @@
+/* HTTPFileServer.cpp */
+/* Copyright (C) 2012 mbed.org, MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "HTTPFileServer.h"
+#include "lwip/tcpip.h"
+#include <cstring>
+#include <cctype>
+
+#define HTTP_RESPONSE(status) "HTTP/1.0 " status "\r\nContent-Type: text/plain\r\nConnection: close\r\n\r\n" status "\r\n"
+
+static const char http_403[] = HTTP_RESPONSE("403 Forbidden");
+static const char http_404[] = HTTP_RESPONSE("404 Not Found");
+static const char http_501[] = HTTP_RESPONSE("501 Not Implemented");
+
+static const char http_header[] = "HTTP/1.0 200 OK\r\nContent-Type: %s\r\nContent-Length: %ld\r\nAccept-Ranges: bytes\r\nConnection: close\r\n\r\n";
+static const char http_header_206[] = "HTTP/1.0 206 Partial Content\r\nContent-Type: %s\r\nContent-Length: %ld\r\nContent-Range: bytes %ld-%ld/%ld\r\nConnection: close\r\n\r\n";
+static const char http_416[] = "HTTP/1.0 416 Requested Range Not Satisfiable\r\nContent-Range: bytes */%ld\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+
+//States of the Range header parser
+enum
+{
+  RANGE_SKIP, //Rest of a header line
+  RANGE_NAME, //Start of a header line
+  RANGE_FROM,
+  RANGE_TO,
+  RANGE_SET, //A single range was read
+  RANGE_NONE //No usable range, the whole file is sent
+};
+
+static const struct
+{
+  const char* ext;
+  const char* type;
+} mime_types[] =
+{
+  { "htm",  "text/html" },
+  { "html", "text/html" },
+  { "txt",  "text/plain" },
+  { "css",  "text/css" },
+  { "js",   "application/javascript" },
+  { "json", "application/json" },
+  { "xml",  "text/xml" },
+  { "jpg",  "image/jpeg" },
+  { "png",  "image/png" },
+  { "gif",  "image/gif" },
+  { "bmp",  "image/bmp" },
+  { "ico",  "image/x-icon" },
+};
+
+HTTPFileServer::HTTPFileServer(const char* root) : m_root(root), m_thread(NULL)
+{
+  for(int i = 0; i < TCP_RAW_CONNECTIONS; i++)
+  {
+    m_transfers[i].server = this;
+    m_transfers[i].conn = NULL;
+    m_transfers[i].fp = NULL;
+    m_transfers[i].job = JOB_NONE;
+  }
+}
+
+int HTTPFileServer::listen(int port, int backlog)
+{
+  if(m_thread == NULL)
+  {
+    m_thread = new Thread(&HTTPFileServer::threadHelper, this, osPriorityNormal, HTTP_FILE_SERVER_STACK);
+  }
+  return TCPRawServer::listen(port, backlog);
+}
+
+bool HTTPFileServer::onAccept(TCPRawConnection* conn)
+{
+  Transfer* t = &m_transfers[conn->id()];
+  
+  if(t->job != JOB_NONE || t->fp != NULL) //The file thread still closes the last file of this slot
+  {
+    return false;
+  }
+  t->conn = conn;
+  t->error = NULL;
+  t->requestLen = 0;
+  t->match = 0;
+  t->rangeState = RANGE_SKIP; //The request line is not a header
+  t->rangeMatch = 0;
+  t->rangeFrom = -1;
+  t->rangeTo = -1;
+  t->left = 0;
+  t->lineDone = false;
+  t->started = false;
+  t->eof = false;
+  t->ready = false;
+  t->front = 0;
+  t->next = 0;
+  t->pending[0] = 0;
+  t->pending[1] = 0;
+  return true;
+}
+
+void HTTPFileServer::onReceive(TCPRawConnection* conn, struct pbuf* p)
+{
+  static const char end[] = "\r\n\r\n";
+  Transfer* t = &m_transfers[conn->id()];
+  
+  if(t->started) //Anything after the request is ignored
+  {
+    return;
+  }
+  
+  //Parse in place: only the request line is kept, the end of the header is matched on the fly
+  for(struct pbuf* q = p; q != NULL; q = q->next)
+  {
+    const char* data = (const char*) q->payload;
+    for(int i = 0; i < q->len; i++)
+    {
+      char c = data[i];
+      if(!t->lineDone)
+      {
+        if(c == '\n')
+        {
+          t->lineDone = true;
+        }
+        else if(c != '\r' && t->requestLen < HTTP_FILE_SERVER_REQUEST - 1)
+        {
+          t->request[t->requestLen++] = c;
+        }
+      }
+      parseRange(t, c);
+      t->match = (c == end[t->match]) ? t->match + 1 : ((c == '\r') ? 1 : 0);
+      if(t->match == 4)
+      {
+        t->started = true;
+        t->request[t->requestLen] = '\0';
+        respond(conn, t);
+        return;
+      }
+    }
+  }
+}
+
+void HTTPFileServer::parseRange(Transfer* t, char c)
+{
+  static const char name[] = "range: bytes=";
+  long* v;
+  
+  switch(t->rangeState)
+  {
+  case RANGE_SKIP:
+    if(c == '\n')
+    {
+      t->rangeState = RANGE_NAME;
+      t->rangeMatch = 0;
+    }
+    break;
+  case RANGE_NAME:
+    if(tolower(c) != name[t->rangeMatch])
+    {
+      t->rangeState = (c == '\n') ? RANGE_NAME : RANGE_SKIP;
+      t->rangeMatch = 0;
+    }
+    else if(++t->rangeMatch == sizeof(name) - 1)
+    {
+      t->rangeState = RANGE_FROM;
+    }
+    break;
+  case RANGE_FROM:
+  case RANGE_TO:
+    v = (t->rangeState == RANGE_FROM) ? &t->rangeFrom : &t->rangeTo;
+    if(c >= '0' && c <= '9' && *v < 100000000L)
+    {
+      *v = ((*v < 0) ? 0 : *v * 10) + (c - '0');
+    }
+    else if(c == '-' && t->rangeState == RANGE_FROM)
+    {
+      t->rangeState = RANGE_TO;
+    }
+    else if((c == '\r' || c == '\n') && t->rangeState == RANGE_TO && (t->rangeFrom >= 0 || t->rangeTo >= 0) &&
+            (t->rangeFrom < 0 || t->rangeTo < 0 || t->rangeTo >= t->rangeFrom))
+    {
+      t->rangeState = RANGE_SET;
+    }
+    else //Several ranges or a malformed one (e.g. last < first) are ignored
+    {
+      t->rangeState = RANGE_NONE;
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+void HTTPFileServer::respond(TCPRawConnection* conn, Transfer* t)
+{
+  char* path;
+  char* sp;
+  
+  if(strncmp(t->request, "GET ", 4) != 0)
+  {
+    fail(conn, http_501);
+    return;
+  }
+  path = t->request + 4;
+  if((sp = strpbrk(path, " ?")) != NULL)
+  {
+    *sp = '\0';
+  }
+  if(path[0] != '/' || strstr(path, "..") != NULL)
+  {
+    fail(conn, http_403);
+    return;
+  }
+  if(strcmp(path, "/") == 0)
+  {
+    path = (char*) "/index.htm";
+  }
+  
+  //The second buffer is free until the first one is sent
+  snprintf(t->buf[1], HTTP_FILE_SERVER_CHUNK, "%s%s", m_root, path);
+  t->type = contentType(path);
+  post(t, JOB_OPEN);
+}
+
+void HTTPFileServer::openFile(Transfer* t)
+{
+  int len;
+  
+  t->fp = fopen(t->buf[1], "rb");
+  if(t->fp == NULL)
+  {
+    t->error = http_404;
+    return;
+  }
+  fseek(t->fp, 0, SEEK_END);
+  long size = ftell(t->fp);
+  long from = 0;
+  long to = size - 1;
+  
+  if(t->rangeState == RANGE_SET)
+  {
+    if(t->rangeFrom < 0) //Suffix range, the last bytes of the file
+    {
+      from = (t->rangeTo < size) ? size - t->rangeTo : 0;
+    }
+    else
+    {
+      from = t->rangeFrom;
+      if(t->rangeTo >= 0 && t->rangeTo < to)
+      {
+        to = t->rangeTo;
+      }
+    }
+    if(from > to)
+    {
+      fclose(t->fp);
+      t->fp = NULL;
+      t->fillLen = snprintf(t->buf[0], HTTP_FILE_SERVER_CHUNK, http_416, size);
+      t->eof = true;
+      return;
+    }
+    len = snprintf(t->buf[0], HTTP_FILE_SERVER_CHUNK, http_header_206, t->type, to - from + 1, from, to, size);
+  }
+  else
+  {
+    len = snprintf(t->buf[0], HTTP_FILE_SERVER_CHUNK, http_header, t->type, size);
+  }
+  fseek(t->fp, from, SEEK_SET);
+  t->left = to - from + 1;
+  
+  //The header and the start of the file go out in the first buffer
+  int want = (t->left < HTTP_FILE_SERVER_CHUNK - len) ? (int) t->left : HTTP_FILE_SERVER_CHUNK - len;
+  int n = fread(t->buf[0] + len, 1, want, t->fp);
+  if(n > 0)
+  {
+    t->left -= n;
+  }
+  if(t->left <= 0 || n < want)
+  {
+    t->eof = true;
+  }
+  t->fillLen = len + ((n > 0) ? n : 0);
+}
+
+void HTTPFileServer::readFile(Transfer* t)
+{
+  int want = (t->left < HTTP_FILE_SERVER_CHUNK) ? (int) t->left : HTTP_FILE_SERVER_CHUNK;
+  int n = fread(t->buf[t->next], 1, want, t->fp);
+  
+  if(n < want || n >= t->left)
+  {
+    t->eof = true;
+  }
+  if(n < 0)
+  {
+    n = 0;
+  }
+  t->left -= n;
+  t->fillLen = n;
+}
+
+void HTTPFileServer::pump(TCPRawConnection* conn, Transfer* t)
+{
+  if(t->job != JOB_NONE) //The file thread is busy with this transfer
+  {
+    return;
+  }
+  
+  if(t->ready)
+  {
+    if(t->fillLen > 0)
+    {
+      if(conn->send(t->buf[t->next], t->fillLen) == t->fillLen)
+      {
+        t->pending[t->next] = t->fillLen;
+        t->next ^= 1;
+      }
+      else if(t->pending[t->front] > 0) //Out of queue entries, try again on the next ack
+      {
+        return;
+      }
+      else //Nothing in flight, no ack will come to try again on
+      {
+        t->eof = true;
+      }
+    }
+    t->ready = false;
+  }
+  
+  if(t->eof)
+  {
+    //The connection closes once the buffers in flight are acknowledged
+    if(t->fp != NULL)
+    {
+      post(t, JOB_CLOSE);
+    }
+    conn->close();
+  }
+  else if(t->pending[t->next] == 0 && conn->sendSpace() >= HTTP_FILE_SERVER_CHUNK)
+  {
+    post(t, JOB_READ);
+  }
+}
+
+void HTTPFileServer::onSent(TCPRawConnection* conn, int length)
+{
+  Transfer* t = &m_transfers[conn->id()];
+  
+  if(!t->started)
+  {
+    return;
+  }
+  
+  //Buffers are sent whole and in turn, so they are acknowledged in the same order
+  while(length > 0 && t->pending[t->front] > 0)
+  {
+    int acked = (length < t->pending[t->front]) ? length : t->pending[t->front];
+    t->pending[t->front] -= acked;
+    length -= acked;
+    if(t->pending[t->front] == 0)
+    {
+      t->front ^= 1;
+    }
+  }
+  pump(conn, t);
+}
+
+void HTTPFileServer::onPeerClose(TCPRawConnection* conn)
+{
+  Transfer* t = &m_transfers[conn->id()];
+  
+  //A complete request is answered to the end, pump() closes at the end of the file
+  if(!t->started)
+  {
+    conn->close();
+  }
+}
+
+void HTTPFileServer::onClose(TCPRawConnection* conn)
+{
+  Transfer* t = &m_transfers[conn->id()];
+  
+  t->conn = NULL;
+  //A queued job finishes first, done() closes the file then
+  if(t->job == JOB_NONE && t->fp != NULL)
+  {
+    post(t, JOB_CLOSE);
+  }
+}
+
+void HTTPFileServer::post(Transfer* t, uint8_t job)
+{
+  t->job = job;
+  m_jobs.put(t); //Never full, a transfer has one job at a time
+}
+
+void HTTPFileServer::threadHelper(const void* arg)
+{
+  HTTPFileServer* server = static_cast<HTTPFileServer*>(const_cast<void*>(arg));
+  
+  for(;;)
+  {
+    osEvent evt = server->m_jobs.get();
+    if(evt.status != osEventMessage)
+    {
+      continue;
+    }
+    Transfer* t = (Transfer*) evt.value.p;
+    switch(t->job)
+    {
+    case JOB_OPEN:
+      openFile(t);
+      break;
+    case JOB_READ:
+      readFile(t);
+      break;
+    case JOB_CLOSE:
+      fclose(t->fp);
+      t->fp = NULL;
+      break;
+    }
+    //Hand the transfer back, retried while the stack is out of messages
+    while(tcpip_callback(&HTTPFileServer::done, t) != ERR_OK)
+    {
+      Thread::wait(10);
+    }
+  }
+}
+
+void HTTPFileServer::done(void* arg)
+{
+  Transfer* t = (Transfer*) arg;
+  uint8_t job = t->job;
+  
+  t->job = JOB_NONE;
+  if(t->conn == NULL) //The connection is gone, only the file is left to close
+  {
+    if(t->fp != NULL)
+    {
+      t->server->post(t, JOB_CLOSE);
+    }
+    return;
+  }
+  if(job == JOB_CLOSE)
+  {
+    return;
+  }
+  if(t->error != NULL)
+  {
+    t->server->fail(t->conn, t->error);
+    return;
+  }
+  t->ready = true;
+  t->server->pump(t->conn, t);
+}
+
+void HTTPFileServer::fail(TCPRawConnection* conn, const char* response)
+{
+  conn->send(response, strlen(response));
+  conn->close();
+}
+
+const char* HTTPFileServer::contentType(const char* path)
+{
+  const char* ext = strrchr(path, '.');
+  
+  if(ext != NULL)
+  {
+    ext++;
+    for(unsigned int i = 0; i < sizeof(mime_types) / sizeof(mime_types[0]); i++)
+    {
+      if(strcasecmp(ext, mime_types[i].ext) == 0)
+      {
+        return mime_types[i].type;
+      }
+    }
+  }
+  return "application/octet-stream";
+}
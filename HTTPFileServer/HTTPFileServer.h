@@ -0,0 +1,131 @@
+/* HTTPFileServer.h */
+/* Copyright (C) 2012 mbed.org, MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** \file
+HTTP file server header file
+*/
+
+#ifndef HTTP_FILE_SERVER_H
+#define HTTP_FILE_SERVER_H
+
+#include "TCPRawServer.h"
+#include "rtos.h"
+#include <cstdio>
+#include <stdint.h>
+
+///Size of each of the two send buffers of a connection
+#define HTTP_FILE_SERVER_CHUNK 512
+///Longest request line kept, longer ones get 404
+#define HTTP_FILE_SERVER_REQUEST 96
+///Stack of the thread reading the files
+#ifndef HTTP_FILE_SERVER_STACK
+#define HTTP_FILE_SERVER_STACK 2048
+#endif
+
+/**A HTTP/1.0 server for the files of one directory
+Answers GET requests from the tcpip thread through TCPRawServer, a single
+"Range: bytes=" range is answered with 206 Partial Content. Every
+connection has two buffers: the stack sends one straight from memory while
+the other is read from the file, and a buffer is refilled as soon as the
+peer acknowledged it. Error pages are sent from flash without a copy.
+The files are opened and read by a thread of the server, so the tcpip
+thread never waits for the card: it queues a buffer for the file thread
+and sends it when the thread hands it back.
+*/
+class HTTPFileServer : public TCPRawServer
+{
+public:
+  /** Instantiate the server
+  @param root : directory to serve, must remain valid while the server runs
+  */
+  HTTPFileServer(const char* root = "/sd");
+
+  /** Start the file thread and listen for connections
+  @param port : port to listen on
+  @param backlog : see TCPRawServer::listen()
+  @return 0 on success, -1 on failure
+  */
+  int listen(int port, int backlog = 1);
+
+protected:
+  virtual bool onAccept(TCPRawConnection* conn);
+  virtual void onReceive(TCPRawConnection* conn, struct pbuf* p);
+  virtual void onSent(TCPRawConnection* conn, int length);
+  virtual void onPeerClose(TCPRawConnection* conn);
+  virtual void onClose(TCPRawConnection* conn);
+
+private:
+  //Work of the file thread
+  enum
+  {
+    JOB_NONE,
+    JOB_OPEN, //Open buf[1], fill buf[0] with the header and the start of the file
+    JOB_READ, //Fill buf[next]
+    JOB_CLOSE
+  };
+
+  struct Transfer
+  {
+    HTTPFileServer* server;
+    TCPRawConnection* conn; //NULL once the connection is gone
+    //The file thread owns fp, left, eof, error, fillLen and buf[next] while a job is queued
+    FILE* fp;
+    const char* type;
+    const char* error; //Error page to send instead of the file
+    char request[HTTP_FILE_SERVER_REQUEST];
+    uint8_t requestLen;
+    uint8_t match; //Characters of "\r\n\r\n" matched
+    uint8_t rangeState;
+    uint8_t rangeMatch; //Characters of "range: bytes=" matched
+    long rangeFrom; //-1 if not given
+    long rangeTo; //-1 if not given
+    long left; //Bytes of the file not read yet
+    bool lineDone;
+    bool started;
+    bool eof;
+    bool ready; //buf[next] is filled but not sent yet
+    uint8_t job;
+    uint8_t front; //Oldest buffer in flight
+    uint8_t next; //Next buffer to fill
+    int fillLen; //Bytes in buf[next]
+    uint16_t pending[2]; //Bytes of each buffer not acknowledged yet
+    char buf[2][HTTP_FILE_SERVER_CHUNK];
+  };
+
+  void parseRange(Transfer* t, char c);
+  void respond(TCPRawConnection* conn, Transfer* t);
+  void pump(TCPRawConnection* conn, Transfer* t);
+  void fail(TCPRawConnection* conn, const char* response);
+  void post(Transfer* t, uint8_t job);
+  static const char* contentType(const char* path);
+
+  //File thread
+  static void threadHelper(const void* arg);
+  static void openFile(Transfer* t);
+  static void readFile(Transfer* t);
+  //Back in the tcpip thread
+  static void done(void* arg);
+
+  const char* m_root;
+  Transfer m_transfers[TCP_RAW_CONNECTIONS];
+  Thread* m_thread;
+  Queue<Transfer, TCP_RAW_CONNECTIONS> m_jobs; //A transfer has one job at a time
+};
+
+#endif
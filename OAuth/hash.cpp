@@ -1,13 +1,14 @@
 
 #include "oauth.h" // base64 encode fn's.
-#include "sha1.h"
+#include "crypto.h" // SHA-1 of axTLS
 
 #include <string.h>
+#include <ctype.h>
 
 void hmac_sha1(unsigned char const *key, size_t keylen, unsigned char const *in, size_t inlen, unsigned char *resbuf)
 {
-    struct SHA1Context inner;
-    struct SHA1Context outer;
+    SHA1_CTX inner;
+    SHA1_CTX outer;
     unsigned char tmpkey[20];
     unsigned char digest[20];
     unsigned char block[64];
@@ -16,10 +17,10 @@ void hmac_sha1(unsigned char const *key, size_t keylen, unsigned char const *in,
     const int OPAD = 0x5c;
 
     if (keylen > 64) {
-        struct SHA1Context keyhash;
-        SHA1Reset(&keyhash);
-        SHA1Input(&keyhash, key, keylen);
-        SHA1Result(&keyhash, tmpkey);
+        SHA1_CTX keyhash;
+        SHA1_Init(&keyhash);
+        SHA1_Update(&keyhash, key, keylen);
+        SHA1_Final(tmpkey, &keyhash);
         key = tmpkey;
         keylen = 20;
     }
@@ -27,18 +28,18 @@ void hmac_sha1(unsigned char const *key, size_t keylen, unsigned char const *in,
     for (size_t i = 0; i < sizeof(block); i++) {
         block[i] = IPAD ^ (i < keylen ? key[i] : 0);
     }
-    SHA1Reset(&inner);
-    SHA1Input(&inner, block, 64);
-    SHA1Input(&inner, in, inlen);
-    SHA1Result(&inner, digest);
+    SHA1_Init(&inner);
+    SHA1_Update(&inner, block, 64);
+    SHA1_Update(&inner, in, inlen);
+    SHA1_Final(digest, &inner);
 
     for (size_t i = 0; i < sizeof(block); i++) {
         block[i] = OPAD ^ (i < keylen ? key[i] : 0);
     }
-    SHA1Reset(&outer);
-    SHA1Input(&outer, block, 64);
-    SHA1Input(&outer, digest, 20);
-    SHA1Result(&outer, resbuf);
+    SHA1_Init(&outer);
+    SHA1_Update(&outer, block, 64);
+    SHA1_Update(&outer, digest, 20);
+    SHA1_Final(resbuf, &outer);
 }
 
 
@@ -54,3 +55,277 @@ std::string oauth_sign_hmac_sha1_raw(const char *m, const size_t ml, const char
     return oauth_encode_base64(result, 20);
 }
 
+/*
+ * Streaming signature base string (RFC 5849 section 3.4.1).
+ *
+ * The base string is never built: its characters are percent-encoded
+ * straight into the inner hash of the HMAC, through a small buffer as
+ * the encoders emit one to five characters at a time. Parameters within
+ * the base string are encoded twice, "a b" becomes "a%2520b".
+ */
+
+static const char oauth_hex[] = "0123456789ABCDEF";
+
+typedef struct {
+    SHA1_CTX sha;
+    int n;
+    unsigned char buf[64];
+} oauth_stream;
+
+static inline bool oauth_unreserved(unsigned char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+           c == '-' || c == '.' || c == '_' || c == '~';
+}
+
+static inline void oauth_put(oauth_stream *s, char c)
+{
+    s->buf[s->n++] = c;
+    if (s->n == (int)sizeof(s->buf)) {
+        SHA1_Update(&s->sha, s->buf, s->n);
+        s->n = 0;
+    }
+}
+
+static void oauth_puts(oauth_stream *s, const char *str)
+{
+    while (*str) oauth_put(s, *str++);
+}
+
+/**
+ * encode once, up to 'stop' or the end of the string
+ */
+static void oauth_put_enc(oauth_stream *s, const char *str, char stop)
+{
+    unsigned char c;
+    while ((c = *str++) && c != stop) {
+        if (oauth_unreserved(c)) {
+            oauth_put(s, c);
+        } else {
+            oauth_put(s, '%');
+            oauth_put(s, oauth_hex[c >> 4]);
+            oauth_put(s, oauth_hex[c & 15]);
+        }
+    }
+}
+
+/**
+ * encode twice, up to 'stop' or the end of the string
+ */
+static void oauth_put_enc2(oauth_stream *s, const char *str, char stop)
+{
+    unsigned char c;
+    while ((c = *str++) && c != stop) {
+        if (oauth_unreserved(c)) {
+            oauth_put(s, c);
+        } else {
+            oauth_puts(s, "%25");
+            oauth_put(s, oauth_hex[c >> 4]);
+            oauth_put(s, oauth_hex[c & 15]);
+        }
+    }
+}
+
+/**
+ * base string URI (RFC 5849 section 3.4.1.2): lower case scheme and host,
+ * no default port, no query, encoded once.
+ */
+static void oauth_put_url(oauth_stream *s, const char *url)
+{
+    const char *scheme = strstr(url, "://");
+    const char *host, *port, *path, *p;
+    char lc[2] = { 0, 0 };
+
+    if (!scheme) {
+        oauth_put_enc(s, url, '?');
+        return;
+    }
+    for (p = url; p < scheme; p++) {
+        lc[0] = tolower(*p);
+        oauth_put_enc(s, lc, 0);
+    }
+    oauth_puts(s, "%3A%2F%2F");
+    host = scheme + 3;
+    path = host + strcspn(host, "/?#");
+    port = (const char *)memchr(host, ':', path - host);
+    for (p = host; p < (port ? port : path); p++) {
+        lc[0] = tolower(*p);
+        oauth_put_enc(s, lc, 0);
+    }
+    if (port && !((scheme - url == 4 && !strncasecmp(url, "http", 4) && path - port == 3 && !strncmp(port, ":80", 3)) ||
+                  (scheme - url == 5 && !strncasecmp(url, "https", 5) && path - port == 4 && !strncmp(port, ":443", 4)))) {
+        oauth_puts(s, "%3A");
+        for (p = port + 1; p < path; p++) oauth_put(s, *p);
+    }
+    if (*path != '/') oauth_puts(s, "%2F");
+    oauth_put_enc(s, path, '?');
+}
+
+/**
+ * parameter name, value and where the name ends
+ */
+static const char *oauth_param_split(const oauth_param_t *p, char *stop)
+{
+    const char *v;
+    if (p->value) {
+        *stop = 0;
+        return p->value;
+    }
+    *stop = '=';
+    v = strchr(p->name, '=');
+    return v ? v + 1 : "";
+}
+
+/**
+ * compare the percent-encoded forms of two strings
+ */
+static int oauth_enc_cmp(const char *a, char astop, const char *b, char bstop)
+{
+    char ea[3], eb[3];
+    int na = 0, nb = 0, ia = 0, ib = 0;
+    unsigned char c;
+
+    for (;;) {
+        if (ia == na) {
+            c = *a;
+            ia = 0;
+            if (c == 0 || c == (unsigned char)astop) {
+                na = 0;
+            } else if (oauth_unreserved(c)) {
+                ea[0] = c;
+                na = 1;
+                a++;
+            } else {
+                ea[0] = '%'; ea[1] = oauth_hex[c >> 4]; ea[2] = oauth_hex[c & 15];
+                na = 3;
+                a++;
+            }
+        }
+        if (ib == nb) {
+            c = *b;
+            ib = 0;
+            if (c == 0 || c == (unsigned char)bstop) {
+                nb = 0;
+            } else if (oauth_unreserved(c)) {
+                eb[0] = c;
+                nb = 1;
+                b++;
+            } else {
+                eb[0] = '%'; eb[1] = oauth_hex[c >> 4]; eb[2] = oauth_hex[c & 15];
+                nb = 3;
+                b++;
+            }
+        }
+        if (na == 0 || nb == 0) return (na != 0) - (nb != 0);
+        if (ea[ia] != eb[ib]) return (unsigned char)ea[ia] - (unsigned char)eb[ib];
+        ia++;
+        ib++;
+    }
+}
+
+/**
+ * parameter order of RFC 5849 section 3.4.1.3.2: by encoded name, then value
+ */
+static int oauth_param_cmp(const oauth_param_t *a, const oauth_param_t *b)
+{
+    char astop, bstop;
+    const char *av = oauth_param_split(a, &astop);
+    const char *bv = oauth_param_split(b, &bstop);
+    int r = oauth_enc_cmp(a->name, astop, b->name, bstop);
+    return r ? r : oauth_enc_cmp(av, 0, bv, 0);
+}
+
+/**
+ * HMAC key: encoded consumer secret '&' encoded token secret, hashed if
+ * longer than a block. returns the key length.
+ */
+static int oauth_hmac_key(unsigned char *key, const char *c_secret, const char *t_secret)
+{
+    oauth_stream s;
+    int len;
+
+    SHA1_Init(&s.sha);
+    s.n = 0;
+    oauth_put_enc(&s, c_secret ? c_secret : "", 0);
+    oauth_put(&s, '&');
+    oauth_put_enc(&s, t_secret ? t_secret : "", 0);
+    len = s.sha.Length_Low / 8 + s.n;
+    if (len <= 64) {
+        // at most one block went through, it is still in the buffer
+        memcpy(key, s.buf, len);
+        return len;
+    }
+    SHA1_Update(&s.sha, s.buf, s.n);
+    SHA1_Final(key, &s.sha);
+    return 20;
+}
+
+int oauth_sign_hmac_sha1_params(const char *http_method, const char *url,
+    const oauth_param_t *params, int n, unsigned char *order,
+    const char *c_secret, const char *t_secret, char *signature)
+{
+    oauth_stream s;
+    unsigned char key[64];
+    unsigned char digest[20];
+    char stop;
+    const char *value;
+    int i, j, k, keylen;
+
+    // the indexes are bytes
+    if (n < 0 || n > OAUTH_MAX_PARAMS) {
+        signature[0] = 0;
+        return -1;
+    }
+
+    // sort by index
+    for (i = 0; i < n; i++) {
+        k = i;
+        for (j = i; j > 0 && oauth_param_cmp(&params[order[j - 1]], &params[k]) > 0; j--) {
+            order[j] = order[j - 1];
+        }
+        order[j] = k;
+    }
+
+    // inner hash: key ^ ipad, then the base string
+    keylen = oauth_hmac_key(key, c_secret, t_secret);
+    memset(key + keylen, 0, sizeof(key) - keylen);
+    for (i = 0; i < 64; i++) key[i] ^= 0x36;
+    SHA1_Init(&s.sha);
+    SHA1_Update(&s.sha, key, 64);
+    s.n = 0;
+
+    oauth_put_enc(&s, http_method, 0);
+    oauth_put(&s, '&');
+    oauth_put_url(&s, url);
+    oauth_put(&s, '&');
+    for (i = 0; i < n; i++) {
+        const oauth_param_t *p = &params[order[i]];
+        value = oauth_param_split(p, &stop);
+        if (i > 0) oauth_puts(&s, "%26");
+        oauth_put_enc2(&s, p->name, stop);
+        oauth_puts(&s, "%3D");
+        oauth_put_enc2(&s, value, 0);
+    }
+    SHA1_Update(&s.sha, s.buf, s.n);
+    SHA1_Final(digest, &s.sha);
+
+    // outer hash: key ^ opad, then the inner digest
+    for (i = 0; i < 64; i++) key[i] ^= 0x36 ^ 0x5c;
+    SHA1_Init(&s.sha);
+    SHA1_Update(&s.sha, key, 64);
+    SHA1_Update(&s.sha, digest, 20);
+    SHA1_Final(digest, &s.sha);
+
+    // base64, 20 bytes give 27 characters and one '='
+    for (i = 0, j = 0; i < 20; i += 3) {
+        unsigned long v = (unsigned long)digest[i] << 16 |
+                          (i + 1 < 20 ? digest[i + 1] << 8 : 0) |
+                          (i + 2 < 20 ? digest[i + 2] : 0);
+        signature[j++] = oauth_b64_encode((v >> 18) & 0x3f);
+        signature[j++] = oauth_b64_encode((v >> 12) & 0x3f);
+        signature[j++] = i + 1 < 20 ? oauth_b64_encode((v >> 6) & 0x3f) : '=';
+        signature[j++] = i + 2 < 20 ? oauth_b64_encode(v & 0x3f) : '=';
+    }
+    signature[j] = 0;
+    return 0;
+}
@@ -43,7 +43,6 @@
 #include "oauth.h"
 
 #include <vector>
-#include <algorithm>
 #include <sstream>
 
 /**
@@ -641,7 +640,6 @@ void oauth_sign_array2_process(
 )
 {
     char oarg[1024];
-    std::string query;
     std::string sign;
     std::string http_request_method;
 
@@ -660,31 +658,36 @@ void oauth_sign_array2_process(
     // add required OAuth protocol parameters
     oauth_add_protocol(argvp, method, c_key, t_key);
 
-    // sort parameters
-    //qsort(&(*argvp)[1], (*argcp)-1, sizeof(char *), oauth_cmpstringp);
-    std::sort(argvp->begin() + 1, argvp->end(), oauth_cmpstringp_ex);
-
-    // serialize URL - base-url 
-    query= oauth_serialize_url_parameters(*argvp);
-
     // generate signature
-    std::string okey = oauth_catenc(2, c_secret, t_secret);
-    std::string odat = oauth_catenc(3, http_request_method.c_str(), (*argvp)[0].c_str(), query.c_str()); // base-string
-#ifdef DEBUG_OAUTH
-    fprintf (stderr, "\nliboauth: data to sign='%s'\n\n", odat.c_str());
-    fprintf (stderr, "\nliboauth: key='%s'\n\n", okey.c_str());
-#endif
     switch(method) {
     //case OA_RSA:
     //    sign = oauth_sign_rsa_sha1(odat.c_str(), okey.c_str()); // XXX okey needs to be RSA key!
     //    break;
     case OA_PLAINTEXT:
-        sign = oauth_sign_plaintext(odat.c_str(), okey.c_str()).c_str();
+        sign = oauth_sign_plaintext(NULL, oauth_catenc(2, c_secret, t_secret).c_str());
         break;
-    default:
-        sign = oauth_sign_hmac_sha1(odat.c_str(), okey.c_str());
+    default: {
+        // the base-string is streamed into the HMAC, argv[0] is the url
+        // and the others are "name=value" pairs, sorted by index
+        int n = argvp->size() - 1;
+        if (n > OAUTH_MAX_PARAMS) {
+            // more than the byte indexes of 'order' can sort, left unsigned
+            return;
+        }
+        std::vector<oauth_param_t> params(n);
+        std::vector<unsigned char> order(n);
+        char signature[OAUTH_SIGNATURE_LEN + 1];
+
+        for (int i = 0; i < n; i++) {
+            params[i].name = (*argvp)[i + 1].c_str();
+            params[i].value = NULL;
+        }
+        oauth_sign_hmac_sha1_params(http_request_method.c_str(), (*argvp)[0].c_str(),
+            &params[0], n, &order[0], c_secret, t_secret, signature);
+        sign = signature;
         break;
     }
+    }
 
     // append signature to query args.
     snprintf(oarg, 1024, "oauth_signature=%s",sign.c_str());
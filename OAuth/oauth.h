@@ -69,6 +69,11 @@ typedef enum {
     OA_PLAINTEXT ///< use plain text signature (for testing only)
   } OAuthMethod;
 
+/**
+ * Base64 encode one byte
+ */
+char oauth_b64_encode(unsigned char u);
+
 /**
  * Base64 encode and return size data in 'src'. The caller must free the
  * returned string.
@@ -137,6 +142,40 @@ std::string oauth_sign_hmac_sha1 (const char *m, const char *k);
  */
 std::string oauth_sign_hmac_sha1_raw(const char *m, const size_t ml, const char *k, const size_t kl);
 
+/**
+ * a request parameter for \ref oauth_sign_hmac_sha1_params, not escaped.
+ */
+typedef struct {
+    const char *name; ///< parameter name, or "name=value" if value is NULL
+    const char *value; ///< parameter value or NULL
+} oauth_param_t;
+
+#define OAUTH_SIGNATURE_LEN 28 ///< length of a base64 HMAC-SHA1 signature
+#define OAUTH_MAX_PARAMS 255 ///< parameters \ref oauth_sign_hmac_sha1_params sorts
+
+/**
+ * returns the base64 encoded HMAC-SHA1 signature of a request without
+ * building its signature base string (RFC 5849 section 3.4.1).
+ *
+ * The base string is percent-encoded straight into the HMAC, the
+ * parameters are sorted through 'order'. Nothing is allocated.
+ *
+ * @param http_method request method in upper case ("GET", "POST",..)
+ * @param url request URL, scheme and host are lower cased, default ports
+ * and the query are left out of the signature.
+ * @param params query, form and oauth_* parameters, not oauth_signature
+ * @param n number of parameters, at most OAUTH_MAX_PARAMS
+ * @param order space for n indexes, the parameters are sorted in there
+ * @param c_secret consumer secret
+ * @param t_secret token secret or NULL
+ * @param signature receives the signature, OAUTH_SIGNATURE_LEN + 1 bytes.
+ * It still needs to be url-escaped for the request.
+ * @return 0, or -1 and an empty signature if n is out of range
+ */
+int oauth_sign_hmac_sha1_params(const char *http_method, const char *url,
+    const oauth_param_t *params, int n, unsigned char *order,
+    const char *c_secret, const char *t_secret, char *signature);
+
 /**
  * returns plaintext signature for the given key.
  *
@@ -378,7 +417,8 @@ std::string oauth_sign_url (const char *url, std::string *postargs,
  * @param t_key token key
  * @param t_secret token secret
  *
- * @return void
+ * @return void, the request is left unsigned when it has more than
+ * OAUTH_MAX_PARAMS parameters to sign
  *
  */
 void oauth_sign_array2_process (std::vector<std::string> *argvp,
@@ -19,9 +19,10 @@ OAuthDataOut::OAuthDataOut(const char * contentType, const char* data)
   m_size = strlen(data) + 1;
 }
 
-void OAuthDataOut::readReset()
+int OAuthDataOut::readReset()
 {
     m_pos = 0;
+    return OK;
 }
 
 // HTTPClient reads a piece of data to be transmitted
@@ -21,7 +21,7 @@ class OAuthDataOut : public IHTTPDataOut
 
     protected:
 	//IHTTPDataOut
-    virtual void readReset();
+    virtual int readReset();
 
     virtual int read(char* buf, size_t len, size_t* pReadLen);
 
@@ -0,0 +1,123 @@
+/* Host test of the streaming HMAC-SHA1 signer
+ *
+ * Builds and runs on the host, without the mbed tree:
+ *
+ *   g++ -I.. -I../../TLS_axTLS/axTLS/crypto -I../../TLS_axTLS/axTLS/ssl -x c ../../TLS_axTLS/axTLS/crypto/sha1.c \
+ *       -x c++ oauth_test.cpp ../hash.cpp ../oauth.cpp -o oauth_test && ./oauth_test
+ *
+ * Signs the request of RFC 5849 section 3.4.1.1 and the photos example of
+ * OAuth Core 1.0 through oauth_sign_hmac_sha1_params() and through the
+ * argv route of oauth_sign_array2_process(), and compares with the
+ * signatures of the base strings given there. Checks that requests with more parameters
+ * than the byte indexes of the sort can hold are refused, not signed
+ * wrong.
+ */
+#include "oauth.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static int failures;
+
+static void check(bool ok, const char *what)
+{
+    printf("%s: %s\n", ok ? "ok" : "FAIL", what);
+    if (!ok)
+        failures++;
+}
+
+// RFC 5849 section 3.4.1.1, the expected signature is the HMAC-SHA1 of the
+// base string printed there
+static void rfc5849(void)
+{
+    // names and values not escaped, duplicate names, "name=value" form
+    oauth_param_t params[] = {
+        { "b5", "=%3D" }, { "a3", "a" }, { "c@", "" }, { "a2", "r b" },
+        { "oauth_consumer_key=9djdj82h48djs9d2", NULL }, { "oauth_token", "kkk9d7dh3k39sjv7" },
+        { "oauth_signature_method", "HMAC-SHA1" }, { "oauth_timestamp", "137131201" },
+        { "oauth_nonce", "7d8f3e4a" }, { "c2", NULL }, { "a3=2 q", NULL },
+    };
+    const int n = sizeof(params) / sizeof(params[0]);
+    unsigned char order[n];
+    char signature[OAUTH_SIGNATURE_LEN + 1];
+
+    check(oauth_sign_hmac_sha1_params("POST", "http://example.com/request?b5=%3D%253D&a3=a&c%40=&a2=r%20b",
+              params, n, order, "j49sk3j29djd", "dh893hdasih9", signature) == 0 &&
+          !strcmp(signature, "r6/TJjbCOr97/+UU0NsvSne7s5g="), "RFC 5849 3.4.1.1");
+    oauth_sign_hmac_sha1_params("POST", "HTTP://Example.COM:80/request", params, n, order,
+        "j49sk3j29djd", "dh893hdasih9", signature);
+    check(!strcmp(signature, "r6/TJjbCOr97/+UU0NsvSne7s5g="), "scheme and host lower cased, default port left out");
+    oauth_sign_hmac_sha1_params("POST", "http://example.com:8080/request", params, n, order,
+        "j49sk3j29djd", "dh893hdasih9", signature);
+    check(strcmp(signature, "r6/TJjbCOr97/+UU0NsvSne7s5g="), "other port signed");
+}
+
+// photos example of OAuth Core 1.0 appendix A.5
+static void photos(void)
+{
+    oauth_param_t params[] = {
+        { "file", "vacation.jpg" }, { "size", "original" }, { "oauth_consumer_key", "dpf43f3p2l4k3l03" },
+        { "oauth_token", "nnch734d00sl2jdk" }, { "oauth_signature_method", "HMAC-SHA1" },
+        { "oauth_timestamp", "1191242096" }, { "oauth_nonce", "kllo9940pd9333jh" }, { "oauth_version", "1.0" },
+    };
+    const int n = sizeof(params) / sizeof(params[0]);
+    unsigned char order[n];
+    char signature[OAUTH_SIGNATURE_LEN + 1];
+    std::vector<std::string> argv;
+
+    oauth_sign_hmac_sha1_params("GET", "http://photos.example.net/photos", params, n, order,
+        "kd94hf93k423kf44", "pfkkdhi9sl3r4s00", signature);
+    check(!strcmp(signature, "tR3+Ty81lMeYAr/Fid0kMTYa/WM="), "photos example");
+
+    // as oauth_split_url_parameters() leaves the request
+    argv.push_back("http://photos.example.net/photos");
+    argv.push_back("file=vacation.jpg");
+    argv.push_back("size=original");
+    argv.push_back("oauth_nonce=kllo9940pd9333jh");
+    argv.push_back("oauth_timestamp=1191242096");
+    oauth_sign_array2_process(&argv, NULL, OA_HMAC, NULL,
+        "dpf43f3p2l4k3l03", "kd94hf93k423kf44", "nnch734d00sl2jdk", "pfkkdhi9sl3r4s00");
+    check(argv.back() == "oauth_signature=tR3+Ty81lMeYAr/Fid0kMTYa/WM=", "photos example through argv");
+}
+
+static void limits(void)
+{
+    static oauth_param_t params[OAUTH_MAX_PARAMS + 1];
+    static unsigned char order[OAUTH_MAX_PARAMS + 1];
+    char signature[OAUTH_SIGNATURE_LEN + 1];
+    std::vector<std::string> argv;
+    int i;
+
+    for (i = 0; i <= OAUTH_MAX_PARAMS; i++)
+        params[i].name = "a=b";
+    check(oauth_sign_hmac_sha1_params("GET", "http://example.com/", params, OAUTH_MAX_PARAMS, order,
+              "c", "t", signature) == 0 && strlen(signature) == OAUTH_SIGNATURE_LEN, "most parameters signed");
+    check(oauth_sign_hmac_sha1_params("GET", "http://example.com/", params, OAUTH_MAX_PARAMS + 1, order,
+              "c", "t", signature) == -1 && signature[0] == 0, "one more refused");
+
+    // oauth_add_protocol() adds six oauth_* parameters
+    argv.push_back("http://example.com/");
+    for (i = 0; i < OAUTH_MAX_PARAMS - 6; i++)
+        argv.push_back("a=b");
+    oauth_sign_array2_process(&argv, NULL, OA_HMAC, NULL, "c", "c", "t", "t");
+    check(argv.size() == OAUTH_MAX_PARAMS + 2 && argv.back().compare(0, 16, "oauth_signature=") == 0,
+          "most parameters signed through argv");
+
+    argv.clear();
+    argv.push_back("http://example.com/");
+    for (i = 0; i < OAUTH_MAX_PARAMS - 5; i++)
+        argv.push_back("a=b");
+    oauth_sign_array2_process(&argv, NULL, OA_HMAC, NULL, "c", "c", "t", "t");
+    check(argv.size() == OAUTH_MAX_PARAMS + 2 && argv.back().compare(0, 16, "oauth_signature=") != 0,
+          "one more left unsigned through argv");
+}
+
+int main()
+{
+    rfc5849();
+    photos();
+    limits();
+
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
@@ -36,7 +36,12 @@ DRESULT disk_read (
 )
 {
     debug_if(FFS_DBG, "disk_read(sector %d, count %d) on drv [%d]\n", sector, count, drv);
-    if (FATFileSystem::_ffs[drv]->disk_read((uint8_t*)buff, sector, count))
+    DiskRequest req;
+    req.sector = sector;
+    req.buffer = (uint8_t*)buff;
+    req.count = count;
+    req.write = false;
+    if (FATFileSystem::_ffs[drv]->_queue.transfer(&req))
         return RES_PARERR;
     else
         return RES_OK;
@@ -51,7 +56,12 @@ DRESULT disk_write (
 )
 {
     debug_if(FFS_DBG, "disk_write(sector %d, count %d) on drv [%d]\n", sector, count, drv);
-    if (FATFileSystem::_ffs[drv]->disk_write((uint8_t*)buff, sector, count))
+    DiskRequest req;
+    req.sector = sector;
+    req.buffer = (uint8_t*)buff;
+    req.count = count;
+    req.write = true;
+    if (FATFileSystem::_ffs[drv]->_queue.transfer(&req))
         return RES_PARERR;
     else
         return RES_OK;
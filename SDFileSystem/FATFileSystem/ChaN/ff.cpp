@@ -123,7 +123,7 @@
 
 /* Reentrancy related */
 #if _FS_REENTRANT
-#if _USE_LFN == 1
+#if _USE_LFN == 1 && _VOLUMES > 1   /* The grant of the only volume covers it */
 #error Static LFN work area must not be used in re-entrant configuration.
 #endif
 #define ENTER_FF(fs)        { if (!lock_fs(fs)) return FR_TIMEOUT; }
@@ -136,6 +136,32 @@
 #define ABORT(fs, res)      { fp->flag |= FA__ERROR; LEAVE_FF(fs, res); }
 
 
+/* Free cluster map */
+#if _USE_FREEMAP && !_FS_READONLY
+#define FMAP_EPC(fs)        (((fs)->fs_type == FS_FAT12) ? 0 : SS(fs) / ((fs)->fs_type == FS_FAT16 ? 2 : 4))    /* FAT entries per sector, 0:not mapped */
+#define FMAP_TEST(fs, s)    ((s) < _FREEMAP_SECTORS && ((fs)->fmap[(s) / 8] & (1 << ((s) % 8))))
+#define FMAP_SET(fs, s)     { if ((s) < _FREEMAP_SECTORS) (fs)->fmap[(s) / 8] |= 1 << ((s) % 8); }
+#define FMAP_CLR(fs, s)     { if ((s) < _FREEMAP_SECTORS) (fs)->fmap[(s) / 8] &= ~(1 << ((s) % 8)); }
+#endif
+
+
+/* Metadata journal */
+#if _USE_JOURNAL
+#if _FS_READONLY || _FS_MINIMIZE || !_USE_EXPAND
+#error _USE_JOURNAL needs _USE_EXPAND and must be 0 on read-only or minimized cfg.
+#endif
+#if _JOURNAL_ENTRIES < 1 || _JOURNAL_ENTRIES > 125
+#error Wrong _JOURNAL_ENTRIES setting
+#endif
+#define JNL_NAME    "FSJOURNLSYS"   /* SFN of the journal file in the root directory */
+#define JNL_MAGIC   0x4C4A5346      /* "FSJL" */
+#define JNL_Magic   0       /* Commit record: signature (4) */
+#define JNL_Count   4       /* Commit record: number of sectors, 0:empty (2) */
+#define JNL_Sum     8       /* Commit record: checksum (4) */
+#define JNL_Sect    12      /* Commit record: home sector of each journal slot (4 each) */
+#endif
+
+
 /* File access control feature */
 #if _FS_LOCK
 #if _FS_READONLY
@@ -150,6 +176,26 @@ typedef struct {
 #endif
 
 
+/* Directory name hash index */
+#if _USE_DIRHASH
+#if _FS_REENTRANT && _VOLUMES > 1  /* The grant of the only volume covers it */
+#error Directory hash index must not be used in re-entrant configuration.
+#endif
+typedef struct {
+    FATFS *fs;              /* Directory ID 1, volume (NULL:blank entry) */
+    WORD id;                /* Directory ID 2, volume mount ID */
+    DWORD clu;              /* Directory ID 3, start cluster */
+    DWORD stamp;            /* Last use (for LRU replacement) */
+    WORD end;               /* Directory index to resume indexing from */
+    WORD done;              /* The index covers the whole directory */
+    WORD n;                 /* Number of indexed objects */
+    WORD sh[_DIRHASH_ENTRIES];  /* SFN hash */
+    WORD lh[_DIRHASH_ENTRIES];  /* LFN hash (0:no LFN) */
+    WORD idx[_DIRHASH_ENTRIES]; /* Directory index of the first entry of the object */
+} DIRHASH;
+#endif
+
+
 
 /* DBCS code ranges and SBCS extend char conversion table */
 
@@ -484,6 +530,13 @@ static
 FILESEM Files[_FS_LOCK];    /* File lock semaphores */
 #endif
 
+#if _USE_DIRHASH
+static
+DIRHASH DirHash[_DIRHASH_DIRS]; /* Name hash index of recently used directories */
+static
+DWORD DhStamp;          /* Use counter for DirHash[] */
+#endif
+
 #if _USE_LFN == 0           /* No LFN feature */
 #define DEF_NAMEBUF         BYTE sfn[12]
 #define INIT_BUF(dobj)      (dobj).fn = sfn
@@ -713,6 +766,137 @@ void clear_lock (   /* Clear lock entries of the volume */
 
 
 
+/*-----------------------------------------------------------------------*/
+/* Metadata journal                                                      */
+/*-----------------------------------------------------------------------*/
+/* On a journaled volume a dirty window goes to the journal instead of its
+   home sector. The first sector of the journal file holds the commit record,
+   the following ones the journaled sectors. A commit writes the record,
+   copies the sectors home and clears the record again, so a record found at
+   mount time belongs to a commit that did not finish. */
+#if _USE_JOURNAL
+
+static
+DWORD jnl_sum (     /* Checksum of the commit record */
+    FATFS *fs       /* File system object */
+)
+{
+    DWORD sum = JNL_MAGIC;
+    UINT i;
+
+
+    for (i = 0; i < fs->jn; i++)
+        sum = (((sum << 1) | (sum >> 31)) + fs->jmap[i]) & 0xFFFFFFFF;
+    return (sum + fs->jn) & 0xFFFFFFFF;
+}
+
+
+static
+DWORD jnl_sect (    /* Sector holding the current content of the sector */
+    FATFS *fs,      /* File system object */
+    DWORD sect      /* Home sector */
+)
+{
+    UINT i;
+
+
+    for (i = 0; i < fs->jn; i++) {
+        if (fs->jmap[i] == sect) return fs->jsect + 1 + i;  /* Journaled, not home yet */
+    }
+    return sect;
+}
+
+
+static
+FRESULT jnl_apply ( /* Copy the journaled sectors home and clear the commit record */
+    FATFS *fs       /* File system object */
+)
+{
+    DWORD sect;
+    UINT i;
+    BYTE nf;
+
+
+    for (i = 0; i < fs->jn; i++) {
+        sect = fs->jmap[i];
+        if (disk_read(fs->drv, fs->win, fs->jsect + 1 + i, 1) != RES_OK ||
+            disk_write(fs->drv, fs->win, sect, 1) != RES_OK)
+            return FR_DISK_ERR;
+        if (sect < (fs->fatbase + fs->fsize)) {     /* In FAT area */
+            for (nf = fs->n_fats; nf > 1; nf--) {   /* Reflect the change to all FAT copies */
+                sect += fs->fsize;
+                disk_write(fs->drv, fs->win, sect, 1);
+            }
+        }
+    }
+    fs->jn = 0;
+    /* The record must be cleared before the journal slots are used again */
+    if (disk_ioctl(fs->drv, CTRL_SYNC, 0) != RES_OK) return FR_DISK_ERR;
+    mem_set(fs->win, 0, SS(fs));
+    ST_DWORD(fs->win+JNL_Magic, JNL_MAGIC);
+    if (disk_write(fs->drv, fs->win, fs->jsect, 1) != RES_OK ||
+        disk_ioctl(fs->drv, CTRL_SYNC, 0) != RES_OK)
+        return FR_DISK_ERR;
+
+    return FR_OK;
+}
+
+
+static
+FRESULT jnl_commit (    /* Commit the journaled sectors */
+    FATFS *fs           /* File system object */
+)                       /* The window must be clean, it is used as work buffer */
+{
+    FRESULT res;
+    UINT i;
+
+
+    if (!fs->jn) return FR_OK;
+    /* The journaled sectors and the file data must be on the disk before the record */
+    if (disk_ioctl(fs->drv, CTRL_SYNC, 0) != RES_OK) return FR_DISK_ERR;
+    mem_set(fs->win, 0, SS(fs));
+    ST_DWORD(fs->win+JNL_Magic, JNL_MAGIC);
+    ST_WORD(fs->win+JNL_Count, fs->jn);
+    ST_DWORD(fs->win+JNL_Sum, jnl_sum(fs));
+    for (i = 0; i < fs->jn; i++) {
+        ST_DWORD(fs->win+JNL_Sect+i*4, fs->jmap[i]);
+    }
+    if (disk_write(fs->drv, fs->win, fs->jsect, 1) != RES_OK ||
+        disk_ioctl(fs->drv, CTRL_SYNC, 0) != RES_OK) {
+        res = FR_DISK_ERR;
+    } else {
+        res = jnl_apply(fs);
+    }
+    if (res == FR_OK && fs->winsect &&  /* Reload the window, it is home now */
+        disk_read(fs->drv, fs->win, fs->winsect, 1) != RES_OK)
+        res = FR_DISK_ERR;
+    if (res != FR_OK) fs->winsect = 0;  /* Invalidate sector cache */
+
+    return res;
+}
+
+
+static
+FRESULT jnl_write ( /* Write the window to the journal */
+    FATFS *fs,      /* File system object */
+    DWORD sect      /* Home sector of the window content */
+)
+{
+    UINT i;
+
+
+    for (i = 0; i < fs->jn && fs->jmap[i] != sect; i++) ;  /* Rewrite its slot if already journaled */
+    if (disk_write(fs->drv, fs->win, fs->jsect + 1 + i, 1) != RES_OK)
+        return FR_DISK_ERR;
+    if (i == fs->jn) fs->jmap[fs->jn++] = sect;
+
+    return (fs->jn == _JOURNAL_ENTRIES) ? jnl_commit(fs) : FR_OK;    /* Commit early when full */
+}
+#endif
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Change window offset                                                  */
 /*-----------------------------------------------------------------------*/
@@ -728,6 +912,13 @@ FRESULT move_window (
 
     wsect = fs->winsect;
     if (wsect != sector) {  /* Changed current window */
+#if _USE_JOURNAL
+        if (fs->wflag && fs->jsect) {   /* Write back dirty window to the journal */
+            if (jnl_write(fs, wsect) != FR_OK)
+                return FR_DISK_ERR;
+            fs->wflag = 0;
+        }
+#endif
 #if !_FS_READONLY
         if (fs->wflag) {    /* Write back dirty window if needed */
             if (disk_write(fs->drv, fs->win, wsect, 1) != RES_OK)
@@ -743,7 +934,11 @@ FRESULT move_window (
         }
 #endif
         if (sector) {
+#if _USE_JOURNAL
+            if (disk_read(fs->drv, fs->win, jnl_sect(fs, sector), 1) != RES_OK)
+#else
             if (disk_read(fs->drv, fs->win, sector, 1) != RES_OK)
+#endif
                 return FR_DISK_ERR;
             fs->winsect = sector;
         }
@@ -780,9 +975,18 @@ FRESULT sync (  /* FR_OK: successful, FR_DISK_ERR: failed */
             ST_DWORD(fs->win+FSI_Free_Count, fs->free_clust);
             ST_DWORD(fs->win+FSI_Nxt_Free, fs->last_clust);
             /* Write it into the FSInfo sector */
+#if _USE_JOURNAL
+            if (fs->jsect)
+                res = jnl_write(fs, fs->fsi_sector);
+            else
+#endif
             disk_write(fs->drv, fs->win, fs->fsi_sector, 1);
             fs->fsi_flag = 0;
         }
+#if _USE_JOURNAL
+        /* Commit the metadata written since the last sync at once */
+        if (res == FR_OK) res = jnl_commit(fs);
+#endif
         /* Make sure that no pending write process in the physical drive */
         if (disk_ioctl(fs->drv, CTRL_SYNC, 0) != RES_OK)
             res = FR_DISK_ERR;
@@ -896,6 +1100,9 @@ FRESULT put_fat (
             if (res != FR_OK) break;
             p = &fs->win[clst * 2 % SS(fs)];
             ST_WORD(p, (WORD)val);
+#if _USE_FREEMAP
+            if (val == 0) FMAP_CLR(fs, clst / (SS(fs) / 2));   /* The sector has a free cluster now */
+#endif
             break;
 
         case FS_FAT32 :
@@ -904,6 +1111,9 @@ FRESULT put_fat (
             p = &fs->win[clst * 4 % SS(fs)];
             val |= LD_DWORD(p) & 0xF0000000;
             ST_DWORD(p, val);
+#if _USE_FREEMAP
+            if ((val & 0x0FFFFFFF) == 0) FMAP_CLR(fs, clst / (SS(fs) / 4));
+#endif
             break;
 
         default :
@@ -984,6 +1194,10 @@ DWORD create_chain (    /* 0:No free cluster, 1:Internal error, 0xFFFFFFFF:Disk
 {
     DWORD cs, ncl, scl;
     FRESULT res;
+#if _USE_FREEMAP
+    DWORD sect;
+    UINT epc, full;
+#endif
 
 
     if (clst == 0) {        /* Create a new chain */
@@ -997,13 +1211,34 @@ DWORD create_chain (    /* 0:No free cluster, 1:Internal error, 0xFFFFFFFF:Disk
         scl = clst;
     }
 
+#if _USE_FREEMAP
+    epc = FMAP_EPC(fs);
+    full = 0;               /* The current FAT sector was scanned from its top */
+#endif
     ncl = scl;              /* Start cluster */
     for (;;) {
         ncl++;                          /* Next cluster */
         if (ncl >= fs->n_fatent) {      /* Wrap around */
+#if _USE_FREEMAP
+            if (full) FMAP_SET(fs, (ncl - 1) / epc);    /* The last FAT sector has no free cluster */
+            full = 0;
+#endif
             ncl = 2;
             if (ncl > scl) return 0;    /* No free cluster */
         }
+#if _USE_FREEMAP
+        if (epc && (ncl == 2 || ncl % epc == 0)) {  /* Top of a FAT sector */
+            sect = ncl / epc;
+            if (full) FMAP_SET(fs, sect - 1);   /* The previous FAT sector has no free cluster */
+            full = 1;
+            if (FMAP_TEST(fs, sect)) {          /* Skip a FAT sector without free cluster */
+                if (scl >= ncl && scl < ncl + epc) return 0;    /* Went round, no free cluster */
+                ncl = (sect + 1) * epc - 1;
+                full = 0;
+                continue;
+            }
+        }
+#endif
         cs = get_fat(fs, ncl);          /* Get the cluster status */
         if (cs == 0) break;             /* Found a free cluster */
         if (cs == 0xFFFFFFFF || cs == 1)/* An error occurred */
@@ -1381,13 +1616,261 @@ BYTE sum_sfn (
 
 
 
+/*-----------------------------------------------------------------------*/
+/* Directory handling - Name hash index                                  */
+/*-----------------------------------------------------------------------*/
+#if _USE_DIRHASH
+static
+WORD dh_term (          /* Hash of a char at a position, the hash of a name is the sum of them */
+    UINT i,             /* Position in the name */
+    WCHAR c             /* Character */
+)
+{
+    DWORD x;
+
+    x = ((DWORD)c << 16 | i) * 0x9E3779B1UL;
+    x ^= x >> 15;
+    x *= 0x85EBCA77UL;
+    return (WORD)(x >> 16);
+}
+
+
+static
+WORD dh_sfn (           /* Hash of an SFN */
+    const BYTE *sfn     /* Pointer to the SFN {file[8],ext[3]} */
+)
+{
+    WORD h = 0;
+    UINT i;
+
+    for (i = 0; i < 11; i++) h += dh_term(i, sfn[i]);
+    return h;
+}
+
+
+#if _USE_LFN
+static
+WORD dh_lfn (           /* Hash of an LFN, case insensitive */
+    const WCHAR *lfn    /* Pointer to the LFN */
+)
+{
+    WORD h = 0;
+    UINT i;
+
+    for (i = 0; lfn[i]; i++) h += dh_term(i, ff_wtoupper(lfn[i]));
+    return h;
+}
+
+
+static
+WORD dh_lfn_part (      /* Hash of the LFN chars in an LFN entry (the sum of all parts is dh_lfn()) */
+    const BYTE *dir     /* Pointer to the LFN entry */
+)
+{
+    WORD h = 0;
+    UINT i, s;
+    WCHAR wc;
+
+    i = ((dir[LDIR_Ord] & 0x3F) - 1) * 13;  /* Offset of the part in the LFN */
+    for (s = 0; s < 13; s++) {
+        wc = LD_WORD(dir+LfnOfs[s]);
+        if (!wc) break;                     /* End of the LFN */
+        h += dh_term(i + s, ff_wtoupper(wc));
+    }
+    return h;
+}
+#endif
+
+
+static
+DIRHASH* dh_get (       /* Pointer to the index of the directory, 0:Not indexed */
+    FATFS_DIR *dj,      /* Pointer to the directory object */
+    int alloc           /* 1:Take over the least recently used index if not indexed */
+)
+{
+    DIRHASH *dh, *lru;
+    UINT i;
+
+
+    lru = DirHash;
+    for (i = 0; i < _DIRHASH_DIRS; i++) {
+        dh = &DirHash[i];
+        if (dh->fs == dj->fs && dh->id == dj->fs->id && dh->clu == dj->sclust) {
+            dh->stamp = ++DhStamp;
+            return dh;
+        }
+        if (dh->stamp < lru->stamp) lru = dh;
+    }
+    if (!alloc) return 0;
+
+    lru->fs = dj->fs; lru->id = dj->fs->id; lru->clu = dj->sclust;
+    lru->end = lru->done = lru->n = 0;
+    lru->stamp = ++DhStamp;
+    return lru;
+}
+
+
+static
+FRESULT dh_build (      /* Index the directory from dh->end until the end of table or the index is full */
+    DIRHASH *dh,        /* Pointer to the index */
+    FATFS_DIR *dj       /* Pointer to the directory object */
+)
+{
+    FRESULT res;
+    BYTE c, *dir;
+    WORD is = 0;
+#if _USE_LFN
+    BYTE a, ord = 0xFF, sum = 0xFF;
+    WORD hl = 0;
+#endif
+
+    res = dir_sdi(dj, dh->end);
+    while (res == FR_OK) {
+        res = move_window(dj->fs, dj->sect);
+        if (res != FR_OK) break;
+        dir = dj->dir;
+        c = dir[DIR_Name];
+        if (c == 0) { res = FR_NO_FILE; break; }    /* Reached to end of table */
+#if _USE_LFN    /* LFN configuration */
+        a = dir[DIR_Attr] & AM_MASK;
+        if (c == DDE || ((a & AM_VOL) && a != AM_LFN)) {    /* An entry without valid data */
+            ord = 0xFF;
+        } else {
+            if (a == AM_LFN) {          /* An LFN entry is found */
+                if (c & LLE) {          /* Is it start of LFN sequence? */
+                    sum = dir[LDIR_Chksum];
+                    c &= ~LLE; ord = c;
+                    is = dj->index; hl = 0;
+                }
+                if (c == ord && sum == dir[LDIR_Chksum]) {  /* Add up the LFN hash */
+                    hl += dh_lfn_part(dir); ord--;
+                } else {
+                    ord = 0xFF;
+                }
+            } else {                    /* An SFN entry is found */
+                if (dh->n >= _DIRHASH_ENTRIES) break;   /* Index is full */
+                if (ord || sum != sum_sfn(dir)) {   /* It has no LFN */
+                    is = dj->index; hl = 0;
+                }
+                dh->sh[dh->n] = dh_sfn(dir);
+                dh->lh[dh->n] = hl;
+                dh->idx[dh->n++] = is;
+                dh->end = dj->index + 1;
+                ord = 0xFF;
+            }
+        }
+#else       /* Non LFN configuration */
+        if (c != DDE && !(dir[DIR_Attr] & AM_VOL)) {    /* Is it a valid entry? */
+            if (dh->n >= _DIRHASH_ENTRIES) break;       /* Index is full */
+            is = dj->index;
+            dh->sh[dh->n] = dh_sfn(dir);
+            dh->lh[dh->n] = 0;
+            dh->idx[dh->n++] = is;
+            dh->end = is + 1;
+        }
+#endif
+        res = dir_next(dj, 0);          /* Next entry */
+    }
+
+    if (res == FR_NO_FILE) {            /* The whole directory is indexed */
+        dh->done = 1;
+        res = FR_OK;
+    }
+
+    return res;
+}
+
+
+#if !_FS_READONLY
+static
+void dh_add (           /* Add a registered object to the index */
+    FATFS_DIR *dj       /* Pointer to the directory object pointing the SFN entry of the object */
+)
+{
+    DIRHASH *dh;
+    WORD is;
+#if _USE_LFN
+    UINT n;
+#endif
+
+
+    dh = dh_get(dj, 0);
+    if (!dh) return;
+    is = dj->index;
+#if _USE_LFN
+    if (dj->fn[NS] & NS_LFN) {          /* The LFN entries are in front of the SFN entry */
+        for (n = 0; dj->lfn[n]; n++) ;
+        is -= (WORD)((n + 12) / 13);
+    }
+#endif
+    if (!dh->done && is >= dh->end) return; /* It will be found by indexing */
+
+    if (dh->n < _DIRHASH_ENTRIES) {
+        dh->sh[dh->n] = dh_sfn(dj->fn);
+#if _USE_LFN
+        dh->lh[dh->n] = (dj->fn[NS] & NS_LFN) ? dh_lfn(dj->lfn) : 0;
+#else
+        dh->lh[dh->n] = 0;
+#endif
+        dh->idx[dh->n++] = is;
+    } else {                            /* Index is full, search from the object linearly */
+        dh->end = is;
+        dh->done = 0;
+    }
+}
+
+
+#if !_FS_MINIMIZE
+static
+void dh_remove (        /* Remove an object from the index */
+    FATFS_DIR *dj       /* Pointer to the directory object pointing the removed SFN entry */
+)
+{
+    DIRHASH *dh;
+    DWORD cl;
+    WORD is, k;
+    UINT i;
+
+
+    dh = dh_get(dj, 0);
+    if (dh) {
+#if _USE_LFN
+        is = (dj->lfn_idx == 0xFFFF) ? dj->index : dj->lfn_idx;
+#else
+        is = dj->index;
+#endif
+        for (k = 0; k < dh->n && dh->idx[k] != is; k++) ;
+        if (k < dh->n) {                /* Replace it with the last one */
+            dh->n--;
+            dh->sh[k] = dh->sh[dh->n];
+            dh->lh[k] = dh->lh[dh->n];
+            dh->idx[k] = dh->idx[dh->n];
+        }
+    }
+
+    cl = ld_clust(dj->fs, dj->dir);
+    if (cl) {                           /* Drop the index of a removed sub-directory */
+        for (i = 0; i < _DIRHASH_DIRS; i++) {
+            if (DirHash[i].fs == dj->fs && DirHash[i].clu == cl) DirHash[i].fs = 0;
+        }
+    }
+}
+#endif
+#endif
+#endif /* _USE_DIRHASH */
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Directory handling - Find an object in the directory                  */
 /*-----------------------------------------------------------------------*/
 
 static
-FRESULT dir_find (
-    FATFS_DIR *dj         /* Pointer to the directory object linked to the file name */
+FRESULT dir_scan (      /* FR_OK:Found, FR_NO_FILE:Not found */
+    FATFS_DIR *dj,      /* Pointer to the directory object linked to the file name */
+    WORD idx,           /* Directory index to start the search at */
+    int one             /* 1:Test only the object at idx */
 )
 {
     FRESULT res;
@@ -1396,7 +1879,7 @@ FRESULT dir_find (
     BYTE a, ord, sum;
 #endif
 
-    res = dir_sdi(dj, 0);           /* Rewind directory object */
+    res = dir_sdi(dj, idx);         /* Rewind directory object */
     if (res != FR_OK) return res;
 
 #if _USE_LFN
@@ -1427,11 +1910,14 @@ FRESULT dir_find (
                 if (!ord && sum == sum_sfn(dir)) break; /* LFN matched? */
                 ord = 0xFF; dj->lfn_idx = 0xFFFF;   /* Reset LFN sequence */
                 if (!(dj->fn[NS] & NS_LOSS) && !mem_cmp(dir, dj->fn, 11)) break;    /* SFN matched? */
+                if (one) { res = FR_NO_FILE; break; }   /* The object did not match */
             }
         }
 #else       /* Non LFN configuration */
-        if (!(dir[DIR_Attr] & AM_VOL) && !mem_cmp(dir, dj->fn, 11)) /* Is it a valid entry? */
-            break;
+        if (!(dir[DIR_Attr] & AM_VOL)) {    /* Is it a valid entry? */
+            if (!mem_cmp(dir, dj->fn, 11)) break;
+            if (one) { res = FR_NO_FILE; break; }
+        }
 #endif
         res = dir_next(dj, 0);      /* Next entry */
     } while (res == FR_OK);
@@ -1440,6 +1926,48 @@ FRESULT dir_find (
 }
 
 
+static
+FRESULT dir_find (
+    FATFS_DIR *dj         /* Pointer to the directory object linked to the file name */
+)
+{
+#if _USE_DIRHASH
+    FRESULT res;
+    DIRHASH *dh;
+    WORD hs, hl, k;
+    int ts, tl;
+
+
+    dh = dh_get(dj, 1);
+    if (!dh->done && dh->n < _DIRHASH_ENTRIES) {
+        res = dh_build(dh, dj);     /* Index the rest of the directory */
+        if (res != FR_OK) { dh->fs = 0; return res; }
+    }
+
+    /* Test only the objects with a matching hash */
+#if _USE_LFN
+    ts = !(dj->fn[NS] & NS_LOSS);
+    tl = (dj->lfn != 0);
+    hl = tl ? dh_lfn(dj->lfn) : 0;
+#else
+    ts = 1; tl = 0; hl = 0;
+#endif
+    hs = dh_sfn(dj->fn);
+    for (k = 0; k < dh->n; k++) {
+        if ((ts && dh->sh[k] == hs) || (tl && dh->lh[k] == hl)) {
+            res = dir_scan(dj, dh->idx[k], 1);
+            if (res != FR_NO_FILE) return res;
+        }
+    }
+    if (dh->done) return FR_NO_FILE;
+
+    return dir_scan(dj, dh->end, 0);    /* Search the objects not indexed */
+#else
+    return dir_scan(dj, 0, 0);
+#endif
+}
+
+
 
 
 /*-----------------------------------------------------------------------*/
@@ -1596,6 +2124,9 @@ FRESULT dir_register (  /* FR_OK:Successful, FR_DENIED:No free entry or too many
             dir[DIR_NTres] = *(dj->fn+NS) & (NS_BODY | NS_EXT); /* Put NT flag */
 #endif
             dj->fs->wflag = 1;
+#if _USE_DIRHASH
+            dh_add(dj);
+#endif
         }
     }
 
@@ -1632,6 +2163,9 @@ FRESULT dir_remove (    /* FR_OK: Successful, FR_DISK_ERR: A disk error */
         } while (res == FR_OK);
         if (res == FR_NO_FILE) res = FR_INT_ERR;
     }
+#if _USE_DIRHASH
+    if (res == FR_OK) dh_remove(dj);
+#endif
 
 #else           /* Non LFN configuration */
     res = dir_sdi(dj, dj->index);
@@ -1640,6 +2174,9 @@ FRESULT dir_remove (    /* FR_OK: Successful, FR_DISK_ERR: A disk error */
         if (res == FR_OK) {
             *dj->dir = DDE;         /* Mark the entry "deleted" */
             dj->fs->wflag = 1;
+#if _USE_DIRHASH
+            dh_remove(dj);
+#endif
         }
     }
 #endif
@@ -2035,6 +2572,68 @@ BYTE check_fs ( /* 0:FAT-VBR, 1:Any BR but not FAT, 2:Not a BR, 3:Disk error */
 
 
 
+#if _USE_JOURNAL
+/*-----------------------------------------------------------------------*/
+/* Find the journal and finish an interrupted commit                     */
+/*-----------------------------------------------------------------------*/
+
+static
+FRESULT jnl_mount ( /* FR_OK: no journal or journal ready, !=0: error */
+    FATFS *fs       /* File system object */
+)
+{
+    FRESULT res;
+    FATFS_DIR dj;
+    BYTE sfn[12];
+    DWORD scl, ncl, cl, n;
+    UINT i;
+
+
+    fs->jsect = 0; fs->jn = 0;
+    dj.fs = fs; dj.sclust = 0; dj.fn = sfn;
+#if _USE_LFN
+    dj.lfn = 0;
+#endif
+    mem_cpy(sfn, JNL_NAME, 11); sfn[NS] = 0;
+    res = dir_find(&dj);                        /* Look for it in the root directory */
+    if (res == FR_NO_FILE) return FR_OK;        /* No journal on the volume */
+    if (res != FR_OK) return res;
+    if (LD_DWORD(dj.dir+DIR_FileSize) < (DWORD)(_JOURNAL_ENTRIES + 1) * SS(fs))
+        return FR_OK;                           /* Too small, not used */
+    scl = ld_clust(fs, dj.dir);
+    if (scl < 2 || scl >= fs->n_fatent) return FR_OK;
+    ncl = (_JOURNAL_ENTRIES + fs->csize) / fs->csize;   /* Clusters used by the journal */
+    for (cl = scl; cl < scl + ncl - 1; cl++) {  /* It must be contiguous */
+        n = get_fat(fs, cl);
+        if (n == 0xFFFFFFFF) return FR_DISK_ERR;
+        if (n != cl + 1) return FR_OK;
+    }
+
+    fs->jsect = clust2sect(fs, scl);
+    if (disk_read(fs->drv, fs->win, fs->jsect, 1) != RES_OK) return FR_DISK_ERR;
+    fs->winsect = 0;                            /* The window is used as work buffer */
+    if (LD_DWORD(fs->win+JNL_Magic) != JNL_MAGIC)   /* New journal, clear the record */
+        return jnl_apply(fs);
+    i = LD_WORD(fs->win+JNL_Count);
+    if (i == 0 || i > _JOURNAL_ENTRIES) return FR_OK;   /* Nothing to do */
+    for (fs->jn = 0; fs->jn < i; fs->jn++)
+        fs->jmap[fs->jn] = LD_DWORD(fs->win+JNL_Sect+fs->jn*4);
+    if (LD_DWORD(fs->win+JNL_Sum) != jnl_sum(fs)) { /* Torn record, the commit did not happen */
+        fs->jn = 0;
+        return FR_OK;
+    }
+    res = jnl_apply(fs);                        /* Finish the commit */
+    fs->free_clust = 0xFFFFFFFF;                /* FSInfo may have changed */
+    fs->last_clust = 0;
+    fs->id = ++Fsid;                            /* Drop what was found out before the commit */
+
+    return res;
+}
+#endif
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Check if the file system object is valid or not                       */
 /*-----------------------------------------------------------------------*/
@@ -2182,8 +2781,12 @@ FRESULT chk_mounted (   /* FR_OK(0): successful, !=0: any error occurred */
             LD_DWORD(fs->win+FSI_StrucSig) == 0x61417272) {
                 fs->last_clust = LD_DWORD(fs->win+FSI_Nxt_Free);
                 fs->free_clust = LD_DWORD(fs->win+FSI_Free_Count);
+                if (fs->free_clust > fs->n_fatent - 2) fs->free_clust = 0xFFFFFFFF;    /* Trust FSInfo only if it is in range */
         }
     }
+#if _USE_FREEMAP
+    mem_set(fs->fmap, 0, sizeof fs->fmap);  /* Nothing known about the FAT yet */
+#endif
 #endif
     fs->fs_type = fmt;      /* FAT sub-type */
     fs->id = ++Fsid;        /* File system mount ID */
@@ -2195,6 +2798,12 @@ FRESULT chk_mounted (   /* FR_OK(0): successful, !=0: any error occurred */
 #if _FS_LOCK                /* Clear file lock semaphores */
     clear_lock(fs);
 #endif
+#if _USE_JOURNAL
+    if (jnl_mount(fs) != FR_OK) {   /* Finish an interrupted commit */
+        fs->fs_type = 0;
+        return FR_DISK_ERR;
+    }
+#endif
 
     return FR_OK;
 }
@@ -2398,6 +3007,10 @@ FRESULT f_open (
             fp->dsect = 0;
 #if _USE_FASTSEEK
             fp->cltbl = 0;                      /* Normal seek mode */
+#endif
+#if _USE_EXPAND && !_FS_READONLY
+            fp->xclust = 0;                     /* No preallocated run */
+            fp->xsync = fp->fsize;
 #endif
             fp->fs = dj.fs; fp->id = dj.fs->id; /* Validate file object */
         }
@@ -2548,6 +3161,11 @@ FRESULT f_write (
                     if (clst == 0)          /* When no cluster is allocated, */
                         fp->sclust = clst = create_chain(fp->fs, 0);    /* Create a new cluster chain */
                 } else {                    /* Middle or end of the file */
+#if _USE_EXPAND
+                    if (fp->sclust <= fp->clust && fp->clust < fp->xclust)
+                        clst = fp->clust + 1;       /* Next cluster of the preallocated run, no FAT access */
+                    else
+#endif
 #if _USE_FASTSEEK
                     if (fp->cltbl)
                         clst = clmt_clust(fp, fp->fptr);    /* Get cluster# from the CLMT */
@@ -2582,10 +3200,20 @@ FRESULT f_write (
             sect += csect;
             cc = btw / SS(fp->fs);          /* When remaining bytes >= sector size, */
             if (cc) {                       /* Write maximum contiguous sectors directly */
+#if _USE_EXPAND
+                if (fp->sclust <= fp->clust && fp->clust <= fp->xclust) {  /* Inside the preallocated run, */
+                    if (csect + cc > (fp->xclust - fp->clust + 1) * fp->fs->csize)  /* clip at its end */
+                        cc = (fp->xclust - fp->clust + 1) * fp->fs->csize - csect;
+                    if (cc > 255) cc = 255;
+                } else
+#endif
                 if (csect + cc > fp->fs->csize) /* Clip at cluster boundary */
                     cc = fp->fs->csize - csect;
                 if (disk_write(fp->fs->drv, wbuff, sect, (BYTE)cc) != RES_OK)
                     ABORT(fp->fs, FR_DISK_ERR);
+#if _USE_EXPAND
+                fp->clust += (csect + cc - 1) / fp->fs->csize;  /* Cluster of the last sector written */
+#endif
 #if _FS_TINY
                 if (fp->fs->winsect - sect < cc) {  /* Refill sector cache if it gets invalidated by the direct write */
                     mem_cpy(fp->fs->win, wbuff + ((fp->fs->winsect - sect) * SS(fp->fs)), SS(fp->fs));
@@ -2633,6 +3261,14 @@ FRESULT f_write (
     if (fp->fptr > fp->fsize) fp->fsize = fp->fptr; /* Update file size if needed */
     fp->flag |= FA__WRITTEN;                        /* Set file change flag */
 
+#if _USE_EXPAND
+    if (fp->xclust)     /* Preallocated file, the FAT is done: update the directory at checkpoints only */
+        need_sync = (fp->fsize - fp->xsync >= EXPAND_SYNC_SIZE);
+#endif
+#if _USE_JOURNAL
+    if (fp->fs->jsect)  /* Journaled volume, consistent between syncs: sync at checkpoints only */
+        need_sync = (fp->fsize - fp->xsync >= JOURNAL_SYNC_SIZE);
+#endif
     if (need_sync) {
         f_sync (fp);
     }
@@ -2679,13 +3315,131 @@ FRESULT f_sync (
                 fp->flag &= ~FA__WRITTEN;
                 fp->fs->wflag = 1;
                 res = sync(fp->fs);
+#if _USE_EXPAND
+                fp->xsync = fp->fsize;
+#endif
+            }
+        }
+    }
+
+    LEAVE_FF(fp->fs, res);
+}
+
+
+
+
+#if _USE_EXPAND
+/*-----------------------------------------------------------------------*/
+/* Reserve a Contiguous Cluster Run for an Empty File                    */
+/*-----------------------------------------------------------------------*/
+/* The run is linked on the FAT once. f_write() then follows it without
+   reading the FAT, writes across cluster boundaries in one disk_write()
+   and updates the directory entry every EXPAND_SYNC_SIZE bytes only.
+   The file size is not changed, f_close() gives back what was not used. */
+
+FRESULT f_expand (
+    FIL *fp,    /* Pointer to the file object */
+    DWORD fsz   /* Number of bytes to reserve */
+)
+{
+    FRESULT res;
+    FATFS *fs;
+    DWORD n, clst, stcl, scl, ncl, cs;
+#if _USE_FREEMAP
+    UINT epc;
+#endif
+
+
+    res = validate(fp);                     /* Check validity of the object */
+    if (res == FR_OK) {
+        if (fp->flag & FA__ERROR) {         /* Check abort flag */
+            res = FR_INT_ERR;
+        } else {
+            if (!(fp->flag & FA_WRITE) || fp->sclust || !fsz)  /* Check access mode and an empty file */
+                res = FR_DENIED;
+        }
+    }
+    if (res == FR_OK) {
+        fs = fp->fs;
+        n = (fsz - 1) / ((DWORD)fs->csize * SS(fs)) + 1;   /* Number of clusters to reserve */
+        stcl = fs->last_clust;              /* Search from the suggested start point */
+        if (stcl < 2 || stcl >= fs->n_fatent) stcl = 2;
+        scl = clst = stcl; ncl = 0;
+#if _USE_FREEMAP
+        epc = FMAP_EPC(fs);
+#endif
+        for (;;) {                          /* Find n free clusters in a row */
+#if _USE_FREEMAP
+            if (epc && clst % epc == 0 && FMAP_TEST(fs, clst / epc)) {  /* Skip a FAT sector without free cluster */
+                if (stcl > clst && stcl < clst + epc) { res = FR_DENIED; break; }
+                clst += epc; scl = clst; ncl = 0;
+                if (clst >= fs->n_fatent) scl = clst = 2;
+                if (clst == stcl) { res = FR_DENIED; break; }
+                continue;
+            }
+#endif
+            cs = get_fat(fs, clst);
+            if (cs == 1) { res = FR_INT_ERR; break; }
+            if (cs == 0xFFFFFFFF) { res = FR_DISK_ERR; break; }
+            if (cs == 0) {
+                if (++ncl == n) break;      /* Found the run scl..clst */
+            } else {
+                scl = clst + 1; ncl = 0;    /* Run broken, start again after this cluster */
+            }
+            if (++clst >= fs->n_fatent) {   /* Wrap around, a run cannot span the end of the FAT */
+                scl = clst = 2; ncl = 0;
+            }
+            if (clst == stcl) { res = FR_DENIED; break; }  /* No contiguous space */
+        }
+        if (res == FR_OK) {                 /* Link the run and flush the FAT */
+            for (clst = scl; res == FR_OK && clst < scl + n - 1; clst++)
+                res = put_fat(fs, clst, clst + 1);
+            if (res == FR_OK) res = put_fat(fs, scl + n - 1, 0x0FFFFFFF);
+            if (res == FR_OK) {
+                fp->sclust = scl;
+                fp->xclust = scl + n - 1;
+                fp->flag |= FA__WRITTEN;
+                fs->last_clust = scl + n - 1;
+                if (fs->free_clust != 0xFFFFFFFF) {
+                    fs->free_clust -= n;
+                    fs->fsi_flag = 1;
+                }
+                res = sync(fs);
             }
         }
+        if (res != FR_OK && res != FR_DENIED) fp->flag |= FA__ERROR;
     }
 
     LEAVE_FF(fp->fs, res);
 }
 
+
+static
+FRESULT release_expand (    /* Remove the unused clusters at the end of a preallocated run */
+    FIL *fp     /* Pointer to the file object */
+)
+{
+    FRESULT res = FR_OK;
+    DWORD lcl;
+
+
+    if (fp->fsize == 0) {       /* Nothing written, remove the entire run */
+        res = remove_chain(fp->fs, fp->sclust);
+        fp->sclust = 0;
+    } else {                    /* Cut the run after the cluster holding the last byte */
+        lcl = fp->sclust + (fp->fsize - 1) / ((DWORD)fp->fs->csize * SS(fp->fs));
+        if (lcl < fp->xclust) {
+            res = put_fat(fp->fs, lcl, 0x0FFFFFFF);
+            if (res == FR_OK) res = remove_chain(fp->fs, lcl + 1);
+        }
+    }
+    fp->xclust = 0;
+    fp->flag |= FA__WRITTEN;
+    if (res != FR_OK) fp->flag |= FA__ERROR;
+    return res;
+}
+#endif /* _USE_EXPAND */
+
 #endif /* !_FS_READONLY */
 
 
@@ -2712,6 +3466,16 @@ FRESULT f_close (
         LEAVE_FF(fs, res);
     }
 #else
+#if _USE_EXPAND
+    res = validate(fp);
+    if (res != FR_OK) return res;
+    if (fp->xclust)
+        res = release_expand(fp);   /* Give back the unused part of the preallocated run */
+#if _FS_REENTRANT
+    unlock_fs(fp->fs, res);
+#endif
+    if (res != FR_OK) return res;
+#endif
     res = f_sync(fp);       /* Flush cached data */
 #if _FS_LOCK
     if (res == FR_OK) {     /* Decrement open counter */
@@ -3155,6 +3919,10 @@ FRESULT f_getfree (
     DWORD n, clst, sect, stat;
     UINT i;
     BYTE fat, *p;
+#if _USE_FREEMAP
+    DWORD fn = 0;
+    UINT epc;
+#endif
 
 
     /* Get drive number */
@@ -3180,8 +3948,21 @@ FRESULT f_getfree (
                 clst = fs->n_fatent;
                 sect = fs->fatbase;
                 i = 0; p = 0;
+#if _USE_FREEMAP
+                epc = FMAP_EPC(fs);
+#endif
                 do {
                     if (!i) {
+#if _USE_FREEMAP
+                        if (p && n == fn) FMAP_SET(fs, sect - 1 - fs->fatbase);    /* No free cluster in the previous sector */
+                        if (FMAP_TEST(fs, sect - fs->fatbase)) {   /* Skip a sector known to be full */
+                            sect++; p = 0;
+                            if (clst <= epc) break;
+                            clst -= epc - 1;
+                            continue;
+                        }
+                        fn = n;
+#endif
                         res = move_window(fs, sect++);
                         if (res != FR_OK) break;
                         p = fs->win;
@@ -3195,9 +3976,17 @@ FRESULT f_getfree (
                         p += 4; i -= 4;
                     }
                 } while (--clst);
+#if _USE_FREEMAP
+                if (res == FR_OK && p && n == fn) FMAP_SET(fs, sect - 1 - fs->fatbase);
+#endif
+            }
+            if (res == FR_OK) {
+                fs->free_clust = n;
+                if (fat == FS_FAT32) {  /* Write the count back so the next mount can trust FSInfo */
+                    fs->fsi_flag = 1;
+                    res = sync(fs);
+                }
             }
-            fs->free_clust = n;
-            if (fat == FS_FAT32) fs->fsi_flag = 1;
             *nclst = n;
         }
     }
@@ -3247,6 +4036,9 @@ FRESULT f_truncate (
                     if (res == FR_OK) res = remove_chain(fp->fs, ncl);
                 }
             }
+#if _USE_EXPAND
+            fp->xclust = 0;         /* The preallocated run is cut */
+#endif
         }
         if (res != FR_OK) fp->flag |= FA__ERROR;
     }
@@ -3562,7 +4354,7 @@ FRESULT f_rename (
 /*-----------------------------------------------------------------------*/
 /* Forward data to the stream directly (available on only tiny cfg)      */
 /*-----------------------------------------------------------------------*/
-#if _USE_FORWARD && _FS_TINY
+#if _USE_FORWARD
 
 FRESULT f_forward (
     FIL *fp,                        /* Pointer to the file object */
@@ -3606,12 +4398,30 @@ FRESULT f_forward (
         sect = clust2sect(fp->fs, fp->clust);       /* Get current data sector */
         if (!sect) ABORT(fp->fs, FR_INT_ERR);
         sect += csect;
+#if _FS_TINY
         if (move_window(fp->fs, sect))              /* Move sector window */
             ABORT(fp->fs, FR_DISK_ERR);
+#else
+        if (fp->dsect != sect) {                    /* Load data sector if not in cache */
+#if !_FS_READONLY
+            if (fp->flag & FA__DIRTY) {             /* Write-back dirty sector cache */
+                if (disk_write(fp->fs->drv, fp->buf, fp->dsect, 1) != RES_OK)
+                    ABORT(fp->fs, FR_DISK_ERR);
+                fp->flag &= ~FA__DIRTY;
+            }
+#endif
+            if (disk_read(fp->fs->drv, fp->buf, sect, 1) != RES_OK) /* Fill sector cache */
+                ABORT(fp->fs, FR_DISK_ERR);
+        }
+#endif
         fp->dsect = sect;
-        rcnt = SS(fp->fs) - (WORD)(fp->fptr % SS(fp->fs));  /* Forward data from sector window */
+        rcnt = SS(fp->fs) - (WORD)(fp->fptr % SS(fp->fs));  /* Forward data from sector buffer */
         if (rcnt > btr) rcnt = btr;
+#if _FS_TINY
         rcnt = (*func)(&fp->fs->win[(WORD)fp->fptr % SS(fp->fs)], rcnt);
+#else
+        rcnt = (*func)(&fp->buf[(WORD)fp->fptr % SS(fp->fs)], rcnt);
+#endif
         if (!rcnt) ABORT(fp->fs, FR_INT_ERR);
     }
 
@@ -3621,6 +4431,52 @@ FRESULT f_forward (
 
 
 
+#if _USE_JOURNAL
+/*-----------------------------------------------------------------------*/
+/* Create the Metadata Journal on the Drive                              */
+/*-----------------------------------------------------------------------*/
+/* The journal is a hidden read-only file of _JOURNAL_ENTRIES + 1 contiguous
+   sectors in the root directory. It is looked for at every mount, so it has
+   to be created once per volume only. */
+
+FRESULT f_mkjournal (
+    BYTE vol        /* Logical drive number */
+)
+{
+    static const char name[] = "0:/FSJOURNL.SYS";
+    TCHAR path[sizeof name];
+    FRESULT res, res2;
+    FIL fil;
+    UINT i;
+
+
+    if (vol >= _VOLUMES) return FR_INVALID_DRIVE;
+    for (i = 0; i < sizeof name; i++) path[i] = (TCHAR)name[i];
+    path[0] = (TCHAR)('0' + vol);
+
+    res = f_open(&fil, path, FA_WRITE | FA_CREATE_NEW);
+    if (res == FR_EXIST && FatFs[vol]->jsect) return FR_OK;    /* Found at mount */
+    if (res != FR_OK) return res;
+    res = f_expand(&fil, (DWORD)(_JOURNAL_ENTRIES + 1) * SS(fil.fs));
+    if (res == FR_OK)   /* Set the file size, the run is linked already */
+        res = f_lseek(&fil, (DWORD)(_JOURNAL_ENTRIES + 1) * SS(fil.fs));
+    res2 = f_close(&fil);
+    if (res == FR_OK) res = res2;
+    if (res == FR_OK)
+        res = f_chmod(path, AM_RDO | AM_HID | AM_SYS, AM_RDO | AM_HID | AM_SYS);
+    if (res != FR_OK) {
+        f_unlink(path);
+        return res;
+    }
+
+    ENTER_FF(FatFs[vol]);
+    res = jnl_mount(FatFs[vol]);
+    LEAVE_FF(FatFs[vol], res);
+}
+#endif /* _USE_JOURNAL */
+
+
+
 #if _USE_MKFS && !_FS_READONLY
 /*-----------------------------------------------------------------------*/
 /* Create File System on the Drive                                       */
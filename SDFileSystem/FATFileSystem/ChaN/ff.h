@@ -93,6 +93,14 @@ typedef struct {
     DWORD   last_clust;     /* Last allocated cluster */
     DWORD   free_clust;     /* Number of free clusters */
     DWORD   fsi_sector;     /* fsinfo sector (FAT32) */
+#if _USE_FREEMAP
+    BYTE    fmap[_FREEMAP_SECTORS / 8]; /* FAT sectors without free cluster (1:full, 0:unknown) */
+#endif
+#if _USE_JOURNAL
+    DWORD   jsect;          /* Journal start sector (0:no journal) */
+    WORD    jn;             /* Number of sectors in the journal */
+    DWORD   jmap[_JOURNAL_ENTRIES]; /* Sector each journal slot stands for */
+#endif
 #endif
 #if _FS_RPATH
     DWORD   cdir;           /* Current directory start cluster (0:root) */
@@ -127,6 +135,10 @@ typedef struct {
 #if _USE_FASTSEEK
     DWORD*  cltbl;          /* Pointer to the cluster link map table (null on file open) */
 #endif
+#if _USE_EXPAND && !_FS_READONLY
+    DWORD   xclust;         /* Last cluster of the contiguous run reserved by f_expand() (0:none) */
+    DWORD   xsync;          /* File size at the last sync of a preallocated file */
+#endif
 #if _FS_LOCK
     UINT    lockid;         /* File lock ID (index of file semaphore table Files[]) */
 #endif
@@ -213,6 +225,7 @@ FRESULT f_stat (const TCHAR*, FILINFO*);            /* Get file status */
 FRESULT f_write (FIL*, const void*, UINT, UINT*);   /* Write data to a file */
 FRESULT f_getfree (const TCHAR*, DWORD*, FATFS**);  /* Get number of free clusters on the drive */
 FRESULT f_truncate (FIL*);                          /* Truncate file */
+FRESULT f_expand (FIL*, DWORD);                     /* Reserve contiguous clusters for an empty file */
 FRESULT f_sync (FIL*);                              /* Flush cached data of a writing file */
 FRESULT f_unlink (const TCHAR*);                    /* Delete an existing file or directory */
 FRESULT f_mkdir (const TCHAR*);                     /* Create a new directory */
@@ -224,6 +237,7 @@ FRESULT f_chdir (const TCHAR*);                     /* Change current directory
 FRESULT f_getcwd (TCHAR*, UINT);                    /* Get current directory */
 FRESULT f_forward (FIL*, UINT(*)(const BYTE*,UINT), UINT, UINT*);   /* Forward data to the stream */
 FRESULT f_mkfs (BYTE, BYTE, UINT);                  /* Create a file system on the drive */
+FRESULT f_mkjournal (BYTE);                         /* Create the metadata journal on the drive */
 FRESULT f_fdisk (BYTE, const DWORD[], void*);       /* Divide a physical drive into some partitions */
 int f_putc (TCHAR, FIL*);                           /* Put a character to the file */
 int f_puts (const TCHAR*, FIL*);                    /* Put a string to the file */
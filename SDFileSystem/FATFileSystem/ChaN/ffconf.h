@@ -45,14 +45,47 @@
 /* To enable f_mkfs function, set _USE_MKFS to 1 and set _FS_READONLY to 0 */
 
 
-#define _USE_FORWARD    0   /* 0:Disable or 1:Enable */
-/* To enable f_forward function, set _USE_FORWARD to 1 and set _FS_TINY to 1. */
+#define _USE_FORWARD    1   /* 0:Disable or 1:Enable */
+/* To enable f_forward function, set _USE_FORWARD to 1. The data is passed from
+   the sector window (_FS_TINY = 1) or from the sector buffer of the file. */
 
 
 #define _USE_FASTSEEK   0   /* 0:Disable or 1:Enable */
 /* To enable fast seek feature, set _USE_FASTSEEK to 1. */
 
 
+#define _USE_EXPAND     1   /* 0:Disable or 1:Enable */
+/* To enable f_expand function, set _USE_EXPAND to 1 and set _FS_READONLY to 0 */
+
+
+#define _USE_FREEMAP    1   /* 0:Disable or 1:Enable */
+#define _FREEMAP_SECTORS    8192    /* FAT sectors covered by the map (one bit each) */
+/* To keep a map of FAT sectors without free clusters, set _USE_FREEMAP to 1
+   and set _FS_READONLY to 0. The map is built while the FAT is scanned and
+   lets cluster allocation and f_getfree skip full FAT sectors. FAT12 volumes
+   and FAT sectors past _FREEMAP_SECTORS are not mapped. */
+
+
+#define _USE_DIRHASH    1   /* 0:Disable or 1:Enable */
+#define _DIRHASH_DIRS       2       /* Directories indexed at a time */
+#define _DIRHASH_ENTRIES    256     /* Objects indexed per directory (6 bytes each) */
+/* To keep a name hash index of recently searched directories, set _USE_DIRHASH
+   to 1. The index of a directory is built on its first lookup, later lookups
+   only read the entries whose hash matches. When all _DIRHASH_DIRS slots are
+   in use the least recently used directory is dropped. Objects past
+   _DIRHASH_ENTRIES are searched linearly. */
+
+
+#define _USE_JOURNAL    1   /* 0:Disable or 1:Enable */
+#define _JOURNAL_ENTRIES    16      /* Sectors per transaction (4 bytes each, up to 125) */
+/* To journal the FAT, directory and FSInfo writes, set _USE_JOURNAL to 1, set
+   _USE_EXPAND to 1 and set _FS_READONLY to 0. f_mkjournal creates the journal
+   file FSJOURNL.SYS on a volume. On a volume with a journal, the metadata
+   written since the last sync is committed at once and a commit interrupted
+   by a power loss is finished at the next mount. Larger transactions, like
+   clearing a new directory cluster, are committed in parts. */
+
+
 
 /*---------------------------------------------------------------------------/
 / Locale and Namespace Configurations
@@ -171,9 +204,12 @@
 /* A header file that defines sync object types on the O/S, such as
 /  windows.h, ucos_ii.h and semphr.h, must be included prior to ff.h. */
 
-#define _FS_REENTRANT   0       /* 0:Disable or 1:Enable */
-#define _FS_TIMEOUT     1000    /* Timeout period in unit of time ticks */
-#define _SYNC_t         HANDLE  /* O/S dependent type of sync object. e.g. HANDLE, OS_EVENT*, ID and etc.. */
+#define _FS_REENTRANT   1       /* 0:Disable or 1:Enable */
+#define _FS_TIMEOUT     5000    /* Timeout period in unit of time ticks */
+#define _SYNC_t         void*   /* O/S dependent type of sync object. e.g. HANDLE, OS_EVENT*, ID and etc.. */
+/* The volumes are used from the shell, the network stack and the logging
+/  threads, an RTX mutex per volume serializes them (syscall.cpp). The mutex
+/  is recursive, a thread may hold it around several FatFs calls. */
 
 /* The _FS_REENTRANT option switches the reentrancy (thread safe) of the FatFs module.
 /
@@ -189,6 +225,8 @@
 
 #define FLUSH_ON_NEW_CLUSTER    0   /* Sync the file on every new cluster */
 #define FLUSH_ON_NEW_SECTOR     1   /* Sync the file on every new sector */
+#define EXPAND_SYNC_SIZE    65536   /* Sync a file preallocated by f_expand() every n bytes instead */
+#define JOURNAL_SYNC_SIZE   65536   /* Sync a file on a journaled volume every n bytes instead */
 /* Only one of these two defines needs to be set to 1. If both are set to 0
    the file is only sync when closed.
    Clusters are group of sectors (eg: 8 sectors). Flushing on new cluster means
@@ -0,0 +1,77 @@
+/*------------------------------------------------------------------------*/
+/* Sample code of OS dependent controls for FatFs                         */
+/* (C)ChaN, 2012                                                          */
+/*------------------------------------------------------------------------*/
+/* RTX version: a mutex per volume. RTX mutexes are recursive, so a       */
+/* thread holding the grant may call FatFs again.                         */
+/*------------------------------------------------------------------------*/
+#include "ff.h"
+
+#if _FS_REENTRANT
+#include "cmsis_os.h"
+
+static uint32_t mutex_cb[_VOLUMES][3];     /* Control blocks, as osMutexDef() lays them out */
+static osMutexDef_t mutex_def[_VOLUMES];
+
+
+/*------------------------------------------------------------------------*/
+/* Create a Synchronization Object                                        */
+/*------------------------------------------------------------------------*/
+/* Called in f_mount() to create a new synchronization object for the
+/  volume. When a 0 is returned, f_mount() fails with FR_INT_ERR. */
+
+int ff_cre_syncobj (    /* 1:Function succeeded, 0:Could not create due to any error */
+    BYTE vol,           /* Corresponding logical drive being processed */
+    _SYNC_t *sobj       /* Pointer to return the created sync object */
+)
+{
+    mutex_def[vol].mutex = mutex_cb[vol];
+    *sobj = (_SYNC_t)osMutexCreate(&mutex_def[vol]);
+    return *sobj != NULL;
+}
+
+
+
+/*------------------------------------------------------------------------*/
+/* Delete a Synchronization Object                                        */
+/*------------------------------------------------------------------------*/
+/* Called in f_mount() to delete the synchronization object of the
+/  volume. When a 0 is returned, f_mount() fails with FR_INT_ERR. */
+
+int ff_del_syncobj (    /* 1:Function succeeded, 0:Could not delete due to any error */
+    _SYNC_t sobj        /* Sync object tied to the logical drive to be deleted */
+)
+{
+    return osMutexDelete((osMutexId)sobj) == osOK;
+}
+
+
+
+/*------------------------------------------------------------------------*/
+/* Request Grant to Access the Volume                                     */
+/*------------------------------------------------------------------------*/
+/* Called on entering file functions to lock the volume.
+/  When a 0 is returned, the file function fails with FR_TIMEOUT. */
+
+int ff_req_grant (  /* 1:Got a grant to access the volume, 0:Could not get a grant */
+    _SYNC_t sobj    /* Sync object to wait */
+)
+{
+    return osMutexWait((osMutexId)sobj, _FS_TIMEOUT) == osOK;
+}
+
+
+
+/*------------------------------------------------------------------------*/
+/* Release Grant to Access the Volume                                     */
+/*------------------------------------------------------------------------*/
+/* Called on leaving file functions to unlock the volume. */
+
+void ff_rel_grant (
+    _SYNC_t sobj    /* Sync object to be signaled */
+)
+{
+    osMutexRelease((osMutexId)sobj);
+}
+
+#endif /* _FS_REENTRANT */
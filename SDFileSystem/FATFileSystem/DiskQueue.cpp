@@ -0,0 +1,149 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "DiskQueue.h"
+#include "FATFileSystem.h"
+
+DiskQueue::DiskQueue(FATFileSystem *disk)
+    : requests(0), commands(0), _disk(disk), _head(NULL)
+#ifdef USE_MUTEX
+    , _thread(NULL)
+#endif
+{
+}
+
+static bool overlaps(const DiskRequest *a, const DiskRequest *b) {
+    return a->sector < b->sector + b->count && b->sector < a->sector + a->count;
+}
+
+void DiskQueue::submit(DiskRequest *req) {
+    DiskRequest **p, **q;
+
+    req->result = -1;
+#ifdef USE_MUTEX
+    _lock.lock();
+#endif
+    // sector order, but behind every queued request it overlaps
+    for (p = &_head; *p && (*p)->sector <= req->sector; p = &(*p)->next)
+        ;
+    for (q = p; *q; q = &(*q)->next) {
+        if (overlaps(*q, req))
+            p = &(*q)->next;
+    }
+    req->next = *p;
+    *p = req;
+#ifdef USE_MUTEX
+    _lock.unlock();
+    if (_thread)
+        _thread->signal_set(DISKQUEUE_SIGNAL);
+#endif
+}
+
+int DiskQueue::dispatch() {
+    DiskRequest *run[DISKQUEUE_MAX_RUN];
+    DiskRequest *req;
+    int n, sectors, result, issued = 0;
+
+#ifdef USE_MUTEX
+    _busy.lock();
+#endif
+    for (;;) {
+#ifdef USE_MUTEX
+        _lock.lock();
+#endif
+        // the first request and the ones continuing it
+        n = 0;
+        sectors = 0;
+        while (_head && n < DISKQUEUE_MAX_RUN) {
+            req = _head;
+            if (n > 0 && (req->write != run[0]->write ||
+                          req->sector != run[n - 1]->sector + run[n - 1]->count ||
+                          sectors + req->count > 255))
+                break;
+            _head = req->next;
+            run[n++] = req;
+            sectors += req->count;
+        }
+#ifdef USE_MUTEX
+        _lock.unlock();
+#endif
+        if (n == 0)
+            break;
+
+        result = _disk->disk_transfer(run, n);
+        requests += n;
+        commands++;
+        issued++;
+        for (int i = 0; i < n; i++) {
+            req = run[i];
+            req->result = result;
+            if (req->done)
+                req->done(req);
+        }
+    }
+#ifdef USE_MUTEX
+    _busy.unlock();
+#endif
+    return issued;
+}
+
+int DiskQueue::transfer(DiskRequest *req) {
+#ifdef USE_MUTEX
+    if (_thread) {
+        req->done = DiskQueue::wake;
+        req->ctx = Thread::gettid();
+        req->complete = false;
+        submit(req);
+        // a stray or late signal must not return while req is queued
+        while (!req->complete)
+            Thread::signal_wait(DISKQUEUE_SIGNAL);
+        return req->result;
+    }
+#endif
+    req->done = NULL;
+    submit(req);
+    dispatch();
+    return req->result;
+}
+
+#ifdef USE_MUTEX
+void DiskQueue::start(osPriority priority, int stackSize) {
+    if (_thread == NULL)
+        _thread = new Thread(DiskQueue::threadHelper, this, priority, stackSize);
+}
+
+void DiskQueue::threadHelper(const void *arg) {
+    DiskQueue *pinstance = static_cast<DiskQueue *>(const_cast<void *>(arg));
+
+    for (;;) {
+        Thread::signal_wait(DISKQUEUE_SIGNAL);
+        pinstance->dispatch();
+    }
+}
+
+void DiskQueue::wake(DiskRequest *req) {
+    osThreadId thread = (osThreadId)req->ctx;
+
+    // req may be gone as soon as complete is set
+    req->complete = true;
+    osSignalSet(thread, DISKQUEUE_SIGNAL);
+}
+#endif
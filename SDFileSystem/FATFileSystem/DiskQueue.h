@@ -0,0 +1,108 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef MBED_DISKQUEUE_H
+#define MBED_DISKQUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "globals.h"
+
+#ifdef USE_MUTEX
+#include "rtos.h"
+#endif
+
+#define DISKQUEUE_MAX_RUN   16          // requests merged into one device command
+#define DISKQUEUE_SIGNAL    (1 << 11)   // thread signal used for wake ups, (1 << 14) is emWin's
+
+class FATFileSystem;
+
+/** A transfer between a buffer and consecutive sectors of a block device
+ *
+ * The request belongs to the queue from submit() until done is called,
+ * the buffer must stay valid until then.
+ */
+struct DiskRequest {
+    uint64_t sector;                    // first sector
+    uint8_t *buffer;                    // count * 512 bytes
+    uint8_t count;                      // number of sectors (1..255)
+    bool write;                         // true: buffer to device
+    int result;                         // 0: done, set before done is called
+    volatile bool complete;             // set once done, what transfer() waits for
+    void (*done)(DiskRequest *req);     // completion, NULL: none
+    void *ctx;                          // free for the owner of the request
+    DiskRequest *next;                  // queue link
+};
+
+/** Submission queue of a block device
+ *
+ * Requests are kept in sector order, a request never passes an earlier one
+ * it overlaps. dispatch() sends runs of adjacent requests going the same
+ * way to the device as one command (FATFileSystem::disk_transfer), so a
+ * card sees one multiple block read or write instead of a command per
+ * request. Requests are dispatched by the caller, or by an own I/O thread
+ * once start() was called.
+ */
+class DiskQueue {
+public:
+    DiskQueue(FATFileSystem *disk);
+
+    /** Queues a request, done is called when it was transferred
+     */
+    void submit(DiskRequest *req);
+
+    /** Transfers everything queued
+     *
+     * @returns number of device commands issued
+     */
+    int dispatch();
+
+    /** Queues a request and waits for it (used by FatFs)
+     *
+     * @returns 0 on success
+     */
+    int transfer(DiskRequest *req);
+
+#ifdef USE_MUTEX
+    /** Dispatches from an own thread from now on (SDFileSystem starts it)
+     *
+     * done is then called from that thread and must not wait for the queue.
+     */
+    void start(osPriority priority = osPriorityAboveNormal, int stackSize = 768);
+#endif
+
+    uint32_t requests;                  // requests transferred
+    uint32_t commands;                  // device commands they took
+
+private:
+    FATFileSystem *_disk;
+    DiskRequest *_head;
+#ifdef USE_MUTEX
+    Mutex _lock;                        // protects the queue
+    Mutex _busy;                        // one dispatcher at a time
+    Thread *_thread;
+
+    static void threadHelper(const void *arg);
+    static void wake(DiskRequest *req);
+#endif
+};
+
+#endif
@@ -88,3 +88,47 @@ int FATFileHandle::fsync() {
 off_t FATFileHandle::flen() {
     return _fh.fsize;
 }
+
+// f_forward() has no context argument. The callback and its context are
+// only set and used under the grant of the volume, which f_forward() takes
+// again: the RTX mutexes of syscall.cpp are recursive.
+#if _FS_REENTRANT && _VOLUMES > 1
+#error The f_forward() callback is shared by all volumes.
+#endif
+static size_t (*forward_func)(void *ctx, const void *data, size_t length);
+static void *forward_ctx;
+
+static UINT forward_stream(const BYTE *data, UINT length) {
+    return forward_func(forward_ctx, data, length);
+}
+
+ssize_t FATFileHandle::forward(size_t (*func)(void *ctx, const void *data, size_t length), void *ctx, size_t length) {
+    UINT n;
+#if _FS_REENTRANT
+    FATFS *fs = _fh.fs;
+    if (fs == NULL || !ff_req_grant(fs->sobj)) {
+        debug_if(FFS_DBG, "f_forward() could not lock the volume\n");
+        return -1;
+    }
+#endif
+    forward_func = func;
+    forward_ctx = ctx;
+    FRESULT res = f_forward(&_fh, &forward_stream, length, &n);
+#if _FS_REENTRANT
+    ff_rel_grant(fs->sobj);
+#endif
+    if (res) {
+        debug_if(FFS_DBG, "f_forward() failed: %d\n", res);
+        return -1;
+    }
+    return n;
+}
+
+int FATFileHandle::preallocate(off_t size) {
+    FRESULT res = f_expand(&_fh, size);
+    if (res) {
+        debug_if(FFS_DBG, "f_expand() failed: %d\n", res);
+        return -1;
+    }
+    return 0;
+}
@@ -37,6 +37,12 @@ public:
     virtual off_t lseek(off_t position, int whence);
     virtual int fsync();
     virtual off_t flen();
+    virtual ssize_t forward(size_t (*func)(void *ctx, const void *data, size_t length), void *ctx, size_t length);
+
+    /** Reserve size bytes of contiguous clusters for an empty file opened for
+     *  writing, appends then go to the disk without FAT updates. See f_expand().
+     */
+    int preallocate(off_t size);
 
 protected:
 
@@ -42,7 +42,7 @@ DWORD get_fattime(void) {
 
 FATFileSystem *FATFileSystem::_ffs[_VOLUMES] = {0};
 
-FATFileSystem::FATFileSystem(const char* n) : FileSystemLike(n) {
+FATFileSystem::FATFileSystem(const char* n) : FileSystemLike(n), _queue(this) {
     debug_if(FFS_DBG, "FATFileSystem(%s)\n", n);
     for(int i=0; i<_VOLUMES; i++) {
         if(_ffs[i] == 0) {
@@ -141,6 +141,17 @@ int FATFileSystem::format() {
     return 0;
 }
 
+#if _USE_JOURNAL
+int FATFileSystem::journal() {
+    FRESULT res = f_mkjournal(_fsid);
+    if (res) {
+        debug_if(FFS_DBG, "f_mkjournal() failed: %d\n", res);
+        return -1;
+    }
+    return 0;
+}
+#endif
+
 DirHandle *FATFileSystem::opendir(const char *name) {
     FATFS_DIR dir;
     FRESULT res = f_opendir(&dir, name);
@@ -166,3 +177,13 @@ int FATFileSystem::unmount() {
     FRESULT res = f_mount(_fsid, NULL);
     return res == 0 ? 0 : -1;
 }
+
+int FATFileSystem::disk_transfer(DiskRequest* const* run, int n) {
+    for (int i = 0; i < n; i++) {
+        DiskRequest *req = run[i];
+        if (req->write ? disk_write(req->buffer, req->sector, req->count)
+                       : disk_read(req->buffer, req->sector, req->count))
+            return -1;
+    }
+    return 0;
+}
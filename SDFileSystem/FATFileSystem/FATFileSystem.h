@@ -24,6 +24,7 @@
 
 #include "FileSystemLike.h"
 #include "FileHandle.h"
+#include "DiskQueue.h"
 #include "ff.h"
 #include <stdint.h>
 
@@ -41,6 +42,7 @@ public:
     static FATFileSystem * _ffs[_VOLUMES];   // FATFileSystem objects, as parallel to FatFs drives array
     FATFS _fs;                               // Work area (file system object) for logical drive
     int _fsid;
+    DiskQueue _queue;                        // Sector requests to the device, FatFs included
 
     /**
      * Opens a file on the filesystem
@@ -67,6 +69,13 @@ public:
      */
     virtual int format();
     
+#if _USE_JOURNAL
+    /**
+     * Creates the metadata journal, FAT and directory updates then survive a power loss
+     */
+    int journal();
+#endif
+
     /**
      * Opens a directory on the filesystem
      */
@@ -94,6 +103,13 @@ public:
     virtual int disk_sync() { return 0; }
     virtual uint64_t disk_sectors() = 0;
 
+    /**
+     * Transfers n requests on consecutive sectors, all reads or all writes.
+     * Calls disk_read() or disk_write() per request, devices that can
+     * stream scattered buffers in one command override it.
+     */
+    virtual int disk_transfer(DiskRequest* const* run, int n);
+
 };
 
 #endif
@@ -30,43 +30,53 @@ namespace mbed
             }
         }
     
-        // read a sector in to the buffer, return 0 if ok
-        virtual int disk_read(char *buffer, int sector) {
-            if(sectors[sector] == 0) {
-                // nothing allocated means sector is empty
-                memset(buffer, 0, 512);
-            } else {
-                memcpy(buffer, sectors[sector], 512);
+        // read sectors in to the buffer, return 0 if ok
+        virtual int disk_read(uint8_t *buffer, uint64_t sector, uint8_t count) {
+            for(; count > 0; count--, sector++, buffer += 512) {
+                if(sector >= disk_sectors()) {
+                    return 1;
+                }
+                if(sectors[sector] == 0) {
+                    // nothing allocated means sector is empty
+                    memset(buffer, 0, 512);
+                } else {
+                    memcpy(buffer, sectors[sector], 512);
+                }
             }
             return 0;
         }
     
-        // write a sector from the buffer, return 0 if ok
-        virtual int disk_write(const char *buffer, int sector) {
-            // if buffer is zero deallocate sector
-            char zero[512];
-            memset(zero, 0, 512);
-            if(memcmp(zero, buffer, 512)==0) {
-                if(sectors[sector] != 0) {
-                    free(sectors[sector]);
-                    sectors[sector] = 0;
+        // write sectors from the buffer, return 0 if ok
+        virtual int disk_write(const uint8_t *buffer, uint64_t sector, uint8_t count) {
+            for(; count > 0; count--, sector++, buffer += 512) {
+                if(sector >= disk_sectors()) {
+                    return 1;
                 }
-                return 0;
-            }
-            // else allocate a sector if needed, and write
-            if(sectors[sector] == 0) {
-                char *sec = (char*)malloc(512);
-                if(sec==0) {
-                    return 1; // out of memory
+                // if buffer is zero deallocate sector
+                char zero[512];
+                memset(zero, 0, 512);
+                if(memcmp(zero, buffer, 512)==0) {
+                    if(sectors[sector] != 0) {
+                        free(sectors[sector]);
+                        sectors[sector] = 0;
+                    }
+                    continue;
+                }
+                // else allocate a sector if needed, and write
+                if(sectors[sector] == 0) {
+                    char *sec = (char*)malloc(512);
+                    if(sec==0) {
+                        return 1; // out of memory
+                    }
+                    sectors[sector] = sec;
                 }
-                sectors[sector] = sec;
+                memcpy(sectors[sector], buffer, 512);
             }
-            memcpy(sectors[sector], buffer, 512);
             return 0;
         }
     
         // return the number of sectors
-        virtual int disk_sectors() {
+        virtual uint64_t disk_sectors() {
             return sizeof(sectors)/sizeof(sectors[0]);
         }
     
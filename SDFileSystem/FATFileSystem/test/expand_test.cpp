@@ -0,0 +1,171 @@
+/* Host test of f_expand() on a RAM disk
+ *
+ * Builds and runs on the host, without the mbed tree:
+ *
+ *   g++ -I../ChaN expand_test.cpp ../ChaN/ff.cpp ../ChaN/ccsbcs.cpp -o expand_test && ./expand_test
+ *
+ * Writes past the preallocated run of a file on a fragmented FAT16 volume,
+ * where the FAT hands out clusters below the run, and checks that no other
+ * file was overwritten and that the FAT chains stay apart.
+ */
+#include "ff.h"
+#include "diskio.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NSECT       16384   // 8 MB, FAT16 with 1 KB clusters
+#define CLUSTER     1024
+#define RESERVED    8       // clusters preallocated at the end of the volume
+#define PAST        3       // clusters written past them
+
+static BYTE disk[NSECT * 512];
+static int failures;
+
+DSTATUS disk_initialize(BYTE drv) { return 0; }
+DSTATUS disk_status(BYTE drv) { return 0; }
+DWORD get_fattime(void) { return 0; }
+
+// single threaded, the volume lock always succeeds
+int ff_cre_syncobj(BYTE vol, _SYNC_t *sobj) { *sobj = NULL; return 1; }
+int ff_del_syncobj(_SYNC_t sobj) { return 1; }
+int ff_req_grant(_SYNC_t sobj) { return 1; }
+void ff_rel_grant(_SYNC_t sobj) {}
+
+DRESULT disk_read(BYTE drv, BYTE *buf, DWORD sector, BYTE count)
+{
+    memcpy(buf, disk + sector * 512, count * 512);
+    return RES_OK;
+}
+
+DRESULT disk_write(BYTE drv, const BYTE *buf, DWORD sector, BYTE count)
+{
+    memcpy(disk + sector * 512, buf, count * 512);
+    return RES_OK;
+}
+
+DRESULT disk_ioctl(BYTE drv, BYTE cmd, void *buf)
+{
+    switch (cmd) {
+    case GET_SECTOR_COUNT: *(DWORD *)buf = NSECT; break;
+    case GET_SECTOR_SIZE:  *(WORD *)buf = 512; break;
+    case GET_BLOCK_SIZE:   *(DWORD *)buf = 1; break;
+    }
+    return RES_OK;
+}
+
+static void check(bool ok, const char *what)
+{
+    printf("%s: %s\n", ok ? "ok" : "FAIL", what);
+    if (!ok)
+        failures++;
+}
+
+static bool write_file(const char *path, int c, UINT len)
+{
+    static BYTE buf[CLUSTER];
+    FIL f;
+    UINT n;
+    bool ok = f_open(&f, path, FA_CREATE_ALWAYS | FA_WRITE) == FR_OK;
+
+    memset(buf, c, sizeof(buf));
+    for (UINT done = 0; ok && done < len; done += n)
+        ok = f_write(&f, buf, len - done < sizeof(buf) ? len - done : sizeof(buf), &n) == FR_OK && n > 0;
+    return f_close(&f) == FR_OK && ok;
+}
+
+static bool file_is(const char *path, int c, UINT len)
+{
+    BYTE buf[CLUSTER];
+    FIL f;
+    UINT n;
+    bool ok = f_open(&f, path, FA_READ) == FR_OK && f.fsize == len;
+
+    for (UINT done = 0; ok && done < len; done += n) {
+        ok = f_read(&f, buf, sizeof(buf), &n) == FR_OK && n > 0;
+        for (UINT i = 0; ok && i < n; i++)
+            ok = buf[i] == c;
+    }
+    f_close(&f);
+    return ok;
+}
+
+// Clusters of a file, from the FAT16 on the disk image
+static int chain(const char *path, DWORD *clusters, int max)
+{
+    FIL f;
+    int n = 0;
+    WORD fatbase = disk[14] | disk[15] << 8;
+
+    if (f_open(&f, path, FA_READ) != FR_OK)
+        return -1;
+    for (DWORD c = f.sclust; c >= 2 && c < 0xFFF8 && n < max; n++) {
+        clusters[n] = c;
+        c = disk[fatbase * 512 + c * 2] | disk[fatbase * 512 + c * 2 + 1] << 8;
+    }
+    f_close(&f);
+    return n;
+}
+
+int main()
+{
+    FATFS fs, *pfs;
+    FIL f;
+    UINT n;
+    DWORD nfree;
+    static BYTE buf[(RESERVED + PAST) * CLUSTER];
+
+    f_mount(0, &fs);
+    check(f_mkfs(0, 1, CLUSTER) == FR_OK, "mkfs");
+
+    // hole | other | gap | filler ... | RESERVED free clusters at the end
+    check(write_file("0:/hole.bin", 'h', CLUSTER), "write hole.bin");
+    check(write_file("0:/other.bin", 'o', 4 * CLUSTER), "write other.bin");
+    check(write_file("0:/gap.bin", 'g', 4 * CLUSTER), "write gap.bin");
+    f_getfree("0:", &nfree, &pfs);
+    check(write_file("0:/filler.bin", 'f', (nfree - RESERVED) * CLUSTER), "write filler.bin");
+    f_unlink("0:/hole.bin");
+    f_unlink("0:/gap.bin");
+    f_getfree("0:", &nfree, &pfs);
+    check(nfree == RESERVED + 1 + 4, "free clusters: the end, hole and gap");
+
+    // The run takes the end, writing past it wraps to the hole, then the gap
+    for (UINT i = 0; i < sizeof(buf); i++)
+        buf[i] = (BYTE)(i * 7 + i / 511);
+    check(f_open(&f, "0:/log.bin", FA_CREATE_ALWAYS | FA_WRITE) == FR_OK, "open log.bin");
+    check(f_expand(&f, RESERVED * CLUSTER) == FR_OK, "expand log.bin");
+    check(f_write(&f, buf, 100, &n) == FR_OK && n == 100, "write log.bin head");
+    check(f_write(&f, buf + 100, sizeof(buf) - 100, &n) == FR_OK && n == sizeof(buf) - 100, "write log.bin past the run");
+    check(f_close(&f) == FR_OK, "close log.bin");
+
+    // Remount and look at the disk
+    f_mount(0, NULL);
+    memset(&fs, 0, sizeof(fs));
+    f_mount(0, &fs);
+    check(file_is("0:/other.bin", 'o', 4 * CLUSTER), "other.bin intact");
+
+    static BYTE rb[sizeof(buf)];
+    bool same = f_open(&f, "0:/log.bin", FA_READ) == FR_OK && f.fsize == sizeof(buf) &&
+                f_read(&f, rb, sizeof(rb), &n) == FR_OK && n == sizeof(rb) && memcmp(rb, buf, sizeof(buf)) == 0;
+    f_close(&f);
+    check(same, "log.bin reads back");
+
+    DWORD lc[64], oc[64];
+    int nl = chain("0:/log.bin", lc, 64);
+    int no = chain("0:/other.bin", oc, 64);
+    check(nl == RESERVED + PAST, "log.bin chain length");
+    check(no == 4, "other.bin chain length");
+    bool apart = true;
+    for (int i = 0; i < nl; i++)
+        for (int j = 0; j < no; j++)
+            apart = apart && lc[i] != oc[j];
+    check(apart, "log.bin and other.bin chains apart");
+    check(nl > RESERVED && lc[RESERVED] < lc[0], "log.bin wrapped below its run");
+
+    f_getfree("0:", &nfree, &pfs);
+    check(nfree == 1 + 4 - PAST, "free clusters after the test");
+
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
@@ -169,6 +169,9 @@ int SDFileSystem::disk_initialize()
     unsigned int resp;
 
 #ifdef USE_MUTEX
+    //Sector transfers go through the I/O thread of the queue from now on
+    _queue.start();
+
     m_Spi.acquireBus();
 #endif
 
@@ -387,7 +390,11 @@ int SDFileSystem::disk_read(uint8_t* buffer, uint64_t sector, uint8_t count)
         //Read a single block, or multiple blocks
         if (count > 1) {
             // return readBlocks((char*)buffer, sector, count) ? RES_OK : RES_ERROR;
-            retval = readBlocks((char*)buffer, sector, count) ? RES_OK : RES_ERROR;
+            DiskRequest req;
+            DiskRequest* run = &req;
+            req.buffer = buffer;
+            req.count = count;
+            retval = readBlocks(&run, sector, count) ? RES_OK : RES_ERROR;
         } else {
             //return readBlock((char*)buffer, sector) ? RES_OK : RES_ERROR;
             retval = readBlock((char*)buffer, sector) ? RES_OK : RES_ERROR;
@@ -427,7 +434,11 @@ int SDFileSystem::disk_write(const uint8_t* buffer, uint64_t sector, uint8_t cou
             //Write a single block, or multiple blocks
             if (count > 1) {
                 // return writeBlocks((const char*)buffer, sector, count) ? RES_OK : RES_ERROR;
-                retval = writeBlocks((const char*)buffer, sector, count) ? RES_OK : RES_ERROR;
+                DiskRequest req;
+                DiskRequest* run = &req;
+                req.buffer = (uint8_t*)buffer;
+                req.count = count;
+                retval = writeBlocks(&run, sector, count) ? RES_OK : RES_ERROR;
             } else {
                 // return writeBlock((const char*)buffer, sector) ? RES_OK : RES_ERROR;
                 retval = writeBlock((const char*)buffer, sector) ? RES_OK : RES_ERROR;
@@ -442,6 +453,51 @@ int SDFileSystem::disk_write(const uint8_t* buffer, uint64_t sector, uint8_t cou
     return retval;
 }
 
+int SDFileSystem::disk_transfer(DiskRequest* const* run, int n)
+{
+    int retval;
+    int count = 0;
+
+    //A single request goes the usual way
+    if (n == 1) {
+        if (run[0]->write)
+            return disk_write(run[0]->buffer, run[0]->sector, run[0]->count);
+        else
+            return disk_read(run[0]->buffer, run[0]->sector, run[0]->count);
+    }
+
+    //Adjacent requests become one multiple block command
+    for (int i = 0; i < n; i++)
+        count += run[i]->count;
+
+#ifdef USE_MUTEX
+    m_Spi.acquireBus();
+#endif
+
+    //Make sure the card is initialized (and writable) before proceeding
+    if (m_Status & STA_NOINIT)
+    {
+        retval = RES_NOTRDY;
+    }
+    else if (run[0]->write)
+    {
+        if (m_Status & STA_PROTECT)
+            retval = RES_WRPRT;
+        else
+            retval = writeBlocks(run, run[0]->sector, count) ? RES_OK : RES_ERROR;
+    }
+    else
+    {
+        retval = readBlocks(run, run[0]->sector, count) ? RES_OK : RES_ERROR;
+    }
+
+#ifdef USE_MUTEX
+    m_Spi.releaseBus();
+#endif
+
+    return retval;
+}
+
 int SDFileSystem::disk_sync()
 {
     int retval; 
@@ -805,8 +861,20 @@ inline bool SDFileSystem::readBlock(char* buffer, unsigned long long lba)
     return false;
 }
 
-inline bool SDFileSystem::readBlocks(char* buffer, unsigned long long lba, int count)
+//Get the buffer of a block in a run of requests
+static inline char* blockBuffer(DiskRequest* const* run, int block)
 {
+    while (block >= (*run)->count) {
+        block -= (*run)->count;
+        run++;
+    }
+    return (char*)(*run)->buffer + (block << 9);
+}
+
+inline bool SDFileSystem::readBlocks(DiskRequest* const* run, unsigned long long lba, int count)
+{
+    int block = 0;
+
     //Try to read each block up to 3 times
     for (int f = 0; f < 3;) {
         //Select the card, and wait for ready
@@ -818,14 +886,14 @@ inline bool SDFileSystem::readBlocks(char* buffer, unsigned long long lba, int c
             //Try to read all of the data blocks
             do {
                 //Read the next block, and break on errors
-                if (!readData(buffer, 512)) {
+                if (!readData(blockBuffer(run, block), 512)) {
                     f++;
                     break;
                 }
 
                 //Update the variables
                 lba++;
-                buffer += 512;
+                block++;
                 f = 0;
             } while (--count);
 
@@ -895,10 +963,10 @@ inline bool SDFileSystem::writeBlock(const char* buffer, unsigned long long lba)
     return false;
 }
 
-inline bool SDFileSystem::writeBlocks(const char* buffer, unsigned long long lba, int count)
+inline bool SDFileSystem::writeBlocks(DiskRequest* const* run, unsigned long long lba, int count)
 {
     char token;
-    const char* currentBuffer = buffer;
+    int currentBlock = 0;
     unsigned long long currentLba = lba;
     int currentCount = count;
 
@@ -921,14 +989,14 @@ inline bool SDFileSystem::writeBlocks(const char* buffer, unsigned long long lba
             //Try to write all of the data blocks
             do {
                 //Write the next block and break on errors
-                token = writeData(currentBuffer, 0xFC);
+                token = writeData(blockBuffer(run, currentBlock), 0xFC);
                 if (token != 0x05) {
                     f++;
                     break;
                 }
 
                 //Update the variables
-                currentBuffer += 512;
+                currentBlock++;
                 f = 0;
             } while (--currentCount);
 
@@ -984,7 +1052,7 @@ inline bool SDFileSystem::writeBlocks(const char* buffer, unsigned long long lba
                     }
 
                     //Roll back the variables based on the number of well written blocks
-                    currentBuffer = buffer + (writtenBlocks << 9);
+                    currentBlock = writtenBlocks;
                     currentLba = lba + writtenBlocks;
                     currentCount = count - writtenBlocks;
 
@@ -173,6 +173,7 @@ public:
     virtual int disk_status();
     virtual int disk_read(uint8_t* buffer, uint64_t sector, uint8_t count);
     virtual int disk_write(const uint8_t* buffer, uint64_t sector, uint8_t count);
+    virtual int disk_transfer(DiskRequest* const* run, int n);
     virtual int disk_sync();
     virtual uint64_t disk_sectors();
 
@@ -227,9 +228,9 @@ private:
     bool readData(char* buffer, int length);
     char writeData(const char* buffer, char token);
     bool readBlock(char* buffer, unsigned long long lba);
-    bool readBlocks(char* buffer, unsigned long long lba, int count);
+    bool readBlocks(DiskRequest* const* run, unsigned long long lba, int count);
     bool writeBlock(const char* buffer, unsigned long long lba);
-    bool writeBlocks(const char* buffer, unsigned long long lba, int count);
+    bool writeBlocks(DiskRequest* const* run, unsigned long long lba, int count);
 };
 
 #endif
@@ -0,0 +1,77 @@
+/* linked list items for the LPC17xx GPDMA controller
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* A GPDMA channel moves at most 4095 items per transfer. Longer jobs are
+ * split into a chain of linked list items, the controller loads the next
+ * item by itself when one is done, so the CPU only has to start the chain.
+ * This file does not touch any hardware and builds on a host compiler. */
+
+#ifndef GPDMA_LLI_H
+#define GPDMA_LLI_H
+
+#include <stdint.h>
+
+#define GPDMA_LLI_MAX_XFER      4095            // TransferSize field is 12 bit
+#define GPDMA_LLI_SWIDTH_16     (1UL << 18)     // source 16 bit
+#define GPDMA_LLI_DWIDTH_16     (1UL << 21)     // destination 16 bit
+#define GPDMA_LLI_SRC_INC       (1UL << 26)     // source address increment
+#define GPDMA_LLI_TC_IRQ        (1UL << 31)     // terminal count flag
+
+// number of items needed to move count transfers
+#define GPDMA_LLI_COUNT(count)  (((count) + GPDMA_LLI_MAX_XFER - 1) / GPDMA_LLI_MAX_XFER)
+
+/** one linked list item, layout is fixed by the hardware
+ *  the item has to be word aligned
+ */
+typedef struct {
+    uint32_t src;       // DMACCSrcAddr
+    uint32_t dst;       // DMACCDestAddr
+    uint32_t next;      // DMACCLLI, 0 ends the chain
+    uint32_t control;   // DMACCControl
+} gpdma_lli_t;
+
+/** build a chain moving count 16 bit words from memory to one peripheral register
+ *
+ * @param lli array for the chain
+ * @param max number of items in the array
+ * @param src source address
+ * @param src_inc 0 : send the same word count times (solid fill)
+ * @param dst address of the peripheral data register
+ * @param count number of 16 bit transfers
+ * @returns number of items used, 0 if count is 0 or the array is too small
+ *
+ * only the last item sets the terminal count flag, so the status bit
+ * shows the end of the whole chain
+ */
+static inline int gpdma_build_lli(gpdma_lli_t *lli, int max, uint32_t src, int src_inc,
+                                  uint32_t dst, uint32_t count)
+{
+    uint32_t chunk;
+    int n = 0;
+
+    if (count == 0 || GPDMA_LLI_COUNT(count) > (uint32_t)max) return(0);
+    while (count > 0) {
+        chunk = count > GPDMA_LLI_MAX_XFER ? GPDMA_LLI_MAX_XFER : count;
+        lli[n].src = src;
+        lli[n].dst = dst;
+        lli[n].next = 0;
+        lli[n].control = chunk | GPDMA_LLI_SWIDTH_16 | GPDMA_LLI_DWIDTH_16
+                         | (src_inc ? GPDMA_LLI_SRC_INC : 0);
+        if (n > 0) lli[n-1].next = (uint32_t)(uintptr_t)&lli[n];
+        if (src_inc) src += 2 * chunk;
+        count -= chunk;
+        n++;
+    }
+    lli[n-1].control |= GPDMA_LLI_TC_IRQ;
+    return(n);
+}
+
+#endif
@@ -18,6 +18,12 @@
 
 #include "mbed.h"
 #include "GraphicsDisplay.h"
+#if defined TARGET_LPC1768
+#include "GPDMA_LLI.h"
+
+// linked list items for a full screen fill with one DMA job
+#define DMA_FILL_LLI    GPDMA_LLI_COUNT(320 * 240)
+#endif
 
 #define RGB(r,g,b)  (((r&0xF8)<<8)|((g&0xFC)<<3)|((b&0xF8)>>3)) //5 red | 6 green | 5 blue
 
@@ -158,6 +164,36 @@
    *
    */    
   void fillrect(int x0, int y0, int x1, int y1, int colour);
+
+  #if defined TARGET_LPC1768
+  /** start to fill a rect with DMA and return at once
+   *
+   * @param x0,y0 top left corner
+   * @param x1,y1 down right corner
+   * @param color 16 bit color
+   * @returns token for fill_done() and fill_wait()
+   *
+   *   the whole rect is sent by one chain of DMA transfers, the CPU is free
+   *   until the next access to the display. Every command to the display
+   *   waits for a running fill first, so there is no need to call fill_wait()
+   *   before drawing. Call it before an other device uses the SPI bus.
+   *   fillrect(), cls(), hline() and vline() use this function.
+   */
+  unsigned int fillrect_async(int x0, int y0, int x1, int y1, int colour);
+
+  /** test if a DMA fill is done
+   *
+   * @param token returned by fillrect_async()
+   * @returns true if the DMA has sent all pixel
+   */
+  bool fill_done(unsigned int token);
+
+  /** wait for a DMA fill and release the SPI bus
+   *
+   * @param token returned by fillrect_async()
+   */
+  void fill_wait(unsigned int token);
+  #endif
     
   /** setup cursor position
    *
@@ -397,6 +433,18 @@ protected:
   virtual void spi_16(bool s);
   
   #endif  
+
+  #if defined TARGET_LPC1768
+  /** end a running DMA fill
+   *  waits for the DMA and the SPI, then releases cs
+   */
+  void fill_finish(void);
+
+  gpdma_lli_t _fill_lli[DMA_FILL_LLI];  // DMA chain of the running fill
+  uint16_t _fill_color;                 // DMA source, has to live until the fill is done
+  unsigned int _fill_token;             // token of the last fill
+  bool _fill_busy;                      // a fill is running or not finished
+  #endif
     
   unsigned char spi_port; 
   unsigned int orientation;
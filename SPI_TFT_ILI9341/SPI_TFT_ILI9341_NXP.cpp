@@ -49,6 +49,8 @@ SPI_TFT_ILI9341::SPI_TFT_ILI9341(PinName mosi, PinName miso, PinName sclk, PinNa
     frequency(10000000);         // 10 Mhz SPI clock : result 2 / 4 = 8
     orientation = 0;
     char_x = 0;
+    _fill_token = 0;
+    _fill_busy = false;
     if((int)_spi.spi == SPI_0) {      // test which SPI is in use
         spi_num = 0;
     }
@@ -124,6 +126,7 @@ void SPI_TFT_ILI9341::set_orientation(unsigned int o)
 // use fast command
 void SPI_TFT_ILI9341::wr_cmd(unsigned char cmd)
 {
+    fill_finish();     // a DMA fill can still use the SPI
     _dc = 0;
     _cs = 0;
     f_write(cmd);
@@ -446,49 +449,17 @@ void SPI_TFT_ILI9341::fillcircle(int x0, int y0, int r, int color)
 
 
 // optimized for speed
+// use DMA
 void SPI_TFT_ILI9341::hline(int x0, int x1, int y, int color)
 {
-    int w,j;
-    w = x1 - x0 + 1;
-    window(x0,y,w,1);
-    _dc = 0;
-    _cs = 0;
-    f_write(0x2C); // send pixel
-    spi_bsy();
-    _dc = 1;
-    spi_16(1);
-
-    for (j=0; j<w; j++) {
-        f_write(color);
-    }
-    spi_bsy();
-    spi_16(0);
-    _cs = 1;
-    WindowMax();
-    return;
+    fillrect_async(x0,y,x1,y,color);
 }
 
 // optimized for speed
+// use DMA
 void SPI_TFT_ILI9341::vline(int x, int y0, int y1, int color)
 {
-    int h,y;
-    h = y1 - y0 + 1;
-    window(x,y0,1,h);
-    _dc = 0;
-    _cs = 0;
-    f_write(0x2C); // send pixel
-    spi_bsy();
-    _dc = 1;
-    spi_16(1);
-    // switch to 16 bit Mode 3
-    for (y=0; y<h; y++) {
-        f_write(color);
-    }
-    spi_bsy();
-    spi_16(0);
-    _cs = 1;
-    WindowMax();
-    return;
+    fillrect_async(x,y0,x,y1,color);
 }
 
 
@@ -587,52 +558,77 @@ void SPI_TFT_ILI9341::rect(int x0, int y0, int x1, int y1, int color)
 // optimized for speed
 // use DMA
 void SPI_TFT_ILI9341::fillrect(int x0, int y0, int x1, int y1, int color)
+{
+    fillrect_async(x0,y0,x1,y1,color);
+}
+
+// the window makes the rect one continuous pixel stream,
+// so a single DMA chain sends the whole rect
+unsigned int SPI_TFT_ILI9341::fillrect_async(int x0, int y0, int x1, int y1, int color)
 {
     int h = y1 - y0 + 1;
     int w = x1 - x0 + 1;
-    int pixel = h * w;
-    unsigned int dma_count;
-    window(x0,y0,w,h);
-
-    wr_cmd(0x2C);  // send pixel
-    spi_16(1);
+    int n;
+    uint32_t dst;
 
-    LPC_GPDMACH0->DMACCSrcAddr = (uint32_t)&color;
+    if (w <= 0 || h <= 0) return(_fill_token);
+    window(x0,y0,w,h);    // waits for the last fill
 
     switch(spi_num) {       // decide which SPI is to use
         case (0):
-            LPC_GPDMACH0->DMACCDestAddr = (uint32_t)&LPC_SSP0->DR; // we send to SSP0
+            dst = (uint32_t)&LPC_SSP0->DR; // we send to SSP0
             LPC_SSP0->DMACR = 0x2;
             break;
-        case (1):
-            LPC_GPDMACH0->DMACCDestAddr = (uint32_t)&LPC_SSP1->DR; // we send to SSP1
+        default:
+            dst = (uint32_t)&LPC_SSP1->DR; // we send to SSP1
             LPC_SSP1->DMACR = 0x2;
             break;
     }
+    _fill_color = color;  // source of the DMA, no address increment
+    n = gpdma_build_lli(_fill_lli, DMA_FILL_LLI, (uint32_t)&_fill_color, 0, dst, w * h);
+    if (n == 0) {         // bigger than the screen
+        WindowMax();
+        return(_fill_token);
+    }
 
-    // start DMA
-    do {
-        if (pixel > 4095) {
-            dma_count = 4095;
-            pixel = pixel - 4095;
-        } else {
-            dma_count = pixel;
-            pixel = 0;
-        }
-        LPC_GPDMA->DMACIntTCClear = 0x1;
-        LPC_GPDMA->DMACIntErrClr = 0x1;
-        LPC_GPDMACH0->DMACCControl = dma_count | (1UL << 18) | (1UL << 21) | (1UL << 31) ; // 16 bit transfer , no address increment, interrupt
-        LPC_GPDMACH0->DMACCConfig  = DMA_CHANNEL_ENABLE | DMA_TRANSFER_TYPE_M2P | (spi_num ? DMA_DEST_SSP1_TX : DMA_DEST_SSP0_TX);
-        LPC_GPDMA->DMACSoftSReq = 0x1;   // DMA request
-        do {
-        } while ((LPC_GPDMA->DMACRawIntTCStat & 0x01) == 0); // DMA is running
-    } while (pixel > 0);
+    wr_cmd(0x2C);  // send pixel
+    spi_16(1);
 
+    // load the first item into the channel, the controller follows the chain
+    LPC_GPDMA->DMACIntTCClear = 0x1;
+    LPC_GPDMA->DMACIntErrClr = 0x1;
+    LPC_GPDMACH0->DMACCSrcAddr  = _fill_lli[0].src;
+    LPC_GPDMACH0->DMACCDestAddr = _fill_lli[0].dst;
+    LPC_GPDMACH0->DMACCLLI      = _fill_lli[0].next;
+    LPC_GPDMACH0->DMACCControl  = _fill_lli[0].control;
+    LPC_GPDMACH0->DMACCConfig   = DMA_CHANNEL_ENABLE | DMA_TRANSFER_TYPE_M2P | (spi_num ? DMA_DEST_SSP1_TX : DMA_DEST_SSP0_TX);
+    LPC_GPDMA->DMACSoftSReq = 0x1;   // DMA request
+    _fill_busy = true;
+    return(++_fill_token);
+}
+
+bool SPI_TFT_ILI9341::fill_done(unsigned int token)
+{
+    if (token != _fill_token || !_fill_busy) return(true);
+    return((LPC_GPDMACH0->DMACCConfig & DMA_CHANNEL_ENABLE) == 0);
+}
+
+void SPI_TFT_ILI9341::fill_wait(unsigned int token)
+{
+    if (token == _fill_token) fill_finish();
+}
+
+void SPI_TFT_ILI9341::fill_finish(void)
+{
+    if (!_fill_busy) return;
+    do {
+    } while (LPC_GPDMACH0->DMACCConfig & DMA_CHANNEL_ENABLE); // chain is running
+    _fill_busy = false;
+    LPC_GPDMACH0->DMACCLLI = 0;      // character() uses single transfers
     spi_bsy();    // wait for end of transfer
     spi_16(0);
     _cs = 1;
     WindowMax();
-    return;
 }
 
 void SPI_TFT_ILI9341::locate(int x, int y)
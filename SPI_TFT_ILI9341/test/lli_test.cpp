@@ -0,0 +1,104 @@
+/* Host test of the GPDMA linked list built for fillrect()
+ *
+ * Builds and runs on the host, without the mbed tree:
+ *
+ *   g++ -I.. lli_test.cpp -o lli_test && ./lli_test
+ *
+ * Builds the chain for solid fills of odd and full screen rectangles, the
+ * way fillrect() does, and walks it like the controller: item count, the
+ * next links, the transfer sizes adding up to the pixels, the terminal
+ * count flag on the last item only, and refusing what does not fit.
+ */
+#include "GPDMA_LLI.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define SCREEN      (320 * 240)
+#define MAX_LLI     GPDMA_LLI_COUNT(SCREEN)
+#define SSP_DR      0x40088008      // LPC_SSP0->DR
+#define COLOR_ADDR  0x10001000      // &_fill_color
+
+static int failures;
+
+static void check(bool ok, const char *what)
+{
+    printf("%s: %s\n", ok ? "ok" : "FAIL", what);
+    if (!ok)
+        failures++;
+}
+
+// Follows the chain from lli[0] like the GPDMA: returns the transfers moved,
+// or -1 if a link, an address or a flag is wrong
+static long walk(const gpdma_lli_t *lli, int n, int src_inc)
+{
+    uint32_t src = lli[0].src;
+    long moved = 0;
+
+    for (int i = 0; i < n; i++) {
+        uint32_t size = lli[i].control & 0xFFF;
+        bool last = i == n - 1;
+
+        if (size == 0 || (!last && size != GPDMA_LLI_MAX_XFER))
+            return -1;
+        if (lli[i].src != src || lli[i].dst != SSP_DR)
+            return -1;
+        if (lli[i].next != (last ? 0 : (uint32_t)(uintptr_t)&lli[i + 1]))
+            return -1;
+        if (((lli[i].control & GPDMA_LLI_TC_IRQ) != 0) != last)
+            return -1;
+        if ((lli[i].control & ~(0xFFFUL | GPDMA_LLI_TC_IRQ)) !=
+            (GPDMA_LLI_SWIDTH_16 | GPDMA_LLI_DWIDTH_16 | (src_inc ? GPDMA_LLI_SRC_INC : 0)))
+            return -1;
+        if (src_inc)
+            src += 2 * size;
+        moved += size;
+    }
+    return moved;
+}
+
+// fillrect(x0, y0, x1, y1) on the whole chain array
+static void fill(int x0, int y0, int x1, int y1)
+{
+    gpdma_lli_t lli[MAX_LLI + 1];
+    char what[80];
+    int w = x1 - x0 + 1;
+    int h = y1 - y0 + 1;
+    int n;
+
+    memset(lli, 0xAA, sizeof(lli));
+    n = gpdma_build_lli(lli, MAX_LLI, COLOR_ADDR, 0, SSP_DR, w * h);
+    snprintf(what, sizeof what, "fill %dx%d: %d items, %d pixels", w, h,
+             (int)GPDMA_LLI_COUNT(w * h), w * h);
+    check(n == (int)GPDMA_LLI_COUNT(w * h) && walk(lli, n, 0) == w * h &&
+          lli[n].src == 0xAAAAAAAA, what);
+}
+
+int main()
+{
+    gpdma_lli_t lli[MAX_LLI + 1];
+
+    check(MAX_LLI == 19, "a full screen needs 19 items");
+
+    fill(0, 0, 0, 0);           // one pixel
+    fill(10, 20, 12, 24);       // 3x5
+    fill(0, 0, 64, 62);         // 65x63 = 4095, one full item
+    fill(0, 0, 4095, 0);        // 4096, the last item moves one pixel
+    fill(1, 1, 319, 239);       // 319x239
+    fill(0, 0, 238, 318);       // 239x319, portrait
+    fill(0, 0, 319, 239);       // full screen
+
+    check(gpdma_build_lli(lli, MAX_LLI, COLOR_ADDR, 0, SSP_DR, 0) == 0, "nothing to fill");
+    check(gpdma_build_lli(lli, MAX_LLI, COLOR_ADDR, 0, SSP_DR, SCREEN + GPDMA_LLI_MAX_XFER) == 0,
+          "larger than the array");
+    check(gpdma_build_lli(lli, 2, COLOR_ADDR, 0, SSP_DR, 2 * GPDMA_LLI_MAX_XFER) == 2 &&
+          walk(lli, 2, 0) == 2 * GPDMA_LLI_MAX_XFER, "exactly fills a short array");
+
+    // a bitmap source moves on by the bytes of each item
+    int n = gpdma_build_lli(lli, MAX_LLI, COLOR_ADDR, 1, SSP_DR, 3 * GPDMA_LLI_MAX_XFER + 7);
+    check(n == 4 && walk(lli, n, 1) == 3 * GPDMA_LLI_MAX_XFER + 7 &&
+          lli[3].src == COLOR_ADDR + 6 * GPDMA_LLI_MAX_XFER, "incrementing source");
+
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
@@ -7,6 +7,7 @@ TLSConnection::TLSConnection():
     Socket(),
     Endpoint(),
     _is_connected(false),
+    _num_cipher_prefs(0),
     _ssl_ctx(),
     _ssl()
 {
@@ -28,6 +29,9 @@ bool TLSConnection::connect(const char *host)
     if(ssl_ctx_new(&_ssl_ctx, 0, SSL_DEFAULT_CLNT_SESS) != &_ssl_ctx)
         return false;
 
+    if(_num_cipher_prefs > 0)
+        ssl_ctx_set_cipher_prefs(&_ssl_ctx, _cipher_prefs, _num_cipher_prefs);
+
     _ssl.ssl_ctx = &_ssl_ctx;
 
     if(ssl_client_new(&_ssl, _sock_fd, NULL, 0) == NULL) {
@@ -44,6 +48,26 @@ bool TLSConnection::connect(const char *host)
     return true;
 }
 
+bool TLSConnection::set_cipher_preferences(const uint16_t *ciphers, int num_ciphers)
+{
+    if(ciphers == NULL) {
+        _num_cipher_prefs = 0;
+        return true;
+    }
+
+    if(num_ciphers <= 0 || num_ciphers > NUM_PROTOCOLS)
+        return false;
+
+    for(int i = 0; i < num_ciphers; ++i) {
+        if(get_cipher_info(ciphers[i]) == NULL)
+            return false;
+        _cipher_prefs[i] = ciphers[i];
+    }
+    _num_cipher_prefs = num_ciphers;
+
+    return true;
+}
+
 bool TLSConnection::is_connected(void)
 {
     return _is_connected;
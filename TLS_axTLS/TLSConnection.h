@@ -26,6 +26,17 @@ public :
     */
     bool connect(const char *host);
 
+    /** Restricts and orders the cipher suites offered in the
+        next handshakes (e.g. SSL_ECDHE_RSA_AES128_GCM_SHA256 for
+        forward secrecy). Call it before connect().
+
+        \param ciphers Cipher suite ids, most preferred first, or
+        NULL to go back to the compiled in list.
+        \param num_ciphers Number of entries in ciphers.
+        \return True if all the cipher suites are supported.
+    */
+    bool set_cipher_preferences(const uint16_t *ciphers, int num_ciphers);
+
     /** Indicates whether a connection is established or not.
 
         \return true if a connection is established, otherwise
@@ -64,6 +75,9 @@ private :
 
     bool _is_connected;
 
+    uint16_t _cipher_prefs[NUM_PROTOCOLS];
+    int _num_cipher_prefs;
+
     SSL_CTX _ssl_ctx;
     SSL _ssl;
 };
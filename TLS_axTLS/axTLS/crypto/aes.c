@@ -350,6 +350,28 @@ void AES_cbc_decrypt(AES_CTX *ctx, const uint8_t *msg, uint8_t *out, int length)
 
 }
 
+/**
+ * Encrypt a single block (16 bytes) of data. This is the building block for
+ * the counter mode (GCM) ciphers.
+ */
+void AES_ecb_encrypt(const AES_CTX *ctx, const uint8_t *in, uint8_t *out)
+{
+    int i;
+    uint32_t data[4];
+
+    memcpy(data, in, AES_BLOCKSIZE);
+
+    for (i = 0; i < 4; i++)
+        data[i] = ntohl(data[i]);
+
+    AES_encrypt(ctx, data);
+
+    for (i = 0; i < 4; i++)
+        data[i] = htonl(data[i]);
+
+    memcpy(out, data, AES_BLOCKSIZE);
+}
+
 /**
  * Encrypt a single block (16 bytes) of data
  */
@@ -93,6 +93,34 @@ void AES_cbc_encrypt(AES_CTX *ctx, const uint8_t *msg,
         uint8_t *out, int length);
 void AES_cbc_decrypt(AES_CTX *ks, const uint8_t *in, uint8_t *out, int length);
 void AES_convert_key(AES_CTX *ctx);
+void AES_ecb_encrypt(const AES_CTX *ctx, const uint8_t *in, uint8_t *out);
+
+/**************************************************************************
+ * AES-GCM declarations 
+ **************************************************************************/
+
+#define GCM_IV_SIZE             12
+#define GCM_TAG_SIZE            16
+
+typedef struct
+{
+    AES_CTX aes_ctx;
+    uint64_t HL[16];        /* precalculated GHASH table (low halves) */
+    uint64_t HH[16];        /* precalculated GHASH table (high halves) */
+    uint8_t y[16];          /* counter block */
+    uint8_t ek0[16];        /* E(K, Y0) - used to mask the tag */
+    uint8_t ectr[16];       /* current key stream block */
+    uint8_t buf[16];        /* GHASH accumulator */
+    uint32_t add_len;       /* bytes of additional data */
+    uint32_t len;           /* bytes of en/decrypted data */
+} GCM_CTX;
+
+void GCM_set_key(GCM_CTX *ctx, const uint8_t *key, AES_MODE mode);
+void GCM_starts(GCM_CTX *ctx, const uint8_t *iv, 
+        const uint8_t *add, int add_len);
+void GCM_encrypt(GCM_CTX *ctx, const uint8_t *in, uint8_t *out, int length);
+void GCM_decrypt(GCM_CTX *ctx, const uint8_t *in, uint8_t *out, int length);
+void GCM_finish(GCM_CTX *ctx, uint8_t *tag);
 
 /**************************************************************************
  * RC4 declarations 
@@ -129,6 +157,23 @@ void SHA1_Init(SHA1_CTX *);
 void SHA1_Update(SHA1_CTX *, const uint8_t * msg, int len);
 void SHA1_Final(uint8_t *digest, SHA1_CTX *);
 
+/**************************************************************************
+ * SHA256 declarations 
+ **************************************************************************/
+
+#define SHA256_SIZE   32
+
+typedef struct
+{
+    uint32_t total[2];
+    uint32_t state[8];
+    uint8_t buffer[64];
+} SHA256_CTX;
+
+void SHA256_Init(SHA256_CTX *c);
+void SHA256_Update(SHA256_CTX *, const uint8_t *input, int len);
+void SHA256_Final(uint8_t *digest, SHA256_CTX *);
+
 /**************************************************************************
  * MD2 declarations 
  **************************************************************************/
@@ -171,6 +216,18 @@ void hmac_md5(const uint8_t *msg, int length, const uint8_t *key,
         int key_len, uint8_t *digest);
 void hmac_sha1(const uint8_t *msg, int length, const uint8_t *key, 
         int key_len, uint8_t *digest);
+void hmac_sha256(const uint8_t *msg, int length, const uint8_t *key, 
+        int key_len, uint8_t *digest);
+
+/**************************************************************************
+ * X25519 (Curve25519 Diffie-Hellman) declarations 
+ **************************************************************************/
+
+#define X25519_SIZE     32
+
+void X25519_scalarmult(uint8_t *out, const uint8_t *scalar, 
+        const uint8_t *point);
+void X25519_base(uint8_t *out, const uint8_t *scalar);
 
 /**************************************************************************
  * RSA declarations 
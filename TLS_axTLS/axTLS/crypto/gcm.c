@@ -0,0 +1,318 @@
+/*
+ * Copyright (c) 2007, Cameron Rich
+ * 
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, 
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice, 
+ *   this list of conditions and the following disclaimer in the documentation 
+ *   and/or other materials provided with the distribution.
+ * * Neither the name of the axTLS project nor the names of its contributors 
+ *   may be used to endorse or promote products derived from this software 
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * AES-GCM as defined in NIST SP 800-38D, for use by the TLSv1.2 AEAD cipher
+ * suites (RFC 5288). 
+ *
+ * GHASH uses Shoup's 4-bit table method: 16 precalculated multiples of H 
+ * (256 bytes) turn each GF(2^128) multiply into 32 table lookups and shifts.
+ * The LPC17xx has no data cache so the table lookups are constant time.
+ */
+
+#include <string.h>
+#include "os_port.h"
+#include "crypto.h"
+
+#define GET_UINT32(n,b,i)                       \
+{                                               \
+    (n) = ((uint32_t) (b)[(i)    ] << 24)       \
+        | ((uint32_t) (b)[(i) + 1] << 16)       \
+        | ((uint32_t) (b)[(i) + 2] <<  8)       \
+        | ((uint32_t) (b)[(i) + 3]      );      \
+}
+
+#define PUT_UINT32(n,b,i)                       \
+{                                               \
+    (b)[(i)    ] = (uint8_t) ((n) >> 24);       \
+    (b)[(i) + 1] = (uint8_t) ((n) >> 16);       \
+    (b)[(i) + 2] = (uint8_t) ((n) >>  8);       \
+    (b)[(i) + 3] = (uint8_t) ((n)      );       \
+}
+
+/* reduction table for the 4 bits shifted out of the low end */
+static const uint16_t last4[16] =
+{
+    0x0000, 0x1c20, 0x3840, 0x2460,
+    0x7080, 0x6ca0, 0x48c0, 0x54e0,
+    0xe100, 0xfd20, 0xd940, 0xc560,
+    0x9180, 0x8da0, 0xa9c0, 0xb5e0
+};
+
+/**
+ * Precalculate the multiples of H = E(K, 0^128).
+ */
+static void gcm_gen_table(GCM_CTX *ctx)
+{
+    int i, j;
+    uint32_t hi, lo;
+    uint64_t vh, vl;
+    uint8_t h[16];
+
+    memset(h, 0, sizeof(h));
+    AES_ecb_encrypt(&ctx->aes_ctx, h, h);
+
+    GET_UINT32(hi, h,  0);
+    GET_UINT32(lo, h,  4);
+    vh = (uint64_t)hi << 32 | lo;
+
+    GET_UINT32(hi, h,  8);
+    GET_UINT32(lo, h, 12);
+    vl = (uint64_t)hi << 32 | lo;
+
+    /* 8 = 1000 corresponds to 1 in GF(2^128) */
+    ctx->HL[8] = vl;
+    ctx->HH[8] = vh;
+    ctx->HH[0] = 0;
+    ctx->HL[0] = 0;
+
+    for (i = 4; i > 0; i >>= 1)
+    {
+        uint32_t T = (vl & 1) * 0xe1000000U;
+        vl  = (vh << 63) | (vl >> 1);
+        vh  = (vh >> 1) ^ ((uint64_t)T << 32);
+        ctx->HL[i] = vl;
+        ctx->HH[i] = vh;
+    }
+
+    for (i = 2; i <= 8; i *= 2)
+    {
+        uint64_t *HiL = ctx->HL + i, *HiH = ctx->HH + i;
+        vh = *HiH;
+        vl = *HiL;
+
+        for (j = 1; j < i; j++)
+        {
+            HiH[j] = vh ^ ctx->HH[j];
+            HiL[j] = vl ^ ctx->HL[j];
+        }
+    }
+}
+
+/**
+ * Multiply x by H in GF(2^128) - the result goes back into x.
+ */
+static void gcm_mult(const GCM_CTX *ctx, uint8_t x[16])
+{
+    int i;
+    uint8_t lo, hi, rem;
+    uint64_t zh, zl;
+
+    lo = x[15] & 0xf;
+
+    zh = ctx->HH[lo];
+    zl = ctx->HL[lo];
+
+    for (i = 15; i >= 0; i--)
+    {
+        lo = x[i] & 0xf;
+        hi = x[i] >> 4;
+
+        if (i != 15)
+        {
+            rem = (uint8_t)zl & 0xf;
+            zl = (zh << 60) | (zl >> 4);
+            zh = (zh >> 4);
+            zh ^= (uint64_t)last4[rem] << 48;
+            zh ^= ctx->HH[lo];
+            zl ^= ctx->HL[lo];
+        }
+
+        rem = (uint8_t)zl & 0xf;
+        zl = (zh << 60) | (zl >> 4);
+        zh = (zh >> 4);
+        zh ^= (uint64_t)last4[rem] << 48;
+        zh ^= ctx->HH[hi];
+        zl ^= ctx->HL[hi];
+    }
+
+    PUT_UINT32(zh >> 32, x, 0);
+    PUT_UINT32(zh, x, 4);
+    PUT_UINT32(zl >> 32, x, 8);
+    PUT_UINT32(zl, x, 12);
+}
+
+/**
+ * Increment the 32 bit counter at the end of the counter block and generate
+ * the next block of key stream.
+ */
+static void gcm_next_block(GCM_CTX *ctx)
+{
+    int i;
+
+    for (i = 16; i > 12; i--)
+    {
+        if (++ctx->y[i-1] != 0)
+            break;
+    }
+
+    AES_ecb_encrypt(&ctx->aes_ctx, ctx->y, ctx->ectr);
+}
+
+/**
+ * Run the en/decryption. The cipher text is always what gets authenticated.
+ * Processing is done a byte at a time within a block, so a record may be fed
+ * in arbitrarily sized pieces. out may equal in, or be below it.
+ */
+static void gcm_crypt(GCM_CTX *ctx, const uint8_t *in, uint8_t *out, 
+        int length, int is_decrypt)
+{
+    int pos = ctx->len & 0xf;
+
+    ctx->len += length;
+
+    while (length > 0)
+    {
+        uint8_t c;
+
+        if (pos == 0)
+            gcm_next_block(ctx);
+
+        /* the fast path - a whole aligned block */
+        if (pos == 0 && length >= 16)
+        {
+            int i;
+            uint8_t tmp[16];
+
+            memcpy(tmp, in, 16);
+
+            for (i = 0; i < 16; i++)
+            {
+                c = tmp[i] ^ ctx->ectr[i];
+                ctx->buf[i] ^= is_decrypt ? tmp[i] : c;
+                tmp[i] = c;
+            }
+
+            memcpy(out, tmp, 16);
+            gcm_mult(ctx, ctx->buf);
+            in += 16;
+            out += 16;
+            length -= 16;
+            continue;
+        }
+
+        c = *in++;
+        ctx->buf[pos] ^= is_decrypt ? c : (c ^ ctx->ectr[pos]);
+        *out++ = c ^ ctx->ectr[pos];
+        length--;
+
+        if (++pos == 16)
+        {
+            gcm_mult(ctx, ctx->buf);
+            pos = 0;
+        }
+    }
+}
+
+/**
+ * Set up the AES key and the GHASH tables.
+ */
+void GCM_set_key(GCM_CTX *ctx, const uint8_t *key, AES_MODE mode)
+{
+    uint8_t iv[AES_IV_SIZE];
+
+    memset(iv, 0, sizeof(iv));
+    AES_set_key(&ctx->aes_ctx, key, iv, mode);
+    gcm_gen_table(ctx);
+}
+
+/**
+ * Start a new message with a 96 bit IV and authenticate the additional data.
+ */
+void GCM_starts(GCM_CTX *ctx, const uint8_t *iv, 
+        const uint8_t *add, int add_len)
+{
+    int i;
+
+    memcpy(ctx->y, iv, GCM_IV_SIZE);
+    ctx->y[12] = 0;
+    ctx->y[13] = 0;
+    ctx->y[14] = 0;
+    ctx->y[15] = 1;
+    AES_ecb_encrypt(&ctx->aes_ctx, ctx->y, ctx->ek0);
+
+    memset(ctx->buf, 0, sizeof(ctx->buf));
+    ctx->add_len = add_len;
+    ctx->len = 0;
+
+    while (add_len > 0)
+    {
+        int use_len = (add_len < 16) ? add_len : 16;
+
+        for (i = 0; i < use_len; i++)
+            ctx->buf[i] ^= add[i];
+
+        gcm_mult(ctx, ctx->buf);
+        add_len -= use_len;
+        add += use_len;
+    }
+}
+
+/**
+ * Encrypt some more of the message.
+ */
+void GCM_encrypt(GCM_CTX *ctx, const uint8_t *in, uint8_t *out, int length)
+{
+    gcm_crypt(ctx, in, out, length, 0);
+}
+
+/**
+ * Decrypt some more of the message.
+ */
+void GCM_decrypt(GCM_CTX *ctx, const uint8_t *in, uint8_t *out, int length)
+{
+    gcm_crypt(ctx, in, out, length, 1);
+}
+
+/**
+ * Finish off the message and generate the 128 bit authentication tag.
+ */
+void GCM_finish(GCM_CTX *ctx, uint8_t *tag)
+{
+    int i;
+    uint8_t len_block[16];
+
+    if (ctx->len & 0xf)     /* flush the partial block */
+        gcm_mult(ctx, ctx->buf);
+
+    /* lengths are in bits */
+    PUT_UINT32(ctx->add_len >> 29, len_block, 0);
+    PUT_UINT32(ctx->add_len << 3, len_block, 4);
+    PUT_UINT32(ctx->len >> 29, len_block, 8);
+    PUT_UINT32(ctx->len << 3, len_block, 12);
+
+    for (i = 0; i < 16; i++)
+        ctx->buf[i] ^= len_block[i];
+
+    gcm_mult(ctx, ctx->buf);
+
+    for (i = 0; i < GCM_TAG_SIZE; i++)
+        tag[i] = ctx->ek0[i] ^ ctx->buf[i];
+}
@@ -0,0 +1,432 @@
+/*
+ * Copyright (c) 2007, Cameron Rich
+ * 
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, 
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice, 
+ *   this list of conditions and the following disclaimer in the documentation 
+ *   and/or other materials provided with the distribution.
+ * * Neither the name of the axTLS project nor the names of its contributors 
+ *   may be used to endorse or promote products derived from this software 
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * X25519 Diffie-Hellman (RFC 7748) for the ECDHE key exchange.
+ *
+ * Field elements mod 2^255-19 are held as ten signed 32 bit limbs of 
+ * alternately 26 and 25 bits (radix 2^25.5), so that every partial product
+ * is a single 32x32->64 bit multiply (SMLAL on the Cortex-M3) and a full
+ * multiplication fits in 64 bit accumulators without intermediate carries.
+ *
+ * Everything here is constant time: there are no branches or table lookups
+ * that depend on secret data.
+ */
+
+#include <string.h>
+#include "os_port.h"
+#include "crypto.h"
+
+typedef int32_t fe[10];
+
+static const uint8_t x25519_basepoint[X25519_SIZE] = { 9 };
+
+static uint64_t load_3(const uint8_t *in)
+{
+    return (uint64_t)in[0] | ((uint64_t)in[1] << 8) | ((uint64_t)in[2] << 16);
+}
+
+static uint64_t load_4(const uint8_t *in)
+{
+    return (uint64_t)in[0] | ((uint64_t)in[1] << 8) | 
+            ((uint64_t)in[2] << 16) | ((uint64_t)in[3] << 24);
+}
+
+static void fe_0(fe h)
+{
+    memset(h, 0, sizeof(fe));
+}
+
+static void fe_1(fe h)
+{
+    memset(h, 0, sizeof(fe));
+    h[0] = 1;
+}
+
+static void fe_copy(fe h, const fe f)
+{
+    memcpy(h, f, sizeof(fe));
+}
+
+static void fe_add(fe h, const fe f, const fe g)
+{
+    int i;
+
+    for (i = 0; i < 10; i++)
+        h[i] = f[i] + g[i];
+}
+
+static void fe_sub(fe h, const fe f, const fe g)
+{
+    int i;
+
+    for (i = 0; i < 10; i++)
+        h[i] = f[i] - g[i];
+}
+
+/**
+ * Swap f and g if b == 1, leave them alone if b == 0 - without branching.
+ */
+static void fe_cswap(fe f, fe g, uint32_t b)
+{
+    int i;
+    int32_t mask = -(int32_t)b;
+
+    for (i = 0; i < 10; i++)
+    {
+        int32_t x = (f[i] ^ g[i]) & mask;
+        f[i] ^= x;
+        g[i] ^= x;
+    }
+}
+
+/**
+ * Propagate the carries through 64 bit limbs and reduce back down to the 
+ * 26/25 bit representation. 
+ */
+static void fe_carry(fe h, int64_t t[10])
+{
+    int64_t c;
+
+#define CARRY26(i)  c = (t[i] + ((int64_t)1 << 25)) >> 26; \
+                    t[i+1] += c; t[i] -= c * ((int64_t)1 << 26);
+#define CARRY25(i)  c = (t[i] + ((int64_t)1 << 24)) >> 25; \
+                    t[i+1] += c; t[i] -= c * ((int64_t)1 << 25);
+
+    CARRY26(0); CARRY26(4);
+    CARRY25(1); CARRY25(5);
+    CARRY26(2); CARRY26(6);
+    CARRY25(3); CARRY25(7);
+    CARRY26(4); CARRY26(8);
+
+    /* the top limb wraps around to the bottom as 2^255 = 19 mod p */
+    c = (t[9] + ((int64_t)1 << 24)) >> 25;
+    t[0] += c * 19;
+    t[9] -= c * ((int64_t)1 << 25);
+
+    CARRY26(0);
+
+#undef CARRY26
+#undef CARRY25
+
+    h[0] = (int32_t)t[0]; h[1] = (int32_t)t[1];
+    h[2] = (int32_t)t[2]; h[3] = (int32_t)t[3];
+    h[4] = (int32_t)t[4]; h[5] = (int32_t)t[5];
+    h[6] = (int32_t)t[6]; h[7] = (int32_t)t[7];
+    h[8] = (int32_t)t[8]; h[9] = (int32_t)t[9];
+}
+
+/**
+ * h = f * g. Odd limbs sit half a bit high, so the product of two odd limbs
+ * is doubled; anything wrapping past limb 9 picks up a factor of 19.
+ */
+static void fe_mul(fe h, const fe f, const fe g)
+{
+    int i, j;
+    int32_t f2[10], g19[10];
+    int64_t t[10];
+
+    for (i = 0; i < 10; i++)
+    {
+        f2[i] = (i & 1) ? 2*f[i] : f[i];
+        g19[i] = 19*g[i];
+        t[i] = 0;
+    }
+
+    for (i = 0; i < 10; i++)
+    {
+        const int32_t fi = f[i];
+        const int32_t fi2 = f2[i];
+
+        for (j = 0; j < 10 - i; j++)
+            t[i+j] += (int64_t)((j & 1) ? fi2 : fi) * g[j];
+
+        for (; j < 10; j++)
+            t[i+j-10] += (int64_t)((j & 1) ? fi2 : fi) * g19[j];
+    }
+
+    fe_carry(h, t);
+}
+
+/**
+ * h = f^2. Uses the symmetry of the cross products to do about half of the 
+ * multiplies of fe_mul().
+ */
+static void fe_sq(fe h, const fe f)
+{
+    int i, j;
+    int64_t t[10];
+
+    for (i = 0; i < 10; i++)
+        t[i] = 0;
+
+    for (i = 0; i < 10; i++)
+    {
+        /* the square term */
+        int64_t m = (int64_t)f[i] * f[i];
+
+        if (i & 1)
+            m *= 2;
+
+        if (2*i >= 10)
+            t[2*i-10] += m * 19;
+        else
+            t[2*i] += m;
+
+        /* the cross terms appear twice */
+        for (j = i + 1; j < 10; j++)
+        {
+            m = (int64_t)f[i] * (2*f[j]);
+
+            if (i & j & 1)
+                m *= 2;
+
+            if (i + j >= 10)
+                t[i+j-10] += m * 19;
+            else
+                t[i+j] += m;
+        }
+    }
+
+    fe_carry(h, t);
+}
+
+/**
+ * h = f * 121665 (the (A-2)/4 curve constant).
+ */
+static void fe_mul121665(fe h, const fe f)
+{
+    int i;
+    int64_t t[10];
+
+    for (i = 0; i < 10; i++)
+        t[i] = (int64_t)f[i] * 121665;
+
+    fe_carry(h, t);
+}
+
+/**
+ * Load a little endian 255 bit number. The top bit is ignored (RFC 7748).
+ */
+static void fe_frombytes(fe h, const uint8_t *s)
+{
+    int64_t t[10];
+
+    t[0] = load_4(s);
+    t[1] = load_3(s + 4) << 6;
+    t[2] = load_3(s + 7) << 5;
+    t[3] = load_3(s + 10) << 3;
+    t[4] = load_3(s + 13) << 2;
+    t[5] = load_4(s + 16);
+    t[6] = load_3(s + 20) << 7;
+    t[7] = load_3(s + 23) << 5;
+    t[8] = load_3(s + 26) << 4;
+    t[9] = (load_3(s + 29) & 0x7fffff) << 2;
+    fe_carry(h, t);
+}
+
+/**
+ * Write out the fully reduced little endian representation.
+ */
+static void fe_tobytes(uint8_t *s, const fe f)
+{
+    int32_t h[10];
+    int32_t q, c;
+    int i;
+
+    fe_copy(h, f);
+
+    /* q = floor(h / p), which is either 0 or 1 */
+    q = (19 * h[9] + ((int32_t)1 << 24)) >> 25;
+
+    for (i = 0; i < 10; i++)
+        q = (h[i] + q) >> ((i & 1) ? 25 : 26);
+
+    /* h - q*p, computed as h + 19q - q*2^255 */
+    h[0] += 19 * q;
+
+    for (i = 0; i < 9; i++)
+    {
+        int bits = (i & 1) ? 25 : 26;
+        c = h[i] >> bits;
+        h[i+1] += c;
+        h[i] -= c * ((int32_t)1 << bits);
+    }
+
+    c = h[9] >> 25;
+    h[9] -= c * ((int32_t)1 << 25);
+
+    s[0] = h[0] >> 0;
+    s[1] = h[0] >> 8;
+    s[2] = h[0] >> 16;
+    s[3] = (h[0] >> 24) | (h[1] << 2);
+    s[4] = h[1] >> 6;
+    s[5] = h[1] >> 14;
+    s[6] = (h[1] >> 22) | (h[2] << 3);
+    s[7] = h[2] >> 5;
+    s[8] = h[2] >> 13;
+    s[9] = (h[2] >> 21) | (h[3] << 5);
+    s[10] = h[3] >> 3;
+    s[11] = h[3] >> 11;
+    s[12] = (h[3] >> 19) | (h[4] << 6);
+    s[13] = h[4] >> 2;
+    s[14] = h[4] >> 10;
+    s[15] = h[4] >> 18;
+    s[16] = h[5] >> 0;
+    s[17] = h[5] >> 8;
+    s[18] = h[5] >> 16;
+    s[19] = (h[5] >> 24) | (h[6] << 1);
+    s[20] = h[6] >> 7;
+    s[21] = h[6] >> 15;
+    s[22] = (h[6] >> 23) | (h[7] << 3);
+    s[23] = h[7] >> 5;
+    s[24] = h[7] >> 13;
+    s[25] = (h[7] >> 21) | (h[8] << 4);
+    s[26] = h[8] >> 4;
+    s[27] = h[8] >> 12;
+    s[28] = (h[8] >> 20) | (h[9] << 6);
+    s[29] = h[9] >> 2;
+    s[30] = h[9] >> 10;
+    s[31] = h[9] >> 18;
+}
+
+/**
+ * Square n times.
+ */
+static void fe_sqn(fe h, const fe f, int n)
+{
+    fe_sq(h, f);
+
+    while (--n > 0)
+        fe_sq(h, h);
+}
+
+/**
+ * out = z^(p-2) = 1/z, using a fixed addition chain (254 squares and 11
+ * multiplies).
+ */
+static void fe_invert(fe out, const fe z)
+{
+    fe t0, t1, t2, t3;
+
+    fe_sq(t0, z);                   /* 2 */
+    fe_sqn(t1, t0, 2);              /* 8 */
+    fe_mul(t1, z, t1);              /* 9 */
+    fe_mul(t0, t0, t1);             /* 11 */
+    fe_sq(t2, t0);                  /* 22 */
+    fe_mul(t1, t1, t2);             /* 2^5 - 1 */
+    fe_sqn(t2, t1, 5);
+    fe_mul(t1, t2, t1);             /* 2^10 - 1 */
+    fe_sqn(t2, t1, 10);
+    fe_mul(t2, t2, t1);             /* 2^20 - 1 */
+    fe_sqn(t3, t2, 20);
+    fe_mul(t2, t3, t2);             /* 2^40 - 1 */
+    fe_sqn(t2, t2, 10);
+    fe_mul(t1, t2, t1);             /* 2^50 - 1 */
+    fe_sqn(t2, t1, 50);
+    fe_mul(t2, t2, t1);             /* 2^100 - 1 */
+    fe_sqn(t3, t2, 100);
+    fe_mul(t2, t3, t2);             /* 2^200 - 1 */
+    fe_sqn(t2, t2, 50);
+    fe_mul(t1, t2, t1);             /* 2^250 - 1 */
+    fe_sqn(t1, t1, 5);              /* 2^255 - 32 */
+    fe_mul(out, t1, t0);            /* 2^255 - 21 */
+}
+
+/**
+ * Calculate out = scalar * point using the Montgomery ladder (RFC 7748 
+ * section 5). The scalar is clamped here so the caller can just pass 32 
+ * random bytes.
+ */
+void X25519_scalarmult(uint8_t *out, const uint8_t *scalar, 
+        const uint8_t *point)
+{
+    uint8_t e[X25519_SIZE];
+    fe x1, x2, z2, x3, z3, a, aa, b, bb, ee, c, d, da, cb;
+    uint32_t swap = 0;
+    int t;
+
+    memcpy(e, scalar, X25519_SIZE);
+    e[0] &= 248;
+    e[31] &= 127;
+    e[31] |= 64;
+
+    fe_frombytes(x1, point);
+    fe_1(x2);
+    fe_0(z2);
+    fe_copy(x3, x1);
+    fe_1(z3);
+
+    for (t = 254; t >= 0; t--)
+    {
+        uint32_t k_t = (e[t >> 3] >> (t & 7)) & 1;
+
+        swap ^= k_t;
+        fe_cswap(x2, x3, swap);
+        fe_cswap(z2, z3, swap);
+        swap = k_t;
+
+        fe_add(a, x2, z2);
+        fe_sq(aa, a);
+        fe_sub(b, x2, z2);
+        fe_sq(bb, b);
+        fe_sub(ee, aa, bb);
+        fe_add(c, x3, z3);
+        fe_sub(d, x3, z3);
+        fe_mul(da, d, a);
+        fe_mul(cb, c, b);
+        fe_add(x3, da, cb);
+        fe_sq(x3, x3);
+        fe_sub(z3, da, cb);
+        fe_sq(z3, z3);
+        fe_mul(z3, x1, z3);
+        fe_mul(x2, aa, bb);
+        fe_mul121665(z2, ee);
+        fe_add(z2, aa, z2);
+        fe_mul(z2, ee, z2);
+    }
+
+    fe_cswap(x2, x3, swap);
+    fe_cswap(z2, z3, swap);
+
+    fe_invert(z2, z2);
+    fe_mul(x2, x2, z2);
+    fe_tobytes(out, x2);
+
+    memset(e, 0, sizeof(e));
+}
+
+/**
+ * Calculate the public value for a private scalar.
+ */
+void X25519_base(uint8_t *out, const uint8_t *scalar)
+{
+    X25519_scalarmult(out, scalar, x25519_basepoint);
+}
@@ -37,6 +37,7 @@
  * - The TLSv1 SSL client/server protocol
  * - No requirement to use any openssl libraries.
  * - A choice between AES block (128/256 bit) and RC4 (128 bit) stream ciphers.
+ * - ECDHE (X25519) key exchange with AES128-GCM for TLSv1.2 servers.
  * - RSA encryption/decryption with variable sized keys (up to 4096 bits).
  * - Certificate chaining and peer authentication.
  * - Session resumption, session renegotiation.
@@ -129,6 +130,7 @@ extern "C" {
 #define SSL_AES256_SHA                          0x35
 #define SSL_RC4_128_SHA                         0x05
 #define SSL_RC4_128_MD5                         0x04
+#define SSL_ECDHE_RSA_AES128_GCM_SHA256         0xc02f
 
 /* build mode ids' */
 #define SSL_BUILD_SKELETON_MODE                 0x01
@@ -217,6 +219,23 @@ EXP_FUNC SSL_CTX * STDCALL ssl_ctx_new(SSL_CTX *ssl_ctx, uint32_t options, int n
  */
 EXP_FUNC void STDCALL ssl_ctx_free(SSL_CTX *ssl_ctx);
 
+/**
+ * @brief (client only) Set the cipher suites offered in the client hello.
+ *
+ * By default the compile time list (ssl_prot_prefs) is offered. The server
+ * normally honours the client's order, so put the preferred cipher first.
+ * Offering SSL_ECDHE_RSA_AES128_GCM_SHA256 also offers TLSv1.2 with the
+ * X25519 curve, which makes for a much quicker handshake than RSA key 
+ * exchange.
+ * @param ssl_ctx [in] The client context.
+ * @param ciphers [in] The cipher ids (SSL_AES128_SHA etc), most preferred 
+ * first. A NULL list restores the defaults.
+ * @param num_ciphers [in] The number of entries in ciphers.
+ * @return SSL_OK, or SSL_ERROR_NO_CIPHER if a cipher is not supported.
+ */
+EXP_FUNC int STDCALL ssl_ctx_set_cipher_prefs(SSL_CTX *ssl_ctx, 
+        const uint16_t *ciphers, int num_ciphers);
+
 /**
  * @brief (server only) Establish a new SSL connection to an SSL client.
  *
@@ -327,8 +346,9 @@ EXP_FUNC uint8_t STDCALL ssl_get_session_id_size(const SSL *ssl);
  * - SSL_AES256_SHA (0x35)
  * - SSL_RC4_128_SHA (0x05)
  * - SSL_RC4_128_MD5 (0x04)
+ * - SSL_ECDHE_RSA_AES128_GCM_SHA256 (0xc02f)
  */
-EXP_FUNC uint8_t STDCALL ssl_get_cipher_id(const SSL *ssl);
+EXP_FUNC uint16_t STDCALL ssl_get_cipher_id(const SSL *ssl);
 
 /**
  * @brief Return the status of the handshake.
@@ -60,24 +60,28 @@ static int set_key_block(SSL *ssl, int is_write);
 static int verify_digest(SSL *ssl, int mode, const uint8_t *buf, int read_len);
 static void *crypt_new(SSL *ssl, uint8_t *key, uint8_t *iv, int is_decrypt);
 static int send_raw_packet(SSL *ssl, uint8_t protocol);
+static void aead_starts(SSL *ssl, AEAD_CTX *aead_ctx, const uint8_t *seq,
+        const uint8_t *explicit_nonce, uint8_t protocol, int plain_len);
+static int aead_verify(SSL *ssl, const uint8_t *tag);
+static int aead_decrypt(SSL *ssl, uint8_t *buf, int len);
 
 /**
  * The server will pick the cipher based on the order that the order that the
  * ciphers are listed. This order is defined at compile time.
  */
 #ifdef CONFIG_SSL_SKELETON_MODE
-const uint8_t ssl_prot_prefs[NUM_PROTOCOLS] = 
+const uint16_t ssl_prot_prefs[NUM_PROTOCOLS] = 
 { SSL_RC4_128_SHA };
 #else
 static void session_free(SSL_SESSION *ssl_sessions[], int sess_index);
 
-const uint8_t ssl_prot_prefs[NUM_PROTOCOLS] = 
+const uint16_t ssl_prot_prefs[NUM_PROTOCOLS] = 
 #ifdef CONFIG_SSL_PROT_LOW                  /* low security, fast speed */
-{ SSL_RC4_128_SHA , SSL_AES128_SHA /*, SSL_AES256_SHA, SSL_RC4_128_MD5*/ };
+{ SSL_ECDHE_RSA_AES128_GCM_SHA256, SSL_RC4_128_SHA , SSL_AES128_SHA /*, SSL_AES256_SHA, SSL_RC4_128_MD5*/ };
 #elif CONFIG_SSL_PROT_MEDIUM                /* medium security, medium speed */
-{ SSL_RC4_128_SHA SSL_AES128_SHA, SSL_AES256_SHA, SSL_RC4_128_SHA, SSL_RC4_128_MD5*/ };    
+{ SSL_ECDHE_RSA_AES128_GCM_SHA256, SSL_RC4_128_SHA SSL_AES128_SHA, SSL_AES256_SHA, SSL_RC4_128_SHA, SSL_RC4_128_MD5*/ };    
 #else /* CONFIG_SSL_PROT_HIGH */            /* high security, low speed */
-{ SSL_RC4_128_SHA SSL_AES256_SHA, SSL_AES128_SHA, SSL_RC4_128_SHA, SSL_RC4_128_MD5*/ };
+{ SSL_ECDHE_RSA_AES128_GCM_SHA256, SSL_RC4_128_SHA SSL_AES256_SHA, SSL_AES128_SHA, SSL_RC4_128_SHA, SSL_RC4_128_MD5*/ };
 #endif
 #endif /* CONFIG_SSL_SKELETON_MODE */
 
@@ -96,7 +100,9 @@ static const cipher_info_t cipher_info[NUM_PROTOCOLS] =
         SHA1_SIZE,                      /* digest size */
         hmac_sha1,                      /* hmac algorithm */
         (crypt_func)RC4_crypt,          /* encrypt */
-        (crypt_func)RC4_crypt           /* decrypt */
+        (crypt_func)RC4_crypt,          /* decrypt */
+        SSL_KEYX_RSA,                   /* key exchange */
+        0                               /* not an AEAD cipher */
     },
 };
 #else
@@ -111,7 +117,9 @@ static const cipher_info_t cipher_info[NUM_PROTOCOLS] =
         SHA1_SIZE,                      /* digest size */
         hmac_sha1,                      /* hmac algorithm */
         (crypt_func)AES_cbc_encrypt,    /* encrypt */
-        (crypt_func)AES_cbc_decrypt     /* decrypt */
+        (crypt_func)AES_cbc_decrypt,    /* decrypt */
+        SSL_KEYX_RSA,                   /* key exchange */
+        0                               /* not an AEAD cipher */
     },
     {   /* AES256-SHA */
         SSL_AES256_SHA,                 /* AES256-SHA */
@@ -122,7 +130,9 @@ static const cipher_info_t cipher_info[NUM_PROTOCOLS] =
         SHA1_SIZE,                      /* digest size */
         hmac_sha1,                      /* hmac algorithm */
         (crypt_func)AES_cbc_encrypt,    /* encrypt */
-        (crypt_func)AES_cbc_decrypt     /* decrypt */
+        (crypt_func)AES_cbc_decrypt,    /* decrypt */
+        SSL_KEYX_RSA,                   /* key exchange */
+        0                               /* not an AEAD cipher */
     },       
     {   /* RC4-SHA */
         SSL_RC4_128_SHA,                /* RC4-SHA */
@@ -133,7 +143,9 @@ static const cipher_info_t cipher_info[NUM_PROTOCOLS] =
         SHA1_SIZE,                      /* digest size */
         hmac_sha1,                      /* hmac algorithm */
         (crypt_func)RC4_crypt,          /* encrypt */
-        (crypt_func)RC4_crypt           /* decrypt */
+        (crypt_func)RC4_crypt,          /* decrypt */
+        SSL_KEYX_RSA,                   /* key exchange */
+        0                               /* not an AEAD cipher */
     },
     /*
      * This protocol is from SSLv2 days and is unlikely to be used - but was
@@ -148,14 +160,33 @@ static const cipher_info_t cipher_info[NUM_PROTOCOLS] =
         MD5_SIZE,                       /* digest size */
         hmac_md5,                       /* hmac algorithm */
         (crypt_func)RC4_crypt,          /* encrypt */
-        (crypt_func)RC4_crypt           /* decrypt */
+        (crypt_func)RC4_crypt,          /* decrypt */
+        SSL_KEYX_RSA,                   /* key exchange */
+        0                               /* not an AEAD cipher */
+    },
+    /*
+     * TLSv1.2 only. The record layer calls GCM directly (the explicit nonce
+     * and additional data don't fit crypt_func) and the "iv" is the 4 byte
+     * implicit salt.
+     */
+    {   /* ECDHE-RSA-AES128-GCM-SHA256 */
+        SSL_ECDHE_RSA_AES128_GCM_SHA256,/* ECDHE-RSA-AES128-GCM-SHA256 */
+        16,                             /* key size */
+        AEAD_SALT_SIZE,                 /* iv size */ 
+        2*(16+AEAD_SALT_SIZE),          /* key block size */
+        0,                              /* no padding */
+        GCM_TAG_SIZE,                   /* digest size (the tag) */
+        NULL,                           /* no hmac - the tag does that */
+        NULL,                           /* encrypt */
+        NULL,                           /* decrypt */
+        SSL_KEYX_ECDHE,                 /* key exchange */
+        1                               /* AEAD cipher */
     },
 };
 #endif
 
-static void prf(const uint8_t *sec, int sec_len, uint8_t *seed, int seed_len,
-        uint8_t *out, int olen);
-static const cipher_info_t *get_cipher_info(uint8_t cipher);
+static void prf(SSL *ssl, const uint8_t *sec, int sec_len, 
+        uint8_t *seed, int seed_len, uint8_t *out, int olen);
 static void increment_read_sequence(SSL *ssl);
 static void increment_write_sequence(SSL *ssl);
 static void add_hmac_digest(SSL *ssl, int snd, uint8_t *hmac_header,
@@ -173,6 +204,7 @@ void DISPLAY_BYTES(SSL *ssl, const char *format,
 EXP_FUNC SSL_CTX *STDCALL ssl_ctx_new(SSL_CTX *ssl_ctx, uint32_t options, int num_sessions)
 {
     ssl_ctx->options = options;
+    ssl_ctx->num_cipher_prefs = 0;      /* use ssl_prot_prefs */
     RNG_initialize();
 
    // if (load_key_certs(ssl_ctx) < 0)
@@ -291,13 +323,14 @@ EXP_FUNC int STDCALL ssl_write(SSL *ssl, const uint8_t *out_data, int out_len)
 {
     int n = out_len, nw, i, tot = 0;
 
-    /* maximum size of a TLS packet is around 16kB, so fragment */
+    /* our record buffer is only 2kB, so fragment - leaving room for the
+       record header, explicit iv/nonce, mac/tag and padding */
     do 
     {
         nw = n;
 
-        if (nw > RT_MAX_PLAIN_LENGTH)    /* fragment if necessary */
-            nw = RT_MAX_PLAIN_LENGTH;
+        if (nw > RT_MAX_FRAGMENT)       /* fragment if necessary */
+            nw = RT_MAX_FRAGMENT;
 
         if ((i = send_packet(ssl, PT_APP_PROTOCOL_DATA, 
                                             &out_data[tot], nw)) <= 0)
@@ -428,7 +461,7 @@ EXP_FUNC int STDCALL ssl_renegotiate(SSL *ssl)
  * @param iv_size   [out]   The iv size for the cipher
  * @return  The amount of key information we need.
  */
-static const cipher_info_t *get_cipher_info(uint8_t cipher)
+const cipher_info_t *get_cipher_info(uint16_t cipher)
 {
     int i;
 
@@ -634,6 +667,7 @@ void add_packet(SSL *ssl, const uint8_t *pkt, int len)
 {
     MD5_Update(&ssl->dc->md5_ctx, pkt, len);
     SHA1_Update(&ssl->dc->sha1_ctx, pkt, len);
+    SHA256_Update(&ssl->dc->sha256_ctx, pkt, len);
 }
 
 /**
@@ -693,16 +727,53 @@ static void p_hash_sha1(const uint8_t *sec, int sec_len,
 }
 
 /**
- * Work out the PRF.
+ * Work out the SHA256 PRF (TLSv1.2).
  */
-static void prf(const uint8_t *sec, int sec_len, uint8_t *seed, int seed_len,
-        uint8_t *out, int olen)
+static void p_hash_sha256(const uint8_t *sec, int sec_len, 
+        uint8_t *seed, int seed_len, uint8_t *out, int olen)
+{
+    uint8_t a1[128];
+
+    /* A(1) */
+    hmac_sha256(seed, seed_len, sec, sec_len, a1);
+    memcpy(&a1[SHA256_SIZE], seed, seed_len);
+    hmac_sha256(a1, SHA256_SIZE+seed_len, sec, sec_len, out);
+
+    while (olen > SHA256_SIZE)
+    {
+        uint8_t a2[SHA256_SIZE];
+        out += SHA256_SIZE;
+        olen -= SHA256_SIZE;
+
+        /* A(N) */
+        hmac_sha256(a1, SHA256_SIZE, sec, sec_len, a2);
+        memcpy(a1, a2, SHA256_SIZE);
+
+        /* work out the actual hash */
+        hmac_sha256(a1, SHA256_SIZE+seed_len, sec, sec_len, out);
+    }
+}
+
+/**
+ * Work out the PRF. TLSv1.2 uses P_SHA256 on its own, earlier versions
+ * combine P_MD5 and P_SHA1.
+ */
+static void prf(SSL *ssl, const uint8_t *sec, int sec_len, 
+        uint8_t *seed, int seed_len, uint8_t *out, int olen)
 {
     int len, i;
     const uint8_t *S1, *S2;
     uint8_t xbuf[256]; /* needs to be > the amount of key data */
     uint8_t ybuf[256]; /* needs to be > the amount of key data */
 
+    if (ssl->version >= SSL_PROTOCOL_VERSION1_2)
+    {
+        /* p_hash writes whole blocks, so don't overrun the output */
+        p_hash_sha256(sec, sec_len, seed, seed_len, xbuf, olen);
+        memcpy(out, xbuf, olen);
+        return;
+    }
+
     len = sec_len/2;
     S1 = sec;
     S2 = &sec[len];
@@ -719,27 +790,30 @@ static void prf(const uint8_t *sec, int sec_len, uint8_t *seed, int seed_len,
  * Generate a master secret based on the client/server random data and the
  * premaster secret.
  */
-void generate_master_secret(SSL *ssl, const uint8_t *premaster_secret)
+void generate_master_secret(SSL *ssl, const uint8_t *premaster_secret,
+        int premaster_len)
 {
     uint8_t buf[128];   /* needs to be > 13+32+32 in size */
     strcpy((char *)buf, "master secret");
     memcpy(&buf[13], ssl->dc->client_random, SSL_RANDOM_SIZE);
     memcpy(&buf[45], ssl->dc->server_random, SSL_RANDOM_SIZE);
-    prf(premaster_secret, SSL_SECRET_SIZE, buf, 77, ssl->dc->master_secret,
-            SSL_SECRET_SIZE);
+    prf(ssl, premaster_secret, premaster_len, buf, 77, 
+            ssl->dc->master_secret, SSL_SECRET_SIZE);
 }
 
 /**
  * Generate a 'random' blob of data used for the generation of keys.
  */
-static void generate_key_block(uint8_t *client_random, uint8_t *server_random,
-        uint8_t *master_secret, uint8_t *key_block, int key_block_size)
+static void generate_key_block(SSL *ssl, uint8_t *client_random, 
+        uint8_t *server_random, uint8_t *master_secret, 
+        uint8_t *key_block, int key_block_size)
 {
     uint8_t buf[128];
     strcpy((char *)buf, "key expansion");
     memcpy(&buf[13], server_random, SSL_RANDOM_SIZE);
     memcpy(&buf[45], client_random, SSL_RANDOM_SIZE);
-    prf(master_secret, SSL_SECRET_SIZE, buf, 77, key_block, key_block_size);
+    prf(ssl, master_secret, SSL_SECRET_SIZE, buf, 77, 
+            key_block, key_block_size);
 }
 
 /** 
@@ -759,15 +833,24 @@ void finished_digest(SSL *ssl, const char *label, uint8_t *digest)
         q += strlen(label);
     }
 
-    MD5_Final(q, &md5_ctx);
-    q += MD5_SIZE;
-    
-    SHA1_Final(q, &sha1_ctx);
-    q += SHA1_SIZE;
+    if (label && ssl->version >= SSL_PROTOCOL_VERSION1_2)
+    {
+        SHA256_CTX sha256_ctx = ssl->dc->sha256_ctx;
+        SHA256_Final(q, &sha256_ctx);
+        q += SHA256_SIZE;
+    }
+    else
+    {
+        MD5_Final(q, &md5_ctx);
+        q += MD5_SIZE;
+        
+        SHA1_Final(q, &sha1_ctx);
+        q += SHA1_SIZE;
+    }
 
     if (label)
     {
-        prf(ssl->dc->master_secret, SSL_SECRET_SIZE, mac_buf, (int)(q-mac_buf),
+        prf(ssl, ssl->dc->master_secret, SSL_SECRET_SIZE, mac_buf, (int)(q-mac_buf),
             digest, SSL_FINISHED_HASH_SIZE);
     }
     else    /* for use in a certificate verify */
@@ -794,6 +877,9 @@ static void *crypt_new(SSL *ssl, uint8_t *key, uint8_t *iv, int is_decrypt)
         case SSL_AES128_SHA:
             {
                 AES_CTX *aes_ctx = (AES_CTX *)malloc(sizeof(AES_CTX));
+                if (aes_ctx == NULL)
+                    return NULL;
+
                 AES_set_key(aes_ctx, key, iv, AES_MODE_128);
 
                 if (is_decrypt)
@@ -807,6 +893,9 @@ static void *crypt_new(SSL *ssl, uint8_t *key, uint8_t *iv, int is_decrypt)
         case SSL_AES256_SHA:
             {
                 AES_CTX *aes_ctx = (AES_CTX *)malloc(sizeof(AES_CTX));
+                if (aes_ctx == NULL)
+                    return NULL;
+
                 AES_set_key(aes_ctx, key, iv, AES_MODE_256);
 
                 if (is_decrypt)
@@ -817,11 +906,25 @@ static void *crypt_new(SSL *ssl, uint8_t *key, uint8_t *iv, int is_decrypt)
                 return (void *)aes_ctx;
             }
 
+        case SSL_ECDHE_RSA_AES128_GCM_SHA256:
+            {
+                AEAD_CTX *aead_ctx = (AEAD_CTX *)malloc(sizeof(AEAD_CTX));
+                if (aead_ctx == NULL)
+                    return NULL;
+
+                GCM_set_key(&aead_ctx->gcm_ctx, key, AES_MODE_128);
+                memcpy(aead_ctx->salt, iv, AEAD_SALT_SIZE);
+                return (void *)aead_ctx;
+            }
+
         case SSL_RC4_128_MD5:
 #endif
         case SSL_RC4_128_SHA:
             {
                 RC4_CTX *rc4_ctx = (RC4_CTX *)malloc(sizeof(RC4_CTX));
+                if (rc4_ctx == NULL)
+                    return NULL;
+
                 RC4_setup(rc4_ctx, key, 16);
                 return (void *)rc4_ctx;
             }
@@ -952,6 +1055,24 @@ int send_packet(SSL *ssl, uint8_t protocol, const uint8_t *in, int length)
             }
         }
 
+        if (ssl->cipher_info->is_aead)
+        {
+            AEAD_CTX *aead_ctx = (AEAD_CTX *)ssl->encrypt_ctx;
+            uint8_t *p = &ssl->bm_data[AEAD_EXPLICIT_NONCE_SIZE];
+
+            /* the sequence number doubles as the explicit nonce */
+            memmove(p, ssl->bm_data, msg_length);
+            memcpy(ssl->bm_data, ssl->write_sequence, 
+                                        AEAD_EXPLICIT_NONCE_SIZE);
+            aead_starts(ssl, aead_ctx, ssl->write_sequence, 
+                                        ssl->bm_data, protocol, msg_length);
+            GCM_encrypt(&aead_ctx->gcm_ctx, p, p, msg_length);
+            GCM_finish(&aead_ctx->gcm_ctx, &p[msg_length]);
+            msg_length += AEAD_EXPLICIT_NONCE_SIZE + GCM_TAG_SIZE;
+            increment_write_sequence(ssl);
+            goto send;
+        }
+
         /* add the packet digest */
         add_hmac_digest(ssl, mode, hmac_header, ssl->bm_data, msg_length, 
                                                 &ssl->bm_data[msg_length]);
@@ -1000,6 +1121,7 @@ int send_packet(SSL *ssl, uint8_t protocol, const uint8_t *in, int length)
         }
     }
 
+send:
     ssl->bm_index = msg_length;
     if ((ret = send_raw_packet(ssl, protocol)) <= 0)
         return ret;
@@ -1031,7 +1153,7 @@ static int set_key_block(SSL *ssl, int is_write)
         print_blob("server", ssl->dc->server_random, 32);
         print_blob("master", ssl->dc->master_secret, SSL_SECRET_SIZE);
 #endif
-        generate_key_block(ssl->dc->client_random, ssl->dc->server_random,
+        generate_key_block(ssl, ssl->dc->client_random, ssl->dc->server_random,
             ssl->dc->master_secret, ssl->dc->key_block, 
             ciph_info->key_block_size);
 #if 0
@@ -1041,19 +1163,23 @@ static int set_key_block(SSL *ssl, int is_write)
 
     q = ssl->dc->key_block;
 
-    if ((is_client && is_write) || (!is_client && !is_write))
+    if (!ciph_info->is_aead)    /* AEAD ciphers have no mac keys */
     {
-        memcpy(ssl->client_mac, q, ciph_info->digest_size);
-    }
+        if ((is_client && is_write) || (!is_client && !is_write))
+        {
+            memcpy(ssl->client_mac, q, ciph_info->digest_size);
+        }
 
-    q += ciph_info->digest_size;
+        q += ciph_info->digest_size;
 
-    if ((!is_client && is_write) || (is_client && !is_write))
-    {
-        memcpy(ssl->server_mac, q, ciph_info->digest_size);
+        if ((!is_client && is_write) || (is_client && !is_write))
+        {
+            memcpy(ssl->server_mac, q, ciph_info->digest_size);
+        }
+
+        q += ciph_info->digest_size;
     }
 
-    q += ciph_info->digest_size;
     memcpy(client_key, q, ciph_info->key_size);
     q += ciph_info->key_size;
     memcpy(server_key, q, ciph_info->key_size);
@@ -1092,10 +1218,86 @@ static int set_key_block(SSL *ssl, int is_write)
             ssl->decrypt_ctx = crypt_new(ssl, client_key, client_iv, 1);
     }
 
+    /* out of memory, the handshake fails */
+    if ((is_write ? ssl->encrypt_ctx : ssl->decrypt_ctx) == NULL)
+        return -1;
+
     ssl->cipher_info = ciph_info;
     return 0;
 }
 
+/**
+ * Start an AEAD record. The nonce is the implicit salt plus the explicit part
+ * sent with the record, and the additional data is the sequence number and
+ * the record header (with the length of the plaintext).
+ */
+static void aead_starts(SSL *ssl, AEAD_CTX *aead_ctx, const uint8_t *seq,
+        const uint8_t *explicit_nonce, uint8_t protocol, int plain_len)
+{
+    uint8_t nonce[GCM_IV_SIZE];
+    uint8_t add[13];
+
+    memcpy(nonce, aead_ctx->salt, AEAD_SALT_SIZE);
+    memcpy(&nonce[AEAD_SALT_SIZE], explicit_nonce, AEAD_EXPLICIT_NONCE_SIZE);
+    memcpy(add, seq, 8);
+    add[8] = protocol;
+    add[9] = 0x03;
+    add[10] = ssl->version & 0x0f;
+    add[11] = plain_len >> 8;
+    add[12] = plain_len & 0xff;
+    GCM_starts(&aead_ctx->gcm_ctx, nonce, add, sizeof(add));
+}
+
+/**
+ * Finish an AEAD record and compare the tag (in constant time).
+ */
+static int aead_verify(SSL *ssl, const uint8_t *tag)
+{
+    uint8_t calc_tag[GCM_TAG_SIZE];
+    uint8_t diff = 0;
+    int i;
+
+    GCM_finish(&((AEAD_CTX *)ssl->decrypt_ctx)->gcm_ctx, calc_tag);
+    increment_read_sequence(ssl);
+
+    for (i = 0; i < GCM_TAG_SIZE; i++)
+        diff |= calc_tag[i] ^ tag[i];
+
+    return diff ? SSL_ERROR_INVALID_HMAC : SSL_OK;
+}
+
+/**
+ * Decrypt AEAD data. Application data is streamed (the record was started
+ * in read_record()), anything else is done as a whole record with the
+ * plaintext moved to the start of the buffer.
+ */
+static int aead_decrypt(SSL *ssl, uint8_t *buf, int len)
+{
+    AEAD_CTX *aead_ctx = (AEAD_CTX *)ssl->decrypt_ctx;
+    int ret;
+
+    if (ssl->record_type == PT_APP_PROTOCOL_DATA)
+    {
+        GCM_decrypt(&aead_ctx->gcm_ctx, buf, buf, len);
+        return len;
+    }
+
+    len -= AEAD_EXPLICIT_NONCE_SIZE + GCM_TAG_SIZE;
+
+    if (len < 0)
+        return SSL_ERROR_INVALID_HMAC;
+
+    aead_starts(ssl, aead_ctx, ssl->read_sequence, buf, 
+                                        ssl->record_type, len);
+    GCM_decrypt(&aead_ctx->gcm_ctx, &buf[AEAD_EXPLICIT_NONCE_SIZE], buf, len);
+
+    if ((ret = aead_verify(ssl, &buf[AEAD_EXPLICIT_NONCE_SIZE+len])) < 0)
+        return ret;
+
+    DISPLAY_BYTES(ssl, "decrypted", buf, len);
+    return len;
+}
+
 /** 
   * Blocking read 
   * data must be valid buffer of size length at least
@@ -1194,7 +1396,20 @@ int read_record(SSL *ssl)
     if(ssl->record_type == PT_APP_PROTOCOL_DATA)
     {   
         ssl->need_bytes -= ssl->cipher_info->digest_size;
-        if(ssl->cipher == SSL_AES256_SHA || ssl->cipher == SSL_AES128_SHA)
+        if (ssl->cipher_info->is_aead)
+        {
+            /* decrypt in place as the data arrives, check the tag at the 
+               end of the record */
+            uint8_t explicit_nonce[AEAD_EXPLICIT_NONCE_SIZE];
+            ret = basic_read2(ssl, explicit_nonce, AEAD_EXPLICIT_NONCE_SIZE);
+            if (ret != AEAD_EXPLICIT_NONCE_SIZE)
+                return ret;
+
+            ssl->need_bytes -= AEAD_EXPLICIT_NONCE_SIZE;
+            aead_starts(ssl, (AEAD_CTX *)ssl->decrypt_ctx, ssl->read_sequence,
+                explicit_nonce, PT_APP_PROTOCOL_DATA, ssl->need_bytes);
+        }
+        else if(ssl->cipher == SSL_AES256_SHA || ssl->cipher == SSL_AES128_SHA)
         {
             // discard IV
             basic_read2(ssl, ssl->bm_all_data + ssl->bm_index, AES_BLOCKSIZE);
@@ -1210,6 +1425,9 @@ int basic_decrypt(SSL *ssl, uint8_t *buf, int len)
 {
    if (IS_SET_SSL_FLAG(SSL_RX_ENCRYPTED))
     {
+        if (ssl->cipher_info->is_aead)
+            return aead_decrypt(ssl, buf, len);
+
         ssl->cipher_info->decrypt(ssl->decrypt_ctx, buf, buf, len);
 
         if (ssl->version >= SSL_PROTOCOL_VERSION1_1 &&
@@ -1260,7 +1478,16 @@ int process_data(SSL* ssl, uint8_t *in_data, int len)
             {
                 ssl->dc->bm_proc_index = 0;
                 ret = do_handshake(ssl, NULL, 0);
-                SET_SSL_FLAG(SSL_NEED_RECORD);
+
+                /* servers often pack several handshake messages into a 
+                   single record - only go for the next record once this 
+                   one is used up */
+                if (ret < 0 || ssl->need_bytes == 0 ||
+                                IS_SET_SSL_FLAG(SSL_RX_ENCRYPTED))
+                {
+                    SET_SSL_FLAG(SSL_NEED_RECORD);
+                }
+
                 return ret;
             }
             else /* no client renegotiation allowed */
@@ -1343,8 +1570,21 @@ int process_data(SSL* ssl, uint8_t *in_data, int len)
                 if(ssl->need_bytes == 0)
                 {
                     // skip digest
-                    uint8_t buf_tmp[SHA1_SIZE];
-                    if(ssl->cipher == SSL_AES256_SHA || ssl->cipher == SSL_AES128_SHA)
+                    uint8_t buf_tmp[GCM_TAG_SIZE > SHA1_SIZE ? 
+                                            GCM_TAG_SIZE : SHA1_SIZE];
+                    if (ssl->cipher_info->is_aead)
+                    {
+                        /* the data has already been handed over, but at
+                           least don't carry on with a forged stream */
+                        SET_SSL_FLAG(SSL_NEED_RECORD);
+                        if (basic_read2(ssl, buf_tmp, GCM_TAG_SIZE) != 
+                                GCM_TAG_SIZE || aead_verify(ssl, buf_tmp) < 0)
+                        {
+                            ssl->hs_status = SSL_ERROR_DEAD;
+                            return SSL_ERROR_INVALID_HMAC;
+                        }
+                    }
+                    else if(ssl->cipher == SSL_AES256_SHA || ssl->cipher == SSL_AES128_SHA)
                     {
                         basic_read2(ssl, buf_tmp, AES_BLOCKSIZE);
                         basic_decrypt(ssl, buf_tmp, AES_BLOCKSIZE);
@@ -1424,6 +1664,13 @@ static int do_handshake(SSL *ssl, uint8_t *buf, int read_len)
     int ret = SSL_OK;
     int is_client = IS_SET_SSL_FLAG(SSL_IS_CLIENT);
 
+    /* keep track of what is left of the record */
+    if (!IS_SET_SSL_FLAG(SSL_RX_ENCRYPTED))
+    {
+        ssl->need_bytes = (ssl->need_bytes > hs_len+SSL_HS_HDR_SIZE) ?
+                        ssl->need_bytes - hs_len - SSL_HS_HDR_SIZE : 0;
+    }
+
     /* some integrity checking on the handshake */
     //PARANOIA_CHECK(read_len-SSL_HS_HDR_SIZE, hs_len);
     if (handshake_type != ssl->next_state)
@@ -1680,6 +1927,7 @@ void disposable_new(SSL *ssl)
         memset(ssl->dc->key_block, 0, MAX_KEYBLOCK_SIZE);
         MD5_Init(&ssl->dc->md5_ctx);
         SHA1_Init(&ssl->dc->sha1_ctx);
+        SHA256_Init(&ssl->dc->sha256_ctx);
     }
 }
 
@@ -1824,11 +2072,39 @@ EXP_FUNC uint8_t STDCALL ssl_get_session_id_size(const SSL *ssl)
 /*
  * Return the cipher id (in the SSL form).
  */
-EXP_FUNC uint8_t STDCALL ssl_get_cipher_id(const SSL *ssl)
+EXP_FUNC uint16_t STDCALL ssl_get_cipher_id(const SSL *ssl)
 {
     return ssl->cipher;
 }
 
+/*
+ * Override the compiled in cipher preferences for this context.
+ */
+EXP_FUNC int STDCALL ssl_ctx_set_cipher_prefs(SSL_CTX *ssl_ctx, 
+        const uint16_t *ciphers, int num_ciphers)
+{
+    int i;
+
+    if (ciphers == NULL)    /* back to the defaults */
+    {
+        ssl_ctx->num_cipher_prefs = 0;
+        return SSL_OK;
+    }
+
+    if (num_ciphers <= 0 || num_ciphers > NUM_PROTOCOLS)
+        return SSL_ERROR_NO_CIPHER;
+
+    for (i = 0; i < num_ciphers; i++)
+    {
+        if (get_cipher_info(ciphers[i]) == NULL)
+            return SSL_ERROR_NO_CIPHER;
+    }
+
+    memcpy(ssl_ctx->cipher_prefs, ciphers, num_ciphers*sizeof(uint16_t));
+    ssl_ctx->num_cipher_prefs = num_ciphers;
+    return SSL_OK;
+}
+
 /*
  * Return the status of the handshake.
  */
@@ -49,9 +49,10 @@ extern "C" {
 #include "config.h"
 
 #define SSL_PROTOCOL_MIN_VERSION    0x31   /* TLS v1.0 */
-#define SSL_PROTOCOL_MINOR_VERSION  0x02   /* TLS v1.1 */
-#define SSL_PROTOCOL_VERSION_MAX    0x32   /* TLS v1.1 */
+#define SSL_PROTOCOL_MINOR_VERSION  0x03   /* TLS v1.2 */
+#define SSL_PROTOCOL_VERSION_MAX    0x33   /* TLS v1.2 */
 #define SSL_PROTOCOL_VERSION1_1     0x32   /* TLS v1.1 */
+#define SSL_PROTOCOL_VERSION1_2     0x33   /* TLS v1.2 */
 #define SSL_RANDOM_SIZE             32
 #define SSL_SECRET_SIZE             48
 #define SSL_FINISHED_HASH_SIZE      12
@@ -61,6 +62,8 @@ extern "C" {
 #define SSL_CLIENT_READ             2
 #define SSL_CLIENT_WRITE            3
 #define SSL_HS_HDR_SIZE             4
+#define AEAD_SALT_SIZE              4   /* implicit part of the GCM nonce */
+#define AEAD_EXPLICIT_NONCE_SIZE    8   /* sent with each record */
 
 /* the flags we use while establishing a connection */
 #define SSL_NEED_RECORD             0x0001
@@ -81,13 +84,27 @@ extern "C" {
 #define RT_EXTRA                    256//1024
 #define BM_RECORD_OFFSET            5
 #define BM_ALL_DATA_SIZE            (RT_MAX_PLAIN_LENGTH+RT_EXTRA-BM_RECORD_OFFSET)
+#define RT_MAX_OVERHEAD             64      /* explicit iv + mac + padding */
+#define RT_MAX_FRAGMENT             (RT_MAX_PLAIN_LENGTH-BM_RECORD_OFFSET-RT_MAX_OVERHEAD)
 
 #ifdef CONFIG_SSL_SKELETON_MODE
 #define NUM_PROTOCOLS               1
 #else
-#define NUM_PROTOCOLS               4
+#define NUM_PROTOCOLS               5
 #endif
 
+/* key exchange methods */
+#define SSL_KEYX_RSA                0
+#define SSL_KEYX_ECDHE              1
+
+/* TLSv1.2 hash/signature algorithm identifiers */
+#define TLS_HASH_SHA1               2
+#define TLS_HASH_SHA256             4
+#define TLS_SIG_RSA                 1
+
+/* TLS named curves */
+#define TLS_CURVE_X25519            0x001d
+
 #define PARANOIA_CHECK(A, B)        if (A < B) { \
     ret = SSL_ERROR_INVALID_HANDSHAKE; goto error; }
 
@@ -117,7 +134,7 @@ enum
 
 typedef struct 
 {
-    uint8_t cipher;
+    uint16_t cipher;
     uint8_t key_size;
     uint8_t iv_size;
     uint8_t key_block_size;
@@ -126,8 +143,16 @@ typedef struct
     hmac_func hmac;
     crypt_func encrypt;
     crypt_func decrypt;
+    uint8_t key_xchg;       /* SSL_KEYX_RSA or SSL_KEYX_ECDHE */
+    uint8_t is_aead;        /* the digest is a tag rather than an hmac */
 } cipher_info_t;
 
+typedef struct
+{
+    GCM_CTX gcm_ctx;
+    uint8_t salt[AEAD_SALT_SIZE];
+} AEAD_CTX;
+
 struct _SSLObjLoader 
 {
     uint8_t *buf;
@@ -153,6 +178,9 @@ typedef struct
 {
     MD5_CTX md5_ctx;
     SHA1_CTX sha1_ctx;
+    SHA256_CTX sha256_ctx;  /* TLSv1.2 handshake hash */
+    uint8_t ecdh_private[X25519_SIZE];
+    uint8_t ecdh_peer[X25519_SIZE];    /* server's ephemeral public key */
     uint8_t final_finish_mac[SSL_FINISHED_HASH_SIZE];
     uint8_t key_block[MAX_KEYBLOCK_SIZE];
     uint8_t master_secret[SSL_SECRET_SIZE];
@@ -167,7 +195,7 @@ struct _SSL
     uint16_t need_bytes;
     uint16_t got_bytes;
     uint8_t record_type;
-    uint8_t cipher;
+    uint16_t cipher;
     uint8_t sess_id_size;
     uint8_t version;
     uint8_t client_version;
@@ -215,6 +243,8 @@ struct _SSL_CTX
     SSL *head;
     SSL *tail;
     SSL_CERT certs[CONFIG_SSL_MAX_CERTS];
+    uint16_t cipher_prefs[NUM_PROTOCOLS];   /* empty means ssl_prot_prefs */
+    uint8_t num_cipher_prefs;
 #ifndef CONFIG_SSL_SKELETON_MODE
     uint16_t num_sessions;
     SSL_SESSION **ssl_sessions;
@@ -232,7 +262,7 @@ typedef struct _SSL_CTX SSL_CTX;
 /* backwards compatibility */
 typedef struct _SSL_CTX SSLCTX;
 
-extern const uint8_t ssl_prot_prefs[NUM_PROTOCOLS];
+extern const uint16_t ssl_prot_prefs[NUM_PROTOCOLS];
 
 SSL *ssl_new(SSL *ssl, int client_fd);
 void disposable_new(SSL *ssl);
@@ -253,7 +283,9 @@ int process_data(SSL* ssl, uint8_t *in_data, int len);
 int ssl_read(SSL *ssl, uint8_t *in_data, int len);
 int send_change_cipher_spec(SSL *ssl);
 void finished_digest(SSL *ssl, const char *label, uint8_t *digest);
-void generate_master_secret(SSL *ssl, const uint8_t *premaster_secret);
+void generate_master_secret(SSL *ssl, const uint8_t *premaster_secret,
+        int premaster_len);
+const cipher_info_t *get_cipher_info(uint16_t cipher);
 void add_packet(SSL *ssl, const uint8_t *pkt, int len);
 int add_cert(SSL_CTX *ssl_ctx, const uint8_t *buf, int len);
 int add_private_key(SSL_CTX *ssl_ctx, SSLObjLoader *ssl_obj);
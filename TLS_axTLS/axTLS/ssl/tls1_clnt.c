@@ -37,10 +37,12 @@
 
 #ifdef CONFIG_SSL_ENABLE_CLIENT        /* all commented out if no client */
 
+static int get_cipher_prefs(SSL *ssl, const uint16_t **prefs);
 static int send_client_hello(SSL *ssl);
 static int process_server_hello(SSL *ssl);
 static int process_server_hello_done(SSL *ssl);
 static int send_client_key_xchg(SSL *ssl);
+static int process_server_key_xchg(SSL *ssl, const uint8_t *buf, int hs_len);
 static int process_cert_req(SSL *ssl);
 static int send_cert_verify(SSL *ssl);
 
@@ -88,6 +90,17 @@ int do_clnt_handshake(SSL *ssl, int handshake_type, uint8_t *buf, int hs_len)
 
         case HS_CERTIFICATE:
             ret = process_certificate(ssl, &ssl->x509_ctx);
+
+            /* ephemeral key exchange has the server's key to come */
+            if (ret == SSL_OK && 
+                    get_cipher_info(ssl->cipher)->key_xchg == SSL_KEYX_ECDHE)
+            {
+                ssl->next_state = HS_SERVER_KEY_XCHG;
+            }
+            break;
+
+        case HS_SERVER_KEY_XCHG:
+            ret = process_server_key_xchg(ssl, buf, hs_len);
             break;
 
         case HS_SERVER_HELLO_DONE:
@@ -166,6 +179,21 @@ int do_client_connect(SSL *ssl)
     return ret;
 }
 
+/*
+ * The cipher suites the client offers, set by the application or ours.
+ */
+static int get_cipher_prefs(SSL *ssl, const uint16_t **prefs)
+{
+    if (ssl->ssl_ctx->num_cipher_prefs)     /* set by the application */
+    {
+        *prefs = ssl->ssl_ctx->cipher_prefs;
+        return ssl->ssl_ctx->num_cipher_prefs;
+    }
+
+    *prefs = ssl_prot_prefs;
+    return NUM_PROTOCOLS;
+}
+
 /*
  * Send the initial client hello.
  */
@@ -174,7 +202,9 @@ static int send_client_hello(SSL *ssl)
     uint8_t *buf = ssl->bm_data;
     time_t tm = time(NULL);
     uint8_t *tm_ptr = &buf[6]; /* time will go here */
-    int i, offset;
+    const uint16_t *prefs;
+    int num_prefs = get_cipher_prefs(ssl, &prefs);
+    int i, offset, cs_offset, ext_offset, offer_ecdhe = 0;
 
     buf[0] = HS_CLIENT_HELLO;
     buf[1] = 0;
@@ -206,19 +236,71 @@ static int send_client_hello(SSL *ssl)
         buf[offset++] = 0;
     }
 
-    buf[offset++] = 0;              /* number of ciphers */
-    buf[offset++] = NUM_PROTOCOLS*2;/* number of ciphers */
+    cs_offset = offset;             /* number of ciphers goes here */
+    offset += 2;
 
     /* put all our supported protocols in our request */
-    for (i = 0; i < NUM_PROTOCOLS; i++)
+    for (i = 0; i < num_prefs; i++)
     {
-        buf[offset++] = 0;          /* cipher we are using */
-        buf[offset++] = ssl_prot_prefs[i];
+        if (prefs[i] == 0)          /* unused slot */
+            continue;
+
+        buf[offset++] = prefs[i] >> 8;
+        buf[offset++] = prefs[i] & 0xff;
+
+        if (get_cipher_info(prefs[i])->key_xchg == SSL_KEYX_ECDHE)
+            offer_ecdhe = 1;
     }
 
+    buf[cs_offset] = (offset - cs_offset - 2) >> 8;
+    buf[cs_offset+1] = (offset - cs_offset - 2) & 0xff;
+
     buf[offset++] = 1;              /* no compression */
     buf[offset++] = 0;
-    buf[3] = offset - 4;            /* handshake size */
+
+    /* extensions */
+    ext_offset = offset;
+    offset += 2;
+
+    if (ssl->version >= SSL_PROTOCOL_VERSION1_2)
+    {
+        /* signature_algorithms - we only verify RSA */
+        static const uint8_t sig_algs[] = 
+        { 
+            0x00, 0x0d, 0x00, 0x06, 0x00, 0x04, 
+            TLS_HASH_SHA256, TLS_SIG_RSA, TLS_HASH_SHA1, TLS_SIG_RSA
+        };
+
+        memcpy(&buf[offset], sig_algs, sizeof(sig_algs));
+        offset += sizeof(sig_algs);
+    }
+
+    if (offer_ecdhe)
+    {
+        /* supported_groups (x25519 only) and uncompressed points */
+        static const uint8_t ecdhe_exts[] = 
+        { 
+            0x00, 0x0a, 0x00, 0x04, 0x00, 0x02, 
+            TLS_CURVE_X25519 >> 8, TLS_CURVE_X25519 & 0xff,
+            0x00, 0x0b, 0x00, 0x02, 0x01, 0x00
+        };
+
+        memcpy(&buf[offset], ecdhe_exts, sizeof(ecdhe_exts));
+        offset += sizeof(ecdhe_exts);
+    }
+
+    if (offset == ext_offset + 2)   /* no extensions after all */
+    {
+        offset = ext_offset;
+    }
+    else
+    {
+        buf[ext_offset] = (offset - ext_offset - 2) >> 8;
+        buf[ext_offset+1] = (offset - ext_offset - 2) & 0xff;
+    }
+
+    buf[2] = (offset - 4) >> 8;     /* handshake size */
+    buf[3] = (offset - 4) & 0xff;
 
     return send_packet(ssl, PT_HANDSHAKE_PROTOCOL, NULL, offset);
 }
@@ -232,7 +314,8 @@ static int process_server_hello(SSL *ssl)
     int pkt_size = ssl->bm_index;
     int num_sessions = ssl->ssl_ctx->num_sessions;
     uint8_t sess_id_size;
-    int offset, ret = SSL_OK;
+    const uint16_t *prefs;
+    int i, num_prefs, offset, ret = SSL_OK;
 
     /* check that we are talking to a TLSv1 server */
     uint8_t version = (buf[0] << 4) + buf[1];
@@ -279,11 +362,36 @@ static int process_server_hello(SSL *ssl)
     offset += sess_id_size;
 
     /* get the real cipher we are using */
-    ssl->cipher = buf[++offset];
+    PARANOIA_CHECK(pkt_size, offset+2);
+    ssl->cipher = (buf[offset] << 8) + buf[offset+1];
+    offset += 2;    /* now on the compression method */
+
+    /* did the server pick something we offered (RFC 5246 7.4.1.3)? */
+    num_prefs = get_cipher_prefs(ssl, &prefs);
+    for (i = 0; i < num_prefs; i++)
+    {
+        if (prefs[i] != 0 && prefs[i] == ssl->cipher)
+            break;
+    }
+
+    if (i == num_prefs)
+    {
+        ret = SSL_ERROR_INVALID_HANDSHAKE;
+        goto error;
+    }
+
+    /* and can we use it? */
+    if (get_cipher_info(ssl->cipher) == NULL ||
+            (get_cipher_info(ssl->cipher)->is_aead && 
+                            ssl->version < SSL_PROTOCOL_VERSION1_2))
+    {
+        ret = SSL_ERROR_NO_CIPHER;
+        goto error;
+    }
+
     ssl->next_state = IS_SET_SSL_FLAG(SSL_SESSION_RESUME) ? 
                                         HS_FINISHED : HS_CERTIFICATE;
 
-    offset++;   // skip the compr
     PARANOIA_CHECK(pkt_size, offset);
     ssl->dc->bm_proc_index = offset+1; 
 
@@ -291,6 +399,144 @@ error:
     return ret;
 }
 
+/**
+ * Check the server's signature over the key exchange parameters using the
+ * key from its certificate. TLSv1.2 signs a DigestInfo of the negotiated hash,
+ * earlier versions sign MD5 and SHA1 back to back.
+ */
+static int verify_server_key_xchg(SSL *ssl, const uint8_t *params, 
+        int params_len, int hash_alg, const uint8_t *sig, int sig_len)
+{
+    static const uint8_t sha1_dinfo[] = 
+    {
+        0x30, 0x21, 0x30, 0x09, 0x06, 0x05, 0x2b, 0x0e,
+        0x03, 0x02, 0x1a, 0x05, 0x00, 0x04, 0x14
+    };
+    static const uint8_t sha256_dinfo[] = 
+    {
+        0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01,
+        0x65, 0x03, 0x04, 0x02, 0x01, 0x05, 0x00, 0x04, 0x20
+    };
+    RSA_CTX *rsa_ctx = ssl->x509_ctx ? ssl->x509_ctx->rsa_ctx : NULL;
+    uint8_t dgst[sizeof(sha256_dinfo)+SHA256_SIZE];
+    uint8_t *block;
+    int dgst_len, len;
+
+    if (rsa_ctx == NULL || sig_len != rsa_ctx->num_octets)
+        return SSL_ERROR_INVALID_KEY;
+
+    if (ssl->version >= SSL_PROTOCOL_VERSION1_2)
+    {
+        if (hash_alg == TLS_HASH_SHA256)
+        {
+            SHA256_CTX sha256_ctx;
+            memcpy(dgst, sha256_dinfo, sizeof(sha256_dinfo));
+            SHA256_Init(&sha256_ctx);
+            SHA256_Update(&sha256_ctx, ssl->dc->client_random, SSL_RANDOM_SIZE);
+            SHA256_Update(&sha256_ctx, ssl->dc->server_random, SSL_RANDOM_SIZE);
+            SHA256_Update(&sha256_ctx, params, params_len);
+            SHA256_Final(&dgst[sizeof(sha256_dinfo)], &sha256_ctx);
+            dgst_len = sizeof(sha256_dinfo) + SHA256_SIZE;
+        }
+        else if (hash_alg == TLS_HASH_SHA1)
+        {
+            SHA1_CTX sha1_ctx;
+            memcpy(dgst, sha1_dinfo, sizeof(sha1_dinfo));
+            SHA1_Init(&sha1_ctx);
+            SHA1_Update(&sha1_ctx, ssl->dc->client_random, SSL_RANDOM_SIZE);
+            SHA1_Update(&sha1_ctx, ssl->dc->server_random, SSL_RANDOM_SIZE);
+            SHA1_Update(&sha1_ctx, params, params_len);
+            SHA1_Final(&dgst[sizeof(sha1_dinfo)], &sha1_ctx);
+            dgst_len = sizeof(sha1_dinfo) + SHA1_SIZE;
+        }
+        else
+        {
+            return SSL_ERROR_NOT_SUPPORTED;
+        }
+    }
+    else
+    {
+        MD5_CTX md5_ctx;
+        SHA1_CTX sha1_ctx;
+        MD5_Init(&md5_ctx);
+        MD5_Update(&md5_ctx, ssl->dc->client_random, SSL_RANDOM_SIZE);
+        MD5_Update(&md5_ctx, ssl->dc->server_random, SSL_RANDOM_SIZE);
+        MD5_Update(&md5_ctx, params, params_len);
+        MD5_Final(dgst, &md5_ctx);
+        SHA1_Init(&sha1_ctx);
+        SHA1_Update(&sha1_ctx, ssl->dc->client_random, SSL_RANDOM_SIZE);
+        SHA1_Update(&sha1_ctx, ssl->dc->server_random, SSL_RANDOM_SIZE);
+        SHA1_Update(&sha1_ctx, params, params_len);
+        SHA1_Final(&dgst[MD5_SIZE], &sha1_ctx);
+        dgst_len = MD5_SIZE + SHA1_SIZE;
+    }
+
+    block = (uint8_t *)alloca(sig_len);
+
+    /* rsa_ctx->bi_ctx is not thread-safe */
+    SSL_CTX_LOCK(ssl->ssl_ctx->mutex);
+    len = RSA_decrypt(rsa_ctx, sig, block, 0);
+    SSL_CTX_UNLOCK(ssl->ssl_ctx->mutex);
+
+    if (len != dgst_len || memcmp(block, dgst, dgst_len))
+        return SSL_ERROR_INVALID_KEY;
+
+    return SSL_OK;
+}
+
+/**
+ * Process the server key exchange. Only ECDHE over x25519 is offered, so the
+ * parameters are a named curve and a 32 byte public value.
+ */
+static int process_server_key_xchg(SSL *ssl, const uint8_t *buf, int hs_len)
+{
+    int ret = SSL_OK;
+    int offset = 4 + X25519_SIZE;   /* the signed parameters */
+    int hash_alg = 0, sig_len;
+
+    PARANOIA_CHECK(hs_len, offset);
+
+    if (buf[0] != 3 ||              /* named_curve */
+            ((buf[1] << 8) + buf[2]) != TLS_CURVE_X25519 ||
+            buf[3] != X25519_SIZE)
+    {
+        ret = SSL_ERROR_NOT_SUPPORTED;
+        goto error;
+    }
+
+    memcpy(ssl->dc->ecdh_peer, &buf[4], X25519_SIZE);
+
+    if (ssl->version >= SSL_PROTOCOL_VERSION1_2)
+    {
+        PARANOIA_CHECK(hs_len, offset+2);
+        hash_alg = buf[offset];
+
+        if (buf[offset+1] != TLS_SIG_RSA)
+        {
+            ret = SSL_ERROR_NOT_SUPPORTED;
+            goto error;
+        }
+
+        offset += 2;
+    }
+
+    PARANOIA_CHECK(hs_len, offset+2);
+    sig_len = (buf[offset] << 8) + buf[offset+1];
+    offset += 2;
+    PARANOIA_CHECK(hs_len, offset+sig_len);
+
+    if ((ret = verify_server_key_xchg(ssl, buf, 4 + X25519_SIZE, 
+                                hash_alg, &buf[offset], sig_len)) < 0)
+    {
+        goto error;
+    }
+
+    ssl->next_state = HS_SERVER_HELLO_DONE;
+
+error:
+    return ret;
+}
+
 /**
  * Process the server hello done message.
  */
@@ -300,6 +546,41 @@ static int process_server_hello_done(SSL *ssl)
     return SSL_OK;
 }
 
+/*
+ * Send an ECDHE client key exchange message - our ephemeral public value. The
+ * shared secret is the premaster secret.
+ */
+static int send_client_ecdhe_xchg(SSL *ssl)
+{
+    uint8_t *buf = ssl->bm_data;
+    uint8_t premaster_secret[X25519_SIZE];
+    uint8_t nonzero = 0;
+    int i;
+
+    buf[0] = HS_CLIENT_KEY_XCHG;
+    buf[1] = 0;
+    buf[2] = 0;
+    buf[3] = X25519_SIZE + 1;
+    buf[4] = X25519_SIZE;
+
+    get_random(X25519_SIZE, ssl->dc->ecdh_private);
+    X25519_base(&buf[5], ssl->dc->ecdh_private);
+    X25519_scalarmult(premaster_secret, 
+                        ssl->dc->ecdh_private, ssl->dc->ecdh_peer);
+    memset(ssl->dc->ecdh_private, 0, X25519_SIZE);
+
+    /* a small order point from the server gives an all zero secret */
+    for (i = 0; i < X25519_SIZE; i++)
+        nonzero |= premaster_secret[i];
+
+    if (nonzero == 0)
+        return SSL_ERROR_INVALID_KEY;
+
+    generate_master_secret(ssl, premaster_secret, X25519_SIZE);
+    memset(premaster_secret, 0, X25519_SIZE);
+    return send_packet(ssl, PT_HANDSHAKE_PROTOCOL, NULL, X25519_SIZE+5);
+}
+
 /*
  * Send a client key exchange message.
  */
@@ -309,11 +590,14 @@ static int send_client_key_xchg(SSL *ssl)
     uint8_t premaster_secret[SSL_SECRET_SIZE];
     int enc_secret_size = -1;
 
+    if (get_cipher_info(ssl->cipher)->key_xchg == SSL_KEYX_ECDHE)
+        return send_client_ecdhe_xchg(ssl);
+
     buf[0] = HS_CLIENT_KEY_XCHG;
     buf[1] = 0;
 
     premaster_secret[0] = 0x03; /* encode the version number */
-    premaster_secret[1] = SSL_PROTOCOL_MINOR_VERSION; /* must be TLS 1.1 */
+    premaster_secret[1] = SSL_PROTOCOL_MINOR_VERSION; /* what we offered */
     get_random(SSL_SECRET_SIZE-2, &premaster_secret[2]);
     DISPLAY_RSA(ssl, ssl->x509_ctx->rsa_ctx);
 
@@ -328,7 +612,7 @@ static int send_client_key_xchg(SSL *ssl)
     buf[4] = enc_secret_size >> 8;
     buf[5] = enc_secret_size & 0xff;
 
-    generate_master_secret(ssl, premaster_secret);
+    generate_master_secret(ssl, premaster_secret, SSL_SECRET_SIZE);
 
     return send_packet(ssl, PT_HANDSHAKE_PROTOCOL, NULL, enc_secret_size+6);
 }
@@ -358,22 +642,41 @@ error:
 static int send_cert_verify(SSL *ssl)
 {
     uint8_t *buf = ssl->bm_data;
-    uint8_t dgst[MD5_SIZE+SHA1_SIZE];
+    static const uint8_t sha256_dinfo[] = 
+    {
+        0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01,
+        0x65, 0x03, 0x04, 0x02, 0x01, 0x05, 0x00, 0x04, 0x20
+    };
+    uint8_t dgst[sizeof(sha256_dinfo)+SHA256_SIZE];
     RSA_CTX *rsa_ctx = ssl->ssl_ctx->rsa_ctx;
-    int n = 0, ret;
+    int n = 0, ret, dgst_len, offset = 4;
 
     DISPLAY_RSA(ssl, rsa_ctx);
 
     buf[0] = HS_CERT_VERIFY;
     buf[1] = 0;
 
-    finished_digest(ssl, NULL, dgst);   /* calculate the digest */
+    if (ssl->version >= SSL_PROTOCOL_VERSION1_2)
+    {
+        /* TLSv1.2 signs a SHA256 DigestInfo and says so */
+        SHA256_CTX sha256_ctx = ssl->dc->sha256_ctx;
+        memcpy(dgst, sha256_dinfo, sizeof(sha256_dinfo));
+        SHA256_Final(&dgst[sizeof(sha256_dinfo)], &sha256_ctx);
+        dgst_len = sizeof(dgst);
+        buf[offset++] = TLS_HASH_SHA256;
+        buf[offset++] = TLS_SIG_RSA;
+    }
+    else
+    {
+        finished_digest(ssl, NULL, dgst);   /* calculate the digest */
+        dgst_len = MD5_SIZE+SHA1_SIZE;
+    }
 
     /* rsa_ctx->bi_ctx is not thread-safe */
     if (rsa_ctx)
     {
         SSL_CTX_LOCK(ssl->ssl_ctx->mutex);
-        n = RSA_encrypt(rsa_ctx, dgst, sizeof(dgst), &buf[6], 1);
+        n = RSA_encrypt(rsa_ctx, dgst, dgst_len, &buf[offset+2], 1);
         SSL_CTX_UNLOCK(ssl->ssl_ctx->mutex);
 
         if (n == 0)
@@ -383,9 +686,9 @@ static int send_cert_verify(SSL *ssl)
         }
     }
     
-    buf[4] = n >> 8;        /* add the RSA size (not officially documented) */
-    buf[5] = n & 0xff;
-    n += 2;
+    buf[offset] = n >> 8;   /* add the RSA size (not officially documented) */
+    buf[offset+1] = n & 0xff;
+    n += offset - 2;
     buf[2] = n >> 8;
     buf[3] = n & 0xff;
     ret = send_packet(ssl, PT_HANDSHAKE_PROTOCOL, NULL, n+4);
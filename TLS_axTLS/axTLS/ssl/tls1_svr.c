@@ -125,10 +125,11 @@ static int process_client_hello(SSL *ssl)
     uint8_t version = (buf[4] << 4) + buf[5];
     ssl->version = ssl->client_version = version;
 
-    if (version > SSL_PROTOCOL_VERSION_MAX)
+    if (version > SSL_PROTOCOL_VERSION1_1)
     {
-        /* use client's version instead */
-        ssl->version = SSL_PROTOCOL_VERSION_MAX; 
+        /* use client's version instead - the server side doesn't do the 
+           TLSv1.2 signature algorithms, so stays at TLSv1.1 */
+        ssl->version = SSL_PROTOCOL_VERSION1_1; 
     }
     else if (version < SSL_PROTOCOL_MIN_VERSION)  /* old version supported? */
     {
@@ -153,17 +154,19 @@ static int process_client_hello(SSL *ssl)
 
     offset += id_len;
     cs_len = (buf[offset]<<8) + buf[offset+1];
-    offset += 3;        /* add 1 due to all cipher suites being 8 bit */
+    offset += 2;
 
-    PARANOIA_CHECK(pkt_size, offset);
+    PARANOIA_CHECK(pkt_size, offset+cs_len);
 
     /* work out what cipher suite we are going to use - client defines 
-       the preference */
+       the preference (we don't send a server key exchange, so RSA only) */
     for (i = 0; i < cs_len; i += 2)
     {
         for (j = 0; j < NUM_PROTOCOLS; j++)
         {
-            if (ssl_prot_prefs[j] == buf[offset+i])   /* got a match? */
+            if (ssl_prot_prefs[j] && 
+                    ssl_prot_prefs[j] == (buf[offset+i] << 8) + buf[offset+i+1] &&
+                    get_cipher_info(ssl_prot_prefs[j])->key_xchg == SSL_KEYX_RSA)
             {
                 ssl->cipher = ssl_prot_prefs[j];
                 goto do_state;
@@ -210,9 +213,13 @@ int process_sslv23_client_hello(SSL *ssl)
     /* now work out what cipher suite we are going to use */
     for (j = 0; j < NUM_PROTOCOLS; j++)
     {
+        if (ssl_prot_prefs[j] == 0 || 
+                get_cipher_info(ssl_prot_prefs[j])->key_xchg != SSL_KEYX_RSA)
+            continue;
+
         for (i = 0; i < cs_len; i += 3)
         {
-            if (ssl_prot_prefs[j] == buf[offset+i])
+            if (ssl_prot_prefs[j] == (buf[offset+i-1] << 8) + buf[offset+i])
             {
                 ssl->cipher = ssl_prot_prefs[j];
                 goto server_hello;
@@ -347,8 +354,8 @@ static int send_server_hello(SSL *ssl)
 #endif
     }
 
-    buf[offset++] = 0;      /* cipher we are using */
-    buf[offset++] = ssl->cipher;
+    buf[offset++] = ssl->cipher >> 8;   /* cipher we are using */
+    buf[offset++] = ssl->cipher & 0xff;
     buf[offset++] = 0;      /* no compression */
     buf[3] = offset - 4;    /* handshake size */
     return send_packet(ssl, PT_HANDSHAKE_PROTOCOL, NULL, offset);
@@ -409,7 +416,7 @@ static int process_client_key_xchg(SSL *ssl)
     print_blob("pre-master", premaster_secret, SSL_SECRET_SIZE);
 #endif
 
-    generate_master_secret(ssl, premaster_secret);
+    generate_master_secret(ssl, premaster_secret, SSL_SECRET_SIZE);
 
 #ifdef CONFIG_SSL_CERT_VERIFICATION
     ssl->next_state = IS_SET_SSL_FLAG(SSL_CLIENT_AUTHENTICATION) ?  
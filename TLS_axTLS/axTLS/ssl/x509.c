@@ -121,7 +121,7 @@ int x509_new(const uint8_t *cert, int *len, X509_CTX **ctx)
 
 #ifdef CONFIG_SSL_CERT_VERIFICATION /* only care if doing verification */
     
-    /* use the appropriate signature algorithm (SHA1/MD5/MD2) */
+    /* use the appropriate signature algorithm (SHA256/SHA1/MD5/MD2) */
     
     if (x509_ctx->sig_type == SIG_TYPE_MD5)
     {
@@ -141,6 +141,15 @@ int x509_new(const uint8_t *cert, int *len, X509_CTX **ctx)
         SHA1_Final(sha_dgst, &sha_ctx);
         x509_ctx->digest = bi_import(bi_ctx, sha_dgst, SHA1_SIZE);
     }
+    else if (x509_ctx->sig_type == SIG_TYPE_SHA256)
+    {
+        SHA256_CTX sha256_ctx;
+        uint8_t sha256_dgst[SHA256_SIZE];
+        SHA256_Init(&sha256_ctx);
+        SHA256_Update(&sha256_ctx, &cert[begin_tbs], end_tbs-begin_tbs);
+        SHA256_Final(sha256_dgst, &sha256_ctx);
+        x509_ctx->digest = bi_import(bi_ctx, sha256_dgst, SHA256_SIZE);
+    }
     else if (x509_ctx->sig_type == SIG_TYPE_MD2)
     {
         MD2_CTX md2_ctx;
@@ -496,6 +505,9 @@ void x509_print(const X509_CTX *cert, CA_CERT_CTX *ca_cert_ctx)
         case SIG_TYPE_SHA1:
             printf("SHA1\r\n");
             break;
+        case SIG_TYPE_SHA256:
+            printf("SHA256\r\n");
+            break;
         case SIG_TYPE_MD2:
             printf("MD2\r\n");
             break;
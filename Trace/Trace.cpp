@@ -0,0 +1,274 @@
+#include "mbed.h"
+#include "rtos.h"
+
+#include <stdarg.h>
+#include <string.h>
+
+#include "Trace.h"
+
+#define TRACE_MASK          (TRACE_RING_WORDS - 1)
+
+// Kinds of arguments a conversion takes
+#define TRACE_ARG_NONE      0       // %%
+#define TRACE_ARG_INT       1       // one word
+#define TRACE_ARG_LONG      2       // two words, %ll
+#define TRACE_ARG_DOUBLE    3       // two words
+#define TRACE_ARG_STR       4       // NUL terminated, padded to words
+
+// Set by the linker script
+extern "C" const char __trace_fmt_start[];
+extern "C" const char __trace_fmt_end[];
+
+// Records are a header word (TRACE_VALID | words << 16 | format ID), the
+// time stamp in us and the arguments. The header is written last, the
+// drain stops at the first slot without TRACE_VALID.
+static volatile uint32_t _ring[TRACE_RING_WORDS];
+static volatile uint32_t _head;     // words reserved
+static volatile uint32_t _tail;     // words drained
+static volatile uint32_t _dropped;  // records that did not fit
+
+static Stream *_out;
+static FILE *_log;
+static Thread *_thread;
+static Mutex _drain;                // one reader of the ring at a time
+
+
+/**
+ * \brief Finds the next conversion of a format string
+ * \param p where to start
+ * \param spec returns the start of the conversion ('%')
+ * \param kind returns the kind of argument it takes
+ * \return end of the conversion, NULL if there is none
+ **/
+static const char *trace_next(const char *p, const char **spec, int *kind)
+{
+    int wide = 0;
+
+    while (*p != '%') {
+        if (*p++ == 0)
+            return NULL;
+    }
+    *spec = p++;
+    // flags, width and precision, then the length
+    while ((*p >= '0' && *p <= '9') || *p == '.' || *p == '-' ||
+           *p == '+' || *p == ' ' || *p == '#')
+        p++;
+    for (;; p++) {
+        if (*p == 'l')
+            wide++;
+        else if (*p == 'j' || *p == 'L')
+            wide += 2;
+        else if (*p != 'h' && *p != 'z' && *p != 't')
+            break;
+    }
+    switch (*p) {
+    case 0:
+    case '*':
+        return NULL;
+    case '%':
+        *kind = TRACE_ARG_NONE;
+        break;
+    case 's':
+        *kind = TRACE_ARG_STR;
+        break;
+    case 'e': case 'E': case 'f': case 'F':
+    case 'g': case 'G': case 'a': case 'A':
+        *kind = TRACE_ARG_DOUBLE;
+        break;
+    default:
+        *kind = (wide >= 2) ? TRACE_ARG_LONG : TRACE_ARG_INT;
+        break;
+    }
+    return p + 1;
+}
+
+static void atomic_add(volatile uint32_t *p, uint32_t n)
+{
+    do {
+    } while (__STREXW(__LDREXW(p) + n, p));
+}
+
+void trace_write(const char *fmt, ...)
+{
+    uint32_t rec[TRACE_MAX_WORDS];
+    const char *p = fmt, *spec, *s;
+    int kind, len, n = 2;
+    uint32_t pos;
+    va_list ap;
+
+    va_start(ap, fmt);
+    while ((p = trace_next(p, &spec, &kind)) != NULL) {
+        if (kind == TRACE_ARG_NONE)
+            continue;
+        if (kind == TRACE_ARG_INT) {
+            if (n + 1 > TRACE_MAX_WORDS)
+                break;
+            rec[n++] = va_arg(ap, uint32_t);
+        } else if (kind == TRACE_ARG_STR) {
+            s = va_arg(ap, const char *);
+            if (s == NULL)
+                s = "(null)";
+            for (len = 0; len < TRACE_STR_MAX && s[len]; len++)
+                ;
+            if (n + len / 4 + 1 > TRACE_MAX_WORDS)
+                break;
+            rec[n + len / 4] = 0;
+            memcpy(&rec[n], s, len);
+            ((char *)&rec[n])[len] = 0;
+            n += len / 4 + 1;
+        } else {
+            if (n + 2 > TRACE_MAX_WORDS)
+                break;
+            if (kind == TRACE_ARG_LONG) {
+                uint64_t v = va_arg(ap, uint64_t);
+                memcpy(&rec[n], &v, 8);
+            } else {
+                double v = va_arg(ap, double);
+                memcpy(&rec[n], &v, 8);
+            }
+            n += 2;
+        }
+    }
+    va_end(ap);
+
+    // reserve n words, give up if the drain is behind
+    do {
+        pos = __LDREXW(&_head);
+        if (pos + n - _tail > TRACE_RING_WORDS) {
+            __CLREX();
+            atomic_add(&_dropped, 1);
+            return;
+        }
+    } while (__STREXW(pos + n, &_head));
+
+    _ring[(pos + 1) & TRACE_MASK] = us_ticker_read();
+    for (int i = 2; i < n; i++)
+        _ring[(pos + i) & TRACE_MASK] = rec[i];
+    __DMB();
+    _ring[pos & TRACE_MASK] = TRACE_VALID | (n << 16) | (uint32_t)(fmt - __trace_fmt_start);
+}
+
+/**
+ * \brief Prints a record as text
+ **/
+static void trace_print(FILE *f, const uint32_t *rec, int n)
+{
+    const char *p, *q, *spec;
+    char buf[16];
+    int kind, i = 2;
+
+    fprintf(f, "[%lu.%06lu] ", (unsigned long)(rec[1] / 1000000),
+            (unsigned long)(rec[1] % 1000000));
+    if ((rec[0] & 0xFFFF) == TRACE_DROPPED) {
+        fprintf(f, "trace: %lu records dropped\r\n", (unsigned long)rec[2]);
+        return;
+    }
+    p = __trace_fmt_start + (rec[0] & 0xFFFF);
+    while ((q = trace_next(p, &spec, &kind)) != NULL) {
+        fwrite(p, 1, spec - p, f);
+        p = q;
+        if (kind == TRACE_ARG_NONE) {
+            fputc('%', f);
+            continue;
+        }
+        if (q - spec >= (int)sizeof(buf) ||
+            i + (kind == TRACE_ARG_LONG || kind == TRACE_ARG_DOUBLE ? 2 : 1) > n) {
+            // not recorded, print the conversion itself
+            fwrite(spec, 1, q - spec, f);
+            continue;
+        }
+        memcpy(buf, spec, q - spec);
+        buf[q - spec] = 0;
+        if (kind == TRACE_ARG_INT) {
+            fprintf(f, buf, rec[i++]);
+        } else if (kind == TRACE_ARG_STR) {
+            fprintf(f, buf, (const char *)&rec[i]);
+            i += strlen((const char *)&rec[i]) / 4 + 1;
+        } else if (kind == TRACE_ARG_LONG) {
+            uint64_t v;
+            memcpy(&v, &rec[i], 8);
+            fprintf(f, buf, v);
+            i += 2;
+        } else {
+            double v;
+            memcpy(&v, &rec[i], 8);
+            fprintf(f, buf, v);
+            i += 2;
+        }
+    }
+    fputs(p, f);
+    fputs("\r\n", f);
+}
+
+static void trace_emit(const uint32_t *rec, int n)
+{
+    if (_log)
+        fwrite(rec, sizeof(uint32_t), n, _log);
+    if (_out)
+        trace_print((FILE *)*_out, rec, n);
+}
+
+int trace_flush()
+{
+    uint32_t rec[TRACE_MAX_WORDS];
+    uint32_t d;
+    int i, n, count = 0;
+
+    _drain.lock();
+    while (_ring[_tail & TRACE_MASK] & TRACE_VALID) {
+        n = (_ring[_tail & TRACE_MASK] >> 16) & 0xFF;
+        for (i = 0; i < n; i++) {
+            rec[i] = _ring[(_tail + i) & TRACE_MASK];
+            _ring[(_tail + i) & TRACE_MASK] = 0;
+        }
+        __DMB();
+        _tail += n;
+        trace_emit(rec, n);
+        count++;
+    }
+
+    do {
+        d = __LDREXW(&_dropped);
+    } while (__STREXW(0, &_dropped));
+    if (d) {
+        rec[0] = TRACE_VALID | (3 << 16) | TRACE_DROPPED;
+        rec[1] = us_ticker_read();
+        rec[2] = d;
+        trace_emit(rec, 3);
+    }
+
+    if ((count || d) && _log)
+        fflush(_log);
+    _drain.unlock();
+    return count;
+}
+
+static void trace_thread(const void *arg)
+{
+    while (true) {
+        trace_flush();
+        Thread::wait(TRACE_DRAIN_MS);
+    }
+}
+
+void trace_start(Stream *out, const char *logfile,
+        osPriority priority,
+        int stackSize,
+        unsigned char *stack_pointer)
+{
+    uint32_t session[3];
+
+    _out = out;
+    if (logfile && _log == NULL) {
+        _log = fopen(logfile, "ab");
+        if (_log) {
+            // lets tracedump.py check it has the right ELF
+            session[0] = TRACE_MAGIC;
+            session[1] = (uint32_t)(uintptr_t)__trace_fmt_start;
+            session[2] = __trace_fmt_end - __trace_fmt_start;
+            fwrite(session, sizeof(uint32_t), 3, _log);
+        }
+    }
+    if (_thread == NULL)
+        _thread = new Thread(trace_thread, NULL, priority, stackSize, stack_pointer);
+}
@@ -0,0 +1,84 @@
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include "mbed.h"
+#include "rtos.h"
+
+/**
+ * Deferred binary logging
+ *
+ * TRACE() stores the format string ID, a time stamp and the raw arguments
+ * in a lock free ring buffer, it does not format anything. A low priority
+ * drain thread formats the records to a Stream and/or appends them as is
+ * to a binary log (e.g. on /sd), Trace/tracedump.py decodes such a log
+ * with the format strings of the matching ELF.
+ *
+ * The format strings live in their own flash section (.trace_fmt), the ID
+ * of a string is its offset in there.
+ *
+ * Tracing is compiled in per module, define TRACE_ON before including
+ * this file. Without it TRACE() expands to nothing and its arguments are
+ * not evaluated.
+ *
+ *   #define TRACE_ON 1
+ *   #include "Trace.h"
+ *   ...
+ *   TRACE("[HTTPClient : DBG]Read %d chars", ret);
+ *
+ * Arguments are recorded as the format says: integers and pointers as a
+ * word, %ll and floating point as two words, %s strings are copied (up
+ * to TRACE_STR_MAX characters). '*' width and precision is not supported.
+ * TRACE() can be used from any thread and from interrupts, a record that
+ * does not fit the ring is counted and dropped.
+ */
+
+#define TRACE_RING_WORDS    256     // ring buffer size, power of 2
+#define TRACE_MAX_WORDS     32      // largest record
+#define TRACE_STR_MAX       31      // characters kept of a %s argument
+#define TRACE_DRAIN_MS      50      // drain thread period
+
+#define TRACE_VALID         0x80000000UL    // header: record committed
+#define TRACE_DROPPED       0xFFFF          // header: format ID of the dropped count
+#define TRACE_MAGIC         0x31435254UL    // "TRC1", starts a binary log session
+
+#if TRACE_ON
+// printf() is never called, it lets the compiler check the arguments
+// against the format
+#define TRACE(fmt, ...) do { \
+        static const char _trace_fmt[] __attribute__((section(".trace_fmt"))) = fmt; \
+        if (0) printf(fmt, ##__VA_ARGS__); \
+        trace_write(_trace_fmt, ##__VA_ARGS__); \
+    } while (0)
+#else
+#define TRACE(fmt, ...) do { } while (0)
+#endif
+
+/** Records a message, use TRACE() instead
+ *
+ * @param fmt format string in the .trace_fmt section
+ */
+void trace_write(const char *fmt, ...);
+
+/** Starts the drain thread
+ *
+ * The drain thread writes to out without a lock: stdio has no locks in
+ * this build, so out must not be used by any other thread (e.g. give it
+ * a UART of its own, not the shell's).
+ *
+ * @param out stream the records are printed to, NULL: none
+ * @param logfile file the records are appended to, NULL: none
+ */
+void trace_start(Stream *out, const char *logfile = NULL,
+        osPriority priority = osPriorityLow,
+        int stackSize = 1024,
+        unsigned char *stack_pointer = NULL);
+
+/** Drains the ring buffer now, e.g. before a reset
+ *
+ * Takes the lock of the drain thread, not for interrupts.
+ *
+ * @returns number of records drained
+ */
+int trace_flush();
+
+#endif
@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+"""Decodes a binary trace log written by Trace/Trace.cpp
+
+    tracedump.py mbed_blinky.elf trace.bin
+
+The format strings are taken from the .trace_fmt section of the ELF the
+firmware was built as, a record holds the offset of its string in there.
+"""
+
+import re
+import struct
+import sys
+
+TRACE_VALID = 0x80000000
+TRACE_DROPPED = 0xFFFF
+TRACE_MAGIC = 0x31435254
+
+# same conversions as trace_next() in Trace.cpp
+CONV = re.compile(r'%([-+ #0-9.]*)([hlLjzt]*)(.)')
+
+
+def read_section(path, name):
+    """Returns (address, contents) of a section of a 32 bit ELF"""
+    data = open(path, 'rb').read()
+    if data[:4] != b'\x7fELF' or data[4] != 1:
+        sys.exit('%s: not a 32 bit ELF file' % path)
+    shoff, = struct.unpack_from('<I', data, 0x20)
+    shentsize, shnum, shstrndx = struct.unpack_from('<HHH', data, 0x2E)
+    headers = [struct.unpack_from('<IIIIII', data, shoff + i * shentsize)
+               for i in range(shnum)]
+    strtab = headers[shstrndx][4]
+    for sh_name, sh_type, sh_flags, sh_addr, sh_offset, sh_size in headers:
+        end = data.index(b'\0', strtab + sh_name)
+        if data[strtab + sh_name:end].decode() == name:
+            return sh_addr, data[sh_offset:sh_offset + sh_size]
+    sys.exit('%s: no %s section, was it built with TRACE_ON?' % (path, name))
+
+
+def words_to_bytes(words):
+    return struct.pack('<%dI' % len(words), *words)
+
+
+def format_record(fmts, rec):
+    """Formats one record like trace_print() does"""
+    fmt_id = rec[0] & 0xFFFF
+    if fmt_id == TRACE_DROPPED:
+        return 'trace: %d records dropped' % rec[2]
+    end = fmts.find(b'\0', fmt_id)
+    if fmt_id >= len(fmts) or end < 0:
+        return '<unknown format %#x>' % fmt_id
+    fmt = fmts[fmt_id:end].decode('latin-1')
+    args = rec[2:]
+    out = []
+    pos = 0
+    for m in CONV.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, length, conv = m.groups()
+        if conv == '%':
+            out.append('%')
+            continue
+        wide = conv in 'eEfFgGaA' or length.count('l') >= 2 or 'j' in length
+        if conv == '*' or len(args) < (2 if wide else 1):
+            # not recorded
+            out.append(m.group(0))
+            continue
+        if conv == 's':
+            raw = words_to_bytes(args)
+            s = raw[:raw.index(b'\0')] if b'\0' in raw else raw
+            args = args[len(s) // 4 + 1:]
+            out.append(('%' + flags + 's') % s.decode('latin-1'))
+        elif conv in 'eEfFgGaA':
+            v, = struct.unpack('<d', words_to_bytes(args[:2]))
+            args = args[2:]
+            out.append(('%' + flags + conv.replace('a', 'e').replace('A', 'E')) % v)
+        else:
+            if wide:
+                v, = struct.unpack('<Q', words_to_bytes(args[:2]))
+                bits = 64
+                args = args[2:]
+            else:
+                v = args[0]
+                bits = 32
+                args = args[1:]
+            if conv in 'di' and v >= 1 << (bits - 1):
+                v -= 1 << bits
+            if conv == 'p':
+                out.append('0x' + ('%' + flags + 'x') % v)
+            elif conv in 'diuxXoc':
+                out.append(('%' + flags + conv.replace('i', 'd')) % v)
+            else:
+                out.append(m.group(0))
+    out.append(fmt[pos:])
+    return ''.join(out)
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(__doc__.strip())
+    fmt_addr, fmts = read_section(sys.argv[1], '.trace_fmt')
+    log = open(sys.argv[2], 'rb').read()
+    words = struct.unpack('<%dI' % (len(log) // 4), log[:len(log) // 4 * 4])
+
+    i = 0
+    skipped = 0
+    while i < len(words):
+        w = words[i]
+        if w == TRACE_MAGIC and i + 3 <= len(words):
+            print('--- trace session ---')
+            if words[i + 1] != fmt_addr or words[i + 2] != len(fmts):
+                print('warning: log was written by another build of %s' % sys.argv[1])
+            i += 3
+        elif w & TRACE_VALID and 2 <= (w >> 16) & 0xFF <= len(words) - i:
+            n = (w >> 16) & 0xFF
+            rec = words[i:i + n]
+            print('[%d.%06d] %s' % (rec[1] // 1000000, rec[1] % 1000000,
+                                    format_record(fmts, rec)))
+            i += n
+        else:
+            skipped += 1
+            i += 1
+    if skipped:
+        print('warning: skipped %d words that were not records' % skipped)
+
+
+if __name__ == '__main__':
+    main()
@@ -8,10 +8,11 @@
  * Copyright (C) 2012 NXP Semiconductors(NXP), All rights reserved.
  */
 
-#include "GUI.h"
 #include "mbed.h"
 #include "rtos.h"
+#include "GUI.h"			/* after rtos.h, which typedefs U8/U16/U32 */
 #include "LCD_X_SPI.h"
+#include "gpdma_irq.h"
 
 // Our global SPI instance for the display
 static SPI ili9341(ILI9341_SPI_MOSI, ILI9341_SPI_MISO, ILI9341_SPI_SCK);
@@ -43,11 +44,31 @@ DigitalOut lcd_dc(ILI9341_LCD_DC);
 #define SPI_DATA    (0x02)              /* RS bit 1 within start byte */
 #define SPI_INDEX   (0x00)              /* RS bit 0 within start byte */
 
+/*--------------- GPDMA configuration for the pixel data ---------------------*/
+
+#define LCD_DMA_CH          LPC_GPDMACH7    /* lowest priority channel */
+#define LCD_DMA_CH_NUM      7
+#define LCD_DMA_CH_BIT      (1 << LCD_DMA_CH_NUM)
+#define LCD_DMA_SSP1_TX     2               /* DMA request line of SSP1 Tx */
+#define LCD_DMA_MAX_XFER    4095            /* TransferSize field is 12 bit */
+#define LCD_DMA_MIN_WORDS   32              /* below this the CPU is quicker */
+
+#define SSP_CR0_DSS_MASK    0x0F
+#define SSP_CR0_DSS_8       0x07
+#define SSP_CR0_DSS_16      0x0F
+#define SSP_CR1_SSE         (1<<1)
+#define SSP_DMACR_TXDMAE    (1<<1)
+
+static osSemaphoreId lcd_dma_sem;
+osSemaphoreDef(lcd_dma_sem);
+
 /* local functions */
 __inline void wr_cmd (unsigned char cmd);						/* Write command to LCD */
 __inline void wr_dat (unsigned short dat);						/* Write data to LCD */
 __inline unsigned char spi_tran (unsigned char byte);	/* Write and read a byte over SPI */
 __inline void spi_tran_fifo (unsigned char byte);		/* Only write a byte over SPI (faster) */
+static void ssp_frame_size (uint32_t dss);				/* Switch between 8 and 16 bit frames */
+static void LCD_X_DMA_IRQHandler (uint32_t id, int error);	/* Pixel DMA done */
 
 /*******************************************************************************
 * Initialize SPI (SSP) peripheral at 8 databit with a bitrate of 12.5Mbps      *
@@ -82,6 +103,16 @@ void LCD_X_SPI_Init(void)
   while(LPC_SSP1->SR & (1<<2))
     Dummy = LPC_SSP1->DR;			/* Clear the Rx FIFO */
 
+  /* GPDMA feeds the SSP1 Tx FIFO for WriteM01, completion is signalled
+     from the DMA interrupt, whose vector is shared by all channels */
+  LPC_SC->PCONP       |= (1 << 29);	/* Power up the GPDMA */
+  LPC_GPDMA->DMACConfig = 0x01;		/* Enable, little endian */
+  LPC_GPDMA->DMACIntTCClear  = LCD_DMA_CH_BIT;
+  LPC_GPDMA->DMACIntErrClr   = LCD_DMA_CH_BIT;
+  if (lcd_dma_sem == NULL)
+    lcd_dma_sem = osSemaphoreCreate(osSemaphore(lcd_dma_sem), 0);
+  gpdma_irq_set(LCD_DMA_CH_NUM, LCD_X_DMA_IRQHandler, 0);
+
   LPC_GPIO4->FIOSET = 0x10000000;	/* Activate LCD backlight */
 }
 
@@ -116,12 +147,51 @@ void LCD_X_SPI_WriteM01(U16 * pData, int NumWords)
   LCD_CS(0);
   spi_tran_fifo(SPI_START | SPI_WR | SPI_DATA);			/* Write : RS = 1, RW = 0 */
 
-  while(NumWords--)
+  /* The SSP sends the MSB first, so 16 bit frames give D8..D15 then D0..D7 */
+  ssp_frame_size(SSP_CR0_DSS_16);
+
+  if (NumWords < LCD_DMA_MIN_WORDS || __get_IPSR() != 0)
   {
-	  spi_tran_fifo(((*pData) >>   8));					/* Write D8..D15 */
-	  spi_tran_fifo(((*(pData++)) & 0xFF));				/* Write D0..D7 */
+    while(NumWords--)
+    {
+      while (!(LPC_SSP1->SR & (1<<1)));					/* wait until TNF set */
+      LPC_SSP1->DR = *(pData++);
+    }
   }
+  else
+  {
+    LPC_SSP1->DMACR = SSP_DMACR_TXDMAE;
+    while(NumWords > 0)
+    {
+      int Chunk = (NumWords > LCD_DMA_MAX_XFER) ? LCD_DMA_MAX_XFER : NumWords;
+
+      LPC_GPDMA->DMACIntTCClear = LCD_DMA_CH_BIT;
+      LPC_GPDMA->DMACIntErrClr  = LCD_DMA_CH_BIT;
+      LCD_DMA_CH->DMACCSrcAddr  = (uint32_t)pData;
+      LCD_DMA_CH->DMACCDestAddr = (uint32_t)&LPC_SSP1->DR;
+      LCD_DMA_CH->DMACCLLI      = 0;
+      LCD_DMA_CH->DMACCControl  = Chunk
+                                | (1 << 12)				/* SBSize = 4 */
+                                | (1 << 15)				/* DBSize = 4 */
+                                | (1 << 18)				/* SWidth = 16 bit */
+                                | (1 << 21)				/* DWidth = 16 bit */
+                                | (1 << 26)				/* source increment */
+                                | (1UL << 31);			/* terminal count interrupt */
+      LCD_DMA_CH->DMACCConfig   = 1							/* enable */
+                                | (LCD_DMA_SSP1_TX << 6)	/* destination peripheral */
+                                | (1 << 11)				/* memory to peripheral */
+                                | (1 << 14)				/* error interrupt */
+                                | (1 << 15);			/* terminal count interrupt */
+
+      osSemaphoreWait(lcd_dma_sem, osWaitForever);
+      pData    += Chunk;
+      NumWords -= Chunk;
+    }
+    LPC_SSP1->DMACR = 0;
+  }
+
   while(LPC_SSP1->SR & (1<<4));							/* wait until done */
+  ssp_frame_size(SSP_CR0_DSS_8);
   LCD_CS(1);
 }
 
@@ -203,4 +273,30 @@ __inline void spi_tran_fifo (unsigned char byte)
   LPC_SSP1->DR = byte;
 }
 
+/*******************************************************************************
+* Change the SSP1 frame size. The SSP has to be idle and disabled while the    *
+* data size is changed.                                                        *
+*   Parameter:    dss:    SSP_CR0_DSS_8 or SSP_CR0_DSS_16                      *
+*   Return:                                                                    *
+*******************************************************************************/
+static void ssp_frame_size (uint32_t dss)
+{
+  while(LPC_SSP1->SR & (1<<4));							/* wait until done */
+  LPC_SSP1->CR1 &= ~SSP_CR1_SSE;
+  LPC_SSP1->CR0  = (LPC_SSP1->CR0 & ~SSP_CR0_DSS_MASK) | dss;
+  LPC_SSP1->CR1 |= SSP_CR1_SSE;
+}
+
+/*******************************************************************************
+* GPDMA interrupt of the pixel channel, its flags are already cleared: wake   *
+* the thread waiting in LCD_X_SPI_WriteM01                                     *
+*   Parameter:    id:     unused                                               *
+*                 error:  1 on a DMA error, the chunk is not sent again        *
+*   Return:                                                                    *
+*******************************************************************************/
+static void LCD_X_DMA_IRQHandler (uint32_t id, int error)
+{
+  osSemaphoreRelease(lcd_dma_sem);
+}
+
 /*************************** End of file ****************************/
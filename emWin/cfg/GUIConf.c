@@ -16,6 +16,7 @@ Purpose     : Display controller initialization
 */
 
 #include "GUI.h"
+#include "WM.h"
 
 /*********************************************************************
 *
@@ -29,6 +30,13 @@ Purpose     : Display controller initialization
 //
 #define GUI_NUMBYTES  1024 * 16  // x KByte
 
+//
+// A full screen memory device (320x240x16bpp = 150 KByte) never fits, so
+// the window manager draws through banded memory devices carved out of
+// GUI_NUMBYTES: about 20 lines per band at 16 KByte, leaving room for the
+// widgets themselves.
+//
+
 //
 // Define the average block size
 //
@@ -78,6 +86,10 @@ void GUI_X_Config(void) {
   //
   GUI_ALLOC_AssignMemory(_aMemory, GUI_NUMBYTES);
   GUI_ALLOC_SetAvBlockSize(GUI_BLOCKSIZE);
+  //
+  // Redraw windows off screen for flicker free partial updates
+  //
+  WM_SetCreateFlags(WM_CF_MEMDEV);
 }
 
 /*************************** End of file ****************************/
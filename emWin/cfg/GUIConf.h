@@ -40,7 +40,7 @@ Purpose     : Configuration of available features and default values
 #define GUI_SUPPORT_MOUSE         (0)  // Support a mouse
 #define GUI_SUPPORT_UNICODE       (1)  // Support mixed ASCII/UNICODE strings
 #define GUI_WINSUPPORT            (1)  // Window manager package available
-#define GUI_SUPPORT_MEMDEV        (0)  // Memory devices available
+#define GUI_SUPPORT_MEMDEV        (1)  // Memory devices available
 #define GUI_SUPPORT_AA            (0)  // Anti aliasing available
 #define WM_SUPPORT_STATIC_MEMDEV  (0)  // Static memory devices available
 
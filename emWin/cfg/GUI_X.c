@@ -15,6 +15,8 @@ Purpose     : Config / System dependent externals for GUI
 ---------------------------END-OF-HEADER------------------------------
 */
 #include <stdio.h>
+#include "cmsis_os.h"       // before GUI.h: RTX typedefs U8/U16/U32 itself
+#include "us_ticker_api.h"
 #include "GUI.h"
 
 /*********************************************************************
@@ -23,6 +25,17 @@ Purpose     : Config / System dependent externals for GUI
 */
 volatile int TimeMS;
 
+/*********************************************************************
+*
+*       Static data
+*/
+static U32 _LastUs;               // us ticker value TimeMS was last advanced to
+static osMutexId _Mutex;          // RTX mutexes are recursive, as emWin needs
+osMutexDef(_Mutex);
+static osThreadId _EventTask;     // thread blocked in GUI_X_WaitEvent()
+
+#define GUI_X_SIGNAL_EVENT  (1 << 14)  // keep clear of the low application flags
+
 /*********************************************************************
 *
 *      Timing:
@@ -35,12 +48,20 @@ volatile int TimeMS;
 */
 
 int GUI_X_GetTime(void) {
+  U32 Elapsed;
+
+  //
+  // Advance in whole ms from the 1us ticker, so the 32 bit wrap of the
+  // ticker doesn't show up as a jump in GUI time
+  //
+  Elapsed  = (us_ticker_read() - _LastUs) / 1000;
+  _LastUs += Elapsed * 1000;
+  TimeMS  += Elapsed;
   return TimeMS;
 }
 
 void GUI_X_Delay(int ms) {
-  int tEnd = TimeMS + ms;
-  while ((tEnd - TimeMS) > 0);
+  osDelay(ms);
 }
 
 /*********************************************************************
@@ -54,7 +75,8 @@ void GUI_X_Delay(int ms) {
 */
 
 void GUI_X_Init(void) {
-  TimeMS = 0;
+  TimeMS  = 0;
+  _LastUs = us_ticker_read();
 }
 
 
@@ -66,7 +88,9 @@ void GUI_X_Init(void) {
 *  Called if WM is in idle state
 */
 
-void GUI_X_ExecIdle(void) {}
+void GUI_X_ExecIdle(void) {
+  osDelay(1);
+}
 
 /*********************************************************************
 *
@@ -87,12 +111,45 @@ void GUI_X_ExecIdle(void) {}
 */
 
 
-//static OS_RSEMA RSema;
+void GUI_X_InitOS(void) {
+  _Mutex = osMutexCreate(osMutex(_Mutex));
+  GUI_SetSignalEventFunc(GUI_X_SignalEvent);
+  GUI_SetWaitEventFunc(GUI_X_WaitEvent);
+  GUI_SetWaitEventTimedFunc(GUI_X_WaitEventTimed);
+}
+
+void GUI_X_Unlock(void)    { osMutexRelease(_Mutex); }
+void GUI_X_Lock(void)      { osMutexWait(_Mutex, osWaitForever); }
+U32  GUI_X_GetTaskId(void) { return (U32)osThreadGetId(); }
+
+/*********************************************************************
+*
+*      Event driving (optional with multitasking)
+*
+*                 GUI_X_WaitEvent()
+*                 GUI_X_WaitEventTimed()
+*                 GUI_X_SignalEvent()
+*
+* Note:
+*   Lets GUI_Exec()/GUI_Delay() sleep until input or a WM message
+*   arrives instead of polling.
+*/
+
+void GUI_X_WaitEvent(void) {
+  _EventTask = osThreadGetId();
+  osSignalWait(GUI_X_SIGNAL_EVENT, osWaitForever);
+}
+
+void GUI_X_WaitEventTimed(int Period) {
+  _EventTask = osThreadGetId();
+  osSignalWait(GUI_X_SIGNAL_EVENT, Period);
+}
 
-void GUI_X_InitOS(void)    { /*OS_CreateRSema(&RSema);*/    }
-void GUI_X_Unlock(void)    { /*OS_Unuse(&RSema);*/ }
-void GUI_X_Lock(void)      { /*OS_Use(&RSema);*/  }
-U32  GUI_X_GetTaskId(void) { return 0; /*(U32)OS_GetTaskID();*/ }
+void GUI_X_SignalEvent(void) {
+  if (_EventTask) {
+    osSignalSet(_EventTask, GUI_X_SIGNAL_EVENT);
+  }
+}
 
 /*********************************************************************
 *
@@ -9,5 +9,9 @@
 
 #define USE_MUTEX 1
 
+// Run the trace drain thread (Trace/Trace.h), modules
+// built with TRACE_ON record into it
+#define USE_TRACE 0
+
 #endif
 
@@ -6,17 +6,26 @@
 #include "SPI_TFT_ILI9341.h"
 #include "Shell.h"
 #include "HTU21D.h"
+#include "HTTPFileServer.h"
+#include "lwip/mem.h"
+#include "globals.h"
+#include "Trace.h"
+#include <malloc.h>
 //#include "USBHostMSD.h"
 
 Serial pc(p28, p27); // (USBTX, USBRX);
 DigitalOut myled(LED1);
 EthernetInterface eth;
+HTTPFileServer httpd("/sd");
 
 Mutex i2cMutex;
 I2C i2c(p9 , p10);
 HTU21D htu21d(p9,p10,i2cMutex);
 
 #define IO_EXT_ADDR (0x21 << 1)
+#define DNS_CACHE_FILE "/sd/dns.txt"
+#define DHCP_LEASE_FILE "/sd/lease.txt"
+#define TRACE_LOG_FILE "/sd/trace.bin"
 
 LocalFileSystem lcl("local"); // mosi, miso, sck, cs 
 SPI_TFT_ILI9341 TFT(p11,p12,p13,p15, p16, p17 ); // mosi, miso, sck, cs, reset, dc
@@ -82,6 +91,133 @@ static void cmd_mem(Stream * chp, int argc, char * argv[])
         get_mem());
 }
 
+/**
+ *  \brief Shows use and fragmentation of the lwIP heap
+ *  \param none
+ *  \return none
+ **/
+static void cmd_netmem(Stream * chp, int argc, char * argv[])
+{
+#if MEM_SIZE_CLASSES
+   struct mem_class_stats st;
+   
+   // frag : share of the elements in use that was not asked for
+   chp->printf(" SIZE  NUM USED  MAX  ERR SPILL FRAG\r\n");
+   for (u8_t cls = 0; mem_class_stats(cls, &st); cls++)
+   {
+       unsigned int frag = 0;
+       if (st.used > 0)
+           frag = 100 - (unsigned int) ((st.requested * 100) / ((u32_t) st.used * st.size));
+       chp->printf("%5u %4u %4u %4u %4u %5u %3u%%\r\n", st.size, st.num,
+           st.used, st.max, st.err, st.spill, frag);
+   }
+#else
+   struct mem_heap_stats st;
+   
+   // frag : share of the free memory not in the largest block
+   mem_heap_stats(&st);
+   chp->printf("Used %u Free %u Largest %u Holes %u Frag %u%%\r\n", st.used, st.free,
+       st.largest, st.holes, st.free ? 100 - (st.largest * 100u) / st.free : 0);
+#endif
+}
+
+#define TOP_MAX_THREADS 16
+
+/**
+ *  \brief Shows CPU load and stack use per thread and heap use
+ *  \param none
+ *  \return none
+ **/
+static void cmd_top(Stream * chp, int argc, char * argv[])
+{
+   static const char * const states[] = {
+       "INACT", "READY", "RUN", "DELAY", "INTVL",
+       "OR", "AND", "SEM", "MBOX", "MUTEX"
+   };
+   // too big for the shell stack
+   static osThreadStat before[TOP_MAX_THREADS];
+   static osThreadStat after[TOP_MAX_THREADS];
+   uint32_t permille[TOP_MAX_THREADS];
+   int n0, n1, i;
+
+   // sample the cycle counters over one second
+   n0 = os_thread_stats(before, TOP_MAX_THREADS);
+   Thread::wait(1000);
+   n1 = os_thread_stats(after, TOP_MAX_THREADS);
+   os_thread_load(before, n0, after, n1, permille);
+
+   chp->printf(" ID PRIO STATE   CPU%%  SWITCH  STACK USED/SIZE  ENTRY\r\n");
+   for (i = 0; i < n1; i++) {
+       chp->printf("%3d %4d %-5s %3lu.%lu %7lu %6lu/%-6lu  0x%08x\r\n",
+            after[i].task_id, after[i].priority,
+            after[i].state < sizeof(states) / sizeof(states[0]) ? states[after[i].state] : "?",
+            (unsigned long) (permille[i] / 10), (unsigned long) (permille[i] % 10),
+            (unsigned long) after[i].switches,
+            (unsigned long) after[i].stack_used, (unsigned long) after[i].stack_size,
+            (unsigned int) after[i].pthread);
+   }
+
+   struct mallinfo mi = mallinfo();
+   chp->printf("Heap: %lu bytes in use, %lu bytes free in arena of %lu bytes\r\n",
+        (unsigned long) mi.uordblks, (unsigned long) mi.fordblks, (unsigned long) mi.arena);
+   chp->printf("Available Memory : %lu bytes, idle wakeups : %lu\r\n",
+        (unsigned long) get_mem(), (unsigned long) os_idle_wakeups);
+}
+
+/**
+ *  \brief Saves the DNS cache to the SD card
+ *  \param none
+ *  \return none
+ **/
+static void cmd_dns(Stream * chp, int argc, char * argv[])
+{
+   if (argc != 1 || strcmp(argv[0], "save") != 0)
+   {
+       chp->printf("dns save\r\n");
+       return;
+   }
+   
+   int count = eth.dnsSave(DNS_CACHE_FILE);
+   if (count < 0)
+       chp->printf("Cannot write %s\r\n", DNS_CACHE_FILE);
+   else
+       chp->printf("%d names saved to %s\r\n", count, DNS_CACHE_FILE);
+}
+
+/**
+ *  \brief Lists the ARP table, adds or removes static entries
+ *  \param none
+ *  \return none
+ **/
+static void cmd_arp(Stream * chp, int argc, char * argv[])
+{
+   char ip[16], mac[18];
+   int type;
+   
+   if (argc == 0)
+   {
+       for (int i = 0; (type = eth.arpGet(i, ip, mac)) >= 0; i++)
+       {
+           if (type > 0)
+               chp->printf("%-15s %s %s\r\n", ip, mac, (type == 2) ? "static" : "");
+       }
+   }
+   else if (argc == 3 && strcmp(argv[0], "add") == 0)
+   {
+       if (eth.arpAdd(argv[1], argv[2]) < 0)
+           chp->printf("Cannot add %s\r\n", argv[1]);
+   }
+   else if (argc == 2 && strcmp(argv[0], "del") == 0)
+   {
+       if (eth.arpRemove(argv[1]) < 0)
+           chp->printf("No static entry for %s\r\n", argv[1]);
+   }
+   else
+   {
+       chp->printf("arp [add <ip> <mac> | del <ip>]\r\n");
+   }
+}
+
 /**
  *  \brief List Directories and files 
  *  \param none
@@ -190,6 +326,7 @@ int main() {
 
 
     pc.baud(115200);
+    pc.buffer(_IOLBF); // one UART burst per line instead of per character, only the shell writes pc once it runs
 
     pc.printf("\r\nStarting Mbed ...\r\n");
     //Initialize the LCD
@@ -200,8 +337,13 @@ int main() {
     
     printf("Inititalizing ethernet ....\r\n");
     eth.init(); // Use DHCP
-    eth.connect();
+    eth.dhcpLoad(DHCP_LEASE_FILE); // ask for the last address again
+    if (eth.connect() == 0)
+        eth.dhcpSave(DHCP_LEASE_FILE);
     printf("IP Address is %s\n", eth.getIPAddress());
+    eth.dnsLoad(DNS_CACHE_FILE);
+    if (httpd.listen(80) == 0)
+        printf("Serving /sd on port 80\r\n");
     
     // After initializing the ethernet interface
     // run it in its own thread
@@ -213,8 +355,16 @@ int main() {
     shell.addCommand("ls", cmd_ls);
     shell.addCommand("load", cmd_load);
     shell.addCommand("mem", cmd_mem);
+    shell.addCommand("top", cmd_top);
     shell.addCommand("sensor", cmd_sensor);
+    shell.addCommand("dns", cmd_dns);
+    shell.addCommand("arp", cmd_arp);
+    shell.addCommand("netmem", cmd_netmem);
     shell.start(osPriorityNormal, SHELL_STACK_SIZ, shellStack);
+#if USE_TRACE
+    // to the card only, pc belongs to the shell and stdio has no locks
+    trace_start(NULL, TRACE_LOG_FILE);
+#endif
     printf("Shell now running!\r\n");
     printf("Available Memory : %d\r\n", get_mem());
         
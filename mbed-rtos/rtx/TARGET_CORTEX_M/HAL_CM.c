@@ -84,6 +84,14 @@ void rt_init_stack (P_TCB p_TCB, FUNCP task_body) {
   /* Initial Task stack pointer. */
   p_TCB->tsk_stack = (U32)stk;
 
+  /* Fill the unused stack with the magic word, rt_stk_used() looks for the
+     highest word that was overwritten. */
+  if (p_TCB->task_id != 0x01) {
+    for (i = 0; &p_TCB->stack[i] < stk; i++) {
+      p_TCB->stack[i] = MAGIC_WORD;
+    }
+  }
+
   /* Task entry point. */
   p_TCB->ptask = task_body;
 
@@ -97,6 +105,23 @@ void rt_init_stack (P_TCB p_TCB, FUNCP task_body) {
 }
 
 
+/*--------------------------- rt_stk_used ---------------------------------*/
+
+U32 rt_stk_used (P_TCB p_TCB) {
+  /* Return the stack high-water mark in bytes, 0 if it is not known. */
+  U32 i,size;
+
+  if (p_TCB->task_id == 0x01 || p_TCB->stack == NULL) {
+    return (0);
+  }
+  size = p_TCB->priv_stack >> 2;
+  for (i = 0; i < size; i++) {
+    if (p_TCB->stack[i] != MAGIC_WORD) break;
+  }
+  return ((size - i) << 2);
+}
+
+
 /*--------------------------- rt_ret_val ----------------------------------*/
 
 static __inline U32 *rt_ret_regs (P_TCB p_TCB) {
@@ -183,6 +183,17 @@
  #define OS_TICK        1000
 #endif
 
+//   <q>Tickless idle
+//   <i> Stops the periodic tick while all threads wait. The idle thread
+//   <i> sleeps until the next timeout or interrupt.
+#ifndef OS_TICKLESS
+#  if defined(TARGET_LPC1768)
+#    define OS_TICKLESS    1
+#  else
+#    define OS_TICKLESS    0
+#  endif
+#endif
+
 // </h>
 
 // <h>System Configuration
@@ -268,10 +279,81 @@
 /*----------------------------------------------------------------------------
  *      OS Idle daemon
  *---------------------------------------------------------------------------*/
+volatile uint32_t os_idle_wakeups;
+
+#if OS_TICKLESS
+#include "cmsis.h"
+
+extern BIT rt_psh_pending (void);
+extern U32 rt_idle_ticks (U32 load, U32 left, U32 val, BIT wrapped, U32 *next);
+
+/* Longest sleep the 24 bit SysTick can time */
+#define OS_IDLE_MAXTICKS   (0xFFFFFF / (OS_TRV + 1))
+
+/* Sleep up to ticks ticks with the scheduler locked, returns the ticks slept */
+static uint32_t os_idle_sleep (uint32_t ticks) {
+  uint32_t left, load, ctrl, val;
+  U32 next;
+
+  left = SysTick->VAL;                          /* rest of the running tick  */
+  if (left == 0) left = OS_TRV + 1;
+  load = left + (ticks - 1) * (OS_TRV + 1);
+
+  /* Reload SysTick to expire at the tick of the next timeout */
+  SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk;
+  SysTick->LOAD = load - 1;
+  SysTick->VAL  = 0;
+  SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+
+  /* Sleep mode only, deep sleep would stop the mbed interface */
+  SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+  __DSB();
+  __WFI();
+
+  val  = SysTick->VAL;
+  ctrl = SysTick->CTRL;
+  SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk;
+  ticks = rt_idle_ticks (load, left, val, (ctrl & SysTick_CTRL_COUNTFLAG_Msk) != 0, &next);
+
+  /* Restart the tick in phase, the tick interrupt stays locked */
+  SCB->ICSR     = SCB_ICSR_PENDSTCLR_Msk;
+  SysTick->LOAD = next - 1;
+  SysTick->VAL  = 0;
+  SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+  SysTick->LOAD = OS_TRV;
+
+  os_idle_wakeups++;
+  return (ticks);
+}
+#endif
+
 void os_idle_demon (void) {
   /* The idle demon is a system thread, running when no other thread is      */
   /* ready to run.                                                           */
 
+#if OS_TICKLESS
+  /* Tickless idle: os_suspend() returns the ticks to the next thread or
+     timer timeout. The core sleeps that long or until an interrupt, mbed
+     Ticker and Timeout events wake it with their own us_ticker interrupt.
+     os_resume() catches up on the skipped ticks.
+  */
+  uint32_t ticks, slept;
+
+  for (;;) {
+    ticks = os_suspend();
+    if (ticks > OS_IDLE_MAXTICKS) ticks = OS_IDLE_MAXTICKS;
+    slept = 0;
+    __disable_irq();
+    if ((ticks > 1) && !rt_psh_pending()) {
+      slept = os_idle_sleep(ticks);
+    }
+    __enable_irq();
+    os_resume(slept);
+    if (ticks == 1) {
+      __WFI();                                  /* next tick has work to do  */
+    }
+  }
+#else
   /* Sleep: ideally, we should put the chip to sleep.
      Unfortunately, this usually requires disconnecting the interface chip (debugger).
      This can be done, but it would break the local file system.
@@ -279,6 +361,7 @@ void os_idle_demon (void) {
   for (;;) {
       // sleep();
   }
+#endif
 }
 
 /*----------------------------------------------------------------------------
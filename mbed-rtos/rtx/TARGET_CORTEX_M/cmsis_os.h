@@ -767,6 +767,48 @@ osStatus osMailFree (osMailQId queue_id, void *mail);
 #endif  // Mail Queues available
 
 
+//  ==== RTX Extensions ====
+
+/// Suspend the RTX task scheduler.
+/// \return number of ticks, for how long the system can sleep or power-down.
+uint32_t os_suspend (void);
+
+/// Resume the RTX task scheduler.
+/// \param[in]     sleep_time    specifies how long the system was in sleep or power-down mode.
+void os_resume (uint32_t sleep_time);
+
+/// Number of tickless sleeps of the idle thread that have ended.
+extern volatile uint32_t os_idle_wakeups;
+
+/// Thread statistics returned by \ref os_thread_stats.
+typedef struct os_thread_stat  {
+  osThreadId             thread_id;      ///< thread ID
+  os_pthread               pthread;      ///< start address of thread function
+  uint8_t                  task_id;      ///< RTX task ID, 255 is the idle thread
+  uint8_t                    state;      ///< RTX task state
+  osPriority              priority;      ///< current thread priority
+  uint32_t              stack_size;      ///< stack size in bytes
+  uint32_t              stack_used;      ///< stack high-water mark in bytes, 0 if not known
+  uint64_t                  cycles;      ///< CPU cycles spent running, interrupts included
+  uint32_t                switches;      ///< number of times the thread was switched in
+} osThreadStat;
+
+/// Get statistics of all threads, the idle thread comes first.
+/// \param[out]    stats         array for the statistics.
+/// \param[in]     max           number of entries in the array.
+/// \return number of entries filled.
+int32_t os_thread_stats (osThreadStat *stats, int32_t max);
+
+/// Get the CPU share of each thread between two calls of \ref os_thread_stats.
+/// \param[in]     before        earlier statistics.
+/// \param[in]     n0            number of entries in before.
+/// \param[in]     after         later statistics.
+/// \param[in]     n1            number of entries in after.
+/// \param[out]    permille      per entry of after, its share of the cycles in 1/1000.
+void os_thread_load (const osThreadStat *before, int32_t n0,
+                     const osThreadStat *after,  int32_t n1, uint32_t *permille);
+
+
 #ifdef  __cplusplus
 }
 #endif
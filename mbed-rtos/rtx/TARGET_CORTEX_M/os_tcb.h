@@ -46,6 +46,10 @@ typedef struct OS_TCB {
 
   /* Task entry point used for uVision debugger                              */
   FUNCP  ptask;                   /* Task entry address                      */
+
+  /* Profiling part                                                          */
+  U64    cycles;                  /* CPU cycles spent running                */
+  U32    switches;                /* Number of times switched in             */
 } *P_TCB;
 
 #endif
@@ -413,6 +413,8 @@ uint8_t os_running;                             // Kernel Running flag
 SVC_0_1(svcKernelInitialize, osStatus, RET_osStatus)
 SVC_0_1(svcKernelStart,      osStatus, RET_osStatus)
 SVC_0_1(svcKernelRunning,    int32_t,  RET_int32_t)
+SVC_0_1(svcKernelSuspend,    int32_t,  RET_int32_t)
+SVC_1_1(svcKernelResume,     osStatus, uint32_t, RET_osStatus)
 
 extern void  sysThreadError   (osStatus status);
 osThreadId   svcThreadCreate  (osThreadDef_t *thread_def, void *argument);
@@ -459,6 +461,17 @@ int32_t svcKernelRunning(void) {
   return os_running;
 }
 
+/// Suspend the RTX task scheduler
+int32_t svcKernelSuspend (void) {
+  return (int32_t)rt_suspend();
+}
+
+/// Resume the RTX task scheduler
+osStatus svcKernelResume (uint32_t sleep_time) {
+  rt_resume(sleep_time);
+  return osOK;
+}
+
 // Kernel Control Public API
 
 /// Initialize the RTOS Kernel for creating objects
@@ -514,6 +527,19 @@ int32_t osKernelRunning(void) {
 }
 
 
+/// Suspend the RTX task scheduler
+uint32_t os_suspend (void) {
+  if (__get_IPSR() != 0) return 0;              // Not allowed in ISR
+  return (uint32_t)__svcKernelSuspend();
+}
+
+/// Resume the RTX task scheduler
+void os_resume (uint32_t sleep_time) {
+  if (__get_IPSR() != 0) return;                // Not allowed in ISR
+  __svcKernelResume(sleep_time);
+}
+
+
 // ==== Thread Management ====
 
 __NO_RETURN void osThreadExit (void);
@@ -525,6 +551,7 @@ SVC_1_1(svcThreadTerminate,   osStatus,   osThreadId,                  RET_osSta
 SVC_0_1(svcThreadYield,       osStatus,                                RET_osStatus)
 SVC_2_1(svcThreadSetPriority, osStatus,   osThreadId,      osPriority, RET_osStatus)
 SVC_1_1(svcThreadGetPriority, osPriority, osThreadId,                  RET_osPriority)
+SVC_2_1(svcThreadStats,       int32_t,    osThreadStat *,  int32_t,    RET_int32_t)
 
 // Thread Service Calls
 extern OS_TID rt_get_TID (void);
@@ -632,6 +659,40 @@ osPriority svcThreadGetPriority (osThreadId thread_id) {
   return (osPriority)(ptcb->prio - 1 + osPriorityIdle);
 }
 
+/// Fill one statistics entry from a TCB
+static void rt_thread_stat (osThreadStat *st, P_TCB ptcb) {
+
+  st->thread_id  = ptcb;
+  st->pthread    = (os_pthread)ptcb->ptask;
+  st->task_id    = ptcb->task_id;
+  st->state      = ptcb->state;
+  st->priority   = (ptcb->prio == 0) ? osPriorityIdle :
+                   (osPriority)(ptcb->prio - 1 + osPriorityIdle);
+  st->stack_size = ptcb->priv_stack;
+  st->stack_used = rt_stk_used(ptcb);
+  st->cycles     = ptcb->cycles;
+  st->switches   = ptcb->switches;
+}
+
+/// Get statistics of all threads, the idle thread comes first
+int32_t svcThreadStats (osThreadStat *stats, int32_t max) {
+  int32_t n = 0;
+  U32     i;
+
+  if ((stats == NULL) || (max <= 0)) return 0;
+
+#if (OS_PROFILE)
+  rt_prof_charge();                             // Charge the caller up to now
+#endif
+  rt_thread_stat(&stats[n++], &os_idle_TCB);
+  for (i = 0; (i < os_maxtaskrun) && (n < max); i++) {
+    if (os_active_TCB[i] != NULL) {
+      rt_thread_stat(&stats[n++], (P_TCB)os_active_TCB[i]);
+    }
+  }
+  return n;
+}
+
 
 // Thread Public API
 
@@ -676,6 +737,12 @@ osPriority osThreadGetPriority (osThreadId thread_id) {
   return __svcThreadGetPriority(thread_id);
 }
 
+/// Get statistics of all threads
+int32_t os_thread_stats (osThreadStat *stats, int32_t max) {
+  if (__get_IPSR() != 0) return 0;              // Not allowed in ISR
+  return __svcThreadStats(stats, max);
+}
+
 /// INTERNAL - Not Public
 /// Auto Terminate Thread on exit (used implicitly when thread exists)
 __NO_RETURN void osThreadExit (void) {
@@ -978,6 +1045,28 @@ void sysTimerTick (void) {
   }
 }
 
+/// Get number of ticks until the next Timer expires
+uint32_t sysUserTimerWakeupTime (void) {
+
+  if (os_timer_head == NULL) return 0xFFFF;
+  return os_timer_head->tcnt;
+}
+
+/// Advance the Timers over a tickless sleep
+void sysUserTimerUpdate (uint32_t sleep_time) {
+
+  while ((os_timer_head != NULL) && (sleep_time != 0)) {
+    if (sleep_time >= os_timer_head->tcnt) {
+      sleep_time -= os_timer_head->tcnt;
+      os_timer_head->tcnt = 1;
+      sysTimerTick();
+    } else {
+      os_timer_head->tcnt -= sleep_time;
+      break;
+    }
+  }
+}
+
 
 // Timer Management Public API
 
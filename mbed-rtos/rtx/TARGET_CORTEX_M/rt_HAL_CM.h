@@ -184,6 +184,18 @@ static inline U8 __clz(U32 value)
 #define ITM_PORT31_U16  (*((volatile U16 *)0xE000007C))
 #define ITM_PORT31_U8   (*((volatile U8  *)0xE000007C))
 
+/* DWT registers */
+#define DWT_CTRL        (*((volatile U32 *)0xE0001000))
+#define DWT_CYCCNT      (*((volatile U32 *)0xE0001004))
+#define DWT_CYCCNTENA   0x00000001
+
+/* Thread CPU accounting needs the DWT cycle counter, ARMv6-M has none */
+#if (__TARGET_ARCH_6S_M)
+#define OS_PROFILE      0
+#else
+#define OS_PROFILE      1
+#endif
+
 /* Variables */
 extern BIT dbg_msg;
 
@@ -228,6 +240,14 @@ __inline static void rt_systick_init (void) {
   NVIC_SYS_PRI3  |= 0xFF000000;
 }
 
+__inline static void rt_prof_init (void) {
+#if (OS_PROFILE)
+  DEMCR      |= DEMCR_TRCENA;
+  DWT_CYCCNT  = 0;
+  DWT_CTRL   |= DWT_CYCCNTENA;
+#endif
+}
+
 __inline static void rt_svc_init (void) {
 #if !(__TARGET_ARCH_6S_M)
   int sh,prigroup;
@@ -252,6 +272,7 @@ extern void *_alloc_box (void *box_mem);
 extern int  _free_box (void *box_mem, void *box);
 
 extern void rt_init_stack (P_TCB p_TCB, FUNCP task_body);
+extern U32  rt_stk_used   (P_TCB p_TCB);
 extern void rt_ret_val  (P_TCB p_TCB, U32 v0);
 extern void rt_ret_val2 (P_TCB p_TCB, U32 v0, U32 v1);
 
@@ -0,0 +1,51 @@
+/*----------------------------------------------------------------------------
+ *      RL-ARM - RTX
+ *----------------------------------------------------------------------------
+ *      Name:    RT_STAT.C
+ *      Purpose: Thread load from two samples of the thread statistics
+ *----------------------------------------------------------------------------
+ * Does not touch the hardware or the kernel state and builds on the host,
+ * test/top_test.c checks it there.
+ *---------------------------------------------------------------------------*/
+
+#include "cmsis_os.h"
+
+
+/*--------------------------- rt_load_delta ---------------------------------*/
+
+static uint64_t rt_load_delta (const osThreadStat *before, int32_t n0,
+                               const osThreadStat *st) {
+  /* Cycles of st since the earlier sample. A thread is the same if ID and  */
+  /* entry match, a thread started since is charged all its cycles.         */
+  int32_t j;
+
+  for (j = 0; j < n0; j++) {
+    if ((before[j].thread_id == st->thread_id) &&
+        (before[j].pthread   == st->pthread)) {
+      return (st->cycles - before[j].cycles);
+    }
+  }
+  return (st->cycles);
+}
+
+
+/*--------------------------- os_thread_load --------------------------------*/
+
+void os_thread_load (const osThreadStat *before, int32_t n0,
+                     const osThreadStat *after,  int32_t n1, uint32_t *permille) {
+  /* CPU share of each thread in after between the two samples.             */
+  uint64_t total = 0;
+  int32_t  i;
+
+  for (i = 0; i < n1; i++) {
+    total += rt_load_delta (before, n0, &after[i]);
+  }
+  for (i = 0; i < n1; i++) {
+    permille[i] = (total == 0) ? 0 :
+                  (uint32_t)((rt_load_delta (before, n0, &after[i]) * 1000) / total);
+  }
+}
+
+/*----------------------------------------------------------------------------
+ * end of file
+ *---------------------------------------------------------------------------*/
@@ -50,6 +50,11 @@
 
 int os_tick_irqn;
 
+#ifdef __CMSIS_RTOS
+extern U32  sysUserTimerWakeupTime (void);
+extern void sysUserTimerUpdate (U32 sleep_time);
+#endif
+
 /*----------------------------------------------------------------------------
  *      Local Variables
  *---------------------------------------------------------------------------*/
@@ -87,6 +92,8 @@ U32 rt_suspend (void) {
   if (os_tmr.next) {
     if (os_tmr.tcnt < delta) delta = os_tmr.tcnt;
   }
+#else
+  if (sysUserTimerWakeupTime () < delta) delta = sysUserTimerWakeupTime ();
 #endif
 
   return (delta);
@@ -117,6 +124,7 @@ void rt_resume (U32 sleep_time) {
         delta--;
         os_time++;
       }
+      os_time += delta;                         /* list emptied early        */
     } else {
       os_time           += delta;
       os_dly.delta_time -= delta;
@@ -125,7 +133,10 @@ void rt_resume (U32 sleep_time) {
     os_time += sleep_time;
   }
 
-#ifndef __CMSIS_RTOS
+#ifdef __CMSIS_RTOS
+  /* Check the user timers. */
+  sysUserTimerUpdate (sleep_time);
+#else
   /* Check the user timers. */
   if (os_tmr.next) {
     delta = sleep_time;
@@ -151,6 +162,35 @@ void rt_resume (U32 sleep_time) {
 }
 
 
+/*--------------------------- rt_psh_pending --------------------------------*/
+BIT rt_psh_pending (void) {
+  /* Check for ISR requests deferred while the scheduler is locked. */
+  return (os_psh_flag);
+}
+
+
+/*--------------------------- rt_idle_ticks ---------------------------------*/
+U32 rt_idle_ticks (U32 load, U32 left, U32 val, BIT wrapped, U32 *next) {
+  /* Ticks that passed while SysTick counted down from load-1 to val, when  */
+  /* the first tick had left counts to go. next gets the counts to the end  */
+  /* of the running tick.                                                    */
+  U32 used, rest;
+
+  if (wrapped) {
+    used = load + (load - 1 - val);             /* counter has wrapped       */
+  } else {
+    used = load - 1 - val;
+  }
+  if (used < left) {
+    *next = left - used;                        /* woken up within the tick  */
+    return (0);
+  }
+  rest  = used - left;
+  *next = (os_trv + 1) - rest % (os_trv + 1);
+  return (1 + rest / (os_trv + 1));
+}
+
+
 /*--------------------------- rt_tsk_lock -----------------------------------*/
 
 void rt_tsk_lock (void) {
@@ -39,6 +39,8 @@ extern int os_tick_irqn;
 /* Functions */
 extern U32  rt_suspend    (void);
 extern void rt_resume     (U32 sleep_time);
+extern BIT  rt_psh_pending (void);
+extern U32  rt_idle_ticks (U32 load, U32 left, U32 val, BIT wrapped, U32 *next);
 extern void rt_tsk_lock   (void);
 extern void rt_tsk_unlock (void);
 extern void rt_psh_req    (void);
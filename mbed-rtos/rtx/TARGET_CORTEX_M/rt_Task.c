@@ -51,6 +51,11 @@ struct OS_TSK os_tsk;
 /* Task Control Blocks of idle demon */
 struct OS_TCB os_idle_TCB;
 
+#if (OS_PROFILE)
+/* Cycle counter at the last task switch request. */
+static U32 os_prof_stamp;
+#endif
+
 
 /*----------------------------------------------------------------------------
  *      Local Functions
@@ -97,15 +102,38 @@ void rt_init_context (P_TCB p_TCB, U8 priority, FUNCP task_body) {
   p_TCB->events  = 0;
   p_TCB->waits   = 0;
   p_TCB->stack_frame = 0;
+  p_TCB->cycles   = 0;
+  p_TCB->switches = 0;
 
   rt_init_stack (p_TCB, task_body);
 }
 
 
+#if (OS_PROFILE)
+/*--------------------------- rt_prof_charge --------------------------------*/
+
+void rt_prof_charge (void) {
+  /* Charge the running task with the cycles up to now, interrupts included. */
+  U32 now = DWT_CYCCNT;
+
+  if (os_tsk.run != NULL) {
+    os_tsk.run->cycles += now - os_prof_stamp;
+  }
+  os_prof_stamp = now;
+}
+#endif
+
+
 /*--------------------------- rt_switch_req ---------------------------------*/
 
 void rt_switch_req (P_TCB p_new) {
   /* Switch to next task (identified by "p_new"). */
+#if (OS_PROFILE)
+  rt_prof_charge ();
+  if (p_new != os_tsk.run) {
+    p_new->switches++;
+  }
+#endif
   os_tsk.new_tsk   = p_new;
   p_new->state = RUNNING;
   DBG_TASK_SWITCH(p_new->task_id);
@@ -268,6 +296,7 @@ void rt_sys_init (FUNCP first_task, U32 prio_stksz, void *stk) {
   U32 i;
 
   DBG_INIT();
+  rt_prof_init();
 
   /* Initialize dynamic memory and task TCB pointers to NULL. */
   for (i = 0; i < os_maxtaskrun; i++) {
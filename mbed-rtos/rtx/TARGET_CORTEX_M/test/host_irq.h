@@ -0,0 +1,3 @@
+/* The CMSIS interrupt intrinsics, for building RTX on the host */
+void __enable_irq(void);
+unsigned int __disable_irq(void);
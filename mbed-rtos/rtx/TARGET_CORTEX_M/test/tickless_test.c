@@ -0,0 +1,182 @@
+/* Host test of the tickless idle arithmetic
+ *
+ * Builds and runs on the host, without the mbed tree:
+ *
+ *   gcc -I.. -D__CMSIS_RTOS -D__CMSIS_GENERIC -include host_irq.h tickless_test.c ../rt_System.c ../rt_List.c -o tickless_test && ./tickless_test
+ *
+ * Catches up the delay list with rt_resume() after a sleep and checks it
+ * ends in the same state as the same number of periodic ticks: os_time,
+ * the tasks woken and the deltas left in the list. Then checks the SysTick
+ * counts to ticks conversion of rt_idle_ticks() against plain division for
+ * wakeups anywhere in the sleep. The NVIC and SysTick registers that the
+ * scheduler lock writes are a page of plain memory here.
+ */
+#include "rt_TypeDef.h"
+#include "RTX_Conf.h"
+#include "rt_Task.h"
+#include "rt_System.h"
+#include "rt_List.h"
+#include "rt_Time.h"
+#include "rt_Robin.h"
+#include "rt_Event.h"
+#include "rt_Mailbox.h"
+#include "rt_Semaphore.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define NTASK   5
+#define TRV     95999       // OS_TRV at 96 MHz and 1 ms ticks
+
+static int failures;
+
+// What rt_System.c and rt_List.c use from the rest of RTX
+U32 const os_trv = TRV;
+U32 os_fifo[4 * 2 + 1];
+U32 os_time;
+struct OS_TSK os_tsk;
+struct OS_ROBIN os_robin;
+static U32 timer_wakeup = 0xFFFF;
+static U32 timer_slept;
+
+void __enable_irq(void) {}
+unsigned int __disable_irq(void) { return 0; }
+void os_error(U32 err_code) { printf("os_error %u\n", err_code); failures++; }
+void rt_chk_robin(void) {}
+void rt_evt_psh(P_TCB p_CB, U16 set_flags) {}
+void rt_mbx_psh(P_MCB p_CB, void *p_msg) {}
+void rt_sem_psh(P_SCB p_CB) {}
+void rt_switch_req(P_TCB p_new) { os_tsk.new_tsk = p_new; }
+void sysTimerTick(void) {}
+U32 sysUserTimerWakeupTime(void) { return timer_wakeup; }
+void sysUserTimerUpdate(U32 sleep_time) { timer_slept = sleep_time; }
+
+static struct OS_TCB idle, task[NTASK];
+static const U16 delay[NTASK] = { 5, 5, 12, 40, 300 };
+
+static void check(int ok, const char *what)
+{
+    printf("%s: %s\n", ok ? "ok" : "FAIL", what);
+    if (!ok)
+        failures++;
+}
+
+// Tasks waiting in the delay list, os_time at 1000
+static void setup(void)
+{
+    memset(&os_rdy, 0, sizeof(os_rdy));
+    memset(&os_dly, 0, sizeof(os_dly));
+    memset(&idle, 0, sizeof(idle));
+    memset(task, 0, sizeof(task));
+    os_time = 1000;
+    idle.state = RUNNING;
+    os_tsk.run = &idle;
+    for (int i = 0; i < NTASK; i++) {
+        task[i].prio = 1 + i;
+        task[i].state = WAIT_DLY;
+        rt_put_dly(&task[i], delay[i]);
+    }
+}
+
+typedef struct {
+    U32 time;
+    U8 state[NTASK];
+    U32 due[NTASK];         // tick each task still waits for
+} snap_t;
+
+static void snap(snap_t *s)
+{
+    P_TCB p = (P_TCB)&os_dly;
+    U32 t = os_time;
+
+    memset(s, 0, sizeof(*s));
+    s->time = os_time;
+    for (int i = 0; i < NTASK; i++)
+        s->state[i] = task[i].state;
+    while (p->p_dlnk != NULL) {
+        t += p->delta_time;
+        p = p->p_dlnk;
+        s->due[p - task] = t;
+    }
+}
+
+static void sleep_vs_ticks(U32 slept)
+{
+    snap_t ticked, resumed;
+    char what[80];
+
+    setup();
+    for (U32 i = 0; i < slept; i++) {   // rt_systick()
+        os_time++;
+        rt_dec_dly();
+    }
+    snap(&ticked);
+
+    setup();
+    rt_suspend();
+    rt_resume(slept);
+    snap(&resumed);
+
+    snprintf(what, sizeof what, "resume after %u ticks matches the periodic tick", slept);
+    check(memcmp(&ticked, &resumed, sizeof(snap_t)) == 0 && timer_slept == slept, what);
+}
+
+static void systick(U32 ticks)
+{
+    U32 left, load, next, got, e, t;
+    int bad = 0;
+    char what[80];
+
+    for (left = 1; left <= TRV + 1; left += 7919) {
+        load = left + (ticks - 1) * (TRV + 1);
+        // e counts after the reload, the counter goes load-1 .. 0, then wraps
+        for (e = 0; e < 2 * load; e += 1 + e / 3) {
+            got = rt_idle_ticks(load, left, e < load ? load - 1 - e : 2 * load - 1 - e, e >= load, &next);
+            t = (TRV + 1 - left) + e;   // counts since the last tick
+            if (got != t / (TRV + 1) || next != TRV + 1 - t % (TRV + 1))
+                bad++;
+        }
+        got = rt_idle_ticks(load, left, load - 1, 1, &next);   // woken by the expiry
+        if (got != ticks || next != TRV + 1)
+            bad++;
+    }
+    snprintf(what, sizeof what, "SysTick counts to ticks, %u tick sleep", ticks);
+    check(bad == 0, what);
+}
+
+int main()
+{
+    // the scheduler lock writes SysTick and the NVIC
+    check(mmap((void *)0xE000E000, 0x1000, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) == (void *)0xE000E000,
+          "map the system control space");
+    os_tick_irqn = -1;
+
+    setup();
+    check(rt_suspend() == 5, "suspend sleeps to the first delay");
+    rt_resume(0);
+    timer_wakeup = 3;
+    check(rt_suspend() == 3, "a user timer due earlier wins");
+    rt_resume(0);
+    timer_wakeup = 0xFFFF;
+    memset(&os_dly, 0, sizeof(os_dly));
+    check(rt_suspend() == 0xFFFF, "nothing due, longest sleep");
+    rt_resume(0);
+
+    sleep_vs_ticks(0);
+    sleep_vs_ticks(4);      // before the first task
+    sleep_vs_ticks(5);      // two tasks at once
+    sleep_vs_ticks(6);
+    sleep_vs_ticks(12);
+    sleep_vs_ticks(39);
+    sleep_vs_ticks(300);    // the last task
+    sleep_vs_ticks(350);    // past the end of the list
+
+    systick(1);
+    systick(2);
+    systick(174);           // OS_IDLE_MAXTICKS at 96 MHz
+
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,121 @@
+/* Host test of the top statistics
+ *
+ * Builds and runs on the host, without the mbed tree:
+ *
+ *   gcc -I.. top_test.c ../HAL_CM.c ../rt_Stat.c -o top_test && ./top_test
+ *
+ * Checks the CPU shares os_thread_load() works out from two samples, with
+ * threads started, ended and replaced between them and cycle counts past
+ * 32 bits, and the stack high-water mark rt_stk_used() finds in the magic
+ * word pattern rt_init_stack() leaves.
+ */
+#include "rt_TypeDef.h"
+#include "RTX_Conf.h"
+#include "rt_HAL_CM.h"
+#include "cmsis_os.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define STACK   1024        // bytes
+
+static int failures;
+
+static void check(int ok, const char *what)
+{
+    printf("%s: %s\n", ok ? "ok" : "FAIL", what);
+    if (!ok)
+        failures++;
+}
+
+static void body_a(void const *arg) {}
+static void body_b(void const *arg) {}
+static void task_body(void) {}
+
+static osThreadStat stat(int id, os_pthread entry, uint64_t cycles)
+{
+    osThreadStat st;
+
+    memset(&st, 0, sizeof(st));
+    st.thread_id = (osThreadId)(uintptr_t)(0x10000000 + id * 0x60);
+    st.pthread = entry;
+    st.task_id = id;
+    st.cycles = cycles;
+    return st;
+}
+
+static void load(void)
+{
+    osThreadStat before[4], after[4];
+    uint32_t permille[4], sum;
+
+    // idle 50%, two threads 25% and 12.5%, one 12.5% past 2^32 cycles
+    before[0] = stat(255, NULL, 1000);
+    before[1] = stat(1, body_a, 2000);
+    before[2] = stat(2, body_b, 3000);
+    before[3] = stat(3, body_a, 0xFFFFFFF0ULL);
+    after[0] = stat(255, NULL, 1000 + 4000);
+    after[1] = stat(1, body_a, 2000 + 2000);
+    after[2] = stat(2, body_b, 3000 + 1000);
+    after[3] = stat(3, body_a, 0xFFFFFFF0ULL + 1000);
+    os_thread_load(before, 4, after, 4, permille);
+    check(permille[0] == 500 && permille[1] == 250 && permille[2] == 125 && permille[3] == 125,
+          "shares of the cycles between the samples");
+
+    // thread 2 ended, its TCB went to a new thread with another entry, and
+    // thread 3 started since: both are charged all their cycles
+    after[2] = stat(2, body_a, 1000);
+    after[3] = stat(4, body_b, 0x100000000ULL);
+    os_thread_load(before, 3, after, 4, permille);
+    sum = permille[0] + permille[1] + permille[2] + permille[3];
+    check(permille[2] < 1 && permille[3] > 990 && sum <= 1000 && sum >= 1000 - 4,
+          "threads started between the samples");
+
+    // a thread gone from the later sample is left out
+    os_thread_load(before, 4, after, 2, permille);
+    check(permille[0] == 666 && permille[1] == 333, "thread ended between the samples");
+
+    // no cycles counted at all
+    os_thread_load(before, 4, before, 4, permille);
+    check(permille[0] == 0 && permille[1] == 0 && permille[2] == 0 && permille[3] == 0,
+          "nothing ran");
+}
+
+static U32 used_after(int task_id, int skew, int words)
+{
+    static U32 mem[STACK / 4 + 2] __attribute__((aligned(8)));
+    struct OS_TCB tcb;
+
+    memset(&tcb, 0, sizeof(tcb));
+    memset(mem, 0, sizeof(mem));
+    tcb.task_id = task_id;
+    tcb.priv_stack = STACK;
+    tcb.stack = mem + skew;
+    rt_init_stack(&tcb, task_body);
+    for (int i = 0; i < words; i++)    // the thread runs, deeper than the frame
+        tcb.stack[STACK / 4 - 1 - i] = i;
+    return rt_stk_used(&tcb);
+}
+
+static void stack(void)
+{
+    struct OS_TCB tcb;
+
+    check(used_after(2, 0, 0) == 16 * 4, "a new thread used its start frame");
+    check(used_after(2, 1, 0) == 17 * 4, "and one word more to align the frame");
+    check(used_after(2, 0, 100) == 100 * 4, "high-water mark at the deepest word");
+    check(used_after(2, 0, STACK / 4 - 1) == STACK - 4, "all but the overflow word");
+    check(used_after(1, 0, 100) == 0, "main thread shares its stack with the heap");
+    memset(&tcb, 0, sizeof(tcb));
+    tcb.task_id = 2;
+    check(rt_stk_used(&tcb) == 0, "no stack");
+}
+
+int main()
+{
+    load();
+    stack();
+
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
@@ -100,6 +100,23 @@ public:
      */
     virtual int fsync() = 0;
 
+    /** Pass data from the current position to a function, the file position
+     *  moves past the data the function took
+     *
+     *  @param func called with each piece of data, returns the number of bytes
+     *   it took, 0 stops the transfer. func(ctx, NULL, 0) asks whether it can
+     *   take data now (non-zero if so)
+     *  @param ctx passed to func
+     *  @param length the number of characters to pass
+     *
+     *  @returns
+     *  The number of characters passed on success, -1 on error.
+     *
+     *  The default reads through a small buffer on the stack, file systems
+     *  override it to pass their own sector buffers without a copy.
+     */
+    virtual ssize_t forward(size_t (*func)(void *ctx, const void *data, size_t length), void *ctx, size_t length);
+
     virtual off_t flen() {
         /* remember our current position */
         off_t pos = lseek(0, SEEK_CUR);
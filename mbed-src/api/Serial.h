@@ -60,6 +60,7 @@ public:
 protected:
     virtual int _getc();
     virtual int _putc(int c);
+    virtual ssize_t _write(const void* buffer, size_t length);
 };
 
 } // namespace mbed
@@ -126,6 +126,7 @@ protected:
 
     int _base_getc();
     int _base_putc(int c);
+    int _base_write(const void *buffer, int length);
 
     serial_t        _serial;
     FunctionPointer _irq[2];
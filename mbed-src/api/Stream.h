@@ -38,6 +38,22 @@ public:
     int printf(const char* format, ...);
     int scanf(const char* format, ...);
 
+    /** Set how output is buffered before it reaches write()
+     *
+     *  Only while one thread uses the stream: stdio has no locks in this
+     *  build and two writers would corrupt the shared buffer.
+     *
+     *  @param mode _IONBF (default), _IOLBF: up to each newline, _IOFBF: until the buffer is full
+     *  @param size size of the buffer, allocated by the C library
+     *
+     *  @returns 0 on success
+     */
+    int buffer(int mode, size_t size = 64);
+
+    /** Write out buffered output
+     */
+    int flush();
+
     operator std::FILE*() {return _file;}
 
 protected:
@@ -51,8 +67,10 @@ protected:
 
     virtual int _putc(int c) = 0;
     virtual int _getc() = 0;
+    virtual ssize_t _write(const void* buffer, size_t length);
 
     std::FILE *_file;
+    bool _reading;
 
     /* disallow copy constructor and assignment operators */
 private:
@@ -16,6 +16,7 @@
 #include "RawSerial.h"
 #include "wait_api.h"
 #include <cstdarg>
+#include <cstring>
 
 #if DEVICE_SERIAL
 
@@ -35,8 +36,7 @@ int RawSerial::putc(int c) {
 }
 
 int RawSerial::puts(const char *str) {
-    while (*str)
-        putc(*str ++);
+    _base_write(str, strlen(str));
     return 0;
 }
 
@@ -31,6 +31,10 @@ int Serial::_putc(int c) {
     return _base_putc(c);
 }
 
+ssize_t Serial::_write(const void* buffer, size_t length) {
+    return _base_write(buffer, length);
+}
+
 } // namespace mbed
 
 #endif
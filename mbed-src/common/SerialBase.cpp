@@ -66,6 +66,10 @@ int SerialBase::_base_putc(int c) {
     return c;
 }
 
+int SerialBase::_base_write(const void *buffer, int length) {
+    return serial_write(&_serial, (const char*)buffer, length);
+}
+
 void SerialBase::send_break() {
   // Wait for 1.5 frames before clearing the break condition
   // This will have different effects on our platforms, but should
@@ -19,7 +19,7 @@
 
 namespace mbed {
 
-Stream::Stream(const char *name) : FileLike(name), _file(NULL) {
+Stream::Stream(const char *name) : FileLike(name), _file(NULL), _reading(false) {
     /* open ourselves */
     char buf[12]; /* :0x12345678 + null byte */
     std::sprintf(buf, ":%p", this);
@@ -31,28 +31,56 @@ Stream::~Stream() {
     fclose(_file);
 }
 
+/* The stream is opened for update, so a flush is needed when switching
+ * between reading and writing. Reading flushes pending output too, so a
+ * prompt shows up before we block for input. */
 int Stream::putc(int c) {
-    fflush(_file);
+    if (_reading) {
+        fflush(_file);
+        _reading = false;
+    }
     return std::fputc(c, _file);
 }
 int Stream::puts(const char *s) {
-    fflush(_file);
+    if (_reading) {
+        fflush(_file);
+        _reading = false;
+    }
     return std::fputs(s, _file);
 }
 int Stream::getc() {
     fflush(_file);
+    _reading = true;
     return mbed_getc(_file);   
 }
 char* Stream::gets(char *s, int size) {
     fflush(_file);
+    _reading = true;
     return mbed_gets(s,size,_file);
 }
 
+int Stream::buffer(int mode, size_t size) {
+    fflush(_file);
+    if (mode == _IONBF) {
+        mbed_set_unbuffered_stream(_file);
+        return 0;
+    }
+    return std::setvbuf(_file, NULL, mode, size);
+}
+
+int Stream::flush() {
+    return fflush(_file);
+}
+
 int Stream::close() {
     return 0;
 }
 
 ssize_t Stream::write(const void* buffer, size_t length) {
+    return _write(buffer, length);
+}
+
+ssize_t Stream::_write(const void* buffer, size_t length) {
     const char* ptr = (const char*)buffer;
     const char* end = ptr + length;
     while (ptr != end) {
@@ -93,7 +121,10 @@ off_t Stream::flen() {
 int Stream::printf(const char* format, ...) {
     std::va_list arg;
     va_start(arg, format);
-    fflush(_file);
+    if (_reading) {
+        fflush(_file);
+        _reading = false;
+    }
     int r = vfprintf(_file, format, arg);
     va_end(arg);
     return r;
@@ -103,6 +134,7 @@ int Stream::scanf(const char* format, ...) {
     std::va_list arg;
     va_start(arg, format);
     fflush(_file);
+    _reading = true;
     int r = vfscanf(_file, format, arg);
     va_end(arg);
     return r;
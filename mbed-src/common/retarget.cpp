@@ -80,6 +80,26 @@ FileHandle::~FileHandle() {
     }
 }
 
+ssize_t FileHandle::forward(size_t (*func)(void *ctx, const void *data, size_t length), void *ctx, size_t length) {
+    char buf[64];
+    ssize_t done = 0;
+
+    while (length > 0 && func(ctx, NULL, 0)) {
+        ssize_t n = read(buf, (length < sizeof(buf)) ? length : sizeof(buf));
+        if (n < 0) return -1;
+        if (n == 0) break;
+        size_t took = func(ctx, buf, n);
+        if (took < (size_t)n) {
+            /* give the rest back to the file */
+            lseek(-(off_t)(n - took), SEEK_CUR);
+        }
+        done += took;
+        length -= took;
+        if (took == 0) return -1;
+    }
+    return done;
+}
+
 #if DEVICE_SERIAL
 extern int stdio_uart_inited;
 extern serial_t stdio_uart;
@@ -205,9 +225,7 @@ extern "C" int PREFIX(_write)(FILEHANDLE fh, const unsigned char *buffer, unsign
     if (fh < 3) {
 #if DEVICE_SERIAL
         if (!stdio_uart_inited) init_serial();
-        for (unsigned int i = 0; i < length; i++) {
-            serial_putc(&stdio_uart, buffer[i]);
-        }
+        serial_write(&stdio_uart, (const char*)buffer, length);
 #endif
         n = length;
     } else {
@@ -0,0 +1,155 @@
+/* Host benchmark of the Stream output path with a fake UART
+ *
+ * Builds and runs on the host, without the mbed tree:
+ *
+ *   g++ -O2 -Istub -I../../api stream_bench.cpp ../FileBase.cpp ../FileLike.cpp -o stream_bench && ./stream_bench
+ *
+ * Prints the same shell and sensor text through Stream::printf() and
+ * puts() with per character writes, and with bulk writes unbuffered, line
+ * buffered and fully buffered. The fake UART counts device calls and
+ * register accesses the way the LPC176X driver makes them (serial_putc:
+ * LSR poll and THR write per character, serial_write: one LSR poll per 16
+ * byte FIFO fill) and keeps the text to check it arrived unchanged.
+ * glibc fopencookie() stands in for retarget.cpp and stub/ for the target
+ * headers.
+ */
+#include <cstdio>
+#include <string>
+#include <time.h>
+
+// Stream() names itself ":%p" in 12 bytes, too small for a 64 bit pointer
+namespace std {
+int bench_sprintf(char *buf, const char *fmt, void *p);
+FILE *bench_fopen(const char *path, const char *mode);
+int bench_setvbuf(FILE *f, char *buf, int mode, size_t size);
+}
+#define sprintf bench_sprintf
+#define fopen bench_fopen
+#define setvbuf bench_setvbuf
+#include "../Stream.cpp"
+#undef sprintf
+#undef fopen
+#undef setvbuf
+
+using namespace mbed;
+
+#define LINES   2000
+
+static int failures;
+
+// retarget.cpp: ":%p" opens the Stream itself
+static void *opening;
+
+int std::bench_sprintf(char *buf, const char *fmt, void *p)
+{
+    opening = p;
+    return std::sprintf(buf, ":s");
+}
+
+static ssize_t cookie_write(void *cookie, const char *buf, size_t size)
+{
+    return ((FileHandle *)cookie)->write(buf, size);
+}
+
+static ssize_t cookie_read(void *cookie, char *buf, size_t size)
+{
+    return ((FileHandle *)cookie)->read(buf, size);
+}
+
+FILE *std::bench_fopen(const char *path, const char *mode)
+{
+    cookie_io_functions_t io = { cookie_read, cookie_write, NULL, NULL };
+
+    if (strcmp(path, ":s") != 0)
+        return NULL;
+    return fopencookie(opening, mode, io);
+}
+
+// newlib allocates size bytes for a NULL buf, glibc would keep the one
+// byte buffer of the unbuffered stream
+int std::bench_setvbuf(FILE *f, char *buf, int mode, size_t size)
+{
+    if (buf == NULL && mode != _IONBF)
+        buf = (char *)malloc(size);     // the fake UART lives until exit
+    return std::setvbuf(f, buf, mode, size);
+}
+
+namespace mbed {
+FileHandle::~FileHandle() {}
+ssize_t FileHandle::forward(size_t (*)(void *, const void *, size_t), void *, size_t) { return -1; }
+void mbed_set_unbuffered_stream(FILE *_file) { setbuf(_file, NULL); }
+int mbed_getc(FILE *_file) { return fgetc(_file); }
+char *mbed_gets(char *s, int size, FILE *_file) { return fgets(s, size, _file); }
+}
+
+class FakeUart : public Stream {
+public:
+    FakeUart(bool bulk) : _bulk(bulk), calls(0), regs(0) {}
+
+    bool _bulk;
+    unsigned long calls;    // driver calls
+    unsigned long regs;     // UART register accesses
+    std::string out;
+
+protected:
+    virtual int _putc(int c) {
+        calls++;
+        regs += 2;          // LSR until THRE, THR
+        out += (char)c;
+        return c;
+    }
+    virtual int _getc() { return -1; }
+    virtual ssize_t _write(const void *buffer, size_t length) {
+        if (!_bulk)
+            return Stream::_write(buffer, length);
+        calls++;
+        regs += (length + 15) / 16 + length;    // LSR per FIFO fill, THR per byte
+        out.append((const char *)buffer, length);
+        return length;
+    }
+};
+
+// text like the shell and the sensor loop print
+static void print_text(FakeUart &u, std::string &expect)
+{
+    char line[128];
+
+    for (int i = 0; i < LINES; i++) {
+        u.printf("%3d %4d %-5s %3lu.%lu %7lu\r\n", i % 12, 0, "WAIT", (unsigned long)i % 100, 5UL, 1000UL + i);
+        snprintf(line, sizeof line, "%3d %4d %-5s %3lu.%lu %7lu\r\n", i % 12, 0, "WAIT", (unsigned long)i % 100, 5UL, 1000UL + i);
+        expect += line;
+        u.puts("Temperature : 23 C\r\n");
+        expect += "Temperature : 23 C\r\n";
+    }
+    u.flush();
+}
+
+static void run(const char *name, bool bulk, int mode)
+{
+    FakeUart u(bulk);
+    std::string expect;
+    struct timespec t0, t1;
+
+    if (mode != _IONBF)
+        u.buffer(mode);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    print_text(u, expect);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    double ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+    bool ok = u.out == expect;
+    printf("%-24s %7zu bytes %7lu calls %7lu accesses %6.1f ns/byte %s\n", name, u.out.size(),
+           u.calls, u.regs, ns / u.out.size(), ok ? "ok" : "FAIL: output differs");
+    if (!ok)
+        failures++;
+}
+
+int main()
+{
+    run("per character", false, _IONBF);
+    run("bulk, unbuffered", true, _IONBF);
+    run("bulk, line buffered", true, _IOLBF);
+    run("bulk, fully buffered", true, _IOFBF);
+    printf(failures ? "FAILED\n" : "PASSED\n");
+    return failures != 0;
+}
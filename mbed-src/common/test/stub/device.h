@@ -0,0 +1 @@
+/* target header not needed on the host */
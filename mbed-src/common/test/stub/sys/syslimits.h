@@ -0,0 +1,2 @@
+/* newlib header missing on the host */
+#include <limits.h>
@@ -58,6 +58,7 @@ void serial_irq_set    (serial_t *obj, SerialIrq irq, uint32_t enable);
 
 int  serial_getc       (serial_t *obj);
 void serial_putc       (serial_t *obj, int c);
+int  serial_write      (serial_t *obj, const char *buf, int length);
 int  serial_readable   (serial_t *obj);
 int  serial_writable   (serial_t *obj);
 void serial_clear      (serial_t *obj);
@@ -0,0 +1,52 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stddef.h>
+
+#include "gpdma_irq.h"
+#include "cmsis.h"
+
+static gpdma_irq_handler irq_handlers[GPDMA_CHANNEL_NUM];
+static uint32_t channel_ids[GPDMA_CHANNEL_NUM];
+
+static void handle_interrupt_in(void) {
+    // Read both status registers once, they are masked by the channel configs
+    uint32_t tc = LPC_GPDMA->DMACIntTCStat;
+    uint32_t err = LPC_GPDMA->DMACIntErrStat;
+    uint32_t stat = tc | err;
+    uint8_t bitloc;
+
+    while (stat > 0) {
+        bitloc = 31 - __CLZ(stat);
+
+        // clear first, the handler may start the next transfer on the channel
+        LPC_GPDMA->DMACIntTCClear = 1 << bitloc;
+        LPC_GPDMA->DMACIntErrClr = 1 << bitloc;
+        if (irq_handlers[bitloc] != NULL)
+            irq_handlers[bitloc](channel_ids[bitloc], (err >> bitloc) & 1);
+        stat -= 1 << bitloc;
+    }
+}
+
+void gpdma_irq_set(int channel, gpdma_irq_handler handler, uint32_t id) {
+    if (channel < 0 || channel >= GPDMA_CHANNEL_NUM)
+        return;
+
+    NVIC_DisableIRQ(DMA_IRQn);
+    channel_ids[channel] = id;
+    irq_handlers[channel] = handler;
+    NVIC_SetVector(DMA_IRQn, (uint32_t)handle_interrupt_in);
+    NVIC_EnableIRQ(DMA_IRQn);
+}
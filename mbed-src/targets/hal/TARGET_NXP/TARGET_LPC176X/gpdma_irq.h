@@ -0,0 +1,44 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_GPDMA_IRQ_H
+#define MBED_GPDMA_IRQ_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GPDMA_CHANNEL_NUM   8
+
+/** Called from the GPDMA interrupt for a channel with its terminal count
+ *  or error interrupt enabled, after both flags of the channel are cleared.
+ *  error is 1 if the error flag was set.
+ */
+typedef void (*gpdma_irq_handler)(uint32_t id, int error);
+
+/** All GPDMA channels share one vector: drivers register a handler per
+ *  channel here instead of taking DMA_IRQn with NVIC_SetVector().
+ *  A NULL handler frees the channel. Interrupts of channels without a
+ *  handler are cleared and dropped.
+ */
+void gpdma_irq_set(int channel, gpdma_irq_handler handler, uint32_t id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -360,6 +360,25 @@ void serial_putc(serial_t *obj, int c) {
     uart_data[obj->index].count++;
 }
 
+int serial_write(serial_t *obj, const char *buf, int length) {
+    int i, n = 0;
+
+    // software CTS is checked per character
+    if (NC != uart_data[obj->index].sw_cts.pin) {
+        for (i = 0; i < length; i++)
+            serial_putc(obj, buf[i]);
+        return length;
+    }
+    // otherwise refill the whole 16 byte Tx FIFO each time it ran empty
+    while (n < length) {
+        while (!(obj->uart->LSR & 0x20));
+        for (i = 0; i < 16 && n < length; i++)
+            obj->uart->THR = buf[n++];
+        uart_data[obj->index].count = i;
+    }
+    return length;
+}
+
 int serial_readable(serial_t *obj) {
     return obj->uart->LSR & 0x01;
 }